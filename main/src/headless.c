@@ -0,0 +1,515 @@
+/**
+ * @file headless.c
+ * @brief Offscreen cncvis renderer for build servers and batch verification.
+ *
+ * Usage: headless [-s script] [-o target] [-f ppm|png|raw] [-n frames]
+ *                 [-l lod-bias] [-i] [-c cache-dir] [-j jobs] [-k allow-list]
+ *                 [-C max-percent] config.xml
+ *
+ * No SDL, no LVGL: loads config.xml through cncvis, renders with TinyGL into
+ * the ZBuffer and optionally writes every frame out. -o is a printf pattern for ppm/png ("out/f_%05d.png") or a
+ * file / "-" (stdout) for a raw rgb24 stream. -l sets the renderer's mesh
+ * detail bias (scene_render.h, default 0) and -i sends every vertex each
+ * frame instead of replaying display lists, for before/after comparisons.
+ * -c keeps preprocessed meshes in a mesh cache directory (mesh_cache.h).
+ * Startup is reported end to end, from main() to every mesh loaded, with
+ * cncvis_init and the scene build broken out, cold or warm.
+ * -j sets the threads loading the actors' meshes (default 0, one per CPU).
+ * -k checks the actors for collisions after every frame's scene update
+ * (scene_collision.h); parent and child assemblies may touch, and so may
+ * the node pairs of the allow list ("a:b,c:d", "" for none).
+ * -C checks every frame against cncvis_render() of the same scene state,
+ * which keeps its own copy of the meshes for it: it reports the pixels
+ * differing by more than COMPARE_TOLERANCE in any channel and the largest
+ * difference, and fails if a frame has more than max-percent of them.
+ * Log output goes to stderr.
+ *
+ * The script is read line by line ("-" = stdin):
+ *
+ *   # comment
+ *   render [frames]                   full frames of the unchanged scene
+ *   jog <assembly> <delta> [frames]   relative joint move spread over frames
+ *   joints <time-us> <assembly>=<value>...
+ *                                     one controller status frame: absolute
+ *                                     joint values applied as a batch, one
+ *                                     frame; older than the last is dropped;
+ *                                     up to 32 joints
+ *   orbit <dx> <dy> [frames]          camera orbit spread over frames
+ *   view front|top|right|iso|reset    camera preset, renders one frame
+ *
+ * Without a script, `render <-n frames>` is run (default 100). The run ends
+ * with a frames-per-second report for rendering alone and including output,
+ * the average triangle count at the picked detail levels, the average number
+ * of frustum-culled actors and of recomputed world matrices, and the
+ * per-stage percentiles from frame_profiler.h. With -k it also reports how
+ * many frames had collisions, the checking time per frame and the pairs
+ * colliding in the last frame.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../../cncvis/api.h"
+
+#include "render/frame_dump.h"
+#include "render/frame_profiler.h"
+#include "render/pixconv.h"
+#include "render/render_state.h"
+#include "render/scene_render.h"
+#include "scene/scene_cncvis.h"
+
+#define COMPARE_TOLERANCE 16 /* Per channel, out of 255: shading rounding, not geometry */
+#define SCRIPT_MAX_WORDS 34  /* Per line: "joints", the time and 32 joints */
+
+// Global Scene State
+ZBuffer *globalFramebuffer = NULL;
+ucncAssembly *globalScene = NULL;
+ucncCamera *globalCamera = NULL;
+ucncLight **globalLights = NULL;
+int globalLightCount = 0;
+
+typedef struct
+{
+    scene_renderer_t renderer;
+    frame_dump_t dump;
+    bool dumping;
+    pixconv_format_t format;
+    int frames;
+    uint64_t triangles; /* Sum over frames at the picked detail levels */
+    uint64_t collision_us; /* Sum of the renderer's collision_us */
+    int collision_frames;  /* Frames with at least one colliding pair */
+    double render_seconds;
+    double output_seconds;
+
+    bool comparing;        /* -C */
+    float compare_limit;   /* Percent of differing pixels a frame may have */
+    uint8_t *frame_copy;   /* The mirror's frame, put back after the reference render */
+    uint8_t *mirror_rgb;
+    uint8_t *reference_rgb;
+    uint64_t compared_pixels;
+    uint64_t differing_pixels;
+    int max_delta;
+    int worst_frame;
+    float worst_percent;
+} headless_t;
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* The renderer's backdrop hook: nothing else touches cncvis here, so no lock */
+static void draw_backdrop(void *arg)
+{
+    scene_cncvis_render_backdrop((scene_t *)arg);
+}
+
+/*
+ * Renders the same state with cncvis_render() and compares it with the
+ * mirror's frame in the ZBuffer, which is put back afterwards so dirty
+ * rectangles keep drawing over it.
+ */
+static void compare_frame(headless_t *h)
+{
+    ZBuffer *zb = globalFramebuffer;
+    size_t bytes = (size_t)zb->linesize * (size_t)zb->ysize;
+    size_t pixels = (size_t)zb->xsize * (size_t)zb->ysize;
+    size_t differing = 0;
+
+    memcpy(h->frame_copy, zb->pbuf, bytes);
+    pixconv_convert(h->mirror_rgb, zb->xsize * 3, PIXCONV_FMT_RGB888, zb->pbuf, zb->linesize, h->format, zb->xsize,
+                    zb->ysize);
+    cncvis_render();
+    pixconv_convert(h->reference_rgb, zb->xsize * 3, PIXCONV_FMT_RGB888, zb->pbuf, zb->linesize, h->format,
+                    zb->xsize, zb->ysize);
+    memcpy(zb->pbuf, h->frame_copy, bytes);
+
+    for (size_t i = 0; i < pixels; i++)
+    {
+        int delta = 0;
+        for (int c = 0; c < 3; c++)
+        {
+            int d = abs((int)h->mirror_rgb[i * 3 + c] - (int)h->reference_rgb[i * 3 + c]);
+            delta = d > delta ? d : delta;
+        }
+        differing += delta > COMPARE_TOLERANCE;
+        h->max_delta = delta > h->max_delta ? delta : h->max_delta;
+    }
+
+    float percent = 100.0f * (float)differing / (float)pixels;
+    if (percent > h->worst_percent || h->compared_pixels == 0)
+    {
+        h->worst_percent = percent;
+        h->worst_frame = h->frames - 1;
+    }
+    h->compared_pixels += pixels;
+    h->differing_pixels += differing;
+    if (percent > h->compare_limit)
+        fprintf(stderr, "headless: frame %d differs from cncvis_render in %.2f%% of its pixels\n", h->frames - 1,
+                (double)percent);
+}
+
+static bool render_frame(headless_t *h, uint32_t reasons)
+{
+    render_rect_t drawn;
+    double start = now_seconds();
+    uint64_t mark = frame_profiler_now_us();
+
+    scene_cncvis_sync(h->renderer.scene);
+    frame_profiler_record(FRAME_STAGE_SYNC, frame_profiler_lap(&mark));
+    scene_render_frame(&h->renderer, reasons, &drawn);
+    h->render_seconds += now_seconds() - start;
+    h->frames++;
+    h->triangles += h->renderer.triangles;
+    h->collision_us += h->renderer.collision_us;
+    h->collision_frames += h->renderer.collisions > 0;
+    frame_profiler_record(FRAME_STAGE_TRANSFORM, h->renderer.transform_us);
+    frame_profiler_record(FRAME_STAGE_RASTER, h->renderer.raster_us);
+    if (h->comparing)
+        compare_frame(h);
+
+    if (!h->dumping)
+        return true;
+
+    start = now_seconds();
+    bool ok = frame_dump_write(&h->dump, globalFramebuffer->pbuf, globalFramebuffer->linesize, h->format);
+    h->output_seconds += now_seconds() - start;
+    return ok;
+}
+
+static bool set_view(const char *name)
+{
+    if (strcmp(name, "front") == 0)
+        ucncCameraSetFrontView(globalCamera);
+    else if (strcmp(name, "top") == 0)
+        ucncCameraSetTopView(globalCamera);
+    else if (strcmp(name, "right") == 0)
+        ucncCameraSetRightView(globalCamera);
+    else if (strcmp(name, "iso") == 0)
+        ucncCameraSetIsometricView(globalCamera);
+    else if (strcmp(name, "reset") == 0)
+        ucncCameraResetView(globalCamera);
+    else
+        return false;
+    update_camera_matrix(globalCamera);
+    return true;
+}
+
+/* Runs one script line; returns false on a syntax or output error */
+static bool run_command(headless_t *h, char *line, int line_number)
+{
+    char *argv[SCRIPT_MAX_WORDS];
+    int argc = 0;
+
+    for (char *tok = strtok(line, " \t\r\n"); tok; tok = strtok(NULL, " \t\r\n"))
+    {
+        if (tok[0] == '#')
+            break;
+        if (argc == SCRIPT_MAX_WORDS)
+        {
+            fprintf(stderr, "line %d: more than %d words\n", line_number, SCRIPT_MAX_WORDS);
+            return false;
+        }
+        argv[argc++] = tok;
+    }
+    if (argc == 0)
+        return true;
+
+    if (strcmp(argv[0], "render") == 0)
+    {
+        int frames = argc > 1 ? atoi(argv[1]) : 1;
+        for (int i = 0; i < frames; i++)
+        {
+            if (!render_frame(h, RENDER_DIRTY_ALL))
+                return false;
+        }
+        return true;
+    }
+    if (strcmp(argv[0], "jog") == 0 && argc >= 3)
+    {
+        int frames = argc > 3 ? atoi(argv[3]) : 1;
+        float step = (float)atof(argv[2]) / (float)(frames > 0 ? frames : 1);
+        int joint = scene_find_node(h->renderer.scene, argv[1]);
+        for (int i = 0; i < frames; i++)
+        {
+            if (!scene_cncvis_update_motion(h->renderer.scene, joint, step))
+            {
+                fprintf(stderr, "line %d: no movable assembly '%s'\n", line_number, argv[1]);
+                return false;
+            }
+            if (!render_frame(h, RENDER_DIRTY_MOTION))
+                return false;
+        }
+        return true;
+    }
+    if (strcmp(argv[0], "joints") == 0 && argc >= 3)
+    {
+        int joints[SCRIPT_MAX_WORDS];
+        float values[SCRIPT_MAX_WORDS];
+        int count = 0;
+        for (int i = 2; i < argc; i++)
+        {
+            char *eq = strchr(argv[i], '=');
+            if (eq == NULL)
+                break;
+            *eq = '\0';
+            joints[count] = scene_find_node(h->renderer.scene, argv[i]);
+            values[count++] = (float)atof(eq + 1);
+        }
+        if (count != argc - 2 ||
+            scene_cncvis_apply_joints(h->renderer.scene, joints, values, count, strtoull(argv[1], NULL, 10)) == 0)
+        {
+            fprintf(stderr, "line %d: expected <time-us> <assembly>=<value>... of movable assemblies\n", line_number);
+            return false;
+        }
+        return render_frame(h, RENDER_DIRTY_MOTION);
+    }
+    if (strcmp(argv[0], "orbit") == 0 && argc >= 3)
+    {
+        int frames = argc > 3 ? atoi(argv[3]) : 1;
+        float div = (float)(frames > 0 ? frames : 1);
+        for (int i = 0; i < frames; i++)
+        {
+            ucncCameraOrbit(globalCamera, (float)atof(argv[1]) / div, (float)atof(argv[2]) / div);
+            if (!render_frame(h, RENDER_DIRTY_CAMERA))
+                return false;
+        }
+        return true;
+    }
+    if (strcmp(argv[0], "view") == 0 && argc >= 2 && set_view(argv[1]))
+        return render_frame(h, RENDER_DIRTY_CAMERA);
+
+    fprintf(stderr, "line %d: cannot parse '%s'\n", line_number, argv[0]);
+    return false;
+}
+
+static bool run_script(headless_t *h, const char *path)
+{
+    FILE *fp = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+    char line[512];
+    int line_number = 0;
+    bool ok = true;
+
+    if (fp == NULL)
+    {
+        fprintf(stderr, "cannot open script '%s'\n", path);
+        return false;
+    }
+    while (ok && fgets(line, sizeof(line), fp))
+        ok = run_command(h, line, ++line_number);
+    if (fp != stdin)
+        fclose(fp);
+    return ok;
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [-s script] [-o target] [-f ppm|png|raw] [-n frames] [-l lod-bias] [-i] [-c cache-dir] "
+            "[-j jobs] [-k allow-list] [-C max-percent] config.xml\n",
+            argv0);
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t startUs = frame_profiler_now_us();
+    const char *script = NULL;
+    const char *target = NULL;
+    frame_dump_format_t format = FRAME_DUMP_PPM;
+    int frames = 100;
+    int lodBias = 0;
+    bool immediate = false;
+    const char *cacheDir = NULL;
+    int loadThreads = 0;
+    const char *collisionAllow = NULL;
+    float compareLimit = -1.0f;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:o:f:n:l:ic:j:k:C:")) != -1)
+    {
+        switch (opt)
+        {
+        case 's': script = optarg; break;
+        case 'o': target = optarg; break;
+        case 'n': frames = atoi(optarg); break;
+        case 'l': lodBias = atoi(optarg); break;
+        case 'i': immediate = true; break;
+        case 'c': cacheDir = optarg; break;
+        case 'j': loadThreads = atoi(optarg); break;
+        case 'k': collisionAllow = optarg; break;
+        case 'C': compareLimit = (float)atof(optarg); break;
+        case 'f':
+            if (!frame_dump_parse_format(optarg, &format))
+            {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (optind != argc - 1)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    // A raw stream on stdout must not be interleaved with log output
+    FILE *rawStdout = NULL;
+    if (target && format == FRAME_DUMP_RAW && strcmp(target, "-") == 0)
+    {
+        rawStdout = fdopen(dup(STDOUT_FILENO), "wb");
+        dup2(STDERR_FILENO, STDOUT_FILENO);
+        if (rawStdout == NULL)
+            return 1;
+    }
+
+    const char *configFile = argv[optind];
+    uint64_t initStartUs = frame_profiler_now_us();
+    if (cncvis_init(configFile) != 0 || globalFramebuffer == NULL)
+    {
+        fprintf(stderr, "cncvis_init failed for '%s'\n", configFile);
+        return 1;
+    }
+    uint64_t initEndUs = frame_profiler_now_us();
+
+    pixconv_init();
+
+    headless_t h;
+    memset(&h, 0, sizeof(h));
+    h.format = globalFramebuffer->mode == ZB_MODE_5R6G5B ? PIXCONV_FMT_RGB565 : PIXCONV_FMT_XRGB8888;
+
+    uint64_t sceneStartUs = frame_profiler_now_us();
+    scene_t *scene = scene_cncvis_build(globalScene, configFile, cacheDir);
+    scene_load_actors(scene, loadThreads, NULL);
+    if (compareLimit < 0.0f)
+        scene_cncvis_release_geometry(scene);
+    uint64_t sceneEndUs = frame_profiler_now_us();
+    fprintf(stderr,
+            "headless: startup %.1f ms end to end (cncvis_init %.1f ms, scene %.1f ms), %d/%d meshes from cache (%s)\n",
+            (double)(sceneEndUs - startUs) / 1000.0, (double)(initEndUs - initStartUs) / 1000.0,
+            (double)(sceneEndUs - sceneStartUs) / 1000.0, scene->cache_hits, scene->cache_hits + scene->cache_misses,
+            cacheDir == NULL ? "no cache" : scene->cache_misses == 0 ? "warm" : "cold");
+    scene_render_init(&h.renderer, scene, globalFramebuffer, globalCamera, globalLights, globalLightCount);
+    h.renderer.lod_level = lodBias;
+    h.renderer.immediate = immediate;
+    h.renderer.backdrop = draw_backdrop;
+    h.renderer.backdrop_arg = scene;
+    if (compareLimit >= 0.0f)
+    {
+        size_t pixels = (size_t)globalFramebuffer->xsize * (size_t)globalFramebuffer->ysize;
+
+        h.comparing = true;
+        h.compare_limit = compareLimit;
+        h.frame_copy = malloc((size_t)globalFramebuffer->linesize * (size_t)globalFramebuffer->ysize);
+        h.mirror_rgb = malloc(pixels * 3);
+        h.reference_rgb = malloc(pixels * 3);
+        if (h.frame_copy == NULL || h.mirror_rgb == NULL || h.reference_rgb == NULL)
+            return 1;
+    }
+    if (collisionAllow)
+    {
+        h.renderer.collision = scene_collision_create(scene, true);
+        if (h.renderer.collision == NULL || scene_collision_allow_list(h.renderer.collision, scene, collisionAllow) < 0)
+        {
+            fprintf(stderr, "headless: bad collision allow list '%s'\n", collisionAllow);
+            return 1;
+        }
+    }
+
+    if (target)
+    {
+        h.dumping = rawStdout ? frame_dump_open_stream(&h.dump, rawStdout, globalFramebuffer->xsize, globalFramebuffer->ysize)
+                              : frame_dump_open(&h.dump, format, target, globalFramebuffer->xsize, globalFramebuffer->ysize);
+        if (!h.dumping)
+            return 1;
+    }
+
+    fprintf(stderr, "headless: %dx%d, %s\n", globalFramebuffer->xsize, globalFramebuffer->ysize,
+            immediate ? "TinyGL immediate mode" : "TinyGL display lists");
+
+    bool ok;
+    double start = now_seconds();
+    if (script)
+    {
+        ok = run_script(&h, script);
+    }
+    else
+    {
+        char line[32];
+        snprintf(line, sizeof(line), "render %d", frames);
+        ok = run_command(&h, line, 0);
+    }
+    double total = now_seconds() - start;
+
+    if (h.dumping)
+        frame_dump_close(&h.dump);
+    if (rawStdout)
+        fclose(rawStdout);
+
+    fprintf(stderr, "headless: %d frames in %.3f s\n", h.frames, total);
+    fprintf(stderr, "headless: render %.2f fps (%.3f ms/frame), with output %.2f fps\n",
+            h.render_seconds > 0.0 ? h.frames / h.render_seconds : 0.0,
+            h.frames ? h.render_seconds * 1000.0 / h.frames : 0.0,
+            total > 0.0 ? h.frames / total : 0.0);
+    if (h.dumping)
+        fprintf(stderr, "headless: output %.3f ms/frame\n", h.frames ? h.output_seconds * 1000.0 / h.frames : 0.0);
+
+    int fullTriangles = 0;
+    for (int i = 0; i < scene->actor_count; i++)
+        fullTriangles += scene->actors[i].mesh.triangle_count;
+    fprintf(stderr, "headless: %.0f triangles/frame at the picked detail levels, %d at full detail\n",
+            h.frames ? (double)h.triangles / h.frames : 0.0, fullTriangles);
+    if (!immediate)
+        fprintf(stderr, "headless: display lists hold %llu triangles, about %.1f MB (%llu compiled)\n",
+                (unsigned long long)h.renderer.list_triangles,
+                (double)h.renderer.list_triangles * SCENE_RENDER_LIST_TRIANGLE_BYTES / 1048576.0,
+                (unsigned long long)h.renderer.compiled_lists);
+    fprintf(stderr, "headless: %.1f of %d actors culled per frame\n",
+            h.frames ? (double)h.renderer.culled_total / h.frames : 0.0, scene->actor_count);
+    fprintf(stderr, "headless: %.1f of %d world matrices recomputed per frame\n",
+            h.frames ? (double)h.renderer.matrices_total / h.frames : 0.0, scene->node_count);
+    if (h.renderer.collision)
+    {
+        int count;
+        const scene_collision_pair_t *pairs = scene_collision_pairs(h.renderer.collision, &count);
+
+        fprintf(stderr, "headless: collisions in %d of %d frames, %.3f ms/frame checking, %d pair(s) in the last%s",
+                h.collision_frames, h.frames, h.frames ? (double)h.collision_us / 1000.0 / h.frames : 0.0, count,
+                count > 0 ? ":" : "\n");
+        for (int i = 0; i < count; i++)
+            fprintf(stderr, " %s/%s", scene->actors[pairs[i].a].name, scene->actors[pairs[i].b].name);
+        if (count > 0)
+            fprintf(stderr, "\n");
+    }
+
+    if (h.comparing)
+    {
+        fprintf(stderr,
+                "headless: vs cncvis_render, %.3f%% of pixels differ by more than %d (largest %d), worst frame %d "
+                "at %.3f%%\n",
+                h.compared_pixels ? 100.0 * (double)h.differing_pixels / (double)h.compared_pixels : 0.0,
+                COMPARE_TOLERANCE, h.max_delta, h.worst_frame, (double)h.worst_percent);
+        ok = ok && h.worst_percent <= h.compare_limit;
+        free(h.frame_copy);
+        free(h.mirror_rgb);
+        free(h.reference_rgb);
+    }
+
+    char profile[512];
+    frame_profiler_format(profile, sizeof(profile), " | ");
+    fprintf(stderr, "headless: stages [ms p50/p95/p99/max]: %s\n", profile);
+
+    scene_render_release(&h.renderer);
+    scene_collision_destroy(h.renderer.collision);
+    scene_destroy(scene);
+    cncvis_cleanup();
+    return ok ? 0 : 1;
+}
@@ -13,58 +13,83 @@ ucncLight **globalLights = NULL;
 int globalLightCount = 0;
 
 static lv_obj_t *canvas = NULL;
-static uint8_t cbuf[LV_CANVAS_BUF_SIZE(CANVAS_WIDTH, CANVAS_HEIGHT, LV_COLOR_DEPTH, LV_DRAW_BUF_STRIDE_ALIGN)];
+static scene_t *sceneMirror = NULL;
+
+/* Joint handles of link1..link6 (scene_find_node), -1 where the config has no such assembly */
+static int linkJoints[JOG_LINKS];
+
+/* Chain ending at link6 and its IK solver for Cartesian jogging; NULL without link6 */
+static kinematics_t *robotChain = NULL;
+static kinematics_ik_t *robotIk = NULL;
+
+/* Contact checks run by the render thread with every frame; NULL when turned off */
+static scene_collision_t *sceneCollision = NULL;
+
+/* Canvas pixel stores, rotated by the render thread's triple buffer. When the pixel
+ * formats match TinyGL rasterizes straight into them (see canvas_attach_framebuffer),
+ * so there is no separate full-size framebuffer. */
+static uint8_t cbuf[RENDER_THREAD_BUFFERS][LV_CANVAS_BUF_SIZE(CANVAS_WIDTH, CANVAS_HEIGHT, LV_COLOR_DEPTH, LV_DRAW_BUF_STRIDE_ALIGN)];
+static bool canvas_zero_copy = false;
+
+/* SDL user event the render thread pushes when a frame is ready; one in the queue at a time */
+static Uint32 frameReadyEvent = (Uint32)-1;
+static bool frameReadyQueued = false;
+
+/* Frame profiler overlay (F9 toggles) and the display refresh being timed */
+static lv_obj_t *profileOverlay = NULL;
+static bool displayRefreshed = false;
+static uint64_t flushStartUs = 0;
+static uint32_t flushSumUs = 0;
+
+/* Startup: background mesh loading and its progress label */
+static scene_loader_t *sceneLoader = NULL;
+static lv_obj_t *loadingLabel = NULL;
+static uint64_t startUs = 0;
+static uint64_t firstPaintUs = 0;
+static uint64_t windowLiveUs = 0;
+static uint64_t cncvisInitUs = 0;
+static uint64_t sceneReadyUs = 0; /* Set by the loader once every actor is done */
+
+/* TinyGL framebuffer layout, as a pixconv format */
+static pixconv_format_t zb_pixel_format(const ZBuffer *zb)
+{
+    return zb->mode == ZB_MODE_5R6G5B ? PIXCONV_FMT_RGB565 : PIXCONV_FMT_XRGB8888;
+}
 
-/* Copy TinyGL framebuffer (ARGB8888) to LVGL buffer (XRGB8888) */
-void ZB_copyFrameBufferLVGL(ZBuffer *zb, lv_color32_t *lv_buf)
+/* Canvas layout for LV_COLOR_FORMAT_NATIVE at the configured LV_COLOR_DEPTH */
+static pixconv_format_t canvas_pixel_format(void)
 {
-    uint32_t *q_ptr = (uint32_t *)zb->pbuf; // Pointer to TinyGL framebuffer (ARGB8888 format)
-    lv_color32_t *p_ptr = lv_buf;           // Pointer to LVGL buffer (XRGB8888 format)
+#if LV_COLOR_DEPTH == 16
+    return PIXCONV_FMT_RGB565;
+#elif LV_COLOR_DEPTH == 24
+    return PIXCONV_FMT_RGB888;
+#else
+    return PIXCONV_FMT_XRGB8888;
+#endif
+}
 
-    int total_pixels = zb->xsize * zb->ysize;
-    int i;
+/*
+ * When TinyGL's PIXEL layout matches the native canvas format (0x00RRGGBB is
+ * byte-for-byte XRGB8888 at LV_COLOR_DEPTH 32; RGB565 at depth 16) the ZBuffer
+ * is re-pointed at the canvas buffers (ZB_resize frees the buffer TinyGL
+ * allocated in cncvis_init; the render thread then moves pbuf to whichever
+ * buffer is free) and the per-frame copy goes away. Returns false if the
+ * layouts don't line up, in which case the render thread keeps converting.
+ */
+static bool canvas_attach_framebuffer(ZBuffer *zb)
+{
+    uint32_t stride = lv_draw_buf_width_to_stride(CANVAS_WIDTH, LV_COLOR_FORMAT_NATIVE);
 
-    // Process 4 pixels at a time
-    for (i = 0; i <= total_pixels - 4; i += 4)
-    {
-        // Pixel 1
-        uint32_t pixel1 = q_ptr[i];
-        p_ptr[i].red = (pixel1 >> 16) & 0xFF;
-        p_ptr[i].green = (pixel1 >> 8) & 0xFF;
-        p_ptr[i].blue = pixel1 & 0xFF;
-        p_ptr[i].alpha = 0xFF;
-
-        // Pixel 2
-        uint32_t pixel2 = q_ptr[i + 1];
-        p_ptr[i + 1].red = (pixel2 >> 16) & 0xFF;
-        p_ptr[i + 1].green = (pixel2 >> 8) & 0xFF;
-        p_ptr[i + 1].blue = pixel2 & 0xFF;
-        p_ptr[i + 1].alpha = 0xFF;
-
-        // Pixel 3
-        uint32_t pixel3 = q_ptr[i + 2];
-        p_ptr[i + 2].red = (pixel3 >> 16) & 0xFF;
-        p_ptr[i + 2].green = (pixel3 >> 8) & 0xFF;
-        p_ptr[i + 2].blue = pixel3 & 0xFF;
-        p_ptr[i + 2].alpha = 0xFF;
-
-        // Pixel 4
-        uint32_t pixel4 = q_ptr[i + 3];
-        p_ptr[i + 3].red = (pixel4 >> 16) & 0xFF;
-        p_ptr[i + 3].green = (pixel4 >> 8) & 0xFF;
-        p_ptr[i + 3].blue = pixel4 & 0xFF;
-        p_ptr[i + 3].alpha = 0xFF;
-    }
+    if (zb == NULL || zb_pixel_format(zb) != canvas_pixel_format() ||
+        stride != CANVAS_WIDTH * (uint32_t)pixconv_bytes_per_pixel(canvas_pixel_format()))
+        return false;
 
-    // Handle any remaining pixels (if total_pixels is not a multiple of 4)
-    for (; i < total_pixels; i++)
-    {
-        uint32_t pixel = q_ptr[i];
-        p_ptr[i].red = (pixel >> 16) & 0xFF;
-        p_ptr[i].green = (pixel >> 8) & 0xFF;
-        p_ptr[i].blue = pixel & 0xFF;
-        p_ptr[i].alpha = 0xFF;
-    }
+    ZB_resize(zb, cbuf[0], CANVAS_WIDTH, CANVAS_HEIGHT);
+    if (zb->pbuf != (void *)cbuf[0] || zb->linesize != (int)stride)
+        return false;
+
+    glViewport(0, 0, CANVAS_WIDTH, CANVAS_HEIGHT);
+    return true;
 }
 
 int main(int argc, char **argv)
@@ -74,13 +99,14 @@ int main(int argc, char **argv)
 
     // app_init();
 
+    startUs = frame_profiler_now_us();
     char configFile[] = "/home/davidsmith/uCNC-machineSimModule/bin/config.xml";
 
     printf("Initializing LVGL...\n");
     lv_init();
 
     printf("Initializing HAL...\n");
-    hal_init(CANVAS_WIDTH, CANVAS_HEIGHT);
+    lv_display_t *disp = hal_init(CANVAS_WIDTH, CANVAS_HEIGHT);
 
     printf("Creating LVGL canvas...\n");
     int buf_size = LV_CANVAS_BUF_SIZE(CANVAS_WIDTH, CANVAS_HEIGHT, LV_COLOR_FORMAT_ARGB8888, LV_DRAW_BUF_STRIDE_ALIGN);
@@ -89,46 +115,371 @@ int main(int argc, char **argv)
 
     // Create LVGL canvas
     canvas = lv_canvas_create(lv_scr_act());
-    lv_canvas_set_buffer(canvas, cbuf, CANVAS_WIDTH, CANVAS_HEIGHT, LV_COLOR_FORMAT_NATIVE);
+    lv_canvas_set_buffer(canvas, cbuf[0], CANVAS_WIDTH, CANVAS_HEIGHT, LV_COLOR_FORMAT_NATIVE);
     lv_canvas_fill_bg(canvas, lv_color_hex3(0x000), LV_OPA_COVER);
     lv_obj_center(canvas);
 
+    // Paint the empty canvas and the loading label now: nothing services LVGL until setup is done
+    loading_init();
+    lv_refr_now(disp);
+    firstPaintUs = frame_profiler_now_us();
+
+    uint64_t initStartUs = frame_profiler_now_us();
     cncvis_init(configFile);
+    cncvisInitUs = frame_profiler_now_us() - initStartUs;
+
+    pixconv_init();
+    canvas_zero_copy = canvas_attach_framebuffer(globalFramebuffer);
+    printf("Canvas path: %s (%s -> %s, %s)\n", canvas_zero_copy ? "zero-copy" : "convert",
+           pixconv_format_name(zb_pixel_format(globalFramebuffer)),
+           pixconv_format_name(canvas_pixel_format()), pixconv_isa_name(pixconv_active_isa()));
+
+    // Mirror the assembly tree so frames can be limited to what actually moved; it takes over the triangles
+    // cncvis parsed and welds them once the render thread runs. Preprocessed meshes are cached in
+    // MESH_CACHE_DIR, "" = off.
+    const char *cacheDir = getenv("MESH_CACHE_DIR");
+    sceneMirror = scene_cncvis_build(globalScene, configFile, cacheDir ? cacheDir : MESH_CACHE_DIR_DEFAULT);
+
+    // Keys 1-6 jog link1..link6: resolve them to joint handles once instead of searching by name per key repeat
+    for (int i = 0; i < JOG_LINKS; i++)
+    {
+        char assemblyName[16];
+        snprintf(assemblyName, sizeof(assemblyName), "link%d", i + 1);
+        linkJoints[i] = sceneMirror ? scene_find_node(sceneMirror, assemblyName) : -1;
+    }
 
-    printf("Init done..\n");
+    // X/Y/Z + arrows move link6's pivot in a straight line, solving the joints by IK on the link1..link6 chain
+    if (linkJoints[JOG_LINKS - 1] >= 0)
+    {
+        const scene_node_t *flange = &sceneMirror->nodes[linkJoints[JOG_LINKS - 1]];
+        robotChain = kinematics_create(sceneMirror, linkJoints[JOG_LINKS - 1], flange->origin);
+        robotIk = robotChain ? kinematics_ik_create(robotChain) : NULL;
+        if (robotIk)
+            printf("Kinematics: %d joints, %s IK\n", kinematics_joint_count(robotChain),
+                   kinematics_ik_analytic(robotIk) ? "closed-form" : "damped least-squares");
+    }
+
+    // Colliding parts are drawn highlighted: COLLISION_CHECKS=0 turns the checks off. Parent and child
+    // assemblies may touch at their joint; COLLISION_ALLOW="a:b,c:d" exempts further assembly pairs.
+    const char *collisionChecks = getenv("COLLISION_CHECKS");
+    if (sceneMirror && (collisionChecks ? atoi(collisionChecks) : COLLISION_CHECKS_DEFAULT) != 0)
+    {
+        const char *collisionAllow = getenv("COLLISION_ALLOW");
+        sceneCollision = scene_collision_create(sceneMirror, true);
+        if (sceneCollision && collisionAllow &&
+            scene_collision_allow_list(sceneCollision, sceneMirror, collisionAllow) < 0)
+            printf("Collision: COLLISION_ALLOW has a malformed pair or unknown assembly, ignoring the rest\n");
+        printf("Collision checks: %s\n", sceneCollision ? "on" : "off (out of memory)");
+    }
+
+    // Re-render only when the camera, lights, joints or window visibility change; each call
+    // site that changes one of them marks it (render_state.h)
+    render_state_init();
+
+    // Reduced resolution while dragging/zooming: INTERACTION_SCALE=fraction, 1 = off
+    const char *interactionScale = getenv("INTERACTION_SCALE");
+    float scale = interactionScale ? (float)atof(interactionScale) : INTERACTION_SCALE_DEFAULT;
+    printf("Interaction scale: %.2f\n", scale);
+
+    // Quality governor: RENDER_TARGET_FPS=fps to hold, 0 = fixed full quality
+    const char *targetFps = getenv("RENDER_TARGET_FPS");
+    float fps = targetFps ? (float)atof(targetFps) : RENDER_TARGET_FPS_DEFAULT;
+    printf("Quality governor: %s\n", fps > 0.0f ? "on" : "off");
+
+    // From here on TinyGL belongs to the render thread
+    render_thread_config_t renderConfig = {
+        .zb = globalFramebuffer,
+        .scene = sceneMirror,
+        .camera = globalCamera,
+        .lights = globalLights,
+        .light_count = &globalLightCount,
+        .width = CANVAS_WIDTH,
+        .height = CANVAS_HEIGHT,
+        .stride = (int)lv_draw_buf_width_to_stride(CANVAS_WIDTH, LV_COLOR_FORMAT_NATIVE),
+        .format = canvas_pixel_format(),
+        .zero_copy = canvas_zero_copy,
+        .collision = sceneCollision,
+        .interaction_scale = scale,
+        .target_fps = fps,
+        .frame_ready = frame_ready_cb,
+    };
+    for (int i = 0; i < RENDER_THREAD_BUFFERS; i++)
+        renderConfig.buffers[i] = cbuf[i];
+#if LV_USE_OS == LV_OS_NONE
+    frameReadyEvent = SDL_RegisterEvents(1);
+#endif
+    if (!render_thread_start(&renderConfig))
+    {
+        printf("Failed to start the render thread\n");
+        return 1;
+    }
 
-    // Set up a timer to render the CNC scene using TinyGL and LVGL
-    lv_timer_create(render_timer_cb, 1, NULL);
+    // Stage timings: the render thread records its own, LVGL's come from display events
+    profile_init(disp);
+
+    // Load the meshes: SCENE_ASYNC_LOAD=1 does it in the background so the window is live at once and
+    // parts appear as they finish, 0 blocks here. SCENE_LOAD_THREADS=N loaders, 0 = one per CPU.
+    const char *asyncLoad = getenv("SCENE_ASYNC_LOAD");
+    const char *loadThreads = getenv("SCENE_LOAD_THREADS");
+    int threads = loadThreads ? atoi(loadThreads) : SCENE_LOAD_THREADS_DEFAULT;
+    scene_load_callbacks_t loadCallbacks = { .changed = scene_changed_cb, .ready = scene_ready_cb };
+    if ((asyncLoad ? atoi(asyncLoad) : SCENE_ASYNC_LOAD_DEFAULT) != 0)
+        sceneLoader = scene_loader_start(sceneMirror, threads, &loadCallbacks);
+    if (sceneLoader == NULL)
+        scene_load_actors(sceneMirror, threads, &loadCallbacks);
+
+    windowLiveUs = frame_profiler_now_us();
+    printf("Init done..\n");
 
 #if LV_USE_OS == LV_OS_NONE
     while (1)
     {
-        // Handle inputs (this now also handles LVGL timer/events)
+        // Handle inputs
         process_mouse_events();
-        process_keyboard_events();
-        
-        // No need to call lv_timer_handler() again - it's now in process_mouse_events()
-        
-        // Small delay to avoid 100% CPU usage
-        SDL_Delay(10);
+
+        // The render thread snapshots camera and joints under the same lock
+        render_thread_lock_scene();
+        bool keysHeld = process_keyboard_events();
+        render_thread_unlock_scene();
+
+        // Show the newest finished frame, then run whatever LVGL timers are due
+        present_frame();
+        displayRefreshed = false;
+        uint64_t lvglStart = frame_profiler_now_us();
+        uint32_t timeout = lv_timer_handler();
+        if (displayRefreshed)
+            frame_profiler_record(FRAME_STAGE_LVGL, frame_profiler_lap(&lvglStart));
+
+        // Sleep until input, a finished frame or the next LVGL timer, so idle wake-ups follow the
+        // shortest LVGL timer period (indev read, display refresh). Held jog/WASD keys
+        // are read from the keyboard state rather than events, so keep polling while down,
+        // and while interacting so the end of a wheel zoom is noticed.
+        if (timeout == LV_NO_TIMER_READY || timeout > MAIN_LOOP_MAX_WAIT_MS)
+            timeout = MAIN_LOOP_MAX_WAIT_MS;
+        if ((keysHeld || render_state_interacting()) && timeout > KEY_REPEAT_MS)
+            timeout = KEY_REPEAT_MS;
+        SDL_WaitEventTimeout(NULL, (int)timeout);
     }
 #elif LV_USE_OS == LV_OS_FREERTOS
+    // No SDL loop here: pick up frames from an LVGL timer instead
+    lv_timer_create(present_timer_cb, KEY_REPEAT_MS, NULL);
     freertos_main(); // For FreeRTOS, delegate to the appropriate task manager
 #endif
 
     return 0;
 }
 
-static void render_timer_cb(lv_timer_t *timer)
+/* Render thread: wake the main loop, unless a wake-up is already queued */
+static void frame_ready_cb(void *arg)
+{
+    (void)arg;
+
+    if (frameReadyEvent == (Uint32)-1 || __atomic_exchange_n(&frameReadyQueued, true, __ATOMIC_ACQ_REL))
+        return;
+
+    SDL_Event event;
+    memset(&event, 0, sizeof(event));
+    event.type = frameReadyEvent;
+    SDL_PushEvent(&event);
+}
+
+#if LV_USE_OS == LV_OS_FREERTOS
+static void present_timer_cb(lv_timer_t *timer)
 {
     (void)timer; // Avoid unused parameter warning
+    present_frame();
+}
+#endif
+
+/* Point the canvas at the newest frame from the render thread, if there is one */
+static void present_frame(void)
+{
+    // Cleared before taking, so a frame published meanwhile queues a new wake-up
+    __atomic_store_n(&frameReadyQueued, false, __ATOMIC_RELEASE);
+
+    render_rect_t changed;
+    uint8_t *frame = render_thread_take_frame(&changed);
+    if (frame == NULL)
+        return;
+
+    // Swap the canvas onto the new frame without lv_canvas_set_buffer, which would
+    // invalidate the whole object; only the area that differs gets redrawn
+    lv_draw_buf_t *draw_buf = lv_canvas_get_draw_buf(canvas);
+    draw_buf->data = frame;
+    draw_buf->unaligned_data = frame;
+    lv_image_cache_drop(draw_buf);
+
+    // lv_obj_invalidate_area takes screen coordinates
+    lv_area_t area;
+    lv_obj_get_coords(canvas, &area);
+    area.x2 = area.x1 + changed.x2;
+    area.y2 = area.y1 + changed.y2;
+    area.x1 += changed.x1;
+    area.y1 += changed.y1;
+    lv_obj_invalidate_area(canvas, &area);
+}
+
+/* Scene loader: an actor or its detail levels came in; any thread */
+static void scene_changed_cb(void *arg, int actor)
+{
+    (void)arg;
+    (void)actor;
+    render_state_mark_dirty(RENDER_DIRTY_GEOMETRY);
+}
+
+/* Scene loader: every actor is done; the loading overlay picks this up */
+static void scene_ready_cb(void *arg, int failed)
+{
+    (void)arg;
+    (void)failed;
+    // The mirror draws every loaded actor, so cncvis' copy of their triangles is only dead weight now
+    render_thread_lock_scene();
+    scene_cncvis_release_geometry(sceneMirror);
+    render_thread_unlock_scene();
+    __atomic_store_n(&sceneReadyUs, frame_profiler_now_us(), __ATOMIC_RELEASE);
+}
+
+/* Progress label over the canvas while meshes are still loading */
+static void loading_timer_cb(lv_timer_t *timer)
+{
+    uint64_t readyUs = __atomic_load_n(&sceneReadyUs, __ATOMIC_ACQUIRE);
+    int finished, total;
+
+    if (readyUs == 0)
+    {
+        scene_load_progress(sceneMirror, &finished, &total);
+        lv_label_set_text_fmt(loadingLabel, "Loading parts %d / %d", finished, total);
+        return;
+    }
+
+    scene_loader_join(sceneLoader);
+    sceneLoader = NULL;
+    lv_obj_add_flag(loadingLabel, LV_OBJ_FLAG_HIDDEN);
+    lv_timer_delete(timer);
+
+    const char *start = sceneMirror->cache_dir[0] == '\0' ? "uncached"
+                        : sceneMirror->cache_misses == 0   ? "warm"
+                        : sceneMirror->cache_hits == 0     ? "cold"
+                                                           : "partly warm";
+    // End to end from main(), so cncvis_init counts towards both
+    printf("Startup: first paint after %.1f ms, window live after %.1f ms, scene ready after %.1f ms, "
+           "cncvis_init %.1f ms of it (%s, %d/%d meshes from cache)\n",
+           (double)(firstPaintUs - startUs) / 1000.0, (double)(windowLiveUs - startUs) / 1000.0,
+           (double)(readyUs - startUs) / 1000.0,
+           (double)cncvisInitUs / 1000.0, start, sceneMirror->cache_hits,
+           sceneMirror->cache_hits + sceneMirror->cache_misses);
+}
+
+static void loading_init(void)
+{
+    loadingLabel = lv_label_create(lv_layer_top());
+    lv_obj_set_style_bg_color(loadingLabel, lv_color_hex(0x000000), LV_PART_MAIN);
+    lv_obj_set_style_bg_opa(loadingLabel, LV_OPA_50, LV_PART_MAIN);
+    lv_obj_set_style_text_color(loadingLabel, lv_color_hex(0xFFFFFF), LV_PART_MAIN);
+    lv_obj_set_style_pad_all(loadingLabel, 4, LV_PART_MAIN);
+    lv_obj_align(loadingLabel, LV_ALIGN_BOTTOM_MID, 0, 0);
+    lv_label_set_text(loadingLabel, "Loading machine");
+
+    lv_timer_create(loading_timer_cb, LOADING_PROGRESS_MS, NULL);
+}
+
+/* Times display refreshes and the flushes to SDL within them */
+static void profile_display_cb(lv_event_t *e)
+{
+    switch (lv_event_get_code(e))
+    {
+    case LV_EVENT_REFR_START:
+        displayRefreshed = true;
+        flushSumUs = 0;
+        break;
+    case LV_EVENT_FLUSH_START:
+        flushStartUs = frame_profiler_now_us();
+        break;
+    case LV_EVENT_FLUSH_FINISH:
+        flushSumUs += frame_profiler_lap(&flushStartUs);
+        break;
+    case LV_EVENT_REFR_READY:
+        frame_profiler_record(FRAME_STAGE_FLUSH, flushSumUs);
+        break;
+    default:
+        break;
+    }
+}
+
+static void profile_overlay_cb(lv_timer_t *timer)
+{
+    (void)timer;
+    char text[768];
+    quality_governor_t quality;
+
+    if (lv_obj_has_flag(profileOverlay, LV_OBJ_FLAG_HIDDEN))
+        return;
+    render_thread_get_quality(&quality);
+    int len = quality_governor_format(&quality, text, sizeof(text));
+    if (len > 0 && (size_t)len < sizeof(text) - 1)
+    {
+        text[len++] = '\n';
+        frame_profiler_format(text + len, sizeof(text) - (size_t)len, "\n");
+    }
+    lv_label_set_text(profileOverlay, text);
+}
 
-    // Call render function from cncvis API (moved to cncvis/api.c)
-    cncvis_render();
+static void profile_log_cb(lv_timer_t *timer)
+{
+    (void)timer;
+    char line[512];
+    quality_governor_t quality;
+
+    frame_profiler_format(line, sizeof(line), " | ");
+    printf("Profile [ms p50/p95/p99/max]: %s\n", line);
+    render_thread_get_quality(&quality);
+    quality_governor_format(&quality, line, sizeof(line));
+    printf("Quality: %s, %llu level change(s)\n", line, (unsigned long long)quality.changes);
+}
 
-    // Copy the rendered framebuffer to LVGL's canvas
-    ZB_copyFrameBufferLVGL(globalFramebuffer, (lv_color32_t *)cbuf);
-    lv_obj_invalidate(canvas);
+static void profile_init(lv_display_t *disp)
+{
+    lv_display_add_event_cb(disp, profile_display_cb, LV_EVENT_ALL, NULL);
+
+    profileOverlay = lv_label_create(lv_layer_top());
+    lv_obj_set_style_bg_color(profileOverlay, lv_color_hex(0x000000), LV_PART_MAIN);
+    lv_obj_set_style_bg_opa(profileOverlay, LV_OPA_50, LV_PART_MAIN);
+    lv_obj_set_style_text_color(profileOverlay, lv_color_hex(0xFFFFFF), LV_PART_MAIN);
+    lv_obj_set_style_pad_all(profileOverlay, 4, LV_PART_MAIN);
+    lv_obj_align(profileOverlay, LV_ALIGN_TOP_LEFT, 0, 0);
+    lv_label_set_text(profileOverlay, "");
+
+    lv_timer_create(profile_overlay_cb, PROFILE_OVERLAY_MS, NULL);
+    lv_timer_create(profile_log_cb, PROFILE_LOG_MS, NULL);
+}
+
+/* Relative joint move that also bumps the scene version; call with the scene locked */
+static void jog_joint(int joint, float delta)
+{
+    if (scene_cncvis_update_motion(sceneMirror, joint, delta))
+        render_state_mark_dirty(RENDER_DIRTY_MOTION);
+}
+
+/* Moves the tool `delta` along world axis `axis` keeping its orientation; stays put when out of reach */
+static void jog_cartesian(int axis, float delta)
+{
+    float joints[KINEMATICS_IK_MAX_JOINTS], tool[16];
+    int count;
+
+    if (robotIk == NULL)
+        return;
+    count = kinematics_joint_count(robotChain);
+    for (int j = 0; j < count; j++)
+        scene_cncvis_get_motion(sceneMirror, kinematics_joint_node(robotChain, j), &joints[j]);
+
+    kinematics_forward(robotChain, joints, 1, &tool, NULL);
+    tool[12 + axis] += delta;
+    if (!kinematics_ik_solve(robotIk, tool, joints, joints, NULL))
+        return;
+
+    for (int j = 0; j < count; j++)
+        scene_cncvis_set_motion(sceneMirror, kinematics_joint_node(robotChain, j), joints[j]);
+    render_state_mark_dirty(RENDER_DIRTY_MOTION);
 }
 
 
@@ -177,6 +528,8 @@ static void process_mouse_events(void) {
     static bool is_right_dragging = false;  // Flag for right mouse button drag (optional: add special behavior)
     static bool is_shift_pressed = false;   // Track shift key for modifier combinations
     static bool is_ctrl_pressed = false;    // Track ctrl key for modifier combinations
+    static bool is_wheel_zooming = false;   // Wheel moved within the last INTERACTION_SETTLE_MS
+    static uint32_t last_wheel_tick = 0;
 
     // First, get current mouse state
     int mouse_x, mouse_y;
@@ -194,6 +547,9 @@ static void process_mouse_events(void) {
         }
     }
     
+    // Camera changes below race with the render thread's snapshot otherwise
+    render_thread_lock_scene();
+
     // Process SDL events for keyboard and system events
     SDL_Event event;
     while (SDL_PollEvent(&event)) {
@@ -216,31 +572,36 @@ static void process_mouse_events(void) {
                 // Force immediate update of the view
                 update_camera_matrix(globalCamera);
                 // Force a redraw
-                lv_obj_invalidate(canvas);
+                render_state_mark_dirty(RENDER_DIRTY_CAMERA);
             } else if (event.key.keysym.sym == SDLK_F2) {
                 printf("Setting Top View\n");
                 ucncCameraSetTopView(globalCamera);
                 update_camera_matrix(globalCamera);
-                lv_obj_invalidate(canvas);
+                render_state_mark_dirty(RENDER_DIRTY_CAMERA);
             } else if (event.key.keysym.sym == SDLK_F3) {
                 printf("Setting Right View\n");
                 ucncCameraSetRightView(globalCamera);
                 update_camera_matrix(globalCamera);
-                lv_obj_invalidate(canvas);
+                render_state_mark_dirty(RENDER_DIRTY_CAMERA);
             } else if (event.key.keysym.sym == SDLK_F4) {
                 printf("Setting Isometric View\n");
                 ucncCameraSetIsometricView(globalCamera);
                 update_camera_matrix(globalCamera);
-                lv_obj_invalidate(canvas);
+                render_state_mark_dirty(RENDER_DIRTY_CAMERA);
             } else if (event.key.keysym.sym == SDLK_F5) {
                 printf("Resetting View\n");
                 ucncCameraResetView(globalCamera);
                 update_camera_matrix(globalCamera);
-                lv_obj_invalidate(canvas);
+                render_state_mark_dirty(RENDER_DIRTY_CAMERA);
+            } else if (event.key.keysym.sym == SDLK_F9) {
+                if (lv_obj_has_flag(profileOverlay, LV_OBJ_FLAG_HIDDEN))
+                    lv_obj_remove_flag(profileOverlay, LV_OBJ_FLAG_HIDDEN);
+                else
+                    lv_obj_add_flag(profileOverlay, LV_OBJ_FLAG_HIDDEN);
             } else if (event.key.keysym.sym == SDLK_SPACE) {
                 printf("Toggling Projection Mode\n");
                 ucncCameraToggleProjection(globalCamera);
-                lv_obj_invalidate(canvas);
+                render_state_mark_dirty(RENDER_DIRTY_CAMERA);
             }
         }
         else if (event.type == SDL_KEYUP) {
@@ -254,10 +615,29 @@ static void process_mouse_events(void) {
         else if (event.type == SDL_QUIT) {
             exit(0);
         }
+        else if (event.type == SDL_WINDOWEVENT) {
+            // Stop rendering while the window can't be seen
+            switch (event.window.event) {
+            case SDL_WINDOWEVENT_HIDDEN:
+            case SDL_WINDOWEVENT_MINIMIZED:
+                render_state_set_visible(false);
+                break;
+            case SDL_WINDOWEVENT_SHOWN:
+            case SDL_WINDOWEVENT_RESTORED:
+            case SDL_WINDOWEVENT_MAXIMIZED:
+                render_state_set_visible(true);
+                break;
+            default:
+                break;
+            }
+        }
         else if (event.type == SDL_MOUSEWHEEL && is_over_canvas) {
             // Use the dedicated wheel handler for CAD-like zoom
             float wheel_sensitivity = is_shift_pressed ? 1.0f : 3.0f;
             ucncCameraHandleMouseWheel(globalCamera, event.wheel.y * wheel_sensitivity);
+            render_state_mark_dirty(RENDER_DIRTY_CAMERA);
+            is_wheel_zooming = true;
+            last_wheel_tick = lv_tick_get();
         }
 
         // LVGL will get events through its input drivers
@@ -314,16 +694,19 @@ static void process_mouse_events(void) {
                     // Middle button: Rotate the camera view (orbit around target)
                     float sensitivity = is_shift_pressed ? 0.125f : 0.5f;
                     ucncCameraOrbit(globalCamera, dx * sensitivity, dy * sensitivity);
+                    render_state_mark_dirty(RENDER_DIRTY_CAMERA);
                 } 
                 else if (is_left_dragging) {
                     // Left button: Pan the view
                     float pan_sensitivity = is_shift_pressed ? 0.5f : 2.0f;
                     ucncCameraPan(globalCamera, dx * pan_sensitivity, dy * pan_sensitivity);
+                    render_state_mark_dirty(RENDER_DIRTY_CAMERA);
                 }
                 else if (is_right_dragging) {
                     // Right button: Zoom
                     float zoom_factor = is_shift_pressed ? 1.0f : 4.0f;
                     ucncCameraZoom(globalCamera, -dy * zoom_factor * 0.1f);
+                    render_state_mark_dirty(RENDER_DIRTY_CAMERA);
                 }
             }
             
@@ -332,45 +715,80 @@ static void process_mouse_events(void) {
             lastMouseY = mouse_y;
         }
     }
+
+    // Render at reduced resolution while the camera is being dragged or zoomed; the wheel
+    // has no release, so zooming ends once it has been still for INTERACTION_SETTLE_MS
+    if (is_wheel_zooming && lv_tick_elaps(last_wheel_tick) > INTERACTION_SETTLE_MS)
+        is_wheel_zooming = false;
+    render_state_set_interacting(is_left_dragging || is_middle_dragging || is_right_dragging || is_wheel_zooming);
     
-    // Let LVGL process its timers and input handling
-    lv_timer_handler();
+    render_thread_unlock_scene();
 
     // Debug output (reduced frequency)
     static int debug_counter = 0;
     if (debug_counter++ % 60 == 0) { // Only print every 60 frames
+        render_stats_t stats;
+        render_thread_stats_t frames;
+        render_state_get_stats(&stats);
+        render_thread_get_stats(&frames);
+        render_thread_lock_scene();
         printCameraDetails(globalCamera);
+        render_thread_unlock_scene();
+        printf("Render: %llu frames rendered, %llu skipped; %llu full, %llu partial (avg %llu px), %llu scaled\n",
+               (unsigned long long)stats.frames_rendered, (unsigned long long)stats.frames_skipped,
+               (unsigned long long)frames.full_frames, (unsigned long long)frames.rect_frames,
+               (unsigned long long)(frames.rect_frames ? frames.rect_pixels / frames.rect_frames : 0),
+               (unsigned long long)frames.scaled_frames);
+        printf("Frames: %llu published, %llu presented, %llu dropped, %llu duplicated\n",
+               (unsigned long long)frames.published, (unsigned long long)frames.presented,
+               (unsigned long long)frames.dropped, (unsigned long long)frames.duplicated);
+        printf("Culling: %u actors culled last frame, %llu in total\n", (unsigned)frames.culled_last,
+               (unsigned long long)frames.culled_actors);
+        printf("Transforms: %u world matrices recomputed last frame, %llu in total\n",
+               (unsigned)frames.matrices_last, (unsigned long long)frames.matrices);
+        if (sceneCollision)
+            printf("Collisions: %u colliding pairs in the newest frame\n", (unsigned)frames.collisions);
     }
 }
 
 
-// Function definitions for keyboard events
-static void process_keyboard_events(void) {
+// Function definitions for keyboard events; returns true while a key that repeats is held
+static bool process_keyboard_events(void) {
 
     const Uint8 *state = SDL_GetKeyboardState(NULL);
+    bool held = false;
 
     // Loop through number keys 1 to 6 and corresponding links link1 to link6
-    for (int i = 1; i <= 6; i++) {
-        // Create the assembly name dynamically (e.g., "link1", "link2", etc.)
-        char assemblyName[10];
-        snprintf(assemblyName, sizeof(assemblyName), "link%d", i);
-
+    for (int i = 1; i <= JOG_LINKS; i++) {
         // Check if the corresponding number key (1 to 6) is being held
         bool isLinkSelected = state[SDL_SCANCODE_1 + (i - 1)]; // SDL_SCANCODE_1 maps to '1'
 
         if (isLinkSelected) {
+            held = held || state[SDL_SCANCODE_UP] || state[SDL_SCANCODE_DOWN];
             // Move the corresponding link with up/down arrows
             if (state[SDL_SCANCODE_UP]) {
                 // Move link up (positive motion)
-                ucncUpdateMotionByName(assemblyName, 1.0f);  // Increase motion value
+                jog_joint(linkJoints[i - 1], 1.0f);  // Increase motion value
             }
             if (state[SDL_SCANCODE_DOWN]) {
                 // Move link down (negative motion)
-                ucncUpdateMotionByName(assemblyName, -1.0f);  // Decrease motion value
+                jog_joint(linkJoints[i - 1], -1.0f);  // Decrease motion value
             }
         }
     }
 
+    // Hold X, Y or Z and use up/down arrows to move the tool along that world axis
+    static const SDL_Scancode cartesianKeys[3] = { SDL_SCANCODE_X, SDL_SCANCODE_Y, SDL_SCANCODE_Z };
+    for (int axis = 0; axis < 3; axis++) {
+        if (state[cartesianKeys[axis]]) {
+            held = held || state[SDL_SCANCODE_UP] || state[SDL_SCANCODE_DOWN];
+            if (state[SDL_SCANCODE_UP])
+                jog_cartesian(axis, CARTESIAN_JOG_STEP);
+            if (state[SDL_SCANCODE_DOWN])
+                jog_cartesian(axis, -CARTESIAN_JOG_STEP);
+        }
+    }
+
     // CAD-like camera movement - using the target-based orbit system
     float moveSpeed = 5.0f;
     
@@ -381,6 +799,8 @@ static void process_keyboard_events(void) {
     
     // Handle camera movement with WASD, QE
     // This is now more CAD-like, moving relative to camera view
+    held = held || state[SDL_SCANCODE_W] || state[SDL_SCANCODE_S] || state[SDL_SCANCODE_A] ||
+           state[SDL_SCANCODE_D] || state[SDL_SCANCODE_Q] || state[SDL_SCANCODE_E];
     if (state[SDL_SCANCODE_W]) {
         // Move target point forward (along camera direction)
         float dx = globalCamera->directionX * moveSpeed;
@@ -435,4 +855,9 @@ static void process_keyboard_events(void) {
                            globalCamera->targetY - globalCamera->upY * moveSpeed,
                            globalCamera->targetZ - globalCamera->upZ * moveSpeed);
     }
+    if (state[SDL_SCANCODE_W] || state[SDL_SCANCODE_S] || state[SDL_SCANCODE_A] || state[SDL_SCANCODE_D] ||
+        state[SDL_SCANCODE_Q] || state[SDL_SCANCODE_E])
+        render_state_mark_dirty(RENDER_DIRTY_CAMERA);
+
+    return held;
 }
@@ -5,6 +5,21 @@
 #define CANVAS_WIDTH 512
 #define CANVAS_HEIGHT 384
 
+#define MAIN_LOOP_MAX_WAIT_MS 500       /* Longest idle sleep when no LVGL timer is due */
+#define KEY_REPEAT_MS 16                /* Poll interval while jog/move keys are held */
+#define JOG_LINKS 6                     /* Keys 1-6 jog assemblies link1..link6 */
+#define CARTESIAN_JOG_STEP 1.0f         /* Tool travel per key repeat of X/Y/Z + arrows, model units */
+#define INTERACTION_SCALE_DEFAULT 0.5f  /* Resolution fraction while dragging or wheel-zooming */
+#define INTERACTION_SETTLE_MS 150       /* Wheel idle time that ends a zoom */
+#define RENDER_TARGET_FPS_DEFAULT 30.0f /* Frame rate the quality governor holds */
+#define PROFILE_OVERLAY_MS 500          /* Refresh period of the frame profiler overlay */
+#define PROFILE_LOG_MS 5000             /* Period of the frame profiler log line */
+#define MESH_CACHE_DIR_DEFAULT "cache"  /* Preprocessed mesh cache, relative to the working dir */
+#define SCENE_LOAD_THREADS_DEFAULT 0    /* Mesh loader threads, 0 = one per CPU */
+#define SCENE_ASYNC_LOAD_DEFAULT 1      /* Load meshes behind a live window, 0 = before the first frame */
+#define LOADING_PROGRESS_MS 100         /* Refresh period of the loading progress label */
+#define COLLISION_CHECKS_DEFAULT 1      /* Check actors for contact after each motion update, 0 = off */
+
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
@@ -24,15 +39,36 @@
 #include "../../cncvis/api.h"
 
 #include "app.h"
+#include "render/frame_profiler.h"
+#include "render/pixconv.h"
+#include "render/render_state.h"
+#include "render/render_thread.h"
+#include "render/scene_render.h"
+#include "scene/kinematics_ik.h"
+#include "scene/scene_cncvis.h"
+#include "scene/scene_loader.h"
 
 static lv_display_t *hal_init(int32_t w, int32_t h);
-static void render_timer_cb(lv_timer_t *timer);
+static bool canvas_attach_framebuffer(ZBuffer *zb);
+static void frame_ready_cb(void *arg);
+#if LV_USE_OS == LV_OS_FREERTOS
+static void present_timer_cb(lv_timer_t *timer);
+#endif
+static void present_frame(void);
+static void jog_joint(int joint, float delta);
+static void jog_cartesian(int axis, float delta);
+static void profile_display_cb(lv_event_t *e);
+static void profile_overlay_cb(lv_timer_t *timer);
+static void profile_log_cb(lv_timer_t *timer);
+static void profile_init(lv_display_t *disp);
+static void scene_changed_cb(void *arg, int actor);
+static void scene_ready_cb(void *arg, int failed);
+static void loading_timer_cb(lv_timer_t *timer);
+static void loading_init(void);
 static void process_mouse_events(void);
-static void process_keyboard_events(void);
+static bool process_keyboard_events(void);
 extern void freertos_main(void);
 
-void ZB_copyFrameBufferLVGL(ZBuffer *zb, lv_color32_t *lv_buf);
-
 static bool is_dragging = false;
 
 ZBuffer *globalFramebuffer;
@@ -0,0 +1,630 @@
+/**
+ * @file band_raster.c
+ * @brief Chunked triangle setup, ordered binning and per-band rasterization.
+ */
+
+#include "band_raster.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SUBPIXEL_BITS 4
+#define SUBPIXEL_ONE (1 << SUBPIXEL_BITS)
+#define GUARD_BAND 16.0f     /* Clip x/y at 16x the viewport to keep fixed-point coordinates small */
+#define MAX_CLIP_VERTS 12
+#define VERTEX_CACHE_SIZE 64 /* Power of two */
+
+/* A set-up screen-space triangle, oriented so all edge functions are >= 0 inside */
+typedef struct
+{
+    int32_t x[3], y[3];      /* 28.4 fixed point */
+    float fx0, fy0;          /* Vertex 0 in pixels, origin of the depth plane */
+    float z0, dzdx, dzdy;
+    uint32_t color;          /* 0x00RRGGBB */
+    int16_t min_x, max_x;    /* Covered pixel range, already clipped */
+    int16_t min_y, max_y;
+} raster_tri_t;
+
+typedef struct
+{
+    int actor;
+    int first;               /* First source triangle */
+    int count;
+
+    raster_tri_t *tris;      /* Set-up output, reused across frames */
+    int tri_count;
+    int tri_capacity;
+    int *band_counts;        /* Triangles per band, then scatter offsets */
+} raster_chunk_t;
+
+typedef struct
+{
+    raster_tri_t **tris;
+    int count;
+    int capacity;
+} raster_bin_t;
+
+typedef struct
+{
+    float mvp[16];
+    float mv[16];
+    float color[3];
+    bool lit;
+} raster_actor_t;
+
+struct band_raster
+{
+    int width;
+    int height;
+    int viewport_width;      /* Area the view maps to, at most width x height */
+    int viewport_height;
+    int band_count;
+    uint32_t clear_color;
+    bool unlit;
+    worker_pool_t *pool;
+    float *depth;
+
+    raster_chunk_t *chunks;
+    int chunk_count;
+    int chunk_capacity;
+    raster_actor_t *actors;
+    int actor_capacity;
+    raster_bin_t *bins;
+
+    /* Frame parameters */
+    const scene_t *scene;
+    uint8_t *pixels;
+    int stride;
+    pixconv_format_t format;
+    render_rect_t clip;
+};
+
+typedef struct
+{
+    float c[4];              /* Clip-space position */
+} clip_vert_t;
+
+/* Direct-mapped post-transform cache of one chunk, keyed by vertex index */
+typedef struct
+{
+    uint32_t index;          /* UINT32_MAX = empty */
+    unsigned mask;           /* Clip planes the vertex is outside of */
+    clip_vert_t v;
+} vertex_cache_t;
+
+band_raster_t *band_raster_create(int width, int height, int threads)
+{
+    band_raster_t *br = calloc(1, sizeof(*br));
+    if (br == NULL)
+        return NULL;
+
+    br->width = width;
+    br->height = height;
+    br->viewport_width = width;
+    br->viewport_height = height;
+    br->band_count = (height + BAND_RASTER_ROWS - 1) / BAND_RASTER_ROWS;
+    br->depth = malloc((size_t)width * (size_t)height * sizeof(float));
+    br->bins = calloc((size_t)br->band_count, sizeof(raster_bin_t));
+    br->pool = worker_pool_create(threads);
+    if (br->depth == NULL || br->bins == NULL || br->pool == NULL)
+    {
+        band_raster_destroy(br);
+        return NULL;
+    }
+    return br;
+}
+
+void band_raster_destroy(band_raster_t *br)
+{
+    if (br == NULL)
+        return;
+
+    worker_pool_destroy(br->pool);
+    for (int i = 0; i < br->chunk_capacity; i++)
+    {
+        free(br->chunks[i].tris);
+        free(br->chunks[i].band_counts);
+    }
+    if (br->bins)
+    {
+        for (int i = 0; i < br->band_count; i++)
+            free(br->bins[i].tris);
+    }
+    free(br->chunks);
+    free(br->actors);
+    free(br->bins);
+    free(br->depth);
+    free(br);
+}
+
+int band_raster_threads(const band_raster_t *br)
+{
+    return worker_pool_threads(br->pool);
+}
+
+void band_raster_set_clear_color(band_raster_t *br, uint32_t rgb)
+{
+    br->clear_color = rgb & 0xFFFFFFu;
+}
+
+void band_raster_set_lighting(band_raster_t *br, bool lit)
+{
+    br->unlit = !lit;
+}
+
+void band_raster_set_viewport(band_raster_t *br, int width, int height)
+{
+    br->viewport_width = width > 0 && width < br->width ? width : br->width;
+    br->viewport_height = height > 0 && height < br->height ? height : br->height;
+}
+
+/* ---- Stage 1: transform, clip and set up one chunk ---- */
+
+static void transform4(const float m[16], const float *v, float out[4])
+{
+    out[0] = m[0] * v[0] + m[4] * v[1] + m[8] * v[2] + m[12];
+    out[1] = m[1] * v[0] + m[5] * v[1] + m[9] * v[2] + m[13];
+    out[2] = m[2] * v[0] + m[6] * v[1] + m[10] * v[2] + m[14];
+    out[3] = m[3] * v[0] + m[7] * v[1] + m[11] * v[2] + m[15];
+}
+
+static uint32_t shade(const raster_actor_t *a, const float *n)
+{
+    /* Eye-space normal z; the model-view is rigid so no inverse transpose is needed */
+    float nx = a->mv[0] * n[0] + a->mv[4] * n[1] + a->mv[8] * n[2];
+    float ny = a->mv[1] * n[0] + a->mv[5] * n[1] + a->mv[9] * n[2];
+    float nz = a->mv[2] * n[0] + a->mv[6] * n[1] + a->mv[10] * n[2];
+    float len = sqrtf(nx * nx + ny * ny + nz * nz);
+    float k = !a->lit ? 1.0f : BAND_RASTER_AMBIENT + BAND_RASTER_DIFFUSE * (len > 0.0f ? fabsf(nz) / len : 0.0f);
+    uint32_t rgb = 0;
+
+    for (int i = 0; i < 3; i++)
+    {
+        float c = a->color[i] * k;
+        int v = (int)(c * 255.0f + 0.5f);
+        v = v < 0 ? 0 : (v > 255 ? 255 : v);
+        rgb = (rgb << 8) | (uint32_t)v;
+    }
+    return rgb;
+}
+
+/* Plane i of the clip volume: near, far, then the four guard-band sides */
+static float plane_distance(const float *c, int plane)
+{
+    switch (plane)
+    {
+    case 0: return c[2] + c[3];
+    case 1: return c[3] - c[2];
+    case 2: return GUARD_BAND * c[3] - c[0];
+    case 3: return GUARD_BAND * c[3] + c[0];
+    case 4: return GUARD_BAND * c[3] - c[1];
+    default: return GUARD_BAND * c[3] + c[1];
+    }
+}
+
+static int clip_polygon(clip_vert_t *poly, int count, clip_vert_t *scratch)
+{
+    for (int plane = 0; plane < 6 && count >= 3; plane++)
+    {
+        int out = 0;
+        for (int i = 0; i < count; i++)
+        {
+            const float *a = poly[i].c;
+            const float *b = poly[(i + 1) % count].c;
+            float da = plane_distance(a, plane);
+            float db = plane_distance(b, plane);
+
+            if (da >= 0.0f)
+                scratch[out++] = poly[i];
+            if ((da >= 0.0f) != (db >= 0.0f) && out < MAX_CLIP_VERTS)
+            {
+                float t = da / (da - db);
+                for (int k = 0; k < 4; k++)
+                    scratch[out].c[k] = a[k] + t * (b[k] - a[k]);
+                out++;
+            }
+        }
+        memcpy(poly, scratch, (size_t)out * sizeof(*poly));
+        count = out;
+    }
+    return count;
+}
+
+static raster_tri_t *chunk_push(raster_chunk_t *chunk)
+{
+    if (chunk->tri_count == chunk->tri_capacity)
+    {
+        int capacity = chunk->tri_capacity ? chunk->tri_capacity * 2 : chunk->count + 64;
+        raster_tri_t *tris = realloc(chunk->tris, (size_t)capacity * sizeof(*tris));
+        if (tris == NULL)
+            return NULL;
+        chunk->tris = tris;
+        chunk->tri_capacity = capacity;
+    }
+    return &chunk->tris[chunk->tri_count++];
+}
+
+static int32_t to_fixed(float v)
+{
+    return (int32_t)floorf(v * (float)SUBPIXEL_ONE + 0.5f);
+}
+
+/* Smallest pixel whose centre is at or after fixed-point coordinate v */
+static int32_t first_pixel(int32_t v)
+{
+    return -((-(v - SUBPIXEL_ONE / 2)) >> SUBPIXEL_BITS);
+}
+
+/* Largest pixel whose centre is at or before fixed-point coordinate v */
+static int32_t last_pixel(int32_t v)
+{
+    return (v - SUBPIXEL_ONE / 2) >> SUBPIXEL_BITS;
+}
+
+static void setup_triangle(band_raster_t *br, raster_chunk_t *chunk, const clip_vert_t *v0,
+                           const clip_vert_t *v1, const clip_vert_t *v2, uint32_t color)
+{
+    const clip_vert_t *v[3] = { v0, v1, v2 };
+    float sx[3], sy[3], sz[3];
+    int32_t x[3], y[3];
+
+    for (int i = 0; i < 3; i++)
+    {
+        float inv_w = 1.0f / v[i]->c[3];
+        sx[i] = (v[i]->c[0] * inv_w + 1.0f) * 0.5f * (float)br->viewport_width;
+        sy[i] = (1.0f - v[i]->c[1] * inv_w) * 0.5f * (float)br->viewport_height;
+        sz[i] = v[i]->c[2] * inv_w * 0.5f + 0.5f;
+        x[i] = to_fixed(sx[i]);
+        y[i] = to_fixed(sy[i]);
+    }
+
+    int64_t area = (int64_t)(x[1] - x[0]) * (y[2] - y[0]) - (int64_t)(y[1] - y[0]) * (x[2] - x[0]);
+    if (area == 0)
+        return;
+    if (area < 0)
+    {
+        int32_t ti;
+        float tf;
+        ti = x[1]; x[1] = x[2]; x[2] = ti;
+        ti = y[1]; y[1] = y[2]; y[2] = ti;
+        tf = sz[1]; sz[1] = sz[2]; sz[2] = tf;
+        area = -area;
+    }
+
+    int32_t min_x = first_pixel(x[0] < x[1] ? (x[0] < x[2] ? x[0] : x[2]) : (x[1] < x[2] ? x[1] : x[2]));
+    int32_t max_x = last_pixel(x[0] > x[1] ? (x[0] > x[2] ? x[0] : x[2]) : (x[1] > x[2] ? x[1] : x[2]));
+    int32_t min_y = first_pixel(y[0] < y[1] ? (y[0] < y[2] ? y[0] : y[2]) : (y[1] < y[2] ? y[1] : y[2]));
+    int32_t max_y = last_pixel(y[0] > y[1] ? (y[0] > y[2] ? y[0] : y[2]) : (y[1] > y[2] ? y[1] : y[2]));
+
+    if (min_x < br->clip.x1) min_x = br->clip.x1;
+    if (max_x > br->clip.x2) max_x = br->clip.x2;
+    if (min_y < br->clip.y1) min_y = br->clip.y1;
+    if (max_y > br->clip.y2) max_y = br->clip.y2;
+    if (min_x > max_x || min_y > max_y)
+        return;
+
+    raster_tri_t *t = chunk_push(chunk);
+    if (t == NULL)
+        return;
+
+    /* Depth plane in pixel units, from the snapped positions the edges use */
+    float ax = (float)(x[1] - x[0]) / SUBPIXEL_ONE, ay = (float)(y[1] - y[0]) / SUBPIXEL_ONE;
+    float bx = (float)(x[2] - x[0]) / SUBPIXEL_ONE, by = (float)(y[2] - y[0]) / SUBPIXEL_ONE;
+    float det = ax * by - ay * bx;
+    float az = sz[1] - sz[0], bz = sz[2] - sz[0];
+
+    for (int i = 0; i < 3; i++)
+    {
+        t->x[i] = x[i];
+        t->y[i] = y[i];
+    }
+    t->fx0 = (float)x[0] / SUBPIXEL_ONE;
+    t->fy0 = (float)y[0] / SUBPIXEL_ONE;
+    t->z0 = sz[0];
+    t->dzdx = (az * by - bz * ay) / det;
+    t->dzdy = (bz * ax - az * bx) / det;
+    t->color = color;
+    t->min_x = (int16_t)min_x;
+    t->max_x = (int16_t)max_x;
+    t->min_y = (int16_t)min_y;
+    t->max_y = (int16_t)max_y;
+}
+
+static void setup_chunk(void *arg, int index, int worker)
+{
+    band_raster_t *br = (band_raster_t *)arg;
+    raster_chunk_t *chunk = &br->chunks[index];
+    const scene_actor_t *actor = &br->scene->actors[chunk->actor];
+    const raster_actor_t *a = &br->actors[chunk->actor];
+    const mesh_t *mesh = scene_actor_mesh(actor);
+    const uint32_t *indices = mesh->indices + (size_t)chunk->first * 3;
+    vertex_cache_t cache[VERTEX_CACHE_SIZE];
+
+    (void)worker;
+    chunk->tri_count = 0;
+    for (int i = 0; i < VERTEX_CACHE_SIZE; i++)
+        cache[i].index = UINT32_MAX;
+
+    for (int t = 0; t < chunk->count; t++, indices += 3)
+    {
+        clip_vert_t poly[MAX_CLIP_VERTS];
+        clip_vert_t scratch[MAX_CLIP_VERTS];
+        unsigned outside_all = 0x3F;
+        unsigned outside_any = 0;
+        int count = 3;
+
+        for (int i = 0; i < 3; i++)
+        {
+            /* Triangles come in vertex-cache order (mesh.h), so most corners were just transformed */
+            vertex_cache_t *entry = &cache[indices[i] & (VERTEX_CACHE_SIZE - 1)];
+            if (entry->index != indices[i])
+            {
+                float p[3];
+                mesh_vertex(mesh, indices[i], p);
+                transform4(a->mvp, p, entry->v.c);
+                entry->mask = 0;
+                for (int plane = 0; plane < 6; plane++)
+                    entry->mask |= plane_distance(entry->v.c, plane) < 0.0f ? 1u << plane : 0u;
+                entry->index = indices[i];
+            }
+            poly[i] = entry->v;
+            outside_all &= entry->mask;
+            outside_any |= entry->mask;
+        }
+        if (outside_all)
+            continue; /* All three vertices beyond the same plane */
+
+        float n[3];
+        mesh_face_normal(mesh, chunk->first + t, n);
+        uint32_t color = shade(a, n);
+        if (outside_any)
+            count = clip_polygon(poly, 3, scratch);
+
+        for (int i = 1; i + 1 < count; i++)
+            setup_triangle(br, chunk, &poly[0], &poly[i], &poly[i + 1], color);
+    }
+
+    memset(chunk->band_counts, 0, (size_t)br->band_count * sizeof(int));
+    for (int i = 0; i < chunk->tri_count; i++)
+    {
+        const raster_tri_t *t = &chunk->tris[i];
+        for (int b = t->min_y / BAND_RASTER_ROWS; b <= t->max_y / BAND_RASTER_ROWS; b++)
+            chunk->band_counts[b]++;
+    }
+}
+
+/* ---- Stage 2: scatter chunk triangles into ordered band bins ---- */
+
+static void scatter_chunk(void *arg, int index, int worker)
+{
+    band_raster_t *br = (band_raster_t *)arg;
+    raster_chunk_t *chunk = &br->chunks[index];
+
+    (void)worker;
+    /* band_counts now holds this chunk's write offset in each bin */
+    for (int i = 0; i < chunk->tri_count; i++)
+    {
+        raster_tri_t *t = &chunk->tris[i];
+        for (int b = t->min_y / BAND_RASTER_ROWS; b <= t->max_y / BAND_RASTER_ROWS; b++)
+            br->bins[b].tris[chunk->band_counts[b]++] = t;
+    }
+}
+
+/* ---- Stage 3: clear and rasterize one band ---- */
+
+static void put_pixel(uint8_t *row, pixconv_format_t format, int x, uint32_t rgb)
+{
+    if (format == PIXCONV_FMT_RGB565)
+        ((uint16_t *)row)[x] = (uint16_t)(((rgb >> 8) & 0xF800) | ((rgb >> 5) & 0x07E0) | ((rgb >> 3) & 0x001F));
+    else
+        ((uint32_t *)row)[x] = rgb;
+}
+
+static void raster_triangle(band_raster_t *br, const raster_tri_t *t, int y_first, int y_last)
+{
+    int64_t step_x[3], step_y[3], row[3];
+    int bias[3];
+    int32_t px = t->min_x * SUBPIXEL_ONE + SUBPIXEL_ONE / 2;
+    int32_t py = y_first * SUBPIXEL_ONE + SUBPIXEL_ONE / 2;
+
+    for (int e = 0; e < 3; e++)
+    {
+        int a = e, b = (e + 1) % 3;
+        int64_t dx = t->x[b] - t->x[a];
+        int64_t dy = t->y[b] - t->y[a];
+
+        /* Antisymmetric tie rule: a shared edge belongs to exactly one of its triangles */
+        bias[e] = (dy < 0 || (dy == 0 && dx > 0)) ? 0 : -1;
+        step_x[e] = -dy * SUBPIXEL_ONE;
+        step_y[e] = dx * SUBPIXEL_ONE;
+        row[e] = dx * (py - t->y[a]) - dy * (px - t->x[a]) + bias[e];
+    }
+
+    for (int y = y_first; y <= y_last; y++)
+    {
+        uint8_t *line = br->pixels + (size_t)y * (size_t)br->stride;
+        float *depth = br->depth + (size_t)y * (size_t)br->width;
+        float fy = (float)y + 0.5f - t->fy0;
+        int64_t e0 = row[0], e1 = row[1], e2 = row[2];
+
+        for (int x = t->min_x; x <= t->max_x; x++)
+        {
+            if ((e0 | e1 | e2) >= 0)
+            {
+                float z = t->z0 + t->dzdx * ((float)x + 0.5f - t->fx0) + t->dzdy * fy;
+                if (z < depth[x])
+                {
+                    depth[x] = z;
+                    put_pixel(line, br->format, x, t->color);
+                }
+            }
+            e0 += step_x[0];
+            e1 += step_x[1];
+            e2 += step_x[2];
+        }
+
+        row[0] += step_y[0];
+        row[1] += step_y[1];
+        row[2] += step_y[2];
+    }
+}
+
+static void raster_band(void *arg, int index, int worker)
+{
+    band_raster_t *br = (band_raster_t *)arg;
+    const raster_bin_t *bin = &br->bins[index];
+    int y_first = index * BAND_RASTER_ROWS;
+    int y_last = y_first + BAND_RASTER_ROWS - 1;
+
+    (void)worker;
+    if (y_first < br->clip.y1) y_first = br->clip.y1;
+    if (y_last > br->clip.y2) y_last = br->clip.y2;
+    if (y_first > y_last)
+        return;
+
+    for (int y = y_first; y <= y_last; y++)
+    {
+        uint8_t *line = br->pixels + (size_t)y * (size_t)br->stride;
+        float *depth = br->depth + (size_t)y * (size_t)br->width;
+        for (int x = br->clip.x1; x <= br->clip.x2; x++)
+        {
+            depth[x] = FLT_MAX;
+            put_pixel(line, br->format, x, br->clear_color);
+        }
+    }
+
+    for (int i = 0; i < bin->count; i++)
+    {
+        const raster_tri_t *t = bin->tris[i];
+        int first = t->min_y > y_first ? t->min_y : y_first;
+        int last = t->max_y < y_last ? t->max_y : y_last;
+        if (first <= last)
+            raster_triangle(br, t, first, last);
+    }
+}
+
+/* ---- Frame ---- */
+
+static bool prepare_chunks(band_raster_t *br, const scene_t *scene)
+{
+    int count = 0;
+
+    for (int i = 0; i < scene->actor_count; i++)
+    {
+        if (scene->actors[i].visible)
+            count += (scene_actor_mesh(&scene->actors[i])->triangle_count + BAND_RASTER_CHUNK - 1) / BAND_RASTER_CHUNK;
+    }
+
+    if (count > br->chunk_capacity)
+    {
+        raster_chunk_t *chunks = realloc(br->chunks, (size_t)count * sizeof(*chunks));
+        if (chunks == NULL)
+            return false;
+        memset(chunks + br->chunk_capacity, 0, (size_t)(count - br->chunk_capacity) * sizeof(*chunks));
+        for (int i = br->chunk_capacity; i < count; i++)
+            chunks[i].band_counts = calloc((size_t)br->band_count, sizeof(int));
+        br->chunks = chunks;
+        br->chunk_capacity = count;
+    }
+
+    if (scene->actor_count > br->actor_capacity)
+    {
+        raster_actor_t *actors = realloc(br->actors, (size_t)scene->actor_count * sizeof(*actors));
+        if (actors == NULL)
+            return false;
+        br->actors = actors;
+        br->actor_capacity = scene->actor_count;
+    }
+
+    count = 0;
+    for (int i = 0; i < scene->actor_count; i++)
+    {
+        int tris = scene->actors[i].visible ? scene_actor_mesh(&scene->actors[i])->triangle_count : 0;
+        for (int first = 0; first < tris; first += BAND_RASTER_CHUNK)
+        {
+            raster_chunk_t *chunk = &br->chunks[count++];
+            if (chunk->band_counts == NULL)
+                return false;
+            chunk->actor = i;
+            chunk->first = first;
+            chunk->count = tris - first < BAND_RASTER_CHUNK ? tris - first : BAND_RASTER_CHUNK;
+        }
+    }
+    br->chunk_count = count;
+    return true;
+}
+
+/* Turns per-chunk band counts into write offsets and sizes the bins */
+static bool prepare_bins(band_raster_t *br)
+{
+    for (int b = 0; b < br->band_count; b++)
+    {
+        raster_bin_t *bin = &br->bins[b];
+        int total = 0;
+
+        for (int c = 0; c < br->chunk_count; c++)
+        {
+            int n = br->chunks[c].band_counts[b];
+            br->chunks[c].band_counts[b] = total;
+            total += n;
+        }
+
+        if (total > bin->capacity)
+        {
+            raster_tri_t **tris = realloc(bin->tris, (size_t)total * sizeof(*tris));
+            if (tris == NULL)
+                return false;
+            bin->tris = tris;
+            bin->capacity = total;
+        }
+        bin->count = total;
+    }
+    return true;
+}
+
+void band_raster_draw(band_raster_t *br, const scene_t *scene, const float view_proj[16],
+                      const float view[16], void *pixels, int stride, pixconv_format_t format,
+                      const render_rect_t *clip)
+{
+    br->scene = scene;
+    br->pixels = (uint8_t *)pixels;
+    br->stride = stride;
+    br->format = format == PIXCONV_FMT_RGB565 ? PIXCONV_FMT_RGB565 : PIXCONV_FMT_XRGB8888;
+    br->clip.x1 = 0;
+    br->clip.y1 = 0;
+    br->clip.x2 = br->viewport_width - 1;
+    br->clip.y2 = br->viewport_height - 1;
+    if (clip)
+    {
+        if (clip->x1 > br->clip.x1) br->clip.x1 = clip->x1;
+        if (clip->y1 > br->clip.y1) br->clip.y1 = clip->y1;
+        if (clip->x2 < br->clip.x2) br->clip.x2 = clip->x2;
+        if (clip->y2 < br->clip.y2) br->clip.y2 = clip->y2;
+        if (br->clip.x1 > br->clip.x2 || br->clip.y1 > br->clip.y2)
+            return;
+    }
+
+    if (!prepare_chunks(br, scene))
+        return;
+
+    for (int i = 0; i < scene->actor_count; i++)
+    {
+        const scene_actor_t *actor = &scene->actors[i];
+        raster_actor_t *a = &br->actors[i];
+        float model[16];
+
+        mat4_mul(model, scene->nodes[actor->node].world, actor->local);
+        mat4_mul(a->mvp, view_proj, model);
+        mat4_mul(a->mv, view, model);
+        memcpy(a->color, scene_actor_color(actor), sizeof(a->color));
+        a->lit = !br->unlit;
+    }
+
+    worker_pool_run(br->pool, setup_chunk, br, br->chunk_count);
+    if (!prepare_bins(br))
+        return;
+    worker_pool_run(br->pool, scatter_chunk, br, br->chunk_count);
+    worker_pool_run(br->pool, raster_band, br, br->band_count);
+}
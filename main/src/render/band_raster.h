@@ -0,0 +1,77 @@
+/**
+ * @file band_raster.h
+ * @brief Band-parallel triangle rasterizer for the scene mirror.
+ *
+ * An alternative to TinyGL's single-threaded rasterizer for dense models.
+ * The frame is cut into horizontal bands of BAND_RASTER_ROWS rows:
+ *
+ *   1. Triangles are transformed, clipped and set up in fixed-size chunks,
+ *      one chunk per job.
+ *   2. Each chunk scatters its triangles into the bins of the bands they
+ *      touch, at offsets from a prefix sum, so every bin lists its triangles
+ *      in submission order no matter which worker produced them.
+ *   3. Each band is cleared and rasterized by one worker.
+ *
+ * Edge functions are exact 28.4 fixed-point integers and depth is evaluated
+ * from the triangle's plane equation at each pixel centre, so a pixel's value
+ * never depends on where its band starts or which thread drew it: the output
+ * is bit-identical for any worker count, including the 1-thread path.
+ *
+ * Not used by the app or by headless, only by raster_bench: it doesn't
+ * reproduce the TinyGL frame. Shading is flat with a headlight (ambient +
+ * |N.V| diffuse per triangle) rather than the cncvis lights and materials,
+ * which ucncLightApply hands straight to TinyGL and TinyGL can't report
+ * back (no glGetLight/glGetMaterial). Its fill and depth rules aren't
+ * TinyGL's either, so even under the same headlight edge pixels differ;
+ * raster_bench reports by how much. Its thread scaling has only been
+ * measured on a single CPU so far.
+ */
+
+#ifndef BAND_RASTER_H
+#define BAND_RASTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../scene/scene.h"
+#include "../sys/worker_pool.h"
+#include "pixconv.h"
+#include "render_rect.h"
+
+#define BAND_RASTER_ROWS 16           /* Rows per band */
+#define BAND_RASTER_CHUNK 4096        /* Source triangles per setup job */
+#define BAND_RASTER_AMBIENT 0.25f     /* Headlight shading: ambient + diffuse * |N.V| */
+#define BAND_RASTER_DIFFUSE 0.75f
+
+typedef struct band_raster band_raster_t;
+
+/* threads as for worker_pool_create(): 0 = one per CPU, 1 = run inline */
+band_raster_t *band_raster_create(int width, int height, int threads);
+void band_raster_destroy(band_raster_t *br);
+
+int band_raster_threads(const band_raster_t *br);
+
+/* 0x00RRGGBB */
+void band_raster_set_clear_color(band_raster_t *br, uint32_t rgb);
+
+/* false: flat actor colours without the headlight */
+void band_raster_set_lighting(band_raster_t *br, bool lit);
+
+/*
+ * Maps the view onto the top-left width x height pixels, e.g. for a reduced
+ * resolution frame that is upscaled afterwards. Clamped to the size given at
+ * creation; 0 x 0 restores the full size.
+ */
+void band_raster_set_viewport(band_raster_t *br, int width, int height);
+
+/*
+ * Clears and draws the actors of `scene` with `visible` set, at the detail
+ * level in their `lod`, into `pixels` (RGB565 or XRGB8888, `stride` bytes
+ * per row). Only `clip` is touched when it is not NULL. view_proj and view
+ * are column-major like glGetFloatv returns them.
+ */
+void band_raster_draw(band_raster_t *br, const scene_t *scene, const float view_proj[16],
+                      const float view[16], void *pixels, int stride, pixconv_format_t format,
+                      const render_rect_t *clip);
+
+#endif // BAND_RASTER_H
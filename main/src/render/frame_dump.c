@@ -0,0 +1,252 @@
+/**
+ * @file frame_dump.c
+ * @brief PPM, stored-deflate PNG and raw RGB frame writers.
+ */
+
+#include "frame_dump.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define PNG_STORED_BLOCK 65535
+
+bool frame_dump_parse_format(const char *name, frame_dump_format_t *format)
+{
+    if (strcmp(name, "ppm") == 0)
+        *format = FRAME_DUMP_PPM;
+    else if (strcmp(name, "png") == 0)
+        *format = FRAME_DUMP_PNG;
+    else if (strcmp(name, "raw") == 0)
+        *format = FRAME_DUMP_RAW;
+    else
+        return false;
+    return true;
+}
+
+bool frame_dump_open(frame_dump_t *dump, frame_dump_format_t format, const char *target,
+                     int width, int height)
+{
+    memset(dump, 0, sizeof(*dump));
+    dump->format = format;
+    dump->target = target;
+    dump->width = width;
+    dump->height = height;
+    dump->rgb = malloc((size_t)width * (size_t)height * 3);
+    if (dump->rgb == NULL)
+        return false;
+
+    if (format == FRAME_DUMP_RAW)
+    {
+        dump->stream = strcmp(target, "-") == 0 ? stdout : fopen(target, "wb");
+        if (dump->stream == NULL)
+        {
+            fprintf(stderr, "frame_dump: cannot open '%s'\n", target);
+            free(dump->rgb);
+            dump->rgb = NULL;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool frame_dump_open_stream(frame_dump_t *dump, FILE *stream, int width, int height)
+{
+    memset(dump, 0, sizeof(*dump));
+    dump->format = FRAME_DUMP_RAW;
+    dump->target = "-";
+    dump->width = width;
+    dump->height = height;
+    dump->stream = stream;
+    dump->borrowed = true;
+    dump->rgb = malloc((size_t)width * (size_t)height * 3);
+    return dump->rgb != NULL;
+}
+
+void frame_dump_close(frame_dump_t *dump)
+{
+    if (dump->stream && (dump->borrowed || dump->stream == stdout))
+        fflush(dump->stream);
+    else if (dump->stream)
+        fclose(dump->stream);
+    free(dump->rgb);
+    memset(dump, 0, sizeof(*dump));
+}
+
+/* Any format to packed R, G, B bytes */
+static bool to_rgb(frame_dump_t *dump, const void *src, int stride, pixconv_format_t src_fmt)
+{
+    uint32_t *row = malloc((size_t)dump->width * sizeof(uint32_t));
+    uint8_t *out = dump->rgb;
+
+    if (row == NULL)
+        return false;
+
+    for (int y = 0; y < dump->height; y++)
+    {
+        pixconv_convert(row, dump->width * 4, PIXCONV_FMT_XRGB8888,
+                        (const uint8_t *)src + (size_t)y * (size_t)stride, stride, src_fmt, dump->width, 1);
+        for (int x = 0; x < dump->width; x++)
+        {
+            *out++ = (uint8_t)(row[x] >> 16);
+            *out++ = (uint8_t)(row[x] >> 8);
+            *out++ = (uint8_t)row[x];
+        }
+    }
+    free(row);
+    return true;
+}
+
+static uint32_t crc_table[256];
+
+static uint32_t crc32_update(uint32_t crc, const uint8_t *data, size_t size)
+{
+    if (crc_table[1] == 0)
+    {
+        for (uint32_t n = 0; n < 256; n++)
+        {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            crc_table[n] = c;
+        }
+    }
+    for (size_t i = 0; i < size; i++)
+        crc = crc_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
+
+static void put_be32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+/* Chunk header and type; the CRC covers the type and the data that follows */
+static uint32_t png_chunk_begin(FILE *fp, const char *type, uint32_t length)
+{
+    uint8_t header[8];
+
+    put_be32(header, length);
+    memcpy(header + 4, type, 4);
+    fwrite(header, 1, 8, fp);
+    return crc32_update(0xFFFFFFFFu, header + 4, 4);
+}
+
+static uint32_t png_chunk_data(FILE *fp, uint32_t crc, const uint8_t *data, size_t size)
+{
+    fwrite(data, 1, size, fp);
+    return crc32_update(crc, data, size);
+}
+
+static void png_chunk_end(FILE *fp, uint32_t crc)
+{
+    uint8_t tail[4];
+
+    put_be32(tail, crc ^ 0xFFFFFFFFu);
+    fwrite(tail, 1, 4, fp);
+}
+
+static bool write_png(FILE *fp, const frame_dump_t *dump)
+{
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    size_t row_bytes = (size_t)dump->width * 3 + 1; /* Filter byte + RGB */
+    size_t raw_size = row_bytes * (size_t)dump->height;
+    size_t blocks = (raw_size + PNG_STORED_BLOCK - 1) / PNG_STORED_BLOCK;
+    uint8_t ihdr[13];
+    uint32_t crc;
+    uint32_t adler_a = 1, adler_b = 0;
+    size_t done = 0;
+    uint8_t *chunk = malloc(PNG_STORED_BLOCK);
+
+    if (chunk == NULL)
+        return false;
+
+    fwrite(signature, 1, sizeof(signature), fp);
+
+    put_be32(ihdr, (uint32_t)dump->width);
+    put_be32(ihdr + 4, (uint32_t)dump->height);
+    ihdr[8] = 8;  /* Bit depth */
+    ihdr[9] = 2;  /* Truecolour */
+    ihdr[10] = 0; /* Deflate */
+    ihdr[11] = 0; /* Adaptive filtering */
+    ihdr[12] = 0; /* No interlace */
+    crc = png_chunk_begin(fp, "IHDR", sizeof(ihdr));
+    png_chunk_end(fp, png_chunk_data(fp, crc, ihdr, sizeof(ihdr)));
+
+    /* zlib stream: header, stored blocks of filter-0 rows, Adler-32 */
+    crc = png_chunk_begin(fp, "IDAT", (uint32_t)(2 + blocks * 5 + raw_size + 4));
+    {
+        static const uint8_t zlib_header[2] = { 0x78, 0x01 };
+        crc = png_chunk_data(fp, crc, zlib_header, 2);
+    }
+    while (done < raw_size)
+    {
+        size_t len = raw_size - done < PNG_STORED_BLOCK ? raw_size - done : PNG_STORED_BLOCK;
+        uint8_t block[5];
+
+        block[0] = done + len == raw_size ? 1 : 0;
+        block[1] = (uint8_t)len;
+        block[2] = (uint8_t)(len >> 8);
+        block[3] = (uint8_t)~len;
+        block[4] = (uint8_t)(~len >> 8);
+        crc = png_chunk_data(fp, crc, block, 5);
+
+        for (size_t i = 0; i < len; i++)
+        {
+            size_t y = (done + i) / row_bytes, x = (done + i) % row_bytes;
+            chunk[i] = x == 0 ? 0 : dump->rgb[y * (row_bytes - 1) + x - 1];
+            adler_a = (adler_a + chunk[i]) % 65521u;
+            adler_b = (adler_b + adler_a) % 65521u;
+        }
+        crc = png_chunk_data(fp, crc, chunk, len);
+        done += len;
+    }
+    {
+        uint8_t adler[4];
+        put_be32(adler, (adler_b << 16) | adler_a);
+        crc = png_chunk_data(fp, crc, adler, 4);
+    }
+    png_chunk_end(fp, crc);
+
+    crc = png_chunk_begin(fp, "IEND", 0);
+    png_chunk_end(fp, crc);
+    free(chunk);
+    return ferror(fp) == 0;
+}
+
+bool frame_dump_write(frame_dump_t *dump, const void *src, int stride, pixconv_format_t src_fmt)
+{
+    size_t size = (size_t)dump->width * (size_t)dump->height * 3;
+    bool ok;
+
+    if (!to_rgb(dump, src, stride, src_fmt))
+        return false;
+
+    if (dump->format == FRAME_DUMP_RAW)
+    {
+        dump->frame++;
+        return fwrite(dump->rgb, 1, size, dump->stream) == size;
+    }
+
+    char path[512];
+    snprintf(path, sizeof(path), dump->target, dump->frame++);
+    FILE *fp = fopen(path, "wb");
+    if (fp == NULL)
+    {
+        fprintf(stderr, "frame_dump: cannot open '%s'\n", path);
+        return false;
+    }
+
+    if (dump->format == FRAME_DUMP_PPM)
+    {
+        fprintf(fp, "P6\n%d %d\n255\n", dump->width, dump->height);
+        ok = fwrite(dump->rgb, 1, size, fp) == size;
+    }
+    else
+    {
+        ok = write_png(fp, dump);
+    }
+    return fclose(fp) == 0 && ok;
+}
@@ -0,0 +1,54 @@
+/**
+ * @file frame_dump.h
+ * @brief Writes rendered frames as PPM/PNG image sequences or a raw RGB stream.
+ *
+ * Image sequences take a printf pattern with one integer conversion for the
+ * frame number ("out/frame_%05d.png"). The raw stream writes packed 8-bit
+ * RGB frames back to back into one file, or stdout for "-", e.g. to pipe
+ * into `ffmpeg -f rawvideo -pixel_format rgb24 -video_size WxH -i -`.
+ *
+ * PNGs are written with stored (uncompressed) deflate blocks, so there is no
+ * zlib dependency; they are valid but as large as the raw data.
+ */
+
+#ifndef FRAME_DUMP_H
+#define FRAME_DUMP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "pixconv.h"
+
+typedef enum
+{
+    FRAME_DUMP_PPM,
+    FRAME_DUMP_PNG,
+    FRAME_DUMP_RAW
+} frame_dump_format_t;
+
+typedef struct
+{
+    frame_dump_format_t format;
+    const char *target;   /* Pattern for PPM/PNG, path or "-" for RAW */
+    int width;
+    int height;
+    int frame;            /* Number of the next frame */
+    FILE *stream;         /* RAW only */
+    bool borrowed;        /* stream belongs to the caller */
+    uint8_t *rgb;         /* One frame of packed RGB */
+} frame_dump_t;
+
+/* Parses "ppm", "png" or "raw" */
+bool frame_dump_parse_format(const char *name, frame_dump_format_t *format);
+
+bool frame_dump_open(frame_dump_t *dump, frame_dump_format_t format, const char *target,
+                     int width, int height);
+/* RAW into a stream the caller owns and closes */
+bool frame_dump_open_stream(frame_dump_t *dump, FILE *stream, int width, int height);
+void frame_dump_close(frame_dump_t *dump);
+
+/* Converts and writes one frame; src is any pixconv format with `stride` bytes per row */
+bool frame_dump_write(frame_dump_t *dump, const void *src, int stride, pixconv_format_t src_fmt);
+
+#endif // FRAME_DUMP_H
@@ -0,0 +1,109 @@
+/**
+ * @file frame_profiler.c
+ * @brief Rolling per-stage sample windows and percentile queries.
+ */
+
+#include "frame_profiler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct
+{
+    uint64_t next; /* Total samples; next % FRAME_PROFILER_WINDOW is the slot to write */
+    uint32_t samples[FRAME_PROFILER_WINDOW];
+} stage_ring_t;
+
+static stage_ring_t rings[FRAME_STAGE_COUNT];
+
+static const char *const stage_names[FRAME_STAGE_COUNT] = {
+    "sync", "transform", "raster", "copy", "render", "lvgl", "flush",
+};
+
+const char *frame_profiler_stage_name(frame_stage_t stage)
+{
+    return stage < FRAME_STAGE_COUNT ? stage_names[stage] : "?";
+}
+
+void frame_profiler_record(frame_stage_t stage, uint32_t us)
+{
+    stage_ring_t *ring = &rings[stage];
+    uint64_t slot = __atomic_load_n(&ring->next, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&ring->samples[slot % FRAME_PROFILER_WINDOW], us, __ATOMIC_RELAXED);
+    __atomic_store_n(&ring->next, slot + 1, __ATOMIC_RELEASE);
+}
+
+void frame_profiler_reset(void)
+{
+    for (int i = 0; i < FRAME_STAGE_COUNT; i++)
+        __atomic_store_n(&rings[i].next, 0, __ATOMIC_RELEASE);
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+/* Nearest-rank percentile of a sorted window */
+static uint32_t percentile(const uint32_t *sorted, uint32_t count, uint32_t pct)
+{
+    uint32_t rank = (count * pct + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+void frame_profiler_get(frame_stage_t stage, frame_stage_stats_t *stats)
+{
+    const stage_ring_t *ring = &rings[stage];
+    uint32_t sorted[FRAME_PROFILER_WINDOW];
+    uint64_t next = __atomic_load_n(&ring->next, __ATOMIC_ACQUIRE);
+
+    memset(stats, 0, sizeof(*stats));
+    stats->count = next;
+    if (next == 0)
+        return;
+
+    /* A sample written while copying only shifts the window by one */
+    stats->window = next < FRAME_PROFILER_WINDOW ? (uint32_t)next : FRAME_PROFILER_WINDOW;
+    for (uint32_t i = 0; i < stats->window; i++)
+        sorted[i] = __atomic_load_n(&ring->samples[i], __ATOMIC_RELAXED);
+    stats->last_us = __atomic_load_n(&ring->samples[(next - 1) % FRAME_PROFILER_WINDOW], __ATOMIC_RELAXED);
+
+    qsort(sorted, stats->window, sizeof(sorted[0]), compare_u32);
+    stats->p50_us = percentile(sorted, stats->window, 50);
+    stats->p95_us = percentile(sorted, stats->window, 95);
+    stats->p99_us = percentile(sorted, stats->window, 99);
+    stats->max_us = sorted[stats->window - 1];
+}
+
+int frame_profiler_format(char *buf, size_t size, const char *separator)
+{
+    size_t len = 0;
+
+    if (size == 0)
+        return 0;
+    buf[0] = '\0';
+
+    for (int i = 0; i < FRAME_STAGE_COUNT; i++)
+    {
+        frame_stage_stats_t s;
+        int n;
+
+        frame_profiler_get((frame_stage_t)i, &s);
+        if (s.count == 0)
+            continue;
+
+        n = snprintf(buf + len, size - len, "%s%s %.2f/%.2f/%.2f/%.2f%s", len ? separator : "",
+                     stage_names[i], s.p50_us / 1000.0, s.p95_us / 1000.0, s.p99_us / 1000.0,
+                     s.max_us / 1000.0, s.p95_us > FRAME_PROFILER_BUDGET_US ? " !" : "");
+        if (n < 0 || (size_t)n >= size - len)
+        {
+            len = size - 1;
+            break;
+        }
+        len += (size_t)n;
+    }
+    return (int)len;
+}
@@ -0,0 +1,75 @@
+/**
+ * @file frame_profiler.h
+ * @brief Per-stage frame timings with rolling p50/p95/p99/max.
+ *
+ * Each pipeline stage keeps its last FRAME_PROFILER_WINDOW durations in
+ * microseconds. Recording is one atomic increment and one store, so the
+ * render thread and the LVGL thread can both record without a lock; each
+ * stage has a single writer. Percentiles are computed from a copy of the
+ * window when they are read.
+ */
+
+#ifndef FRAME_PROFILER_H
+#define FRAME_PROFILER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#define FRAME_PROFILER_WINDOW 256     /* Samples kept per stage */
+#define FRAME_PROFILER_BUDGET_US 33333 /* 30 fps; stages whose p95 exceed it are flagged */
+
+typedef enum
+{
+    FRAME_STAGE_SYNC,      /* Scene lock and cncvis pose/camera snapshot */
+    FRAME_STAGE_TRANSFORM, /* scene_update and dirty-rectangle collection */
+    FRAME_STAGE_RASTER,    /* TinyGL clear and rasterization */
+    FRAME_STAGE_COPY,      /* ZBuffer to canvas conversion, stale-area copies */
+    FRAME_STAGE_RENDER,    /* Whole render-thread frame, sync to publish */
+    FRAME_STAGE_LVGL,      /* lv_timer_handler passes that refreshed the display */
+    FRAME_STAGE_FLUSH,     /* Display flush to SDL, summed per refresh */
+    FRAME_STAGE_COUNT
+} frame_stage_t;
+
+typedef struct
+{
+    uint64_t count;   /* Samples recorded since start or reset */
+    uint32_t window;  /* Samples the percentiles are taken over */
+    uint32_t last_us;
+    uint32_t p50_us;
+    uint32_t p95_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+} frame_stage_stats_t;
+
+static inline uint64_t frame_profiler_now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+/* Microseconds since *mark; moves *mark to now */
+static inline uint32_t frame_profiler_lap(uint64_t *mark)
+{
+    uint64_t now = frame_profiler_now_us();
+    uint32_t elapsed = (uint32_t)(now - *mark);
+    *mark = now;
+    return elapsed;
+}
+
+const char *frame_profiler_stage_name(frame_stage_t stage);
+
+void frame_profiler_record(frame_stage_t stage, uint32_t us);
+void frame_profiler_reset(void);
+
+void frame_profiler_get(frame_stage_t stage, frame_stage_stats_t *stats);
+
+/*
+ * "stage p50/p95/p99/max" in milliseconds for every stage with samples,
+ * joined by `separator` (" | " for a log line, "\n" for the overlay).
+ * Stages over budget at p95 are marked with '!'. Returns the length written.
+ */
+int frame_profiler_format(char *buf, size_t size, const char *separator);
+
+#endif // FRAME_PROFILER_H
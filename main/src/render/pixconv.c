@@ -0,0 +1,709 @@
+/**
+ * @file pixconv.c
+ * @brief Scalar and SIMD pixel-format conversion kernels with runtime dispatch.
+ */
+
+#include "pixconv.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PIXCONV_X86 1
+#include <immintrin.h>
+#define PIXCONV_TARGET_SSE2 __attribute__((target("sse2")))
+#define PIXCONV_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+#if defined(__aarch64__) || defined(__ARM_NEON)
+#define PIXCONV_NEON 1
+#include <arm_neon.h>
+#endif
+
+static pixconv_row_fn kernels[PIXCONV_ISA_COUNT][PIXCONV_FMT_COUNT][PIXCONV_FMT_COUNT];
+static pixconv_row_fn dispatch[PIXCONV_FMT_COUNT][PIXCONV_FMT_COUNT];
+static bool isa_supported[PIXCONV_ISA_COUNT];
+static pixconv_isa_t active_isa = PIXCONV_ISA_SCALAR;
+static bool initialized = false;
+
+/**********************
+ *  SCALAR KERNELS
+ **********************/
+
+static inline uint16_t rgb_to_565(uint32_t r, uint32_t g, uint32_t b)
+{
+    return (uint16_t)(((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3));
+}
+
+static inline uint32_t rgb565_to_xrgb(uint16_t p)
+{
+    uint32_t r = ((p >> 8) & 0xF8) | (p >> 13);
+    uint32_t g = ((p >> 3) & 0xFC) | ((p >> 9) & 0x03);
+    uint32_t b = ((p << 3) & 0xF8) | ((p >> 2) & 0x07);
+    return 0xFF000000u | (r << 16) | (g << 8) | b;
+}
+
+static void copy32(void *dst, const void *src, int count) { memcpy(dst, src, (size_t)count * 4); }
+static void copy24(void *dst, const void *src, int count) { memcpy(dst, src, (size_t)count * 3); }
+static void copy16(void *dst, const void *src, int count) { memcpy(dst, src, (size_t)count * 2); }
+
+static void x32_to_argb_scalar(void *dst, const void *src, int count)
+{
+    const uint32_t *s = (const uint32_t *)src;
+    uint32_t *d = (uint32_t *)dst;
+    for (int i = 0; i < count; i++)
+        d[i] = s[i] | 0xFF000000u;
+}
+
+static void x32_to_565_scalar(void *dst, const void *src, int count)
+{
+    const uint32_t *s = (const uint32_t *)src;
+    uint16_t *d = (uint16_t *)dst;
+    for (int i = 0; i < count; i++)
+        d[i] = rgb_to_565((s[i] >> 16) & 0xFF, (s[i] >> 8) & 0xFF, s[i] & 0xFF);
+}
+
+static void x32_to_888_scalar(void *dst, const void *src, int count)
+{
+    const uint32_t *s = (const uint32_t *)src;
+    uint8_t *d = (uint8_t *)dst;
+    for (int i = 0; i < count; i++, d += 3)
+    {
+        d[0] = (uint8_t)s[i];
+        d[1] = (uint8_t)(s[i] >> 8);
+        d[2] = (uint8_t)(s[i] >> 16);
+    }
+}
+
+static void r565_to_x32_scalar(void *dst, const void *src, int count)
+{
+    const uint16_t *s = (const uint16_t *)src;
+    uint32_t *d = (uint32_t *)dst;
+    for (int i = 0; i < count; i++)
+        d[i] = rgb565_to_xrgb(s[i]);
+}
+
+static void r565_to_888_scalar(void *dst, const void *src, int count)
+{
+    const uint16_t *s = (const uint16_t *)src;
+    uint8_t *d = (uint8_t *)dst;
+    for (int i = 0; i < count; i++, d += 3)
+    {
+        uint32_t p = rgb565_to_xrgb(s[i]);
+        d[0] = (uint8_t)p;
+        d[1] = (uint8_t)(p >> 8);
+        d[2] = (uint8_t)(p >> 16);
+    }
+}
+
+static void r888_to_x32_scalar(void *dst, const void *src, int count)
+{
+    const uint8_t *s = (const uint8_t *)src;
+    uint32_t *d = (uint32_t *)dst;
+    for (int i = 0; i < count; i++, s += 3)
+        d[i] = 0xFF000000u | ((uint32_t)s[2] << 16) | ((uint32_t)s[1] << 8) | s[0];
+}
+
+static void r888_to_565_scalar(void *dst, const void *src, int count)
+{
+    const uint8_t *s = (const uint8_t *)src;
+    uint16_t *d = (uint16_t *)dst;
+    for (int i = 0; i < count; i++, s += 3)
+        d[i] = rgb_to_565(s[2], s[1], s[0]);
+}
+
+/**********************
+ *  SSE2 KERNELS
+ **********************/
+
+#ifdef PIXCONV_X86
+
+PIXCONV_TARGET_SSE2 static void x32_to_argb_sse2(void *dst, const void *src, int count)
+{
+    const uint32_t *s = (const uint32_t *)src;
+    uint32_t *d = (uint32_t *)dst;
+    const __m128i alpha = _mm_set1_epi32((int)0xFF000000u);
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i *)(s + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(s + i + 4));
+        _mm_storeu_si128((__m128i *)(d + i), _mm_or_si128(a, alpha));
+        _mm_storeu_si128((__m128i *)(d + i + 4), _mm_or_si128(b, alpha));
+    }
+    x32_to_argb_scalar(d + i, s + i, count - i);
+}
+
+PIXCONV_TARGET_SSE2 static inline __m128i pack565_sse2(__m128i p)
+{
+    __m128i r = _mm_and_si128(_mm_srli_epi32(p, 8), _mm_set1_epi32(0xF800));
+    __m128i g = _mm_and_si128(_mm_srli_epi32(p, 5), _mm_set1_epi32(0x07E0));
+    __m128i b = _mm_and_si128(_mm_srli_epi32(p, 3), _mm_set1_epi32(0x001F));
+    __m128i v = _mm_or_si128(_mm_or_si128(r, g), b);
+    /* Sign-extend so the signed pack below keeps all 16 bits */
+    return _mm_srai_epi32(_mm_slli_epi32(v, 16), 16);
+}
+
+PIXCONV_TARGET_SSE2 static void x32_to_565_sse2(void *dst, const void *src, int count)
+{
+    const uint32_t *s = (const uint32_t *)src;
+    uint16_t *d = (uint16_t *)dst;
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i a = pack565_sse2(_mm_loadu_si128((const __m128i *)(s + i)));
+        __m128i b = pack565_sse2(_mm_loadu_si128((const __m128i *)(s + i + 4)));
+        _mm_storeu_si128((__m128i *)(d + i), _mm_packs_epi32(a, b));
+    }
+    x32_to_565_scalar(d + i, s + i, count - i);
+}
+
+PIXCONV_TARGET_SSE2 static void r565_to_x32_sse2(void *dst, const void *src, int count)
+{
+    const uint16_t *s = (const uint16_t *)src;
+    uint32_t *d = (uint32_t *)dst;
+    const __m128i m_f8 = _mm_set1_epi16(0xF8);
+    const __m128i m_fc = _mm_set1_epi16(0xFC);
+    const __m128i m_03 = _mm_set1_epi16(0x03);
+    const __m128i m_07 = _mm_set1_epi16(0x07);
+    const __m128i alpha = _mm_set1_epi16((short)0xFF00);
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i p = _mm_loadu_si128((const __m128i *)(s + i));
+        __m128i r = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(p, 8), m_f8), _mm_srli_epi16(p, 13));
+        __m128i g = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(p, 3), m_fc), _mm_and_si128(_mm_srli_epi16(p, 9), m_03));
+        __m128i b = _mm_or_si128(_mm_and_si128(_mm_slli_epi16(p, 3), m_f8), _mm_and_si128(_mm_srli_epi16(p, 2), m_07));
+        __m128i bg = _mm_or_si128(b, _mm_slli_epi16(g, 8));
+        __m128i ra = _mm_or_si128(r, alpha);
+        _mm_storeu_si128((__m128i *)(d + i), _mm_unpacklo_epi16(bg, ra));
+        _mm_storeu_si128((__m128i *)(d + i + 4), _mm_unpackhi_epi16(bg, ra));
+    }
+    r565_to_x32_scalar(d + i, s + i, count - i);
+}
+
+/* No byte shuffle before SSSE3: squeeze each 64-bit lane to 6 bytes, then close the gap between the lanes */
+PIXCONV_TARGET_SSE2 static inline __m128i pack888_sse2(__m128i p)
+{
+    __m128i q = _mm_or_si128(_mm_and_si128(p, _mm_set1_epi64x(0xFFFFFF)),
+                             _mm_and_si128(_mm_srli_epi64(p, 8), _mm_set1_epi64x(0xFFFFFF000000)));
+    return _mm_or_si128(_mm_and_si128(q, _mm_set_epi32(0, 0, 0x0000FFFF, (int)0xFFFFFFFFu)),
+                        _mm_and_si128(_mm_srli_si128(q, 2), _mm_set_epi32(0, (int)0xFFFFFFFFu, (int)0xFFFF0000u, 0)));
+}
+
+/* The inverse: 12 bytes of `p` to four pixels, alpha opaque */
+PIXCONV_TARGET_SSE2 static inline __m128i unpack888_sse2(__m128i p)
+{
+    __m128i q = _mm_or_si128(_mm_and_si128(p, _mm_set_epi32(0, 0, 0x0000FFFF, (int)0xFFFFFFFFu)),
+                             _mm_and_si128(_mm_slli_si128(p, 2), _mm_set_epi32(0x0000FFFF, (int)0xFFFFFFFFu, 0, 0)));
+    return _mm_or_si128(_mm_or_si128(_mm_and_si128(q, _mm_set1_epi64x(0xFFFFFF)),
+                                     _mm_and_si128(_mm_slli_epi64(q, 8), _mm_set1_epi64x(0xFFFFFF00000000))),
+                        _mm_set1_epi32((int)0xFF000000u));
+}
+
+PIXCONV_TARGET_SSE2 static void x32_to_888_sse2(void *dst, const void *src, int count)
+{
+    const uint32_t *s = (const uint32_t *)src;
+    uint8_t *d = (uint8_t *)dst;
+    int i = 0;
+    /* Each 16-byte store spills 4 bytes past its 12 useful ones; keep two pixels of slack */
+    for (; i + 10 <= count; i += 8)
+    {
+        _mm_storeu_si128((__m128i *)(d + i * 3), pack888_sse2(_mm_loadu_si128((const __m128i *)(s + i))));
+        _mm_storeu_si128((__m128i *)(d + i * 3 + 12), pack888_sse2(_mm_loadu_si128((const __m128i *)(s + i + 4))));
+    }
+    x32_to_888_scalar(d + i * 3, s + i, count - i);
+}
+
+PIXCONV_TARGET_SSE2 static void r565_to_888_sse2(void *dst, const void *src, int count)
+{
+    const uint16_t *s = (const uint16_t *)src;
+    uint8_t *d = (uint8_t *)dst;
+    uint32_t px[8];
+    int i = 0;
+    for (; i + 10 <= count; i += 8)
+    {
+        r565_to_x32_sse2(px, s + i, 8);
+        _mm_storeu_si128((__m128i *)(d + i * 3), pack888_sse2(_mm_loadu_si128((const __m128i *)px)));
+        _mm_storeu_si128((__m128i *)(d + i * 3 + 12), pack888_sse2(_mm_loadu_si128((const __m128i *)(px + 4))));
+    }
+    r565_to_888_scalar(d + i * 3, s + i, count - i);
+}
+
+PIXCONV_TARGET_SSE2 static void r888_to_x32_sse2(void *dst, const void *src, int count)
+{
+    const uint8_t *s = (const uint8_t *)src;
+    uint32_t *d = (uint32_t *)dst;
+    int i = 0;
+    /* Each 16-byte load reads 4 bytes past its 12 useful ones; same slack on the source */
+    for (; i + 10 <= count; i += 8)
+    {
+        _mm_storeu_si128((__m128i *)(d + i), unpack888_sse2(_mm_loadu_si128((const __m128i *)(s + i * 3))));
+        _mm_storeu_si128((__m128i *)(d + i + 4), unpack888_sse2(_mm_loadu_si128((const __m128i *)(s + i * 3 + 12))));
+    }
+    r888_to_x32_scalar(d + i, s + i * 3, count - i);
+}
+
+PIXCONV_TARGET_SSE2 static void r888_to_565_sse2(void *dst, const void *src, int count)
+{
+    const uint8_t *s = (const uint8_t *)src;
+    uint16_t *d = (uint16_t *)dst;
+    int i = 0;
+    for (; i + 10 <= count; i += 8)
+    {
+        __m128i a = pack565_sse2(unpack888_sse2(_mm_loadu_si128((const __m128i *)(s + i * 3))));
+        __m128i b = pack565_sse2(unpack888_sse2(_mm_loadu_si128((const __m128i *)(s + i * 3 + 12))));
+        _mm_storeu_si128((__m128i *)(d + i), _mm_packs_epi32(a, b));
+    }
+    r888_to_565_scalar(d + i, s + i * 3, count - i);
+}
+
+/**********************
+ *  AVX2 KERNELS
+ **********************/
+
+PIXCONV_TARGET_AVX2 static void x32_to_argb_avx2(void *dst, const void *src, int count)
+{
+    const uint32_t *s = (const uint32_t *)src;
+    uint32_t *d = (uint32_t *)dst;
+    const __m256i alpha = _mm256_set1_epi32((int)0xFF000000u);
+    int i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(s + i));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(s + i + 8));
+        _mm256_storeu_si256((__m256i *)(d + i), _mm256_or_si256(a, alpha));
+        _mm256_storeu_si256((__m256i *)(d + i + 8), _mm256_or_si256(b, alpha));
+    }
+    x32_to_argb_scalar(d + i, s + i, count - i);
+}
+
+PIXCONV_TARGET_AVX2 static inline __m256i pack565_avx2(__m256i p)
+{
+    __m256i r = _mm256_and_si256(_mm256_srli_epi32(p, 8), _mm256_set1_epi32(0xF800));
+    __m256i g = _mm256_and_si256(_mm256_srli_epi32(p, 5), _mm256_set1_epi32(0x07E0));
+    __m256i b = _mm256_and_si256(_mm256_srli_epi32(p, 3), _mm256_set1_epi32(0x001F));
+    __m256i v = _mm256_or_si256(_mm256_or_si256(r, g), b);
+    return _mm256_srai_epi32(_mm256_slli_epi32(v, 16), 16);
+}
+
+PIXCONV_TARGET_AVX2 static void x32_to_565_avx2(void *dst, const void *src, int count)
+{
+    const uint32_t *s = (const uint32_t *)src;
+    uint16_t *d = (uint16_t *)dst;
+    int i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m256i a = pack565_avx2(_mm256_loadu_si256((const __m256i *)(s + i)));
+        __m256i b = pack565_avx2(_mm256_loadu_si256((const __m256i *)(s + i + 8)));
+        /* packs works per 128-bit lane; restore pixel order afterwards */
+        __m256i v = _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), 0xD8);
+        _mm256_storeu_si256((__m256i *)(d + i), v);
+    }
+    x32_to_565_scalar(d + i, s + i, count - i);
+}
+
+PIXCONV_TARGET_AVX2 static void x32_to_888_avx2(void *dst, const void *src, int count)
+{
+    const uint32_t *s = (const uint32_t *)src;
+    uint8_t *d = (uint8_t *)dst;
+    const __m256i shuf = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+                                          0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    int i = 0;
+    /* Each 16-byte store spills 4 bytes past its 12 useful ones; keep two pixels of slack */
+    for (; i + 10 <= count; i += 8)
+    {
+        __m256i v = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(s + i)), shuf);
+        _mm_storeu_si128((__m128i *)(d + i * 3), _mm256_castsi256_si128(v));
+        _mm_storeu_si128((__m128i *)(d + i * 3 + 12), _mm256_extracti128_si256(v, 1));
+    }
+    x32_to_888_scalar(d + i * 3, s + i, count - i);
+}
+
+/* Eight RGB565 pixels to XRGB8888 */
+PIXCONV_TARGET_AVX2 static inline __m256i unpack565_avx2(const uint16_t *s)
+{
+    const __m256i m_f8 = _mm256_set1_epi32(0xF8);
+    const __m256i m_fc = _mm256_set1_epi32(0xFC);
+    const __m256i m_03 = _mm256_set1_epi32(0x03);
+    const __m256i m_07 = _mm256_set1_epi32(0x07);
+    const __m256i alpha = _mm256_set1_epi32((int)0xFF000000u);
+    __m256i p = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)s));
+    __m256i r = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(p, 8), m_f8), _mm256_srli_epi32(p, 13));
+    __m256i g = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(p, 3), m_fc), _mm256_and_si256(_mm256_srli_epi32(p, 9), m_03));
+    __m256i b = _mm256_or_si256(_mm256_and_si256(_mm256_slli_epi32(p, 3), m_f8), _mm256_and_si256(_mm256_srli_epi32(p, 2), m_07));
+    return _mm256_or_si256(_mm256_or_si256(alpha, _mm256_slli_epi32(r, 16)),
+                           _mm256_or_si256(_mm256_slli_epi32(g, 8), b));
+}
+
+/* Eight RGB888 pixels from s[0..28) to XRGB8888: 4 bytes are read past the 24 useful ones */
+PIXCONV_TARGET_AVX2 static inline __m256i unpack888_avx2(const uint8_t *s)
+{
+    const __m256i shuf = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                                          0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    __m256i p = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)s)),
+                                        _mm_loadu_si128((const __m128i *)(s + 12)), 1);
+    return _mm256_or_si256(_mm256_shuffle_epi8(p, shuf), _mm256_set1_epi32((int)0xFF000000u));
+}
+
+PIXCONV_TARGET_AVX2 static void r565_to_x32_avx2(void *dst, const void *src, int count)
+{
+    const uint16_t *s = (const uint16_t *)src;
+    uint32_t *d = (uint32_t *)dst;
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+        _mm256_storeu_si256((__m256i *)(d + i), unpack565_avx2(s + i));
+    r565_to_x32_scalar(d + i, s + i, count - i);
+}
+
+PIXCONV_TARGET_AVX2 static void r565_to_888_avx2(void *dst, const void *src, int count)
+{
+    const uint16_t *s = (const uint16_t *)src;
+    uint8_t *d = (uint8_t *)dst;
+    const __m256i shuf = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+                                          0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    int i = 0;
+    /* Same store slack as x32_to_888_avx2 */
+    for (; i + 10 <= count; i += 8)
+    {
+        __m256i v = _mm256_shuffle_epi8(unpack565_avx2(s + i), shuf);
+        _mm_storeu_si128((__m128i *)(d + i * 3), _mm256_castsi256_si128(v));
+        _mm_storeu_si128((__m128i *)(d + i * 3 + 12), _mm256_extracti128_si256(v, 1));
+    }
+    r565_to_888_scalar(d + i * 3, s + i, count - i);
+}
+
+PIXCONV_TARGET_AVX2 static void r888_to_x32_avx2(void *dst, const void *src, int count)
+{
+    const uint8_t *s = (const uint8_t *)src;
+    uint32_t *d = (uint32_t *)dst;
+    int i = 0;
+    /* Two pixels of slack for the bytes unpack888_avx2 over-reads */
+    for (; i + 10 <= count; i += 8)
+        _mm256_storeu_si256((__m256i *)(d + i), unpack888_avx2(s + i * 3));
+    r888_to_x32_scalar(d + i, s + i * 3, count - i);
+}
+
+PIXCONV_TARGET_AVX2 static void r888_to_565_avx2(void *dst, const void *src, int count)
+{
+    const uint8_t *s = (const uint8_t *)src;
+    uint16_t *d = (uint16_t *)dst;
+    int i = 0;
+    for (; i + 18 <= count; i += 16)
+    {
+        __m256i a = pack565_avx2(unpack888_avx2(s + i * 3));
+        __m256i b = pack565_avx2(unpack888_avx2(s + i * 3 + 24));
+        __m256i v = _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), 0xD8);
+        _mm256_storeu_si256((__m256i *)(d + i), v);
+    }
+    r888_to_565_scalar(d + i, s + i * 3, count - i);
+}
+
+#endif /* PIXCONV_X86 */
+
+/**********************
+ *  NEON KERNELS
+ **********************/
+
+#ifdef PIXCONV_NEON
+
+static inline uint16x8_t pack565_neon(uint8x8_t r, uint8x8_t g, uint8x8_t b)
+{
+    uint16x8_t v = vshll_n_u8(r, 8);
+    v = vsriq_n_u16(v, vshll_n_u8(g, 8), 5);
+    return vsriq_n_u16(v, vshll_n_u8(b, 8), 11);
+}
+
+static inline uint8x8x3_t unpack565_neon(uint16x8_t p)
+{
+    uint8x8x3_t c;
+    uint8x8_t r = vand_u8(vshrn_n_u16(p, 8), vdup_n_u8(0xF8));
+    uint8x8_t g = vand_u8(vshrn_n_u16(p, 3), vdup_n_u8(0xFC));
+    uint8x8_t b = vand_u8(vmovn_u16(vshlq_n_u16(p, 3)), vdup_n_u8(0xF8));
+    c.val[0] = vorr_u8(b, vshr_n_u8(b, 5));
+    c.val[1] = vorr_u8(g, vshr_n_u8(g, 6));
+    c.val[2] = vorr_u8(r, vshr_n_u8(r, 5));
+    return c;
+}
+
+static void x32_to_argb_neon(void *dst, const void *src, int count)
+{
+    const uint32_t *s = (const uint32_t *)src;
+    uint32_t *d = (uint32_t *)dst;
+    const uint32x4_t alpha = vdupq_n_u32(0xFF000000u);
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        vst1q_u32(d + i, vorrq_u32(vld1q_u32(s + i), alpha));
+        vst1q_u32(d + i + 4, vorrq_u32(vld1q_u32(s + i + 4), alpha));
+    }
+    x32_to_argb_scalar(d + i, s + i, count - i);
+}
+
+static void x32_to_565_neon(void *dst, const void *src, int count)
+{
+    const uint32_t *s = (const uint32_t *)src;
+    uint16_t *d = (uint16_t *)dst;
+    int i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        uint8x16x4_t px = vld4q_u8((const uint8_t *)(s + i));
+        vst1q_u16(d + i, pack565_neon(vget_low_u8(px.val[2]), vget_low_u8(px.val[1]), vget_low_u8(px.val[0])));
+        vst1q_u16(d + i + 8, pack565_neon(vget_high_u8(px.val[2]), vget_high_u8(px.val[1]), vget_high_u8(px.val[0])));
+    }
+    x32_to_565_scalar(d + i, s + i, count - i);
+}
+
+static void x32_to_888_neon(void *dst, const void *src, int count)
+{
+    const uint32_t *s = (const uint32_t *)src;
+    uint8_t *d = (uint8_t *)dst;
+    int i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        uint8x16x4_t px = vld4q_u8((const uint8_t *)(s + i));
+        uint8x16x3_t out = { { px.val[0], px.val[1], px.val[2] } };
+        vst3q_u8(d + i * 3, out);
+    }
+    x32_to_888_scalar(d + i * 3, s + i, count - i);
+}
+
+static void r565_to_x32_neon(void *dst, const void *src, int count)
+{
+    const uint16_t *s = (const uint16_t *)src;
+    uint32_t *d = (uint32_t *)dst;
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        uint8x8x3_t c = unpack565_neon(vld1q_u16(s + i));
+        uint8x8x4_t out = { { c.val[0], c.val[1], c.val[2], vdup_n_u8(0xFF) } };
+        vst4_u8((uint8_t *)(d + i), out);
+    }
+    r565_to_x32_scalar(d + i, s + i, count - i);
+}
+
+static void r565_to_888_neon(void *dst, const void *src, int count)
+{
+    const uint16_t *s = (const uint16_t *)src;
+    uint8_t *d = (uint8_t *)dst;
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+        vst3_u8(d + i * 3, unpack565_neon(vld1q_u16(s + i)));
+    r565_to_888_scalar(d + i * 3, s + i, count - i);
+}
+
+static void r888_to_x32_neon(void *dst, const void *src, int count)
+{
+    const uint8_t *s = (const uint8_t *)src;
+    uint32_t *d = (uint32_t *)dst;
+    int i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        uint8x16x3_t px = vld3q_u8(s + i * 3);
+        uint8x16x4_t out = { { px.val[0], px.val[1], px.val[2], vdupq_n_u8(0xFF) } };
+        vst4q_u8((uint8_t *)(d + i), out);
+    }
+    r888_to_x32_scalar(d + i, s + i * 3, count - i);
+}
+
+static void r888_to_565_neon(void *dst, const void *src, int count)
+{
+    const uint8_t *s = (const uint8_t *)src;
+    uint16_t *d = (uint16_t *)dst;
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        uint8x8x3_t px = vld3_u8(s + i * 3);
+        vst1q_u16(d + i, pack565_neon(px.val[2], px.val[1], px.val[0]));
+    }
+    r888_to_565_scalar(d + i, s + i * 3, count - i);
+}
+
+#endif /* PIXCONV_NEON */
+
+/**********************
+ *  DISPATCH
+ **********************/
+
+static void set_32_32(pixconv_isa_t isa, pixconv_row_fn fn)
+{
+    /* XRGB and ARGB share a layout; only the alpha byte needs forcing */
+    kernels[isa][PIXCONV_FMT_XRGB8888][PIXCONV_FMT_ARGB8888] = fn;
+    kernels[isa][PIXCONV_FMT_ARGB8888][PIXCONV_FMT_XRGB8888] = fn;
+}
+
+static void set_from_32(pixconv_isa_t isa, pixconv_format_t dst, pixconv_row_fn fn)
+{
+    kernels[isa][dst][PIXCONV_FMT_XRGB8888] = fn;
+    kernels[isa][dst][PIXCONV_FMT_ARGB8888] = fn;
+}
+
+static void set_to_32(pixconv_isa_t isa, pixconv_format_t src, pixconv_row_fn fn)
+{
+    kernels[isa][PIXCONV_FMT_XRGB8888][src] = fn;
+    kernels[isa][PIXCONV_FMT_ARGB8888][src] = fn;
+}
+
+static void detect_cpu(void)
+{
+    isa_supported[PIXCONV_ISA_SCALAR] = true;
+#ifdef PIXCONV_X86
+    __builtin_cpu_init();
+    isa_supported[PIXCONV_ISA_SSE2] = __builtin_cpu_supports("sse2");
+    isa_supported[PIXCONV_ISA_AVX2] = __builtin_cpu_supports("avx2");
+#endif
+#ifdef PIXCONV_NEON
+    isa_supported[PIXCONV_ISA_NEON] = true;
+#endif
+}
+
+void pixconv_init(void)
+{
+    if (initialized)
+        return;
+
+    detect_cpu();
+
+    /* Scalar: every pair */
+    for (int f = 0; f < PIXCONV_FMT_COUNT; f++)
+    {
+        int bpp = pixconv_bytes_per_pixel((pixconv_format_t)f);
+        kernels[PIXCONV_ISA_SCALAR][f][f] = bpp == 4 ? copy32 : bpp == 3 ? copy24 : copy16;
+    }
+    set_32_32(PIXCONV_ISA_SCALAR, x32_to_argb_scalar);
+    set_from_32(PIXCONV_ISA_SCALAR, PIXCONV_FMT_RGB565, x32_to_565_scalar);
+    set_from_32(PIXCONV_ISA_SCALAR, PIXCONV_FMT_RGB888, x32_to_888_scalar);
+    set_to_32(PIXCONV_ISA_SCALAR, PIXCONV_FMT_RGB565, r565_to_x32_scalar);
+    set_to_32(PIXCONV_ISA_SCALAR, PIXCONV_FMT_RGB888, r888_to_x32_scalar);
+    kernels[PIXCONV_ISA_SCALAR][PIXCONV_FMT_RGB888][PIXCONV_FMT_RGB565] = r565_to_888_scalar;
+    kernels[PIXCONV_ISA_SCALAR][PIXCONV_FMT_RGB565][PIXCONV_FMT_RGB888] = r888_to_565_scalar;
+
+#ifdef PIXCONV_X86
+    if (isa_supported[PIXCONV_ISA_SSE2])
+    {
+        set_32_32(PIXCONV_ISA_SSE2, x32_to_argb_sse2);
+        set_from_32(PIXCONV_ISA_SSE2, PIXCONV_FMT_RGB565, x32_to_565_sse2);
+        set_from_32(PIXCONV_ISA_SSE2, PIXCONV_FMT_RGB888, x32_to_888_sse2);
+        set_to_32(PIXCONV_ISA_SSE2, PIXCONV_FMT_RGB565, r565_to_x32_sse2);
+        set_to_32(PIXCONV_ISA_SSE2, PIXCONV_FMT_RGB888, r888_to_x32_sse2);
+        kernels[PIXCONV_ISA_SSE2][PIXCONV_FMT_RGB888][PIXCONV_FMT_RGB565] = r565_to_888_sse2;
+        kernels[PIXCONV_ISA_SSE2][PIXCONV_FMT_RGB565][PIXCONV_FMT_RGB888] = r888_to_565_sse2;
+    }
+    if (isa_supported[PIXCONV_ISA_AVX2])
+    {
+        set_32_32(PIXCONV_ISA_AVX2, x32_to_argb_avx2);
+        set_from_32(PIXCONV_ISA_AVX2, PIXCONV_FMT_RGB565, x32_to_565_avx2);
+        set_from_32(PIXCONV_ISA_AVX2, PIXCONV_FMT_RGB888, x32_to_888_avx2);
+        set_to_32(PIXCONV_ISA_AVX2, PIXCONV_FMT_RGB565, r565_to_x32_avx2);
+        set_to_32(PIXCONV_ISA_AVX2, PIXCONV_FMT_RGB888, r888_to_x32_avx2);
+        kernels[PIXCONV_ISA_AVX2][PIXCONV_FMT_RGB888][PIXCONV_FMT_RGB565] = r565_to_888_avx2;
+        kernels[PIXCONV_ISA_AVX2][PIXCONV_FMT_RGB565][PIXCONV_FMT_RGB888] = r888_to_565_avx2;
+    }
+#endif
+#ifdef PIXCONV_NEON
+    set_32_32(PIXCONV_ISA_NEON, x32_to_argb_neon);
+    set_from_32(PIXCONV_ISA_NEON, PIXCONV_FMT_RGB565, x32_to_565_neon);
+    set_from_32(PIXCONV_ISA_NEON, PIXCONV_FMT_RGB888, x32_to_888_neon);
+    set_to_32(PIXCONV_ISA_NEON, PIXCONV_FMT_RGB565, r565_to_x32_neon);
+    set_to_32(PIXCONV_ISA_NEON, PIXCONV_FMT_RGB888, r888_to_x32_neon);
+    kernels[PIXCONV_ISA_NEON][PIXCONV_FMT_RGB888][PIXCONV_FMT_RGB565] = r565_to_888_neon;
+    kernels[PIXCONV_ISA_NEON][PIXCONV_FMT_RGB565][PIXCONV_FMT_RGB888] = r888_to_565_neon;
+#endif
+
+    /* Pick the widest supported kernel per pair, falling back towards scalar */
+    static const pixconv_isa_t order[] = { PIXCONV_ISA_AVX2, PIXCONV_ISA_NEON, PIXCONV_ISA_SSE2, PIXCONV_ISA_SCALAR };
+    for (int d = 0; d < PIXCONV_FMT_COUNT; d++)
+    {
+        for (int s = 0; s < PIXCONV_FMT_COUNT; s++)
+        {
+            for (unsigned k = 0; k < sizeof(order) / sizeof(order[0]); k++)
+            {
+                if (isa_supported[order[k]] && kernels[order[k]][d][s])
+                {
+                    dispatch[d][s] = kernels[order[k]][d][s];
+                    break;
+                }
+            }
+        }
+    }
+
+    for (unsigned k = 0; k < sizeof(order) / sizeof(order[0]); k++)
+    {
+        if (isa_supported[order[k]])
+        {
+            active_isa = order[k];
+            break;
+        }
+    }
+
+    initialized = true;
+}
+
+pixconv_row_fn pixconv_get(pixconv_format_t dst, pixconv_format_t src)
+{
+    if (!initialized)
+        pixconv_init();
+    return dispatch[dst][src];
+}
+
+pixconv_row_fn pixconv_get_isa(pixconv_format_t dst, pixconv_format_t src, pixconv_isa_t isa)
+{
+    if (!initialized)
+        pixconv_init();
+    return isa_supported[isa] ? kernels[isa][dst][src] : NULL;
+}
+
+pixconv_isa_t pixconv_active_isa(void)
+{
+    if (!initialized)
+        pixconv_init();
+    return active_isa;
+}
+
+bool pixconv_isa_supported(pixconv_isa_t isa)
+{
+    if (!initialized)
+        pixconv_init();
+    return isa_supported[isa];
+}
+
+int pixconv_bytes_per_pixel(pixconv_format_t fmt)
+{
+    switch (fmt)
+    {
+    case PIXCONV_FMT_RGB565: return 2;
+    case PIXCONV_FMT_RGB888: return 3;
+    default:                 return 4;
+    }
+}
+
+const char *pixconv_format_name(pixconv_format_t fmt)
+{
+    static const char *names[PIXCONV_FMT_COUNT] = { "XRGB8888", "ARGB8888", "RGB565", "RGB888" };
+    return fmt < PIXCONV_FMT_COUNT ? names[fmt] : "?";
+}
+
+const char *pixconv_isa_name(pixconv_isa_t isa)
+{
+    static const char *names[PIXCONV_ISA_COUNT] = { "scalar", "sse2", "avx2", "neon" };
+    return isa < PIXCONV_ISA_COUNT ? names[isa] : "?";
+}
+
+void pixconv_convert(void *dst, int dst_stride, pixconv_format_t dst_fmt,
+                     const void *src, int src_stride, pixconv_format_t src_fmt,
+                     int w, int h)
+{
+    pixconv_row_fn fn = pixconv_get(dst_fmt, src_fmt);
+
+    /* Contiguous rows on both sides: one call covers the whole rectangle */
+    if (dst_stride == w * pixconv_bytes_per_pixel(dst_fmt) &&
+        src_stride == w * pixconv_bytes_per_pixel(src_fmt))
+    {
+        fn(dst, src, w * h);
+        return;
+    }
+
+    uint8_t *d = (uint8_t *)dst;
+    const uint8_t *s = (const uint8_t *)src;
+    for (int y = 0; y < h; y++, d += dst_stride, s += src_stride)
+        fn(d, s, w);
+}
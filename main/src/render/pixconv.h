@@ -0,0 +1,66 @@
+/**
+ * @file pixconv.h
+ * @brief Pixel-format conversion between TinyGL framebuffers and LVGL canvas buffers.
+ *
+ * Row kernels exist for every (dst, src) pair of the formats below. Scalar
+ * versions are always present; SSE2, AVX2 and NEON versions are picked at
+ * runtime by pixconv_init() when the CPU supports them, for every pair of
+ * two different formats; same-format pairs stay a memcpy. Every SIMD kernel
+ * produces exactly the same bytes as its scalar counterpart. SSE2 has no
+ * byte shuffle, so its RGB888 kernels move pixels with 64-bit shifts.
+ *
+ * The module has no LVGL or TinyGL dependency so it can be benchmarked on
+ * its own (see pixconv_bench.c).
+ */
+
+#ifndef PIXCONV_H
+#define PIXCONV_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Memory layouts are little-endian, matching LVGL's formats of the same name */
+typedef enum
+{
+    PIXCONV_FMT_XRGB8888, /* uint32 0xXXRRGGBB, X ignored */
+    PIXCONV_FMT_ARGB8888, /* uint32 0xAARRGGBB, always written opaque */
+    PIXCONV_FMT_RGB565,   /* uint16 RRRRRGGGGGGBBBBB */
+    PIXCONV_FMT_RGB888,   /* bytes B, G, R */
+    PIXCONV_FMT_COUNT
+} pixconv_format_t;
+
+typedef enum
+{
+    PIXCONV_ISA_SCALAR,
+    PIXCONV_ISA_SSE2,
+    PIXCONV_ISA_AVX2,
+    PIXCONV_ISA_NEON,
+    PIXCONV_ISA_COUNT
+} pixconv_isa_t;
+
+/* Converts `count` pixels of one row */
+typedef void (*pixconv_row_fn)(void *dst, const void *src, int count);
+
+/* Detects the CPU and fills the dispatch table. Safe to call more than once. */
+void pixconv_init(void);
+
+/* Best available kernel for a format pair (never NULL after pixconv_init) */
+pixconv_row_fn pixconv_get(pixconv_format_t dst, pixconv_format_t src);
+
+/* Kernel for one specific ISA, or NULL if this build/CPU has none for the pair */
+pixconv_row_fn pixconv_get_isa(pixconv_format_t dst, pixconv_format_t src, pixconv_isa_t isa);
+
+/* Highest ISA selected by pixconv_init() */
+pixconv_isa_t pixconv_active_isa(void);
+bool pixconv_isa_supported(pixconv_isa_t isa);
+
+int pixconv_bytes_per_pixel(pixconv_format_t fmt);
+const char *pixconv_format_name(pixconv_format_t fmt);
+const char *pixconv_isa_name(pixconv_isa_t isa);
+
+/* Converts a w x h rectangle; strides are in bytes */
+void pixconv_convert(void *dst, int dst_stride, pixconv_format_t dst_fmt,
+                     const void *src, int src_stride, pixconv_format_t src_fmt,
+                     int w, int h);
+
+#endif // PIXCONV_H
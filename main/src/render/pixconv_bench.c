@@ -0,0 +1,109 @@
+/**
+ * @file pixconv_bench.c
+ * @brief Microbenchmark for the pixconv kernels.
+ *
+ * Usage: pixconv_bench [width height [milliseconds-per-kernel]]
+ *
+ * For every format pair and every kernel the CPU supports, converts a full
+ * frame repeatedly and reports frame time, Mpixel/s and GB/s (bytes read plus
+ * bytes written). SIMD output is checked against the scalar kernel.
+ */
+
+#include "pixconv.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv)
+{
+    int width = 512;
+    int height = 384;
+    double budget = 0.25;
+
+    if (argc >= 3)
+    {
+        width = atoi(argv[1]);
+        height = atoi(argv[2]);
+    }
+    if (argc >= 4)
+        budget = atof(argv[3]) / 1000.0;
+    if (width <= 0 || height <= 0 || budget <= 0.0)
+    {
+        fprintf(stderr, "usage: %s [width height [ms-per-kernel]]\n", argv[0]);
+        return 1;
+    }
+
+    pixconv_init();
+
+    int pixels = width * height;
+    uint8_t *src = malloc((size_t)pixels * 4);
+    uint8_t *dst = malloc((size_t)pixels * 4);
+    uint8_t *ref = malloc((size_t)pixels * 4);
+    if (!src || !dst || !ref)
+    {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    srand(1234);
+    for (int i = 0; i < pixels * 4; i++)
+        src[i] = (uint8_t)rand();
+
+    printf("pixconv_bench: %dx%d, active isa %s\n", width, height, pixconv_isa_name(pixconv_active_isa()));
+    printf("%-10s %-10s %-7s %10s %10s %8s\n", "src", "dst", "isa", "us/frame", "Mpix/s", "GB/s");
+
+    int failures = 0;
+    for (int s = 0; s < PIXCONV_FMT_COUNT; s++)
+    {
+        for (int d = 0; d < PIXCONV_FMT_COUNT; d++)
+        {
+            pixconv_row_fn scalar = pixconv_get_isa((pixconv_format_t)d, (pixconv_format_t)s, PIXCONV_ISA_SCALAR);
+            size_t dst_bytes = (size_t)pixels * pixconv_bytes_per_pixel((pixconv_format_t)d);
+            size_t src_bytes = (size_t)pixels * pixconv_bytes_per_pixel((pixconv_format_t)s);
+            scalar(ref, src, pixels);
+
+            for (int isa = 0; isa < PIXCONV_ISA_COUNT; isa++)
+            {
+                pixconv_row_fn fn = pixconv_get_isa((pixconv_format_t)d, (pixconv_format_t)s, (pixconv_isa_t)isa);
+                if (fn == NULL || (isa != PIXCONV_ISA_SCALAR && fn == scalar))
+                    continue;
+
+                memset(dst, 0, dst_bytes);
+                fn(dst, src, pixels);
+                bool match = memcmp(dst, ref, dst_bytes) == 0;
+                if (!match)
+                    failures++;
+
+                long iterations = 0;
+                double start = now_seconds();
+                double elapsed;
+                do
+                {
+                    fn(dst, src, pixels);
+                    iterations++;
+                    elapsed = now_seconds() - start;
+                } while (elapsed < budget);
+
+                double per_frame = elapsed / (double)iterations;
+                printf("%-10s %-10s %-7s %10.1f %10.1f %8.2f%s\n",
+                       pixconv_format_name((pixconv_format_t)s), pixconv_format_name((pixconv_format_t)d),
+                       pixconv_isa_name((pixconv_isa_t)isa), per_frame * 1e6, pixels / per_frame * 1e-6,
+                       (double)(src_bytes + dst_bytes) / per_frame * 1e-9, match ? "" : "  MISMATCH");
+            }
+        }
+    }
+
+    free(src);
+    free(dst);
+    free(ref);
+    return failures ? 2 : 0;
+}
@@ -0,0 +1,94 @@
+/**
+ * @file quality_governor.c
+ * @brief Quality ladder and the hysteresis that moves along it.
+ */
+
+#include "quality_governor.h"
+
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+
+static const quality_settings_t ladder[QUALITY_LEVELS] = {
+    { 0, INT_MAX, QUALITY_LIGHTING_LIT, 1.0f },
+    { 1, INT_MAX, QUALITY_LIGHTING_LIT, 1.0f },
+    { 1, 1, QUALITY_LIGHTING_LIT, 1.0f },
+    { 2, 1, QUALITY_LIGHTING_LIT, 0.75f },
+    { 2, 1, QUALITY_LIGHTING_UNLIT, 0.75f },
+    { 3, 1, QUALITY_LIGHTING_UNLIT, 0.5f },
+};
+
+const quality_settings_t *quality_governor_level(int level)
+{
+    if (level < 0)
+        level = 0;
+    if (level >= QUALITY_LEVELS)
+        level = QUALITY_LEVELS - 1;
+    return &ladder[level];
+}
+
+static void set_level(quality_governor_t *g, int level)
+{
+    g->level = level;
+    g->settings = ladder[level];
+    g->average_us = 0.0f; /* Measurements at the old level say little about the new one */
+    g->over_frames = 0;
+    g->under_frames = 0;
+}
+
+void quality_governor_init(quality_governor_t *g, float target_fps)
+{
+    memset(g, 0, sizeof(*g));
+    g->enabled = target_fps > 0.0f;
+    g->budget_us = g->enabled ? (uint32_t)(1000000.0f / target_fps) : 0;
+    set_level(g, 0);
+    snprintf(g->reason, sizeof(g->reason), g->enabled ? "start" : "governor off");
+}
+
+bool quality_governor_update(quality_governor_t *g, uint32_t frame_us)
+{
+    g->frames++;
+    g->last_us = frame_us;
+    if (!g->enabled)
+        return false;
+
+    if (g->average_us == 0.0f)
+        g->average_us = (float)frame_us;
+    else
+        g->average_us += QUALITY_AVERAGE_WEIGHT * ((float)frame_us - g->average_us);
+
+    float budget = (float)g->budget_us;
+    g->over_frames = g->average_us > budget ? g->over_frames + 1 : 0;
+    g->under_frames = g->average_us < budget * QUALITY_UPGRADE_RATIO ? g->under_frames + 1 : 0;
+
+    int level = g->level;
+    if (g->over_frames >= QUALITY_DEGRADE_FRAMES && level < QUALITY_LEVELS - 1)
+        level++;
+    else if (g->under_frames >= QUALITY_UPGRADE_FRAMES && level > 0)
+        level--;
+    if (level == g->level)
+        return false;
+
+    snprintf(g->reason, sizeof(g->reason), "%s: avg %.1f ms %s %.1f ms at level %d", level > g->level ? "down" : "up",
+             g->average_us / 1000.0f, level > g->level ? ">" : "<",
+             (level > g->level ? budget : budget * QUALITY_UPGRADE_RATIO) / 1000.0f, g->level);
+    set_level(g, level);
+    g->changes++;
+    g->last_change_frame = g->frames;
+    return true;
+}
+
+int quality_governor_format(const quality_governor_t *g, char *buf, size_t size)
+{
+    const quality_settings_t *s = &g->settings;
+    char lights[16];
+
+    if (s->max_lights == INT_MAX)
+        snprintf(lights, sizeof(lights), "all");
+    else
+        snprintf(lights, sizeof(lights), "%d", s->max_lights);
+
+    return snprintf(buf, size, "level %d/%d (lod %d, lights %s, %s, %.0f%%), avg %.1f/%.1f ms (%s)", g->level,
+                    QUALITY_LEVELS - 1, s->lod_level, lights, s->lighting == QUALITY_LIGHTING_LIT ? "lit" : "unlit",
+                    s->resolution_scale * 100.0f, g->average_us / 1000.0f, g->budget_us / 1000.0f, g->reason);
+}
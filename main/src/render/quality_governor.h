@@ -0,0 +1,76 @@
+/**
+ * @file quality_governor.h
+ * @brief Closed-loop frame-budget governor for the renderer's quality knobs.
+ *
+ * The governor walks a fixed ladder of quality levels, cheapest last:
+ * mesh LOD first, then the number of active lights, then the lighting model
+ * and finally the render resolution. Every full-view frame drawn at its
+ * settings (not at interaction_scale, not the full-quality frame at rest)
+ * feeds its render and copy time in; a moving average above the budget for
+ * QUALITY_DEGRADE_FRAMES frames in a row steps one level down, one well under
+ * the budget for QUALITY_UPGRADE_FRAMES frames steps back up. The gap between
+ * the two thresholds and the longer upgrade run are the hysteresis that keeps
+ * it from flapping between two levels.
+ *
+ * The governor itself is plain data and not thread-safe; render_thread owns
+ * one and hands out copies (render_thread_get_quality).
+ */
+
+#ifndef QUALITY_GOVERNOR_H
+#define QUALITY_GOVERNOR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define QUALITY_LEVELS 6
+#define QUALITY_DEGRADE_FRAMES 3     /* Consecutive frames over budget before stepping down */
+#define QUALITY_UPGRADE_FRAMES 30    /* Consecutive frames under QUALITY_UPGRADE_RATIO before stepping up */
+#define QUALITY_UPGRADE_RATIO 0.6f   /* Fraction of the budget the average must stay under to step up */
+#define QUALITY_AVERAGE_WEIGHT 0.25f /* Weight of the newest frame in the moving average */
+
+typedef enum
+{
+    QUALITY_LIGHTING_LIT,   /* cncvis lights */
+    QUALITY_LIGHTING_UNLIT  /* Flat actor colours, no lighting */
+} quality_lighting_t;
+
+typedef struct
+{
+    int lod_level;              /* Mesh detail bias (scene_renderer_t), 0 = no visible loss */
+    int max_lights;             /* Upper bound on the ucncLights applied */
+    quality_lighting_t lighting;
+    float resolution_scale;     /* Fraction of the canvas size, 1 = full */
+} quality_settings_t;
+
+typedef struct
+{
+    bool enabled;               /* false: always level 0 */
+    uint32_t budget_us;         /* Frame time the governor aims for */
+    int level;                  /* Current ladder level, 0 = full quality */
+    quality_settings_t settings;
+
+    float average_us;           /* Moving average at the current level, 0 before the first frame */
+    uint32_t last_us;
+    int over_frames;
+    int under_frames;
+
+    uint64_t frames;            /* Frames fed in */
+    uint64_t changes;           /* Level changes */
+    uint64_t last_change_frame;
+    char reason[128];           /* Why the current level was chosen */
+} quality_governor_t;
+
+/* target_fps <= 0 disables the governor; it then stays at full quality */
+void quality_governor_init(quality_governor_t *g, float target_fps);
+
+/* Feeds one frame's render + copy time; returns true when the settings changed */
+bool quality_governor_update(quality_governor_t *g, uint32_t frame_us);
+
+/* Settings of one ladder level */
+const quality_settings_t *quality_governor_level(int level);
+
+/* One line: level, knobs, average against budget and the last reason */
+int quality_governor_format(const quality_governor_t *g, char *buf, size_t size);
+
+#endif // QUALITY_GOVERNOR_H
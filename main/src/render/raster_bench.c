@@ -0,0 +1,423 @@
+/**
+ * @file raster_bench.c
+ * @brief Thread-scaling benchmark for the band-parallel rasterizer.
+ *
+ * Usage: raster_bench [frames [max-threads [model.stl ...]]]
+ *
+ * Loads the given STL files (e.g. the models under machines/) into one
+ * scene, or builds a procedural mesh of ~500k triangles when none are given,
+ * then renders a turntable of `frames` 512x384 frames with 1, 2, 4, ... up
+ * to max-threads workers (default: CPU count). Prints ms/frame and the
+ * speedup over one thread, and checks every run's output is bit-identical
+ * to the single-threaded one.
+ *
+ * The same turntable is then drawn by TinyGL, lit to match the band
+ * rasterizer's headlight, for its ms/frame and for how far the last frames
+ * of the two are apart: the share of pixels that differ and the largest
+ * difference of any 8-bit channel. They aren't expected to match (see
+ * band_raster.h); this puts a number on it.
+ */
+
+#include "band_raster.h"
+
+#include "../../../cncvis/api.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_WIDTH 512
+#define BENCH_HEIGHT 384
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* UV sphere; triangles wind outwards */
+static bool make_sphere(stl_mesh_t *mesh, int rings, int segments, float radius)
+{
+    int count = rings * segments * 2;
+    float *v = malloc((size_t)count * 9 * sizeof(float));
+    float *n = malloc((size_t)count * 3 * sizeof(float));
+    int t = 0;
+
+    if (v == NULL || n == NULL)
+    {
+        free(v);
+        free(n);
+        return false;
+    }
+
+    for (int r = 0; r < rings; r++)
+    {
+        for (int s = 0; s < segments; s++)
+        {
+            float p[4][3];
+            for (int k = 0; k < 4; k++)
+            {
+                float theta = (float)M_PI * (float)(r + (k >> 1)) / (float)rings;
+                float phi = 2.0f * (float)M_PI * (float)(s + (k & 1)) / (float)segments;
+                p[k][0] = radius * sinf(theta) * cosf(phi);
+                p[k][1] = radius * sinf(theta) * sinf(phi);
+                p[k][2] = radius * cosf(theta);
+            }
+            const int quad[2][3] = { { 0, 2, 1 }, { 1, 2, 3 } };
+            for (int q = 0; q < 2; q++, t++)
+            {
+                float c[3] = { 0, 0, 0 };
+                for (int i = 0; i < 3; i++)
+                {
+                    memcpy(&v[t * 9 + i * 3], p[quad[q][i]], sizeof(p[0]));
+                    for (int k = 0; k < 3; k++)
+                        c[k] += p[quad[q][i]][k] / 3.0f;
+                }
+                float len = sqrtf(c[0] * c[0] + c[1] * c[1] + c[2] * c[2]);
+                for (int k = 0; k < 3; k++)
+                    n[t * 3 + k] = len > 0.0f ? c[k] / len : 0.0f;
+            }
+        }
+    }
+
+    mesh->triangle_count = count;
+    mesh->vertices = v;
+    mesh->normals = n;
+    return true;
+}
+
+static void perspective(float out[16], float fovy_deg, float aspect, float znear, float zfar)
+{
+    float f = 1.0f / tanf(fovy_deg * (float)M_PI / 360.0f);
+
+    memset(out, 0, 16 * sizeof(float));
+    out[0] = f / aspect;
+    out[5] = f;
+    out[10] = (zfar + znear) / (znear - zfar);
+    out[11] = -1.0f;
+    out[14] = 2.0f * zfar * znear / (znear - zfar);
+}
+
+static void look_at(float out[16], const float eye[3], const float center[3])
+{
+    float f[3] = { center[0] - eye[0], center[1] - eye[1], center[2] - eye[2] };
+    float up[3] = { 0.0f, 0.0f, 1.0f };
+    float len = sqrtf(f[0] * f[0] + f[1] * f[1] + f[2] * f[2]);
+    for (int i = 0; i < 3; i++)
+        f[i] /= len;
+
+    float s[3] = { f[1] * up[2] - f[2] * up[1], f[2] * up[0] - f[0] * up[2], f[0] * up[1] - f[1] * up[0] };
+    len = sqrtf(s[0] * s[0] + s[1] * s[1] + s[2] * s[2]);
+    for (int i = 0; i < 3; i++)
+        s[i] /= len;
+    float u[3] = { s[1] * f[2] - s[2] * f[1], s[2] * f[0] - s[0] * f[2], s[0] * f[1] - s[1] * f[0] };
+
+    mat4_identity(out);
+    for (int i = 0; i < 3; i++)
+    {
+        out[i * 4 + 0] = s[i];
+        out[i * 4 + 1] = u[i];
+        out[i * 4 + 2] = -f[i];
+    }
+    out[12] = -(s[0] * eye[0] + s[1] * eye[1] + s[2] * eye[2]);
+    out[13] = -(u[0] * eye[0] + u[1] * eye[1] + u[2] * eye[2]);
+    out[14] = f[0] * eye[0] + f[1] * eye[1] + f[2] * eye[2];
+}
+
+/*
+ * TinyGL context with the band rasterizer's shading: one directional light
+ * along the view axis, the actor colour as ambient and diffuse material,
+ * both sides lit. 32-bit pixels if this TinyGL has them, else RGB565.
+ */
+static ZBuffer *tinygl_open(void)
+{
+    static const GLfloat headlight[4] = { 0.0f, 0.0f, 1.0f, 0.0f };
+    static const GLfloat diffuse[4] = { BAND_RASTER_DIFFUSE, BAND_RASTER_DIFFUSE, BAND_RASTER_DIFFUSE, 1.0f };
+    static const GLfloat ambient[4] = { BAND_RASTER_AMBIENT, BAND_RASTER_AMBIENT, BAND_RASTER_AMBIENT, 1.0f };
+    static const GLfloat none[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+    ZBuffer *zb = ZB_open(BENCH_WIDTH, BENCH_HEIGHT, ZB_MODE_RGBA, NULL);
+
+    if (zb == NULL)
+        zb = ZB_open(BENCH_WIDTH, BENCH_HEIGHT, ZB_MODE_5R6G5B, NULL);
+    if (zb == NULL)
+        return NULL;
+
+    glInit(zb);
+    glViewport(0, 0, BENCH_WIDTH, BENCH_HEIGHT);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glEnable(GL_DEPTH_TEST);
+    glShadeModel(GL_FLAT);
+    glEnable(GL_LIGHTING);
+    glEnable(GL_LIGHT0);
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity(); /* The light position is taken in eye space */
+    glLightfv(GL_LIGHT0, GL_POSITION, headlight);
+    glLightfv(GL_LIGHT0, GL_DIFFUSE, diffuse);
+    glLightfv(GL_LIGHT0, GL_AMBIENT, none);
+    glLightfv(GL_LIGHT0, GL_SPECULAR, none);
+    glLightModelfv(GL_LIGHT_MODEL_AMBIENT, ambient);
+    glLightModeli(GL_LIGHT_MODEL_TWO_SIDE, 1);
+    glEnable(GL_COLOR_MATERIAL);
+    glColorMaterial(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE);
+    return zb;
+}
+
+/* The scene as scene_render submits it in immediate mode */
+static void tinygl_draw(const scene_t *scene, const float proj[16], const float view[16])
+{
+    glMatrixMode(GL_PROJECTION);
+    glLoadMatrixf(proj);
+    glMatrixMode(GL_MODELVIEW);
+    glLoadMatrixf(view);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    for (int a = 0; a < scene->actor_count; a++)
+    {
+        const scene_actor_t *actor = &scene->actors[a];
+        const mesh_t *mesh = scene_actor_mesh(actor);
+        const uint32_t *i = mesh->indices;
+
+        glPushMatrix();
+        glMultMatrixf(scene->nodes[actor->node].world);
+        glMultMatrixf(actor->local);
+        glColor3f(actor->color[0], actor->color[1], actor->color[2]);
+        glBegin(GL_TRIANGLES);
+        for (int t = 0; t < mesh->triangle_count; t++, i += 3)
+        {
+            float n[3];
+            mesh_face_normal(mesh, t, n);
+            glNormal3f(n[0], n[1], n[2]);
+            for (int k = 0; k < 3; k++)
+                glVertex3f(mesh->x[i[k]], mesh->y[i[k]], mesh->z[i[k]]);
+        }
+        glEnd();
+        glPopMatrix();
+    }
+}
+
+/* 0x00RRGGBB of pixel x, RGB565 widened to 8 bits per channel */
+static uint32_t pixel_rgb(const uint8_t *row, pixconv_format_t format, int x)
+{
+    if (format == PIXCONV_FMT_RGB565)
+    {
+        uint16_t p;
+        memcpy(&p, row + x * 2, sizeof(p));
+        return (uint32_t)((p >> 11) * 255 / 31) << 16 | (uint32_t)(((p >> 5) & 63) * 255 / 63) << 8 |
+               (uint32_t)((p & 31) * 255 / 31);
+    }
+
+    uint32_t p;
+    memcpy(&p, row + x * 4, sizeof(p));
+    return p & 0xFFFFFFu;
+}
+
+/* Share of pixels that differ between two frames and the largest channel difference */
+static double compare_frames(const uint8_t *a, const uint8_t *b, int stride, pixconv_format_t format, int *largest)
+{
+    long differ = 0;
+
+    *largest = 0;
+    for (int y = 0; y < BENCH_HEIGHT; y++)
+    {
+        for (int x = 0; x < BENCH_WIDTH; x++)
+        {
+            uint32_t pa = pixel_rgb(a + (size_t)y * stride, format, x);
+            uint32_t pb = pixel_rgb(b + (size_t)y * stride, format, x);
+
+            if (pa == pb)
+                continue;
+            differ++;
+            for (int shift = 0; shift < 24; shift += 8)
+            {
+                int d = abs((int)((pa >> shift) & 255) - (int)((pb >> shift) & 255));
+                *largest = d > *largest ? d : *largest;
+            }
+        }
+    }
+    return (double)differ / ((double)BENCH_WIDTH * BENCH_HEIGHT);
+}
+
+/* TinyGL's row: its ms/frame and how its last frame compares with the band rasterizer's */
+static bool bench_tinygl(scene_t *scene, int frames, const float proj[16], const float view[16],
+                         const float view_proj[16], double base)
+{
+    ZBuffer *zb = tinygl_open();
+    pixconv_format_t format;
+    band_raster_t *br;
+    uint8_t *band;
+    double start = 0.0, ms, differ;
+    int largest;
+
+    if (zb == NULL)
+    {
+        fprintf(stderr, "failed to open a TinyGL framebuffer\n");
+        return false;
+    }
+    format = zb->mode == ZB_MODE_5R6G5B ? PIXCONV_FMT_RGB565 : PIXCONV_FMT_XRGB8888;
+
+    for (int f = -1; f < frames; f++)
+    {
+        if (f == 0)
+            start = now_seconds();
+        scene->nodes[0].rotation[2] = (float)(f < 0 ? 0 : f) * 3.0f;
+        scene->nodes[0].dirty = true;
+        scene_update(scene);
+        tinygl_draw(scene, proj, view);
+    }
+    ms = (now_seconds() - start) * 1000.0 / frames;
+
+    /* The band rasterizer's frame of the same pose, in TinyGL's pixel format */
+    br = band_raster_create(BENCH_WIDTH, BENCH_HEIGHT, 1);
+    band = malloc((size_t)zb->linesize * BENCH_HEIGHT);
+    if (br == NULL || band == NULL)
+    {
+        fprintf(stderr, "out of memory\n");
+        band_raster_destroy(br);
+        free(band);
+        glClose();
+        ZB_close(zb);
+        return false;
+    }
+    band_raster_draw(br, scene, view_proj, view, band, zb->linesize, format, NULL);
+    differ = compare_frames((const uint8_t *)zb->pbuf, band, zb->linesize, format, &largest);
+
+    if (differ == 0.0)
+        printf("%8s %12.3f %8.2fx identical to TinyGL\n", "TinyGL", ms, base / ms);
+    else
+        printf("%8s %12.3f %8.2fx %.2f%% of pixels differ from TinyGL, by up to %d/255\n", "TinyGL", ms, base / ms,
+               differ * 100.0, largest);
+
+    band_raster_destroy(br);
+    free(band);
+    glClose();
+    ZB_close(zb);
+    return true;
+}
+
+static scene_t *build_scene(int count, char **paths)
+{
+    scene_t *scene = scene_create();
+    int root;
+
+    if (scene == NULL)
+        return NULL;
+    root = scene_add_node(scene, "turntable", -1, NULL);
+
+    if (count == 0)
+    {
+        stl_mesh_t mesh;
+        float color[3] = { 0.8f, 0.6f, 0.3f };
+        if (make_sphere(&mesh, 400, 640, 100.0f))
+            scene_add_actor_mesh(scene, root, "sphere", &mesh, NULL, color);
+    }
+    for (int i = 0; i < count; i++)
+        scene_add_actor(scene, root, paths[i], paths[i], NULL, NULL);
+
+    scene_update(scene);
+    return scene;
+}
+
+int main(int argc, char **argv)
+{
+    int frames = argc >= 2 ? atoi(argv[1]) : 60;
+    int max_threads = argc >= 3 ? atoi(argv[2]) : worker_pool_cpu_count();
+
+    if (frames <= 0 || max_threads <= 0)
+    {
+        fprintf(stderr, "usage: %s [frames [max-threads [model.stl ...]]]\n", argv[0]);
+        return 1;
+    }
+
+    scene_t *scene = build_scene(argc > 3 ? argc - 3 : 0, argv + 3);
+    if (scene == NULL || scene->actor_count == 0)
+    {
+        fprintf(stderr, "no geometry\n");
+        return 1;
+    }
+
+    aabb_t bounds;
+    int triangles = 0;
+    aabb_empty(&bounds);
+    for (int i = 0; i < scene->actor_count; i++)
+    {
+        aabb_union(&bounds, &scene->actors[i].world_bounds);
+        triangles += scene->actors[i].mesh.triangle_count;
+    }
+
+    float center[3], radius = 0.0f;
+    for (int i = 0; i < 3; i++)
+    {
+        float half = 0.5f * (bounds.max[i] - bounds.min[i]);
+        center[i] = 0.5f * (bounds.max[i] + bounds.min[i]);
+        radius += half * half;
+    }
+    radius = sqrtf(radius);
+
+    float eye[3] = { center[0] + 2.0f * radius, center[1] - 2.0f * radius, center[2] + radius };
+    float proj[16], view[16], view_proj[16];
+    perspective(proj, 45.0f, (float)BENCH_WIDTH / (float)BENCH_HEIGHT, radius * 0.1f, radius * 10.0f);
+    look_at(view, eye, center);
+    mat4_mul(view_proj, proj, view);
+
+    size_t frame_bytes = (size_t)BENCH_WIDTH * BENCH_HEIGHT * 4;
+    uint8_t *reference = malloc(frame_bytes);
+    uint8_t *pixels = malloc(frame_bytes);
+    if (reference == NULL || pixels == NULL)
+    {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    printf("%d triangles, %d frames of %dx%d, %d CPU(s)\n", triangles, frames, BENCH_WIDTH, BENCH_HEIGHT,
+           worker_pool_cpu_count());
+    printf("%8s %12s %9s %s\n", "threads", "ms/frame", "speedup", "output");
+
+    double base = 0.0;
+    for (int threads = 1;; threads = threads * 2 > max_threads && threads < max_threads ? max_threads : threads * 2)
+    {
+        band_raster_t *br = band_raster_create(BENCH_WIDTH, BENCH_HEIGHT, threads);
+        if (br == NULL)
+        {
+            fprintf(stderr, "failed to create rasterizer with %d threads\n", threads);
+            return 1;
+        }
+
+        double start = 0.0;
+        for (int f = -1; f < frames; f++)
+        {
+            if (f == 0)
+                start = now_seconds(); /* Frame -1 warms up allocations */
+            scene->nodes[0].rotation[2] = (float)(f < 0 ? 0 : f) * 3.0f;
+            scene->nodes[0].dirty = true;
+            scene_update(scene);
+            band_raster_draw(br, scene, view_proj, view, pixels, BENCH_WIDTH * 4, PIXCONV_FMT_XRGB8888, NULL);
+        }
+        double ms = (now_seconds() - start) * 1000.0 / frames;
+
+        const char *status = "reference";
+        if (threads == 1)
+        {
+            memcpy(reference, pixels, frame_bytes);
+            base = ms;
+        }
+        else
+        {
+            status = memcmp(reference, pixels, frame_bytes) == 0 ? "identical" : "MISMATCH";
+        }
+        printf("%8d %12.3f %8.2fx %s\n", band_raster_threads(br), ms, base / ms, status);
+
+        band_raster_destroy(br);
+        if (threads >= max_threads)
+            break;
+    }
+
+    bool compared = bench_tinygl(scene, frames, proj, view, view_proj, base);
+
+    free(reference);
+    free(pixels);
+    scene_destroy(scene);
+    return compared ? 0 : 1;
+}
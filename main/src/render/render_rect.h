@@ -0,0 +1,17 @@
+/**
+ * @file render_rect.h
+ * @brief Inclusive pixel rectangle shared by the render modules.
+ */
+
+#ifndef RENDER_RECT_H
+#define RENDER_RECT_H
+
+#include <stdint.h>
+
+/* Inclusive canvas-pixel rectangle, like lv_area_t */
+typedef struct
+{
+    int32_t x1, y1, x2, y2;
+} render_rect_t;
+
+#endif // RENDER_RECT_H
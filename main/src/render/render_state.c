@@ -0,0 +1,108 @@
+/**
+ * @file render_state.c
+ * @brief Scene version counter and dirty reasons.
+ *
+ * Marks come from the UI thread, begin/end_frame from the render thread, so
+ * the counters shared between the two are only touched through __atomic
+ * builtins.
+ */
+
+#include "render_state.h"
+
+static uint32_t version = 1; /* Starts ahead of rendered_version so the first frame is drawn */
+static uint32_t rendered_version = 0;
+static uint32_t pending_reasons = RENDER_DIRTY_ALL;
+static uint32_t frame_version = 0;
+static uint64_t frames_rendered = 0;
+static uint64_t frames_skipped = 0;
+static bool visible = true;
+static bool interacting = false;
+
+static void (*notify_fn)(void *) = NULL;
+static void *notify_arg = NULL;
+
+void render_state_init(void)
+{
+    version = 1;
+    rendered_version = 0;
+    pending_reasons = RENDER_DIRTY_ALL;
+    frames_rendered = 0;
+    frames_skipped = 0;
+    visible = true;
+    interacting = false;
+}
+
+void render_state_set_notify(void (*fn)(void *arg), void *arg)
+{
+    notify_arg = arg;
+    notify_fn = fn;
+}
+
+void render_state_mark_dirty(uint32_t reasons)
+{
+    /* Reasons first: a frame that sees the new version also sees why */
+    __atomic_fetch_or(&pending_reasons, reasons, __ATOMIC_RELEASE);
+    __atomic_add_fetch(&version, 1, __ATOMIC_RELEASE);
+    if (notify_fn)
+        notify_fn(notify_arg);
+}
+
+void render_state_set_visible(bool is_visible)
+{
+    if (is_visible == __atomic_load_n(&visible, __ATOMIC_RELAXED))
+        return;
+
+    __atomic_store_n(&visible, is_visible, __ATOMIC_RELEASE);
+    if (is_visible)
+        render_state_mark_dirty(RENDER_DIRTY_VISIBILITY);
+}
+
+void render_state_set_interacting(bool is_interacting)
+{
+    if (is_interacting == __atomic_load_n(&interacting, __ATOMIC_RELAXED))
+        return;
+
+    __atomic_store_n(&interacting, is_interacting, __ATOMIC_RELEASE);
+    if (!is_interacting)
+        render_state_mark_dirty(RENDER_DIRTY_QUALITY);
+}
+
+bool render_state_interacting(void)
+{
+    return __atomic_load_n(&interacting, __ATOMIC_ACQUIRE);
+}
+
+bool render_state_begin_frame(uint32_t *reasons)
+{
+    uint32_t current = __atomic_load_n(&version, __ATOMIC_ACQUIRE);
+    uint32_t taken;
+
+    if (!__atomic_load_n(&visible, __ATOMIC_ACQUIRE) ||
+        current == __atomic_load_n(&rendered_version, __ATOMIC_RELAXED))
+    {
+        __atomic_add_fetch(&frames_skipped, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+
+    taken = __atomic_exchange_n(&pending_reasons, 0, __ATOMIC_ACQ_REL);
+    if (reasons)
+        *reasons = taken;
+    frame_version = current;
+    return true;
+}
+
+void render_state_end_frame(void)
+{
+    /* Changes made while the frame was being drawn keep the version ahead */
+    __atomic_store_n(&rendered_version, frame_version, __ATOMIC_RELEASE);
+    __atomic_add_fetch(&frames_rendered, 1, __ATOMIC_RELAXED);
+}
+
+void render_state_get_stats(render_stats_t *stats)
+{
+    stats->version = __atomic_load_n(&version, __ATOMIC_RELAXED);
+    stats->rendered_version = __atomic_load_n(&rendered_version, __ATOMIC_RELAXED);
+    stats->frames_rendered = __atomic_load_n(&frames_rendered, __ATOMIC_RELAXED);
+    stats->frames_skipped = __atomic_load_n(&frames_skipped, __ATOMIC_RELAXED);
+    stats->visible = __atomic_load_n(&visible, __ATOMIC_RELAXED);
+}
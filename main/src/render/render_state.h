@@ -0,0 +1,75 @@
+/**
+ * @file render_state.h
+ * @brief Scene versioning so the cncvis scene is only re-rendered when something changed.
+ *
+ * Every change to the scene bumps a version counter together with a reason
+ * bit. The render loop calls render_state_begin_frame() each tick; it only
+ * returns true when the version moved since the last rendered frame and the
+ * window is visible. Otherwise the tick is counted as skipped.
+ *
+ * Nothing is compared behind the caller's back: whoever changes the camera
+ * (orbit, pan, zoom, wheel, view presets, ucncCameraSetTarget) or a light
+ * marks RENDER_DIRTY_CAMERA or RENDER_DIRTY_LIGHTS right after the call.
+ *
+ * Visibility belongs to the UI thread; marks may also come from worker
+ * threads such as the scene loader. begin/end_frame may run on a
+ * render thread, which render_state_set_notify() can wake on marks.
+ */
+
+#ifndef RENDER_STATE_H
+#define RENDER_STATE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum
+{
+    RENDER_DIRTY_CAMERA = 1u << 0,
+    RENDER_DIRTY_MOTION = 1u << 1,
+    RENDER_DIRTY_LIGHTS = 1u << 2,
+    RENDER_DIRTY_VISIBILITY = 1u << 3,
+    RENDER_DIRTY_QUALITY = 1u << 4,    /* Interaction ended or the view is at rest: replace reduced frames */
+    RENDER_DIRTY_GEOMETRY = 1u << 5,   /* The scene loader attached an actor or its detail levels */
+    RENDER_DIRTY_ALL = 0xFFFFFFFFu
+} render_dirty_reason_t;
+
+typedef struct
+{
+    uint32_t version;          /* Current scene version */
+    uint32_t rendered_version; /* Version of the last rendered frame */
+    uint64_t frames_rendered;
+    uint64_t frames_skipped;   /* Ticks where nothing changed, or the window was hidden */
+    bool visible;
+} render_stats_t;
+
+void render_state_init(void);
+
+/* Called after every mark, e.g. to wake a render thread; fn must be cheap */
+void render_state_set_notify(void (*fn)(void *arg), void *arg);
+
+/* Record a scene change; reasons is a mask of render_dirty_reason_t */
+void render_state_mark_dirty(uint32_t reasons);
+
+/* A hidden window skips rendering; becoming visible again forces a frame */
+void render_state_set_visible(bool visible);
+
+/*
+ * The operator is dragging or wheel-zooming the camera; the renderer may
+ * trade resolution for frame rate meanwhile. Ending an interaction marks
+ * RENDER_DIRTY_QUALITY so a full-resolution frame follows.
+ */
+void render_state_set_interacting(bool interacting);
+bool render_state_interacting(void);
+
+/*
+ * Returns true if a frame must be rendered, and the accumulated dirty reasons
+ * in *reasons (may be NULL). Every false return counts as a skipped frame.
+ * A true return must be followed by render_state_end_frame().
+ */
+bool render_state_begin_frame(uint32_t *reasons);
+void render_state_end_frame(void);
+
+void render_state_get_stats(render_stats_t *stats);
+
+#endif // RENDER_STATE_H
@@ -0,0 +1,395 @@
+/**
+ * @file render_thread.c
+ * @brief Render thread, scene lock and triple-buffered frame hand-off.
+ */
+
+#include "render_thread.h"
+#include "frame_profiler.h"
+#include "render_state.h"
+#include "triple_buffer.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "../scene/scene_cncvis.h"
+#include "../sys/os_thread.h"
+
+#define RENDER_THREAD_STACK (256 * 1024)
+#define RENDER_THREAD_IDLE_MS 100 /* Upper bound on sleeping through a missed wake-up */
+
+typedef struct
+{
+    render_thread_config_t config;
+    os_thread_t thread;
+    os_mutex_t scene_lock;
+    os_event_t wake;
+    bool stop;
+    bool busy;                                  /* A frame is being drawn */
+
+    /* Render thread only */
+    scene_renderer_t renderer;
+    ucncCamera camera;                          /* Snapshots used for the frame in progress */
+    ucncLight lights[RENDER_THREAD_MAX_LIGHTS];
+    ucncLight *light_ptrs[RENDER_THREAD_MAX_LIGHTS];
+    render_rect_t stale[RENDER_THREAD_BUFFERS]; /* Area each buffer is behind the newest frame */
+    int latest;                                 /* Slot of the newest published frame, -1 before the first */
+
+    quality_governor_t quality;                 /* Updated and read under scene_lock */
+    bool interaction_scaled;                    /* The frame in progress is at interaction_scale */
+    bool reduced;                               /* The newest frame is below full quality */
+    bool rest_pending;                          /* A full-quality frame was requested for the view at rest */
+    bool resting;                               /* The frame in progress is that one */
+
+    /* Written before publishing a slot, read after acquiring it */
+    render_rect_t changed[RENDER_THREAD_BUFFERS];
+    triple_buffer_t frames;
+
+    uint64_t duplicated;
+    uint64_t full_frames;
+    uint64_t rect_frames;
+    uint64_t rect_pixels;
+    uint64_t scaled_frames;
+    uint64_t culled_actors;
+    uint32_t culled_last;
+    uint64_t matrices;
+    uint32_t matrices_last;
+    uint32_t collisions;
+    uint64_t joints_us;                         /* Joint batch time of the frame in progress */
+    uint64_t joints_shown_us;                   /* ... and of the newest published one */
+} render_thread_t;
+
+static render_thread_t rt;
+
+/* Rectangles with x1 > x2 are empty */
+static const render_rect_t rect_none = { 0, 0, -1, -1 };
+
+static bool rect_is_empty(const render_rect_t *r)
+{
+    return r->x1 > r->x2 || r->y1 > r->y2;
+}
+
+static void rect_add(render_rect_t *acc, const render_rect_t *r)
+{
+    if (rect_is_empty(r))
+        return;
+    if (rect_is_empty(acc))
+    {
+        *acc = *r;
+        return;
+    }
+    if (r->x1 < acc->x1) acc->x1 = r->x1;
+    if (r->y1 < acc->y1) acc->y1 = r->y1;
+    if (r->x2 > acc->x2) acc->x2 = r->x2;
+    if (r->y2 > acc->y2) acc->y2 = r->y2;
+}
+
+static void wake_render_thread(void *arg)
+{
+    os_event_post((os_event_t *)arg);
+}
+
+/* cncvis' layer behind the actors; it reads the live camera, lights and assemblies */
+static void draw_backdrop(void *arg)
+{
+    (void)arg;
+    os_mutex_lock(&rt.scene_lock);
+    scene_cncvis_render_backdrop(rt.config.scene);
+    os_mutex_unlock(&rt.scene_lock);
+}
+
+/* Copies camera, lights, joint poses and quality settings so the frame can be drawn without the lock */
+static void snapshot_scene(void)
+{
+    const render_thread_config_t *c = &rt.config;
+    quality_settings_t settings;
+    int count, level;
+
+    os_mutex_lock(&rt.scene_lock);
+    rt.camera = *c->camera;
+    count = *c->light_count < RENDER_THREAD_MAX_LIGHTS ? *c->light_count : RENDER_THREAD_MAX_LIGHTS;
+    for (int i = 0; i < count; i++)
+        rt.lights[i] = *c->lights[i];
+    scene_cncvis_sync(c->scene);
+    rt.joints_us = c->scene->joints_timestamp_us;
+    settings = rt.quality.settings;
+    level = rt.quality.level;
+    os_mutex_unlock(&rt.scene_lock);
+
+    /* At rest one frame costs nothing in frame rate, so it ignores the governor */
+    if (rt.resting)
+        settings = *quality_governor_level(0);
+
+    rt.renderer.light_count = count;
+    rt.renderer.max_lights = settings.max_lights;
+    rt.renderer.lod_level = settings.lod_level;
+    rt.renderer.unlit = settings.lighting == QUALITY_LIGHTING_UNLIT;
+    rt.renderer.resolution_scale = settings.resolution_scale;
+    rt.interaction_scaled = !rt.resting && render_state_interacting() && c->interaction_scale > 0.0f &&
+                            c->interaction_scale < 1.0f;
+    if (rt.interaction_scaled)
+        rt.renderer.resolution_scale *= c->interaction_scale;
+    rt.reduced = !rt.resting && (level > 0 || rt.interaction_scaled);
+}
+
+/* Same-format row copy between two canvas buffers */
+static void copy_rect(uint8_t *dst, const uint8_t *src, const render_rect_t *r)
+{
+    const render_thread_config_t *c = &rt.config;
+    size_t offset = (size_t)r->y1 * (size_t)c->stride + (size_t)r->x1 * (size_t)pixconv_bytes_per_pixel(c->format);
+    size_t bytes = (size_t)(r->x2 - r->x1 + 1) * (size_t)pixconv_bytes_per_pixel(c->format);
+
+    for (int32_t y = r->y1; y <= r->y2; y++, offset += (size_t)c->stride)
+        memcpy(dst + offset, src + offset, bytes);
+}
+
+/* ZBuffer rectangle to canvas format */
+static void convert_rect(uint8_t *dst, const ZBuffer *zb, const render_rect_t *r)
+{
+    const render_thread_config_t *c = &rt.config;
+    pixconv_format_t src_fmt = zb->mode == ZB_MODE_5R6G5B ? PIXCONV_FMT_RGB565 : PIXCONV_FMT_XRGB8888;
+    const uint8_t *src = (const uint8_t *)zb->pbuf + r->y1 * zb->linesize +
+                         r->x1 * pixconv_bytes_per_pixel(src_fmt);
+
+    pixconv_convert(dst + r->y1 * c->stride + r->x1 * pixconv_bytes_per_pixel(c->format), c->stride,
+                    c->format, src, zb->linesize, src_fmt, r->x2 - r->x1 + 1, r->y2 - r->y1 + 1);
+}
+
+static void render_one_frame(uint32_t reasons)
+{
+    const render_thread_config_t *c = &rt.config;
+    int back = triple_buffer_back(&rt.frames);
+    uint8_t *target = c->buffers[back];
+    render_rect_t drawn;
+    uint64_t start = frame_profiler_now_us();
+    uint64_t mark = start;
+    uint32_t sync_us, copy_us = 0;
+
+    rt.resting = rt.rest_pending && reasons == RENDER_DIRTY_QUALITY;
+    rt.rest_pending = false;
+    snapshot_scene();
+    sync_us = frame_profiler_lap(&mark);
+    __atomic_store_n(&rt.busy, true, __ATOMIC_RELAXED);
+
+    if (c->zero_copy)
+    {
+        /* TinyGL draws into the back buffer, so first bring it up to the newest frame */
+        if (rt.latest >= 0 && !rect_is_empty(&rt.stale[back]))
+            copy_rect(target, c->buffers[rt.latest], &rt.stale[back]);
+        rt.stale[back] = rect_none;
+        c->zb->pbuf = target;
+        copy_us = frame_profiler_lap(&mark);
+    }
+
+    if (!scene_render_frame(&rt.renderer, reasons, &drawn))
+    {
+        __atomic_store_n(&rt.busy, false, __ATOMIC_RELAXED);
+        return;
+    }
+    frame_profiler_lap(&mark);
+
+    if (!c->zero_copy)
+    {
+        /* TinyGL keeps its own framebuffer; convert what this buffer is missing */
+        rect_add(&rt.stale[back], &drawn);
+        convert_rect(target, c->zb, &rt.stale[back]);
+        copy_us += frame_profiler_lap(&mark);
+    }
+
+    for (int i = 0; i < RENDER_THREAD_BUFFERS; i++)
+        rect_add(&rt.stale[i], &drawn);
+    rt.stale[back] = rect_none;
+
+    /* If LVGL hasn't taken the previous frame it may skip it: carry its area along */
+    rt.changed[back] = drawn;
+    if (rt.latest >= 0 && triple_buffer_pending(&rt.frames))
+        rect_add(&rt.changed[back], &rt.changed[rt.latest]);
+
+    triple_buffer_publish(&rt.frames);
+    rt.latest = back;
+    if (c->frame_ready)
+        c->frame_ready(c->frame_ready_arg);
+
+    __atomic_store_n(&rt.full_frames, rt.renderer.full_frames, __ATOMIC_RELAXED);
+    __atomic_store_n(&rt.rect_frames, rt.renderer.rect_frames, __ATOMIC_RELAXED);
+    __atomic_store_n(&rt.rect_pixels, rt.renderer.rect_pixels, __ATOMIC_RELAXED);
+    __atomic_store_n(&rt.scaled_frames, rt.renderer.scaled_frames, __ATOMIC_RELAXED);
+    __atomic_store_n(&rt.culled_actors, rt.renderer.culled_total, __ATOMIC_RELAXED);
+    __atomic_store_n(&rt.culled_last, rt.renderer.culled, __ATOMIC_RELAXED);
+    __atomic_store_n(&rt.matrices, rt.renderer.matrices_total, __ATOMIC_RELAXED);
+    __atomic_store_n(&rt.matrices_last, rt.renderer.matrices, __ATOMIC_RELAXED);
+    __atomic_store_n(&rt.collisions, rt.renderer.collisions, __ATOMIC_RELAXED);
+    __atomic_store_n(&rt.joints_shown_us, rt.joints_us, __ATOMIC_RELAXED);
+    __atomic_store_n(&rt.busy, false, __ATOMIC_RELAXED);
+
+    /*
+     * Partial frames cost a fraction of a full one, and interaction-scaled
+     * and at-rest frames aren't drawn at the governor's settings: only full
+     * views at its own level steer it.
+     */
+    if (drawn.x1 == 0 && drawn.y1 == 0 && drawn.x2 == c->width - 1 && drawn.y2 == c->height - 1 &&
+        !rt.interaction_scaled && !rt.resting)
+    {
+        /* Level changes show up in the profile log (render_thread_get_quality) */
+        os_mutex_lock(&rt.scene_lock);
+        quality_governor_update(&rt.quality, rt.renderer.transform_us + rt.renderer.raster_us + copy_us);
+        os_mutex_unlock(&rt.scene_lock);
+    }
+
+    /* Only frames that were published, so idle wake-ups don't dilute the percentiles */
+    frame_profiler_record(FRAME_STAGE_SYNC, sync_us);
+    frame_profiler_record(FRAME_STAGE_TRANSFORM, rt.renderer.transform_us);
+    frame_profiler_record(FRAME_STAGE_RASTER, rt.renderer.raster_us);
+    frame_profiler_record(FRAME_STAGE_COPY, copy_us);
+    frame_profiler_record(FRAME_STAGE_RENDER, frame_profiler_lap(&start));
+}
+
+static void render_thread_main(void *arg)
+{
+    (void)arg;
+
+    while (!__atomic_load_n(&rt.stop, __ATOMIC_ACQUIRE))
+    {
+        uint32_t reasons = 0;
+
+        /*
+         * A quiet wait means the view is at rest: redraw a frame left below
+         * full quality, or one whose backdrop dirty rectangles left behind.
+         */
+        if (!os_event_wait(&rt.wake, RENDER_THREAD_IDLE_MS) && (rt.reduced || rt.renderer.backdrop_stale) &&
+            !rt.rest_pending)
+        {
+            rt.rest_pending = true;
+            render_state_mark_dirty(RENDER_DIRTY_QUALITY);
+        }
+        if (!render_state_begin_frame(&reasons))
+            continue;
+
+        render_one_frame(reasons);
+        render_state_end_frame();
+    }
+
+    scene_render_release(&rt.renderer);
+}
+
+bool render_thread_start(const render_thread_config_t *config)
+{
+    memset(&rt, 0, sizeof(rt));
+    rt.config = *config;
+    rt.latest = -1;
+    for (int i = 0; i < RENDER_THREAD_BUFFERS; i++)
+    {
+        rt.stale[i].x1 = 0;
+        rt.stale[i].y1 = 0;
+        rt.stale[i].x2 = config->width - 1;
+        rt.stale[i].y2 = config->height - 1;
+    }
+    for (int i = 0; i < RENDER_THREAD_MAX_LIGHTS; i++)
+        rt.light_ptrs[i] = &rt.lights[i];
+    triple_buffer_init(&rt.frames);
+    quality_governor_init(&rt.quality, config->target_fps);
+
+    scene_render_init(&rt.renderer, config->scene, config->zb, &rt.camera, rt.light_ptrs, 0);
+    rt.renderer.collision = config->collision;
+    rt.renderer.backdrop = draw_backdrop;
+
+    if (!os_mutex_init(&rt.scene_lock))
+        return false;
+    if (!os_event_init(&rt.wake))
+    {
+        os_mutex_destroy(&rt.scene_lock);
+        return false;
+    }
+
+    render_state_set_notify(wake_render_thread, &rt.wake);
+    if (!os_thread_create(&rt.thread, "render", render_thread_main, NULL, RENDER_THREAD_STACK, 1))
+    {
+        printf("render_thread: failed to create thread\n");
+        render_state_set_notify(NULL, NULL);
+        os_event_destroy(&rt.wake);
+        os_mutex_destroy(&rt.scene_lock);
+        return false;
+    }
+    return true;
+}
+
+void render_thread_stop(void)
+{
+    __atomic_store_n(&rt.stop, true, __ATOMIC_RELEASE);
+    os_event_post(&rt.wake);
+    os_thread_join(&rt.thread);
+
+    render_state_set_notify(NULL, NULL);
+    os_event_destroy(&rt.wake);
+    os_mutex_destroy(&rt.scene_lock);
+}
+
+void render_thread_lock_scene(void)
+{
+    os_mutex_lock(&rt.scene_lock);
+}
+
+void render_thread_unlock_scene(void)
+{
+    os_mutex_unlock(&rt.scene_lock);
+}
+
+int render_thread_apply_joints(const int *joints, const float *values, int count, uint64_t timestamp_us)
+{
+    int applied;
+
+    if (rt.config.scene == NULL)
+        return 0;
+    os_mutex_lock(&rt.scene_lock);
+    applied = scene_cncvis_apply_joints(rt.config.scene, joints, values, count, timestamp_us);
+    os_mutex_unlock(&rt.scene_lock);
+
+    if (applied > 0)
+        render_state_mark_dirty(RENDER_DIRTY_MOTION);
+    return applied;
+}
+
+int render_thread_find_joint(const char *assembly)
+{
+    /* Nodes and their names are fixed once the mirror is built */
+    return rt.config.scene ? scene_find_node(rt.config.scene, assembly) : -1;
+}
+
+uint8_t *render_thread_take_frame(render_rect_t *changed)
+{
+    int front;
+
+    if (!triple_buffer_acquire(&rt.frames, &front))
+    {
+        if (__atomic_load_n(&rt.busy, __ATOMIC_RELAXED))
+            __atomic_add_fetch(&rt.duplicated, 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    *changed = rt.changed[front];
+    return rt.config.buffers[front];
+}
+
+void render_thread_get_stats(render_thread_stats_t *stats)
+{
+    stats->published = __atomic_load_n(&rt.frames.published, __ATOMIC_RELAXED);
+    stats->presented = __atomic_load_n(&rt.frames.acquired, __ATOMIC_RELAXED);
+    stats->dropped = __atomic_load_n(&rt.frames.dropped, __ATOMIC_RELAXED);
+    stats->duplicated = __atomic_load_n(&rt.duplicated, __ATOMIC_RELAXED);
+    stats->full_frames = __atomic_load_n(&rt.full_frames, __ATOMIC_RELAXED);
+    stats->rect_frames = __atomic_load_n(&rt.rect_frames, __ATOMIC_RELAXED);
+    stats->rect_pixels = __atomic_load_n(&rt.rect_pixels, __ATOMIC_RELAXED);
+    stats->scaled_frames = __atomic_load_n(&rt.scaled_frames, __ATOMIC_RELAXED);
+    stats->culled_actors = __atomic_load_n(&rt.culled_actors, __ATOMIC_RELAXED);
+    stats->culled_last = __atomic_load_n(&rt.culled_last, __ATOMIC_RELAXED);
+    stats->matrices = __atomic_load_n(&rt.matrices, __ATOMIC_RELAXED);
+    stats->matrices_last = __atomic_load_n(&rt.matrices_last, __ATOMIC_RELAXED);
+    stats->collisions = __atomic_load_n(&rt.collisions, __ATOMIC_RELAXED);
+    stats->joints_timestamp_us = __atomic_load_n(&rt.joints_shown_us, __ATOMIC_RELAXED);
+}
+
+void render_thread_get_quality(quality_governor_t *quality)
+{
+    os_mutex_lock(&rt.scene_lock);
+    *quality = rt.quality;
+    os_mutex_unlock(&rt.scene_lock);
+}
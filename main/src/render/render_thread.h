@@ -0,0 +1,108 @@
+/**
+ * @file render_thread.h
+ * @brief Render thread that owns TinyGL and hands finished frames to LVGL.
+ *
+ * The thread sleeps until render_state reports a change, snapshots camera,
+ * lights and joint poses under the scene lock, renders without holding it,
+ * and publishes the frame through a triple buffer of canvas-format buffers.
+ * The LVGL side calls render_thread_take_frame() when woken by the
+ * frame_ready callback: one atomic exchange, no lock, and it never waits for
+ * a frame in progress.
+ *
+ * Frames follow the quality governor's settings while anything changes.
+ * Once a wait for changes times out, a frame left below full quality (by
+ * the governor or interaction_scale) or with a stale backdrop is drawn
+ * once more at full quality.
+ *
+ * Anything the UI thread does to cncvis state the renderer reads (camera
+ * setters, ucncUpdateMotionByName, lights) must happen between
+ * render_thread_lock_scene() and render_thread_unlock_scene().
+ */
+
+#ifndef RENDER_THREAD_H
+#define RENDER_THREAD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../../../cncvis/api.h"
+#include "../scene/scene.h"
+#include "pixconv.h"
+#include "quality_governor.h"
+#include "scene_render.h"
+
+#define RENDER_THREAD_BUFFERS 3
+#define RENDER_THREAD_MAX_LIGHTS 8
+
+typedef struct
+{
+    ZBuffer *zb;
+    scene_t *scene;
+    ucncCamera *camera;        /* Shared with the UI thread; copied under the scene lock */
+    ucncLight **lights;
+    const int *light_count;
+
+    uint8_t *buffers[RENDER_THREAD_BUFFERS]; /* Canvas-format frames */
+    int width;
+    int height;
+    int stride;                /* Bytes per canvas row */
+    pixconv_format_t format;   /* Canvas pixel format */
+    bool zero_copy;            /* ZBuffer layout equals the canvas: TinyGL draws into the back buffer */
+    scene_collision_t *collision; /* Optional collision checker run with every frame, owned by the caller */
+    float interaction_scale;   /* Resolution fraction while render_state_interacting(); 0 or 1 = full */
+    float target_fps;          /* Frame rate the quality governor holds; 0 = governor off */
+
+    /* Called on the render thread after each published frame, e.g. to wake the UI loop */
+    void (*frame_ready)(void *arg);
+    void *frame_ready_arg;
+} render_thread_config_t;
+
+typedef struct
+{
+    uint64_t published;   /* Frames handed to LVGL */
+    uint64_t presented;   /* Frames LVGL picked up */
+    uint64_t dropped;     /* Replaced before LVGL picked them up */
+    uint64_t duplicated;  /* UI passes that kept showing the old frame while a new one was being drawn */
+    uint64_t full_frames;
+    uint64_t rect_frames;
+    uint64_t rect_pixels;
+    uint64_t scaled_frames; /* Rendered at interaction_scale */
+    uint64_t culled_actors; /* Actors skipped by frustum culling, summed over frames */
+    uint32_t culled_last;   /* The same for the last frame */
+    uint64_t matrices;      /* World matrices recomputed, summed over frames */
+    uint32_t matrices_last; /* The same for the last frame */
+    uint32_t collisions;    /* Colliding actor pairs in the newest frame */
+    uint64_t joints_timestamp_us; /* Controller time of the joint batch shown by the newest frame */
+} render_thread_stats_t;
+
+bool render_thread_start(const render_thread_config_t *config);
+void render_thread_stop(void);
+
+void render_thread_lock_scene(void);
+void render_thread_unlock_scene(void);
+
+/*
+ * Applies one controller status frame (scene_cncvis_apply_joints) under the
+ * scene lock and marks the scene dirty once for the whole batch. Safe from
+ * any thread, e.g. the one reading the controller. Returns the number of
+ * joints set (0 before render_thread_start), or -1 if the batch was older
+ * than the last one.
+ */
+int render_thread_apply_joints(const int *joints, const float *values, int count, uint64_t timestamp_us);
+
+/* Joint handle of an assembly for render_thread_apply_joints (scene_find_node), or -1 */
+int render_thread_find_joint(const char *assembly);
+
+/*
+ * Returns the newest finished frame, or NULL if there is none since the last
+ * call. *changed is the canvas area that differs from the previously taken
+ * frame. Call from the LVGL thread only.
+ */
+uint8_t *render_thread_take_frame(render_rect_t *changed);
+
+void render_thread_get_stats(render_thread_stats_t *stats);
+
+/* Copy of the quality governor: current level, knobs and why it is there */
+void render_thread_get_quality(quality_governor_t *quality);
+
+#endif // RENDER_THREAD_H
@@ -0,0 +1,607 @@
+/**
+ * @file scene_render.c
+ * @brief Draws the scene mirror with TinyGL, limited to a dirty rectangle when possible.
+ */
+
+#include "scene_render.h"
+#include "frame_profiler.h"
+#include "render_state.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+void scene_render_init(scene_renderer_t *r, scene_t *scene, ZBuffer *zb, ucncCamera *camera,
+                       ucncLight **lights, int light_count)
+{
+    memset(r, 0, sizeof(*r));
+    r->scene = scene;
+    r->zb = zb;
+    r->camera = camera;
+    r->lights = lights;
+    r->light_count = light_count;
+    r->max_lights = light_count;
+    r->full_frame_ratio = 0.6f;
+    r->resolution_scale = 1.0f;
+}
+
+void scene_render_release(scene_renderer_t *r)
+{
+    for (int i = 0; i < r->list_count; i++)
+    {
+        if (r->lists[i].list != 0)
+            glDeleteLists(r->lists[i].list, 1);
+    }
+    free(r->lists);
+    r->lists = NULL;
+    r->list_count = 0;
+    r->list_triangles = 0;
+    free(r->backdrop_pixels);
+    free(r->backdrop_depth);
+    r->backdrop_pixels = NULL;
+    r->backdrop_depth = NULL;
+    r->have_backdrop = false;
+}
+
+bool scene_render_project_bounds(const float view_proj[16], const aabb_t *bounds,
+                                 int width, int height, render_rect_t *out)
+{
+    if (aabb_is_empty(bounds))
+        return false;
+
+    float min_x = FLT_MAX, min_y = FLT_MAX, max_x = -FLT_MAX, max_y = -FLT_MAX;
+    for (int i = 0; i < 8; i++)
+    {
+        float x = (i & 1) ? bounds->max[0] : bounds->min[0];
+        float y = (i & 2) ? bounds->max[1] : bounds->min[1];
+        float z = (i & 4) ? bounds->max[2] : bounds->min[2];
+        const float *m = view_proj;
+        float cx = m[0] * x + m[4] * y + m[8] * z + m[12];
+        float cy = m[1] * x + m[5] * y + m[9] * z + m[13];
+        float cw = m[3] * x + m[7] * y + m[11] * z + m[15];
+
+        if (cw <= 1e-5f)
+        {
+            /* Box reaches behind the eye: assume it covers the whole view */
+            out->x1 = 0;
+            out->y1 = 0;
+            out->x2 = width - 1;
+            out->y2 = height - 1;
+            return true;
+        }
+
+        float sx = (cx / cw + 1.0f) * 0.5f * (float)width;
+        float sy = (1.0f - cy / cw) * 0.5f * (float)height;
+        if (sx < min_x) min_x = sx;
+        if (sx > max_x) max_x = sx;
+        if (sy < min_y) min_y = sy;
+        if (sy > max_y) max_y = sy;
+    }
+
+    if (max_x < 0.0f || max_y < 0.0f || min_x >= (float)width || min_y >= (float)height)
+        return false;
+
+    /* One pixel of slack for TinyGL's rounding of vertex positions */
+    out->x1 = min_x < 1.0f ? 0 : (int32_t)min_x - 1;
+    out->y1 = min_y < 1.0f ? 0 : (int32_t)min_y - 1;
+    out->x2 = max_x >= (float)(width - 2) ? width - 1 : (int32_t)max_x + 1;
+    out->y2 = max_y >= (float)(height - 2) ? height - 1 : (int32_t)max_y + 1;
+    return true;
+}
+
+static void rect_union(render_rect_t *acc, bool *valid, const render_rect_t *r)
+{
+    if (!*valid)
+    {
+        *acc = *r;
+        *valid = true;
+        return;
+    }
+    if (r->x1 < acc->x1) acc->x1 = r->x1;
+    if (r->y1 < acc->y1) acc->y1 = r->y1;
+    if (r->x2 > acc->x2) acc->x2 = r->x2;
+    if (r->y2 > acc->y2) acc->y2 = r->y2;
+}
+
+/* Union of the old and new screen area of every actor whose pose or collision highlight changed */
+static bool collect_dirty_rect(const scene_renderer_t *r, int width, int height, render_rect_t *dirty)
+{
+    const scene_t *scene = r->scene;
+    bool valid = false;
+
+    for (int i = 0; i < scene->actor_count; i++)
+    {
+        const scene_actor_t *actor = &scene->actors[i];
+        render_rect_t rect;
+
+        if (!scene->nodes[actor->node].moved && actor->colliding == actor->drawn_colliding &&
+            memcmp(&actor->world_bounds, &actor->drawn_bounds, sizeof(aabb_t)) == 0)
+            continue;
+
+        if (scene_render_project_bounds(r->view_proj, &actor->drawn_bounds, width, height, &rect))
+            rect_union(dirty, &valid, &rect);
+        if (scene_render_project_bounds(r->view_proj, &actor->world_bounds, width, height, &rect))
+            rect_union(dirty, &valid, &rect);
+    }
+
+    return valid;
+}
+
+/*
+ * Pixels per world unit at an actor's bounds: the projected diagonal of the
+ * box over its world-space diagonal. Unlike scene_render_project_bounds this
+ * doesn't clamp to the view, so a close-up actor keeps its full size.
+ * Returns 0 when the box is off screen and -1 when it reaches behind the eye.
+ */
+static float pixels_per_unit(const float view_proj[16], const aabb_t *bounds, int width, int height)
+{
+    float min_x = FLT_MAX, min_y = FLT_MAX, max_x = -FLT_MAX, max_y = -FLT_MAX;
+    float dx = bounds->max[0] - bounds->min[0];
+    float dy = bounds->max[1] - bounds->min[1];
+    float dz = bounds->max[2] - bounds->min[2];
+    float diagonal = sqrtf(dx * dx + dy * dy + dz * dz);
+
+    for (int i = 0; i < 8; i++)
+    {
+        float x = (i & 1) ? bounds->max[0] : bounds->min[0];
+        float y = (i & 2) ? bounds->max[1] : bounds->min[1];
+        float z = (i & 4) ? bounds->max[2] : bounds->min[2];
+        const float *m = view_proj;
+        float cw = m[3] * x + m[7] * y + m[11] * z + m[15];
+        if (cw <= 1e-5f)
+            return -1.0f;
+
+        float sx = (m[0] * x + m[4] * y + m[8] * z + m[12]) / cw * 0.5f * (float)width;
+        float sy = (m[1] * x + m[5] * y + m[9] * z + m[13]) / cw * 0.5f * (float)height;
+        if (sx < min_x) min_x = sx;
+        if (sx > max_x) max_x = sx;
+        if (sy < min_y) min_y = sy;
+        if (sy > max_y) max_y = sy;
+    }
+
+    if (max_x < -0.5f * (float)width || min_x > 0.5f * (float)width || max_y < -0.5f * (float)height ||
+        min_y > 0.5f * (float)height)
+        return 0.0f;
+    if (diagonal <= 0.0f)
+        return -1.0f;
+    return sqrtf((max_x - min_x) * (max_x - min_x) + (max_y - min_y) * (max_y - min_y)) / diagonal;
+}
+
+/*
+ * Picks each actor's detail level for a width x height view: the coarsest
+ * one whose geometric error projects to at most SCENE_RENDER_LOD_PIXELS,
+ * doubled per lod_level step the quality governor asked for. At level 0 the
+ * error stays under half a pixel, so switching levels doesn't pop.
+ */
+static void select_lods(scene_renderer_t *r, const float view_proj[16], int width, int height)
+{
+    float tolerance = SCENE_RENDER_LOD_PIXELS * (float)(1 << (r->lod_level > 0 ? r->lod_level : 0));
+
+    r->triangles = 0;
+    for (int i = 0; i < r->scene->actor_count; i++)
+    {
+        scene_actor_t *actor = &r->scene->actors[i];
+        float scale = pixels_per_unit(view_proj, &actor->world_bounds, width, height);
+
+        actor->lod = 0;
+        if (scale >= 0.0f && scene_actor_ready(actor))
+        {
+            actor->lod = scene_actor_lod_count(actor) - 1;
+            while (actor->lod > 0 && actor->lod_error[actor->lod] * scale > tolerance)
+                actor->lod--;
+        }
+        if (actor->visible)
+            r->triangles += (uint32_t)scene_actor_mesh(actor)->triangle_count;
+    }
+}
+
+static void submit_mesh(const mesh_t *mesh)
+{
+    const uint32_t *i = mesh->indices;
+
+    glBegin(GL_TRIANGLES);
+    for (int t = 0; t < mesh->triangle_count; t++, i += 3)
+    {
+        float n[3];
+        mesh_face_normal(mesh, t, n);
+        glNormal3f(n[0], n[1], n[2]);
+        glVertex3f(mesh->x[i[0]], mesh->y[i[0]], mesh->z[i[0]]);
+        glVertex3f(mesh->x[i[1]], mesh->y[i[1]], mesh->z[i[1]]);
+        glVertex3f(mesh->x[i[2]], mesh->y[i[2]], mesh->z[i[2]]);
+    }
+    glEnd();
+}
+
+/*
+ * Display list of an actor's current level, 0 if TinyGL has none to give.
+ * Only the level in use is kept: a list of another level is deleted before
+ * the new one is compiled, so the lists hold what the last full frame drew.
+ */
+static GLuint actor_list(scene_renderer_t *r, int index)
+{
+    const scene_actor_t *actor = &r->scene->actors[index];
+    scene_render_list_t *entry;
+
+    if (r->scene->actor_count > r->list_count)
+    {
+        int count = r->scene->actor_count;
+        scene_render_list_t *lists = realloc(r->lists, (size_t)count * sizeof(*lists));
+        if (lists == NULL)
+            return 0;
+        memset(lists + r->list_count, 0, (size_t)(count - r->list_count) * sizeof(*lists));
+        r->lists = lists;
+        r->list_count = count;
+    }
+
+    entry = &r->lists[index];
+    if (entry->list != 0 && entry->level == actor->lod)
+        return entry->list;
+    if (entry->list != 0)
+    {
+        glDeleteLists(entry->list, 1);
+        r->list_triangles -= (uint64_t)entry->triangles;
+        entry->list = 0;
+    }
+
+    const mesh_t *mesh = scene_actor_mesh(actor);
+    GLuint list = glGenLists(1);
+    if (list == 0)
+        return 0;
+    glNewList(list, GL_COMPILE);
+    submit_mesh(mesh);
+    glEndList();
+    entry->list = list;
+    entry->level = actor->lod;
+    entry->triangles = mesh->triangle_count;
+    r->list_triangles += (uint64_t)mesh->triangle_count;
+    r->compiled_lists++;
+    return list;
+}
+
+static void draw_actor(scene_renderer_t *r, int index)
+{
+    const scene_actor_t *actor = &r->scene->actors[index];
+    const scene_node_t *node = &r->scene->nodes[actor->node];
+    GLuint list = r->immediate ? 0 : actor_list(r, index);
+
+    glPushMatrix();
+    glMultMatrixf(node->world);
+    glMultMatrixf(actor->local);
+    const float *color = scene_actor_color(actor);
+    glColor3f(color[0], color[1], color[2]);
+
+    /* Only the model matrix changes between frames; the geometry is replayed as compiled */
+    if (list != 0)
+        glCallList(list);
+    else
+        submit_mesh(scene_actor_mesh(actor));
+
+    glPopMatrix();
+}
+
+/* Wireframe box of an actor's bounds, standing in for it until its mesh is attached */
+static void draw_placeholder(scene_renderer_t *r, int index)
+{
+    static const uint8_t edges[12][2] = {
+        { 0, 1 }, { 2, 3 }, { 4, 5 }, { 6, 7 }, /* Along x */
+        { 0, 2 }, { 1, 3 }, { 4, 6 }, { 5, 7 }, /* Along y */
+        { 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 }, /* Along z */
+    };
+    const scene_actor_t *actor = &r->scene->actors[index];
+    const aabb_t *b = &actor->bounds;
+
+    glPushMatrix();
+    glMultMatrixf(r->scene->nodes[actor->node].world);
+    glMultMatrixf(actor->local);
+    glColor3f(actor->color[0], actor->color[1], actor->color[2]);
+    glBegin(GL_LINES);
+    for (int e = 0; e < 12; e++)
+    {
+        for (int k = 0; k < 2; k++)
+        {
+            int c = edges[e][k];
+            glVertex3f(b->min[0] + (c & 1 ? b->max[0] - b->min[0] : 0.0f),
+                       b->min[1] + (c & 2 ? b->max[1] - b->min[1] : 0.0f),
+                       b->min[2] + (c & 4 ? b->max[2] - b->min[2] : 0.0f));
+        }
+    }
+    glEnd();
+    glPopMatrix();
+}
+
+/* The actors setup_view() left visible, then boxes for those still loading (unlit: lines have no normals) */
+static void draw_actors(scene_renderer_t *r)
+{
+    bool boxes = false;
+
+    for (int i = 0; i < r->scene->actor_count; i++)
+    {
+        if (r->scene->actors[i].visible)
+            draw_actor(r, i);
+    }
+    for (int i = 0; i < r->scene->actor_count; i++)
+    {
+        const scene_actor_t *actor = &r->scene->actors[i];
+
+        if (scene_actor_ready(actor) || !scene_actor_bounds_ready(actor))
+            continue;
+        if (!boxes && !r->unlit)
+            glDisable(GL_LIGHTING);
+        boxes = true;
+        draw_placeholder(r, i);
+    }
+    if (boxes && !r->unlit)
+        glEnable(GL_LIGHTING);
+}
+
+static void fetch_camera(scene_renderer_t *r, float proj[16], float view[16])
+{
+    ucncCameraApply(r->camera);
+    glGetFloatv(GL_PROJECTION_MATRIX, proj);
+    glGetFloatv(GL_MODELVIEW_MATRIX, view);
+}
+
+/* Maps the pixel rectangle `rect` of a width x height view onto the whole clip space */
+static void pick_matrix(int width, int height, const render_rect_t *rect, float pick[16])
+{
+    float rw = (float)(rect->x2 - rect->x1 + 1);
+    float rh = (float)(rect->y2 - rect->y1 + 1);
+    float left = 2.0f * (float)rect->x1 / (float)width - 1.0f;
+    float right = 2.0f * (float)(rect->x2 + 1) / (float)width - 1.0f;
+    float top = 1.0f - 2.0f * (float)rect->y1 / (float)height;
+    float bottom = 1.0f - 2.0f * (float)(rect->y2 + 1) / (float)height;
+
+    mat4_identity(pick);
+    pick[0] = (float)width / rw;
+    pick[5] = (float)height / rh;
+    pick[12] = -(right + left) / (right - left);
+    pick[13] = -(top + bottom) / (top - bottom);
+}
+
+/* Frustum culling for the frame about to be drawn; view_proj may include a pick matrix */
+static void cull(scene_renderer_t *r, const float view_proj[16])
+{
+    frustum_t frustum;
+
+    frustum_from_matrix(&frustum, view_proj);
+    r->culled = (uint32_t)scene_cull(r->scene, &frustum);
+    r->culled_total += r->culled;
+}
+
+/*
+ * The cap goes through cncvis: only the first max_lights lights are
+ * applied. cncvis has no call to switch a light off, so lights past the cap
+ * are simply not applied; whichever of them cncvis itself enabled stays as
+ * it set it up.
+ */
+static void apply_lights(scene_renderer_t *r)
+{
+    int count = r->light_count < r->max_lights ? r->light_count : r->max_lights;
+
+    for (int i = 0; i < count; i++)
+        ucncLightApply(r->lights[i]);
+}
+
+/*
+ * Applies the cncvis camera and lights. For a sub-rectangle the viewport
+ * covers just that rectangle and the projection is pre-multiplied with a
+ * pick matrix mapping it onto the whole viewport, so TinyGL clips
+ * everything outside it before rasterizing.
+ */
+static void setup_view(scene_renderer_t *r, int width, int height, const render_rect_t *rect)
+{
+    float proj[16];
+    float view[16];
+
+    fetch_camera(r, proj, view);
+
+    if (rect == NULL)
+    {
+        glViewport(0, 0, width, height);
+        mat4_mul(r->view_proj, proj, view);
+        r->have_view_proj = true;
+        cull(r, r->view_proj);
+        select_lods(r, r->view_proj, width, height);
+    }
+    else
+    {
+        float pick[16];
+        float view_proj[16];
+
+        pick_matrix(width, height, rect, pick);
+        mat4_mul(proj, pick, proj);
+        mat4_mul(view_proj, proj, view);
+        cull(r, view_proj);
+
+        /* TinyGL's viewport origin is the ZBuffer's top-left corner, rows growing down */
+        glViewport(rect->x1, rect->y1, rect->x2 - rect->x1 + 1, rect->y2 - rect->y1 + 1);
+        glMatrixMode(GL_PROJECTION);
+        glLoadMatrixf(proj);
+    }
+
+    glMatrixMode(GL_MODELVIEW);
+    glLoadMatrixf(view);
+    apply_lights(r);
+
+    /* Only undo what an unlit frame did; cncvis owns the lighting setup otherwise */
+    if (r->unlit)
+        glDisable(GL_LIGHTING);
+    else if (r->lighting_off)
+        glEnable(GL_LIGHTING);
+    r->lighting_off = r->unlit;
+}
+
+/*
+ * Starts a full frame with the layer behind the actors, cncvis' background,
+ * axes and on-screen display (or a plain clear without a backdrop hook),
+ * and keeps a copy of its colour and depth to put back under dirty
+ * rectangles later.
+ */
+static void draw_backdrop(scene_renderer_t *r)
+{
+    ZBuffer *zb = r->zb;
+    size_t pixel_bytes = (size_t)zb->linesize * (size_t)zb->ysize;
+    size_t depth_bytes = (size_t)zb->xsize * (size_t)zb->ysize * sizeof(*zb->zbuf);
+
+    if (r->backdrop)
+        r->backdrop(r->backdrop_arg);
+    else
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    if (r->backdrop_pixels == NULL)
+        r->backdrop_pixels = malloc(pixel_bytes);
+    if (r->backdrop_depth == NULL)
+        r->backdrop_depth = malloc(depth_bytes);
+    r->have_backdrop = r->backdrop_pixels != NULL && r->backdrop_depth != NULL;
+    if (r->have_backdrop)
+    {
+        memcpy(r->backdrop_pixels, zb->pbuf, pixel_bytes);
+        memcpy(r->backdrop_depth, zb->zbuf, depth_bytes);
+    }
+    r->backdrop_stale = false;
+}
+
+/* Puts the backdrop's colour and depth back under `rect`; both buffers are row-major, zbuf xsize wide */
+static void restore_backdrop(scene_renderer_t *r, const render_rect_t *rect)
+{
+    ZBuffer *zb = r->zb;
+    size_t bytes_per_pixel = (size_t)(zb->linesize / zb->xsize);
+    size_t width = (size_t)(rect->x2 - rect->x1 + 1);
+
+    for (int y = rect->y1; y <= rect->y2; y++)
+    {
+        size_t pixel = (size_t)y * (size_t)zb->linesize + (size_t)rect->x1 * bytes_per_pixel;
+        size_t depth = ((size_t)y * (size_t)zb->xsize + (size_t)rect->x1) * sizeof(*zb->zbuf);
+
+        memcpy((uint8_t *)zb->pbuf + pixel, (const uint8_t *)r->backdrop_pixels + pixel, width * bytes_per_pixel);
+        memcpy((uint8_t *)zb->zbuf + depth, (const uint8_t *)r->backdrop_depth + depth, width * sizeof(*zb->zbuf));
+    }
+}
+
+/*
+ * Nearest-neighbour upscale of the top-left src_w x src_h pixels over
+ * width x height, in place. Walking backwards from the last pixel, every
+ * source pixel lies at or before the one being written, so nothing is
+ * overwritten before it is read.
+ */
+static void upscale_in_place(uint8_t *pixels, int linesize, int bytes_per_pixel, int src_w, int src_h,
+                             int width, int height)
+{
+    for (int y = height - 1; y >= 0; y--)
+    {
+        uint8_t *dst = pixels + (size_t)y * (size_t)linesize;
+        const uint8_t *src = pixels + (size_t)(y * src_h / height) * (size_t)linesize;
+
+        if (bytes_per_pixel == 2)
+        {
+            for (int x = width - 1; x >= 0; x--)
+                ((uint16_t *)dst)[x] = ((const uint16_t *)src)[x * src_w / width];
+        }
+        else
+        {
+            for (int x = width - 1; x >= 0; x--)
+                ((uint32_t *)dst)[x] = ((const uint32_t *)src)[x * src_w / width];
+        }
+    }
+}
+
+/*
+ * Whole view at resolution_scale into the top-left corner of the ZBuffer,
+ * upscaled over all of it. Only the actors: the backdrop comes back with
+ * the next full-resolution frame.
+ */
+static void draw_scaled(scene_renderer_t *r, int width, int height)
+{
+    int scaled_w = (int)((float)width * r->resolution_scale + 0.5f);
+    int scaled_h = (int)((float)height * r->resolution_scale + 0.5f);
+
+    if (scaled_w < 1) scaled_w = 1;
+    if (scaled_h < 1) scaled_h = 1;
+
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    setup_view(r, scaled_w, scaled_h, NULL);
+    draw_actors(r);
+    glViewport(0, 0, width, height);
+
+    upscale_in_place((uint8_t *)r->zb->pbuf, r->zb->linesize, r->zb->linesize / r->zb->xsize, scaled_w,
+                     scaled_h, width, height);
+}
+
+bool scene_render_frame(scene_renderer_t *r, uint32_t reasons, render_rect_t *drawn)
+{
+    int width = r->zb->xsize;
+    int height = r->zb->ysize;
+    render_rect_t dirty;
+    bool scaled = r->resolution_scale > 0.0f && r->resolution_scale < 1.0f;
+    bool full = !r->have_view_proj || !r->have_backdrop || r->degraded || scaled ||
+                (reasons & ~(uint32_t)RENDER_DIRTY_MOTION) != 0;
+    uint64_t mark = frame_profiler_now_us();
+
+    scene_update(r->scene);
+    if (r->collision)
+    {
+        uint64_t start = frame_profiler_now_us();
+        r->collisions = (uint32_t)scene_collision_update(r->collision, r->scene);
+        r->collision_us = (uint32_t)(frame_profiler_now_us() - start);
+    }
+    r->matrices = (uint32_t)r->scene->matrices_updated;
+    r->matrices_total += r->matrices;
+    r->raster_us = 0;
+
+    if (!full)
+    {
+        if (!collect_dirty_rect(r, width, height, &dirty))
+        {
+            scene_mark_drawn(r->scene);
+            r->transform_us = frame_profiler_lap(&mark);
+            return false;
+        }
+
+        float area = (float)(dirty.x2 - dirty.x1 + 1) * (float)(dirty.y2 - dirty.y1 + 1);
+        full = area > r->full_frame_ratio * (float)width * (float)height;
+    }
+    r->transform_us = frame_profiler_lap(&mark);
+
+    if (scaled)
+    {
+        draw_scaled(r, width, height);
+
+        drawn->x1 = 0;
+        drawn->y1 = 0;
+        drawn->x2 = width - 1;
+        drawn->y2 = height - 1;
+        r->scaled_frames++;
+    }
+    else if (full)
+    {
+        draw_backdrop(r);
+        setup_view(r, width, height, NULL);
+        draw_actors(r);
+
+        drawn->x1 = 0;
+        drawn->y1 = 0;
+        drawn->x2 = width - 1;
+        drawn->y2 = height - 1;
+        r->full_frames++;
+    }
+    else
+    {
+        restore_backdrop(r, &dirty);
+        setup_view(r, width, height, &dirty);
+
+        /* setup_view culled against the rectangle: everything overlapping it is redrawn */
+        draw_actors(r);
+        glViewport(0, 0, width, height);
+        r->backdrop_stale = r->backdrop != NULL;
+
+        *drawn = dirty;
+        r->rect_frames++;
+        r->rect_pixels += (uint64_t)(dirty.x2 - dirty.x1 + 1) * (uint64_t)(dirty.y2 - dirty.y1 + 1);
+    }
+
+    r->degraded = scaled;
+    scene_mark_drawn(r->scene);
+    r->raster_us = frame_profiler_lap(&mark);
+    return true;
+}
@@ -0,0 +1,133 @@
+/**
+ * @file scene_render.h
+ * @brief Draws the scene mirror with TinyGL, limited to a dirty rectangle when possible.
+ *
+ * Camera and lights still come from cncvis (ucncCameraApply/ucncLightApply);
+ * geometry comes from the scene mirror. A full frame starts with the
+ * `backdrop` hook, which draws everything cncvis shows besides the actors
+ * (scene_cncvis_render_backdrop: background, axes, on-screen display), and
+ * keeps a copy of it. When only joints moved, the old and new screen bounds
+ * of the actors that moved are unioned into one rectangle; the backdrop is
+ * put back there and the actors are rasterized through a viewport covering
+ * just that rectangle. Everything else on the canvas is left as drawn in the
+ * previous frame. Whatever of the backdrop follows the joints or counts
+ * frames is then behind until the next full frame (`backdrop_stale`).
+ *
+ * With `resolution_scale` below 1 (while the operator drags the camera) the
+ * actors alone are rendered into the top-left part of the ZBuffer and
+ * upscaled over the full frame. The first frame back at scale 1 is always
+ * full.
+ *
+ * Every full frame picks each actor's mesh detail level (scene.h) from its
+ * projected size: the coarsest level whose error stays under
+ * SCENE_RENDER_LOD_PIXELS on screen, a tolerance `lod_level` doubles per
+ * step. Dirty-rectangle frames keep the levels of the last full frame so
+ * redrawn parts match the pixels around them.
+ *
+ * Before anything is submitted, the scene's node hierarchy is culled against
+ * the view frustum (scene_cull), narrowed to the dirty rectangle on partial
+ * frames; actors outside are never submitted.
+ *
+ * Each actor's current level is compiled into a display list the first
+ * time it is drawn and replayed afterwards, so a frame only pushes the model
+ * matrices; when a full frame picks another level, that list replaces the
+ * old one. TinyGL keeps a list as its op stream, about
+ * SCENE_RENDER_LIST_TRIANGLE_BYTES per triangle (152 on 64-bit hosts).
+ * `immediate` goes back to sending every vertex each frame.
+ *
+ * With `collision` set, every frame runs scene_collision_update() right
+ * after scene_update(); actors whose highlight changed are redrawn like
+ * moved ones.
+ */
+
+#ifndef SCENE_RENDER_H
+#define SCENE_RENDER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../../../cncvis/api.h"
+#include "../scene/scene.h"
+#include "../scene/scene_collision.h"
+#include "render_rect.h"
+
+#define SCENE_RENDER_LOD_PIXELS 0.5f /* Screen-space error allowed at lod_level 0 */
+/* glNormal3f (4 GLParams) and 3 glVertex3f (5 each, as glVertex4f); a GLParam is pointer-sized */
+#define SCENE_RENDER_LIST_TRIANGLE_BYTES (19 * sizeof(void *))
+
+typedef struct
+{
+    GLuint list;            /* 0 until compiled */
+    int level;              /* Detail level it holds */
+    int triangles;
+} scene_render_list_t;
+
+typedef struct
+{
+    scene_t *scene;
+    ZBuffer *zb;
+    ucncCamera *camera;
+    ucncLight **lights;
+    int light_count;
+    int max_lights;         /* Only lights[0..max_lights) are applied */
+    scene_collision_t *collision; /* Checked after each scene_update when set; owned by the caller */
+
+    float full_frame_ratio; /* Dirty area fraction above which the full frame is redrawn */
+    float resolution_scale; /* Fraction of the ZBuffer size to render at, 1 = full */
+    bool degraded;          /* The frame on screen was rendered at reduced resolution */
+    int lod_level;          /* Detail bias: each step doubles the allowed screen-space error */
+    bool unlit;             /* Flat actor colours instead of the cncvis lights */
+    bool lighting_off;      /* GL_LIGHTING was disabled for an unlit frame */
+    bool immediate;         /* glBegin/glEnd every frame instead of display lists */
+
+    scene_render_list_t *lists; /* Per actor, its level in use */
+    int list_count;
+    uint64_t compiled_lists; /* Lists compiled so far, replaced ones included */
+    uint64_t list_triangles; /* Triangles held by the current lists */
+
+    void (*backdrop)(void *arg); /* Draws the layer behind the actors over the whole ZBuffer; NULL = a clear */
+    void *backdrop_arg;
+    void *backdrop_pixels;  /* Copy of the last backdrop, pbuf layout */
+    void *backdrop_depth;   /* ... and its depth, zbuf layout */
+    bool have_backdrop;
+    bool backdrop_stale;    /* Dirty rectangles were drawn since the last backdrop */
+
+    float view_proj[16];    /* Camera of the last full frame */
+    bool have_view_proj;
+
+    uint64_t full_frames;
+    uint64_t rect_frames;
+    uint64_t rect_pixels;   /* Sum of rasterized rectangle areas */
+    uint64_t scaled_frames; /* Frames rendered at reduced resolution */
+    uint32_t triangles;     /* Last full frame: triangles of the visible actors at their levels */
+    uint32_t culled;        /* Last frame: actors skipped by frustum culling */
+    uint64_t culled_total;  /* Sum of `culled` over all drawn frames */
+    uint32_t matrices;      /* Last frame: world matrices scene_update recomputed */
+    uint64_t matrices_total; /* Sum of `matrices` over all frames */
+
+    uint32_t collisions;    /* Last frame: colliding actor pairs */
+
+    uint32_t transform_us;  /* Last frame: scene_update, collision checks and dirty-rectangle collection */
+    uint32_t collision_us;  /* Last frame: the collision checks alone */
+    uint32_t raster_us;     /* Last frame: clear and rasterization, 0 if nothing was drawn */
+} scene_renderer_t;
+
+void scene_render_init(scene_renderer_t *r, scene_t *scene, ZBuffer *zb, ucncCamera *camera,
+                       ucncLight **lights, int light_count);
+
+/* Deletes the compiled display lists and the backdrop copy; call on the thread owning the TinyGL context */
+void scene_render_release(scene_renderer_t *r);
+
+/*
+ * Renders one frame. `reasons` are the render_state dirty reasons; anything
+ * besides RENDER_DIRTY_MOTION forces a full frame. Returns false if nothing on
+ * screen changed, otherwise *drawn is the canvas area that was redrawn.
+ * Node poses must already be synced (scene_cncvis_sync) by the caller.
+ */
+bool scene_render_frame(scene_renderer_t *r, uint32_t reasons, render_rect_t *drawn);
+
+/* Screen rectangle covered by a world-space box; false if it is off screen */
+bool scene_render_project_bounds(const float view_proj[16], const aabb_t *bounds,
+                                 int width, int height, render_rect_t *out);
+
+#endif // SCENE_RENDER_H
@@ -0,0 +1,57 @@
+/**
+ * @file triple_buffer.c
+ * @brief Atomic index exchange behind the render thread's frame hand-off.
+ */
+
+#include "triple_buffer.h"
+
+#define TRIPLE_BUFFER_FRESH 0x4u
+#define TRIPLE_BUFFER_INDEX 0x3u
+
+void triple_buffer_init(triple_buffer_t *tb)
+{
+    tb->front = 0;
+    tb->middle = 1;
+    tb->back = 2;
+    tb->published = 0;
+    tb->dropped = 0;
+    tb->acquired = 0;
+}
+
+bool triple_buffer_pending(const triple_buffer_t *tb)
+{
+    return (__atomic_load_n(&tb->middle, __ATOMIC_ACQUIRE) & TRIPLE_BUFFER_FRESH) != 0;
+}
+
+bool triple_buffer_publish(triple_buffer_t *tb)
+{
+    /* Release: the frame written into `back` is visible before the index is */
+    uint32_t old = __atomic_exchange_n(&tb->middle, tb->back | TRIPLE_BUFFER_FRESH, __ATOMIC_ACQ_REL);
+
+    tb->back = old & TRIPLE_BUFFER_INDEX;
+    __atomic_add_fetch(&tb->published, 1, __ATOMIC_RELAXED);
+    if (old & TRIPLE_BUFFER_FRESH)
+    {
+        __atomic_add_fetch(&tb->dropped, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+    return true;
+}
+
+bool triple_buffer_acquire(triple_buffer_t *tb, int *front)
+{
+    uint32_t old;
+
+    if (!triple_buffer_pending(tb))
+    {
+        *front = (int)tb->front;
+        return false;
+    }
+
+    /* Only the producer touches middle besides us, and it never clears FRESH */
+    old = __atomic_exchange_n(&tb->middle, tb->front, __ATOMIC_ACQ_REL);
+    tb->front = old & TRIPLE_BUFFER_INDEX;
+    __atomic_add_fetch(&tb->acquired, 1, __ATOMIC_RELAXED);
+    *front = (int)tb->front;
+    return true;
+}
@@ -0,0 +1,48 @@
+/**
+ * @file triple_buffer.h
+ * @brief Lock-free single-producer/single-consumer triple buffer of frame indices.
+ *
+ * Three slots rotate between the producer (back), the consumer (front) and a
+ * shared middle slot. Publishing swaps back and middle, acquiring swaps front
+ * and middle; both are one atomic exchange, so neither side ever waits on the
+ * other. Only indices are exchanged: the frames themselves live with the
+ * caller, indexed 0..2.
+ *
+ * A publish that replaces a middle frame the consumer never picked up counts
+ * as dropped.
+ */
+
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct
+{
+    uint32_t middle;    /* Shared: slot index | TRIPLE_BUFFER_FRESH */
+    uint32_t back;      /* Producer-owned slot */
+    uint32_t front;     /* Consumer-owned slot */
+    uint64_t published; /* Written by the producer, read anywhere */
+    uint64_t dropped;
+    uint64_t acquired;  /* Written by the consumer, read anywhere */
+} triple_buffer_t;
+
+void triple_buffer_init(triple_buffer_t *tb);
+
+/* Producer: slot to draw the next frame into */
+static inline int triple_buffer_back(const triple_buffer_t *tb)
+{
+    return (int)tb->back;
+}
+
+/* Producer: true if the last published frame is still waiting for the consumer */
+bool triple_buffer_pending(const triple_buffer_t *tb);
+
+/* Producer: hands the back slot to the consumer; returns false if a waiting frame was dropped */
+bool triple_buffer_publish(triple_buffer_t *tb);
+
+/* Consumer: takes the newest frame if there is one; *front is the slot to show */
+bool triple_buffer_acquire(triple_buffer_t *tb, int *front);
+
+#endif // TRIPLE_BUFFER_H
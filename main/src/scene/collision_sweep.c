@@ -0,0 +1,284 @@
+/**
+ * @file collision_sweep.c
+ * @brief Move interpolation, per-thread scene views and the event list.
+ */
+
+#include "collision_sweep.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "scene_collision.h"
+#include "../sys/worker_pool.h"
+
+#define TWO_PI 6.28318530718f
+
+typedef struct
+{
+    scene_t *view;
+    scene_collision_t *collision;
+    collision_sweep_event_t *events;
+    int event_count;
+    int event_capacity;
+    uint64_t poses;
+    bool failed;               /* An event was lost to memory running out */
+} sweep_worker_t;
+
+typedef struct
+{
+    const collision_sweep_config_t *config;
+    sweep_worker_t workers[WORKER_POOL_MAX_THREADS];
+} sweep_t;
+
+/* A move's path: linear in every axis but the two of an arc plane, which turn about the centre */
+typedef struct
+{
+    int plane[2];
+    bool arc;
+    float start_angle;
+    float sweep;               /* Radians, negative clockwise */
+    float start_radius;
+    float end_radius;
+} path_t;
+
+static void plan_path(const gcode_move_t *move, const float start[GCODE_AXES], path_t *path)
+{
+    memset(path, 0, sizeof(*path));
+    path->arc = move->motion == GCODE_ARC_CW || move->motion == GCODE_ARC_CCW;
+    if (!path->arc)
+        return;
+
+    gcode_plane_axes(move->plane, path->plane);
+    float s0 = start[path->plane[0]] - move->center[0], s1 = start[path->plane[1]] - move->center[1];
+    float e0 = move->end[path->plane[0]] - move->center[0], e1 = move->end[path->plane[1]] - move->center[1];
+    float end_angle = atan2f(e1, e0);
+
+    path->start_angle = atan2f(s1, s0);
+    path->start_radius = sqrtf(s0 * s0 + s1 * s1);
+    path->end_radius = sqrtf(e0 * e0 + e1 * e1);
+    path->sweep = end_angle - path->start_angle;
+    /* Equal start and end angles make a full circle */
+    if (move->motion == GCODE_ARC_CW && path->sweep >= 0.0f)
+        path->sweep -= TWO_PI;
+    else if (move->motion == GCODE_ARC_CCW && path->sweep <= 0.0f)
+        path->sweep += TWO_PI;
+}
+
+static void path_pose(const gcode_move_t *move, const float start[GCODE_AXES], const path_t *path, float t,
+                      float pose[GCODE_AXES])
+{
+    for (int k = 0; k < GCODE_AXES; k++)
+        pose[k] = start[k] + (move->end[k] - start[k]) * t;
+    if (path->arc && t < 1.0f)
+    {
+        float angle = path->start_angle + path->sweep * t;
+        float radius = path->start_radius + (path->end_radius - path->start_radius) * t;
+
+        pose[path->plane[0]] = move->center[0] + radius * cosf(angle);
+        pose[path->plane[1]] = move->center[1] + radius * sinf(angle);
+    }
+}
+
+/* Poses after the start that keep every step within the configured resolution */
+static int path_samples(const collision_sweep_config_t *config, const gcode_move_t *move,
+                        const float start[GCODE_AXES], const path_t *path)
+{
+    float travel = 0.0f, turn = 0.0f, steps;
+
+    for (int k = 0; k < 3; k++)
+    {
+        bool on_arc = path->arc && (k == path->plane[0] || k == path->plane[1]);
+        float d = on_arc ? 0.0f : move->end[k] - start[k];
+        travel += d * d;
+    }
+    if (path->arc)
+    {
+        float length = fabsf(path->sweep) * fmaxf(path->start_radius, path->end_radius);
+        travel += length * length;
+    }
+    for (int k = 3; k < GCODE_AXES; k++)
+        turn = fmaxf(turn, fabsf(move->end[k] - start[k]));
+
+    steps = fmaxf(sqrtf(travel) / config->linear_step, turn / config->angular_step);
+    return steps > 1.0f ? (int)fminf(ceilf(steps), 1e7f) : 1;
+}
+
+/* Keeps the smallest distance per pair within the events of the running move, which start at `first` */
+static void record(sweep_worker_t *w, int first, const gcode_move_t *move, int index,
+                   const scene_collision_pair_t *pair)
+{
+    for (int i = first; i < w->event_count; i++)
+    {
+        collision_sweep_event_t *event = &w->events[i];
+        if (event->a == pair->a && event->b == pair->b)
+        {
+            event->distance = fminf(event->distance, pair->distance);
+            return;
+        }
+    }
+    if (w->event_count == w->event_capacity)
+    {
+        int capacity = w->event_capacity ? w->event_capacity * 2 : 64;
+        collision_sweep_event_t *events = realloc(w->events, (size_t)capacity * sizeof(*events));
+        if (events == NULL)
+        {
+            w->failed = true;
+            return;
+        }
+        w->events = events;
+        w->event_capacity = capacity;
+    }
+    w->events[w->event_count++] = (collision_sweep_event_t){ move->line, index, pair->a, pair->b, pair->distance };
+}
+
+static void check_pose(const collision_sweep_config_t *config, sweep_worker_t *w, const float pose[GCODE_AXES],
+                       int first, const gcode_move_t *move, int index)
+{
+    const scene_collision_pair_t *pairs;
+    int count;
+
+    for (int k = 0; k < GCODE_AXES; k++)
+    {
+        if (config->joints[k] >= 0)
+            scene_set_joint(w->view, config->joints[k], pose[k]);
+    }
+    scene_update(w->view);
+    scene_collision_update(w->collision, w->view);
+    pairs = scene_collision_pairs(w->collision, &count);
+    for (int p = 0; p < count; p++)
+        record(w, first, move, index, &pairs[p]);
+    w->poses++;
+}
+
+static void sweep_moves(void *arg, int begin, int end, int worker)
+{
+    sweep_t *sweep = arg;
+    const collision_sweep_config_t *config = sweep->config;
+    const gcode_program_t *program = config->program;
+    sweep_worker_t *w = &sweep->workers[worker];
+
+    for (int i = begin; i < end; i++)
+    {
+        const gcode_move_t *move = &program->moves[i];
+        const float *start = i > 0 ? program->moves[i - 1].end : program->start;
+        int first = w->event_count;
+        float pose[GCODE_AXES];
+        path_t path;
+
+        plan_path(move, start, &path);
+        int samples = path_samples(config, move, start, &path);
+        for (int k = i > 0 ? 1 : 0; k <= samples; k++)
+        {
+            path_pose(move, start, &path, (float)k / (float)samples, pose);
+            check_pose(config, w, pose, first, move, i);
+        }
+    }
+}
+
+static int event_order(const void *x, const void *y)
+{
+    const collision_sweep_event_t *a = x, *b = y;
+
+    if (a->move != b->move)
+        return (a->move > b->move) - (a->move < b->move);
+    if (a->a != b->a)
+        return (a->a > b->a) - (a->a < b->a);
+    return (a->b > b->b) - (a->b < b->b);
+}
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void release_workers(sweep_t *sweep, int threads)
+{
+    for (int t = 0; t < threads; t++)
+    {
+        scene_collision_destroy(sweep->workers[t].collision);
+        scene_destroy(sweep->workers[t].view);
+        free(sweep->workers[t].events);
+    }
+}
+
+bool collision_sweep_run(const collision_sweep_config_t *config, collision_sweep_result_t *result)
+{
+    double start = now_seconds();
+    worker_pool_t *pool = worker_pool_create(config->threads); /* NULL runs the sweep on this thread alone */
+    int threads = worker_pool_threads(pool);
+    sweep_t *sweep = calloc(1, sizeof(*sweep));
+    bool ok = sweep != NULL;
+
+    memset(result, 0, sizeof(*result));
+    result->first_collision = -1;
+    for (int t = 0; ok && t < threads; t++)
+    {
+        sweep_worker_t *w = &sweep->workers[t];
+
+        w->view = scene_create_view(config->scene);
+        w->collision = w->view ? scene_collision_create(w->view, config->allow_adjacent) : NULL;
+        ok = w->collision != NULL &&
+             (config->allow_list == NULL || scene_collision_allow_list(w->collision, w->view, config->allow_list) >= 0);
+        if (ok)
+            scene_collision_set_clearance(w->collision, config->clearance);
+    }
+
+    if (ok)
+    {
+        /* Short programs get finer chunks so every thread still has something to steal from */
+        int count = config->program->move_count;
+        int grain = count / (threads * 16);
+
+        grain = grain < 1 ? 1 : grain > COLLISION_SWEEP_GRAIN ? COLLISION_SWEEP_GRAIN : grain;
+        sweep->config = config;
+        result->steals = worker_pool_run_ranges(pool, sweep_moves, sweep, count, grain);
+        for (int t = 0; t < threads; t++)
+        {
+            result->event_count += sweep->workers[t].event_count;
+            result->poses += sweep->workers[t].poses;
+            ok = ok && !sweep->workers[t].failed;
+        }
+        result->events = malloc((size_t)(result->event_count > 0 ? result->event_count : 1) * sizeof(*result->events));
+        ok = ok && result->events != NULL;
+    }
+
+    if (ok)
+    {
+        int n = 0;
+        for (int t = 0; t < threads; t++)
+        {
+            memcpy(&result->events[n], sweep->workers[t].events,
+                   (size_t)sweep->workers[t].event_count * sizeof(*result->events));
+            n += sweep->workers[t].event_count;
+        }
+        qsort(result->events, (size_t)n, sizeof(*result->events), event_order);
+        for (int i = 0; i < n; i++)
+        {
+            if (result->events[i].distance > 0.0f)
+                continue;
+            if (result->collisions++ == 0)
+                result->first_collision = i;
+        }
+        result->threads = threads;
+    }
+    else
+        collision_sweep_free(result);
+
+    if (sweep)
+        release_workers(sweep, threads);
+    free(sweep);
+    worker_pool_destroy(pool);
+    result->seconds = now_seconds() - start;
+    return ok;
+}
+
+void collision_sweep_free(collision_sweep_result_t *result)
+{
+    free(result->events);
+    memset(result, 0, sizeof(*result));
+    result->first_collision = -1;
+}
@@ -0,0 +1,69 @@
+/**
+ * @file collision_sweep.h
+ * @brief Offline collision verification of a whole G-code program.
+ *
+ * Every move of a program (gcode.h) is swept through at a fixed resolution:
+ * the program axes drive scene nodes as joint values (scene_set_joint), and
+ * each pose goes through scene_update() and scene_collision_update() like a
+ * rendered frame would. A move is sampled often enough that no program
+ * axis travels more than linear_step (X/Y/Z together, along the arc for
+ * G2/G3) or angular_step (each rotary axis) between two poses.
+ *
+ * The moves are spread over a worker pool with worker_pool_run_ranges():
+ * each thread owns a view of the scene (scene_create_view) and a collision
+ * checker of its own, so threads share only the read-only meshes and
+ * hierarchies. Runs of consecutive moves stay on one thread, which keeps
+ * the incremental matrix and pair updates effective, and threads that run
+ * out of moves steal from the others.
+ */
+
+#ifndef COLLISION_SWEEP_H
+#define COLLISION_SWEEP_H
+
+#include "gcode.h"
+#include "scene.h"
+
+#define COLLISION_SWEEP_GRAIN 64   /* Most moves a thread takes off its share at a time */
+
+typedef struct
+{
+    const scene_t *scene;          /* Loaded and updated; only read during the sweep */
+    const gcode_program_t *program;
+    int joints[GCODE_AXES];        /* Node each program axis drives, -1 = none */
+    float linear_step;             /* Largest X/Y/Z travel between poses */
+    float angular_step;            /* Largest rotary step between poses, degrees */
+    float clearance;               /* Report pairs closer than this as near misses; 0 = contact only */
+    bool allow_adjacent;           /* As scene_collision_create() */
+    const char *allow_list;        /* As scene_collision_allow_list(), NULL = none */
+    int threads;                   /* Counting the caller; 0 = one per CPU */
+} collision_sweep_config_t;
+
+typedef struct
+{
+    uint32_t line;                 /* Program line of the move */
+    int move;
+    int a;                         /* Actor indices, a < b */
+    int b;
+    float distance;                /* 0 for a collision, else the smallest gap during the move */
+} collision_sweep_event_t;
+
+typedef struct
+{
+    collision_sweep_event_t *events; /* One per move and actor pair, in program order */
+    int event_count;
+    int collisions;                /* Events at distance 0 */
+    int first_collision;           /* Index of the earliest, -1 = none */
+    uint64_t poses;
+    int steals;
+    int threads;
+    double seconds;
+} collision_sweep_result_t;
+
+/*
+ * Sweeps the whole program. Returns false, with *result empty, if memory
+ * runs out or the allow list doesn't parse.
+ */
+bool collision_sweep_run(const collision_sweep_config_t *config, collision_sweep_result_t *result);
+void collision_sweep_free(collision_sweep_result_t *result);
+
+#endif // COLLISION_SWEEP_H
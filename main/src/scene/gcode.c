@@ -0,0 +1,313 @@
+/**
+ * @file gcode.c
+ * @brief Line-by-line G-code word parser and modal state for the move list.
+ */
+
+#include "gcode.h"
+
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INCH 25.4f
+
+typedef struct
+{
+    int motion;                /* gcode_motion_t, modal */
+    int plane;
+    bool relative;             /* G91 */
+    bool arc_absolute;         /* G90.1; I/J/K are relative to the start otherwise */
+    float scale;               /* 1 for G21, INCH for G20 */
+    float position[GCODE_AXES];
+} modal_t;
+
+/* The words of one block */
+typedef struct
+{
+    int motion;                /* -1 = none on this line */
+    bool skip;                 /* A code whose motion isn't modelled */
+    unsigned axes;             /* Bit per axis word */
+    float axis[GCODE_AXES];
+    unsigned offsets;          /* Bit per I/J/K word */
+    float offset[3];
+    bool has_radius;
+    float radius;
+} block_t;
+
+int gcode_axis_index(char letter)
+{
+    static const char axes[GCODE_AXES] = { 'X', 'Y', 'Z', 'A', 'B', 'C' };
+
+    for (int k = 0; k < GCODE_AXES; k++)
+    {
+        if (toupper((unsigned char)letter) == axes[k])
+            return k;
+    }
+    return -1;
+}
+
+void gcode_plane_axes(int plane, int axes[2])
+{
+    static const int planes[3][2] = { { 0, 1 }, { 2, 0 }, { 1, 2 } };
+
+    axes[0] = planes[plane][0];
+    axes[1] = planes[plane][1];
+}
+
+static bool fail(gcode_program_t *program, int line, const char *message)
+{
+    program->error_line = line;
+    snprintf(program->error, sizeof(program->error), "%s", message);
+    return false;
+}
+
+/* Modal G codes; the rest that moves the machine in ways not modelled here sets `skip` */
+static void apply_g(modal_t *modal, block_t *block, float value)
+{
+    int code = (int)lroundf(value * 10.0f);
+
+    switch (code)
+    {
+    case 0: case 10: case 20: case 30:
+        block->motion = code / 10;
+        break;
+    case 170: case 180: case 190:
+        modal->plane = code / 10 - 17;
+        break;
+    case 200: modal->scale = INCH; break;
+    case 210: modal->scale = 1.0f; break;
+    case 900: modal->relative = false; break;
+    case 910: modal->relative = true; break;
+    case 901: modal->arc_absolute = true; break;
+    case 911: modal->arc_absolute = false; break;
+    case 280: case 281: case 300: case 301: case 530: case 920: case 921: case 922: case 923:
+    case 382: case 383: case 384: case 385: case 730: case 760:
+        block->skip = true;
+        break;
+    default:
+        if (code >= 810 && code <= 890)
+            block->skip = true;
+        break;
+    }
+}
+
+/*
+ * Decimal number after an address letter. Not strtof(): G-code has no
+ * exponents or hex, and "G0X10" must not read as 0x10.
+ */
+static bool scan_number(const char *p, const char **end, float *value)
+{
+    char digits[32];
+    size_t n = 0;
+    bool any = false;
+
+    while (*p == ' ' || *p == '\t')
+        p++;
+    if (*p == '+' || *p == '-')
+        digits[n++] = *p++;
+    while ((isdigit((unsigned char)*p) || *p == '.') && n < sizeof(digits) - 1)
+    {
+        any |= *p != '.';
+        digits[n++] = *p++;
+    }
+    digits[n] = '\0';
+    *end = p;
+    *value = any ? strtof(digits, NULL) : 0.0f;
+    return any;
+}
+
+static bool parse_block(gcode_program_t *program, int line, const char *text, modal_t *modal, block_t *block)
+{
+    const char *p = text;
+
+    memset(block, 0, sizeof(*block));
+    block->motion = -1;
+    while (*p != '\0')
+    {
+        char letter = (char)toupper((unsigned char)*p);
+        float value;
+
+        if (isspace((unsigned char)*p) || *p == '/' || *p == '%')
+        {
+            p++;
+            continue;
+        }
+        if (*p == ';')
+            break;
+        if (*p == '(')
+        {
+            const char *close = strchr(p, ')');
+            if (close == NULL)
+                return fail(program, line, "unterminated comment");
+            p = close + 1;
+            continue;
+        }
+        if (!isalpha((unsigned char)*p))
+            return fail(program, line, "expected an address letter");
+        if (!scan_number(p + 1, &p, &value))
+        {
+            /* O-words and some dialects put text after the letter; only motion words need a number */
+            if (letter == 'O')
+                break;
+            return fail(program, line, "address letter without a number");
+        }
+        int axis = gcode_axis_index(letter);
+        if (letter == 'G')
+            apply_g(modal, block, value);
+        else if (axis >= 0)
+        {
+            block->axes |= 1u << axis;
+            block->axis[axis] = value;
+        }
+        else if (letter >= 'I' && letter <= 'K')
+        {
+            block->offsets |= 1u << (letter - 'I');
+            block->offset[letter - 'I'] = value;
+        }
+        else if (letter == 'R')
+        {
+            block->has_radius = true;
+            block->radius = value;
+        }
+    }
+    return true;
+}
+
+/* Centre of an R-format arc: the short way round for R > 0, the long way for R < 0 */
+static bool radius_center(const float start[2], const float end[2], float radius, bool clockwise, float center[2])
+{
+    float dx = end[0] - start[0], dy = end[1] - start[1];
+    float chord = sqrtf(dx * dx + dy * dy);
+
+    if (chord == 0.0f || radius == 0.0f)
+        return false;
+    float half = chord * 0.5f, r = fabsf(radius);
+    if (half > r * 1.0001f)
+        return false;
+    float h = sqrtf(fmaxf(r * r - half * half, 0.0f));
+
+    /* Left of the direction of travel for a short counter-clockwise arc */
+    if (clockwise != (radius < 0.0f))
+        h = -h;
+    center[0] = start[0] + dx * 0.5f - dy / chord * h;
+    center[1] = start[1] + dy * 0.5f + dx / chord * h;
+    return true;
+}
+
+static bool add_move(gcode_program_t *program, int *capacity, const gcode_move_t *move)
+{
+    if (program->move_count == *capacity)
+    {
+        int grown = *capacity ? *capacity * 2 : 4096;
+        gcode_move_t *moves = realloc(program->moves, (size_t)grown * sizeof(*moves));
+        if (moves == NULL)
+            return false;
+        program->moves = moves;
+        *capacity = grown;
+    }
+    program->moves[program->move_count++] = *move;
+    return true;
+}
+
+static bool apply_block(gcode_program_t *program, int line, modal_t *modal, const block_t *block, int *capacity)
+{
+    gcode_move_t move;
+    int plane[2];
+
+    if (block->skip)
+    {
+        program->ignored++;
+        return true;
+    }
+    if (block->motion >= 0)
+        modal->motion = block->motion;
+    if (block->axes == 0)
+        return true;
+
+    memset(&move, 0, sizeof(move));
+    move.line = (uint32_t)line;
+    move.motion = (uint8_t)modal->motion;
+    move.plane = (uint8_t)modal->plane;
+    for (int k = 0; k < GCODE_AXES; k++)
+    {
+        float value = block->axis[k] * (k < 3 ? modal->scale : 1.0f);
+
+        if (!(block->axes & (1u << k)))
+            move.end[k] = modal->position[k];
+        else
+            move.end[k] = modal->relative ? modal->position[k] + value : value;
+    }
+
+    if (move.motion == GCODE_ARC_CW || move.motion == GCODE_ARC_CCW)
+    {
+        float start[2], end[2];
+
+        gcode_plane_axes(modal->plane, plane);
+        for (int i = 0; i < 2; i++)
+        {
+            start[i] = modal->position[plane[i]];
+            end[i] = move.end[plane[i]];
+        }
+        if (block->has_radius)
+        {
+            if (!radius_center(start, end, block->radius * modal->scale, move.motion == GCODE_ARC_CW, move.center))
+                return fail(program, line, "arc radius doesn't reach the end point");
+        }
+        else if (block->offsets != 0)
+        {
+            for (int i = 0; i < 2; i++)
+            {
+                float offset = block->offset[plane[i]] * modal->scale;
+                move.center[i] = modal->arc_absolute ? offset : start[i] + offset;
+            }
+        }
+        else
+            return fail(program, line, "arc without I/J/K or R");
+    }
+
+    if (!add_move(program, capacity, &move))
+        return fail(program, 0, "out of memory");
+    program->axes_used |= block->axes;
+    memcpy(modal->position, move.end, sizeof(modal->position));
+    return true;
+}
+
+bool gcode_load(const char *path, const float start[GCODE_AXES], gcode_program_t *program)
+{
+    FILE *fp = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+    modal_t modal = { .motion = GCODE_RAPID, .scale = 1.0f };
+    char *text = NULL;
+    size_t size = 0;
+    int capacity = 0;
+    bool ok = true;
+
+    memset(program, 0, sizeof(*program));
+    if (start)
+        memcpy(program->start, start, sizeof(program->start));
+    memcpy(modal.position, program->start, sizeof(modal.position));
+    if (fp == NULL)
+        return fail(program, 0, "cannot open the program");
+
+    while (ok && getline(&text, &size, fp) >= 0)
+    {
+        block_t block;
+        int line = ++program->line_count;
+
+        ok = parse_block(program, line, text, &modal, &block) && apply_block(program, line, &modal, &block, &capacity);
+    }
+    if (ok && ferror(fp))
+        ok = fail(program, 0, "read error");
+    free(text);
+    if (fp != stdin)
+        fclose(fp);
+    return ok;
+}
+
+void gcode_free(gcode_program_t *program)
+{
+    free(program->moves);
+    program->moves = NULL;
+    program->move_count = 0;
+}
@@ -0,0 +1,71 @@
+/**
+ * @file gcode.h
+ * @brief Reads the motion of an RS-274 (G-code) program into a flat move list.
+ *
+ * Only what moves the machine is kept: G0 rapids, G1 lines and G2/G3 arcs
+ * (I/J/K centre or R radius, in the G17/G18/G19 plane, helical with the
+ * third axis and any rotary axes interpolated along), with G90/G91,
+ * G90.1/G91.1 and G20/G21 applied so every move ends in absolute program
+ * coordinates, millimetres for X/Y/Z and degrees for A/B/C. Feeds, spindle,
+ * tool and M codes don't change the path and are skipped; so are codes
+ * whose motion depends on controller state the program doesn't carry
+ * (G28 homing, G53 machine coordinates, G92 offsets, canned cycles), which
+ * are counted in `ignored` instead.
+ *
+ * A program is read in one pass with one move per line at most, so the
+ * list stays a compact array even for files of millions of lines.
+ */
+
+#ifndef GCODE_H
+#define GCODE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define GCODE_AXES 6           /* X, Y, Z, A, B, C */
+
+typedef enum
+{
+    GCODE_RAPID,
+    GCODE_LINEAR,
+    GCODE_ARC_CW,
+    GCODE_ARC_CCW,
+} gcode_motion_t;
+
+typedef struct
+{
+    uint32_t line;             /* 1-based line of the program */
+    uint8_t motion;            /* gcode_motion_t */
+    uint8_t plane;             /* Arcs: 0 = G17 XY, 1 = G18 ZX, 2 = G19 YZ */
+    float center[2];           /* Arcs: absolute centre on the plane's two axes */
+    float end[GCODE_AXES];     /* Absolute end point; the start is the previous move's end */
+} gcode_move_t;
+
+typedef struct
+{
+    gcode_move_t *moves;
+    int move_count;
+    int line_count;
+    float start[GCODE_AXES];   /* Position before the first move */
+    unsigned axes_used;        /* Bit per axis named by any move */
+    int ignored;               /* Lines with codes skipped as described above */
+    int error_line;            /* Line of the first error, 0 = none */
+    char error[96];
+} gcode_program_t;
+
+/*
+ * Reads `path` ("-" = stdin) starting from `start` (NULL = all zero).
+ * Returns false with error_line and error set, or with error_line 0 if the
+ * file can't be read or memory runs out; the moves read so far are kept
+ * either way and must be released with gcode_free().
+ */
+bool gcode_load(const char *path, const float start[GCODE_AXES], gcode_program_t *program);
+void gcode_free(gcode_program_t *program);
+
+/* Axis index of an address letter X..C (either case), -1 for any other */
+int gcode_axis_index(char letter);
+
+/* The two axes of an arc plane, first then second, as in the move's `center` */
+void gcode_plane_axes(int plane, int axes[2]);
+
+#endif // GCODE_H
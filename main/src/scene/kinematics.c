@@ -0,0 +1,433 @@
+/**
+ * @file kinematics.c
+ * @brief Chain extraction and the structure-of-arrays forward kinematics kernel.
+ */
+
+#include "kinematics.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* GCC/Clang vector extensions; they map onto AVX, SSE or NEON, whatever -march allows */
+typedef float vec_t __attribute__((vector_size(KINEMATICS_LANES * sizeof(float))));
+typedef int32_t ivec_t __attribute__((vector_size(KINEMATICS_LANES * sizeof(int32_t))));
+typedef uint32_t uvec_t __attribute__((vector_size(KINEMATICS_LANES * sizeof(uint32_t))));
+
+/* Affine 3x4 part of a column-major 4x4, m[col * 3 + row]; the bottom row is always 0 0 0 1 */
+typedef struct
+{
+    float m[12];
+    bool identity;
+} affine_t;
+
+/*
+ * One node of the chain. Its local matrix is pre * R(axis, value) * post for
+ * a rotational joint, T(value along axis) * pre for a linear one and just
+ * pre for a fixed node, where pre and post hold everything constant.
+ */
+typedef struct
+{
+    int node;
+    int joint;             /* Index into a joint set, -1 = fixed */
+    scene_motion_t motion;
+    int axis;
+    float scale;           /* Joint value to rotation radians or offset, with the inversion */
+    affine_t pre;
+    affine_t post;
+} link_t;
+
+/* Columns mixed by a rotation about X, Y and Z */
+static const int rotation_pairs[3][2] = { { 1, 2 }, { 2, 0 }, { 0, 1 } };
+
+struct kinematics
+{
+    link_t *links;
+    int link_count;
+    int *joint_nodes;
+    int joint_count;
+    float tool[3];
+};
+
+static void affine_from_mat4(affine_t *a, const float m[16])
+{
+    float identity[16];
+
+    for (int c = 0; c < 4; c++)
+        memcpy(&a->m[c * 3], &m[c * 4], 3 * sizeof(float));
+    mat4_identity(identity);
+    a->identity = memcmp(m, identity, sizeof(identity)) == 0;
+}
+
+/* ---- Chain extraction ---- */
+
+static void build_link(link_t *link, const scene_node_t *node)
+{
+    float pre[16], post[16];
+    int axis = node->motion_axis;
+    float sign = node->motion_inverted ? -1.0f : 1.0f;
+
+    link->motion = node->motion;
+    link->axis = axis;
+    mat4_identity(post);
+
+    switch (node->motion)
+    {
+    case SCENE_MOTION_ROTATIONAL:
+        /* scene_node_local_matrix() rotates X, Y, Z in turn; split around the joint's axis */
+        mat4_translation(pre, node->origin[0] + node->position[0], node->origin[1] + node->position[1],
+                         node->origin[2] + node->position[2]);
+        for (int a = 0; a < axis; a++)
+            mat4_rotate_axis(pre, a, node->rotation[a]);
+        for (int a = axis + 1; a < 3; a++)
+            mat4_rotate_axis(post, a, node->rotation[a]);
+        mat4_translate(post, -node->origin[0], -node->origin[1], -node->origin[2]);
+        link->scale = sign * (float)(M_PI / 180.0);
+        break;
+    case SCENE_MOTION_LINEAR:
+    {
+        scene_node_t rest = *node;
+        rest.position[axis] = 0.0f;
+        scene_node_local_matrix(&rest, pre);
+        link->scale = sign;
+        break;
+    }
+    default:
+        scene_node_local_matrix(node, pre);
+        link->scale = 0.0f;
+        break;
+    }
+
+    affine_from_mat4(&link->pre, pre);
+    affine_from_mat4(&link->post, post);
+}
+
+kinematics_t *kinematics_create(const scene_t *scene, int tip, const float tool[3])
+{
+    kinematics_t *kin;
+    int depth = 0;
+
+    if (tip < 0)
+        tip = scene->node_count - 1;
+    if (tip < 0 || tip >= scene->node_count)
+        return NULL;
+
+    for (int n = tip; n >= 0; n = scene->nodes[n].parent)
+        depth++;
+
+    kin = calloc(1, sizeof(*kin));
+    if (kin == NULL)
+        return NULL;
+    kin->links = calloc((size_t)depth, sizeof(*kin->links));
+    kin->joint_nodes = calloc((size_t)depth, sizeof(*kin->joint_nodes));
+    if (kin->links == NULL || kin->joint_nodes == NULL)
+    {
+        kinematics_destroy(kin);
+        return NULL;
+    }
+
+    /* Walk up from the tip, filling the chain from its end */
+    kin->link_count = depth;
+    for (int n = tip, i = depth - 1; n >= 0; n = scene->nodes[n].parent, i--)
+    {
+        kin->links[i].node = n;
+        build_link(&kin->links[i], &scene->nodes[n]);
+    }
+    for (int i = 0; i < depth; i++)
+    {
+        link_t *link = &kin->links[i];
+        link->joint = link->motion == SCENE_MOTION_NONE ? -1 : kin->joint_count;
+        if (link->joint >= 0)
+            kin->joint_nodes[kin->joint_count++] = link->node;
+    }
+
+    if (tool)
+        memcpy(kin->tool, tool, sizeof(kin->tool));
+    return kin;
+}
+
+void kinematics_destroy(kinematics_t *kin)
+{
+    if (kin == NULL)
+        return;
+    free(kin->links);
+    free(kin->joint_nodes);
+    free(kin);
+}
+
+int kinematics_joint_count(const kinematics_t *kin)
+{
+    return kin->joint_count;
+}
+
+int kinematics_joint_node(const kinematics_t *kin, int joint)
+{
+    return kin->joint_nodes[joint];
+}
+
+int kinematics_link_count(const kinematics_t *kin)
+{
+    return kin->link_count;
+}
+
+int kinematics_link_node(const kinematics_t *kin, int link)
+{
+    return kin->links[link].node;
+}
+
+void kinematics_scene_joints(const kinematics_t *kin, const scene_t *scene, float *joints)
+{
+    for (int j = 0; j < kin->joint_count; j++)
+    {
+        const scene_node_t *node = &scene->nodes[kin->joint_nodes[j]];
+        float field = node->motion == SCENE_MOTION_ROTATIONAL ? node->rotation[node->motion_axis]
+                                                              : node->position[node->motion_axis];
+        joints[j] = node->motion_inverted ? -field : field;
+    }
+}
+
+bool kinematics_joint_rotational(const kinematics_t *kin, int joint)
+{
+    for (int i = 0; i < kin->link_count; i++)
+    {
+        if (kin->links[i].joint == joint)
+            return kin->links[i].motion == SCENE_MOTION_ROTATIONAL;
+    }
+    return false;
+}
+
+/* ---- Scalar evaluation ---- */
+
+static void affine_to_mat4(const affine_t *a, float m[16])
+{
+    for (int c = 0; c < 4; c++)
+    {
+        memcpy(&m[c * 4], &a->m[c * 3], 3 * sizeof(float));
+        m[c * 4 + 3] = c == 3 ? 1.0f : 0.0f;
+    }
+}
+
+static void mul_link_part(float w[16], const affine_t *a)
+{
+    float m[16];
+
+    if (a->identity)
+        return;
+    affine_to_mat4(a, m);
+    mat4_mul(w, w, m);
+}
+
+/* w = w * R(axis, degrees), touching only the two columns that change */
+static void rotate_columns(float w[16], int axis, float degrees)
+{
+    float rad = degrees * (float)(M_PI / 180.0);
+    float s = sinf(rad), c = cosf(rad);
+    int u = rotation_pairs[axis][0] * 4, v = rotation_pairs[axis][1] * 4;
+
+    for (int row = 0; row < 3; row++)
+    {
+        float cu = w[u + row], cv = w[v + row];
+        w[u + row] = cu * c + cv * s;
+        w[v + row] = cv * c - cu * s;
+    }
+}
+
+void kinematics_joint_frames(const kinematics_t *kin, const float *joints, float (*axes)[3], float (*points)[3],
+                             float tip[16])
+{
+    float w[16];
+
+    mat4_identity(w);
+    for (int i = 0; i < kin->link_count; i++)
+    {
+        const link_t *link = &kin->links[i];
+        float sign = link->scale < 0.0f ? -1.0f : 1.0f;
+        int a = link->axis;
+
+        if (link->joint < 0)
+        {
+            mul_link_part(w, &link->pre);
+            continue;
+        }
+
+        if (link->motion == SCENE_MOTION_ROTATIONAL)
+        {
+            mul_link_part(w, &link->pre);
+            if (points)
+                memcpy(points[link->joint], &w[12], 3 * sizeof(float));
+            if (axes)
+            {
+                for (int row = 0; row < 3; row++)
+                    axes[link->joint][row] = w[a * 4 + row] * sign;
+            }
+            rotate_columns(w, a, joints[link->joint] * sign);
+            mul_link_part(w, &link->post);
+        }
+        else
+        {
+            if (axes)
+            {
+                for (int row = 0; row < 3; row++)
+                    axes[link->joint][row] = w[a * 4 + row] * sign;
+            }
+            if (points)
+                memcpy(points[link->joint], &w[12], 3 * sizeof(float));
+            float value = joints[link->joint] * sign;
+            mat4_translate(w, a == 0 ? value : 0.0f, a == 1 ? value : 0.0f, a == 2 ? value : 0.0f);
+            mul_link_part(w, &link->pre);
+        }
+    }
+
+    if (tip)
+    {
+        mat4_translate(w, kin->tool[0], kin->tool[1], kin->tool[2]);
+        memcpy(tip, w, sizeof(w));
+    }
+}
+
+/* ---- Vector kernel ---- */
+
+/*
+ * Sine and cosine of every lane: reduction to [-pi/4, pi/4] by the nearest
+ * multiple of pi/2 in three steps (Cody-Waite), then the minimax
+ * polynomials of Cephes' sinf/cosf and a quadrant fix-up. About 1 ulp for
+ * the joint ranges of a machine.
+ */
+static void vec_sincos(const vec_t *angle, vec_t *s, vec_t *c)
+{
+    vec_t x = *angle;
+    vec_t t = x * (float)(2.0 / M_PI);
+    vec_t half = 0.5f + __builtin_convertvector(t < 0.0f, vec_t);
+    ivec_t q = __builtin_convertvector(t + half, ivec_t);
+    vec_t qf = __builtin_convertvector(q, vec_t);
+    vec_t r = x - qf * 1.5703125f - qf * 4.837512969970703125e-4f - qf * 7.549789948768648e-8f;
+    vec_t r2 = r * r;
+
+    vec_t ps = r + r * r2 * (-1.6666654611e-1f + r2 * (8.3321608736e-3f + r2 * -1.9515295891e-4f));
+    vec_t pc = 1.0f - 0.5f * r2 +
+               r2 * r2 * (4.166664568298827e-2f + r2 * (-1.388731625493765e-3f + r2 * 2.443315711809948e-5f));
+
+    /* Odd quadrants swap the two, quadrants 2-3 negate the sine and 1-2 the cosine */
+    uvec_t uq = (uvec_t)q;
+    uvec_t swap = -(uq & 1u);
+    uvec_t bs = (uvec_t)ps, bc = (uvec_t)pc;
+    uvec_t sin_bits = ((bs & ~swap) | (bc & swap)) ^ ((uq & 2u) << 30);
+    uvec_t cos_bits = ((bc & ~swap) | (bs & swap)) ^ (((uq + 1u) & 2u) << 30);
+    *s = (vec_t)sin_bits;
+    *c = (vec_t)cos_bits;
+}
+
+/* w = w * a for KINEMATICS_LANES affine matrices at once */
+static void mul_affine(vec_t w[12], const affine_t *a)
+{
+    vec_t r[12];
+
+    if (a->identity)
+        return;
+    for (int c = 0; c < 4; c++)
+    {
+        for (int row = 0; row < 3; row++)
+        {
+            r[c * 3 + row] = w[0 + row] * a->m[c * 3 + 0] + w[3 + row] * a->m[c * 3 + 1] +
+                             w[6 + row] * a->m[c * 3 + 2];
+        }
+    }
+    for (int row = 0; row < 3; row++)
+        r[9 + row] += w[9 + row];
+    memcpy(w, r, sizeof(r));
+}
+
+/* w = w * R(axis, angle) given the angle's sine and cosine; only two columns change */
+static void rotate_axis(vec_t w[12], int axis, const vec_t *sine, const vec_t *cosine)
+{
+    vec_t s = *sine, c = *cosine;
+    int u = rotation_pairs[axis][0] * 3, v = rotation_pairs[axis][1] * 3;
+
+    for (int row = 0; row < 3; row++)
+    {
+        vec_t cu = w[u + row], cv = w[v + row];
+        w[u + row] = cu * c + cv * s;
+        w[v + row] = cv * c - cu * s;
+    }
+}
+
+static void store_pose(const vec_t w[12], int lane, float out[16])
+{
+    for (int c = 0; c < 4; c++)
+    {
+        for (int row = 0; row < 3; row++)
+            out[c * 4 + row] = w[c * 3 + row][lane];
+        out[c * 4 + 3] = 0.0f;
+    }
+    out[15] = 1.0f;
+}
+
+static void forward_block(const kinematics_t *kin, const float *joints, int first, int valid, float (*tips)[16],
+                          float (*links)[16])
+{
+    vec_t w[12];
+    vec_t zero = { 0 };
+
+    for (int i = 0; i < 12; i++)
+        w[i] = zero;
+    w[0] = w[4] = w[8] = zero + 1.0f;
+
+    for (int i = 0; i < kin->link_count; i++)
+    {
+        const link_t *link = &kin->links[i];
+
+        if (link->joint < 0)
+        {
+            mul_affine(w, &link->pre);
+        }
+        else
+        {
+            /* Gather this joint of every set; padding lanes repeat the last valid set */
+            vec_t value;
+            for (int lane = 0; lane < KINEMATICS_LANES; lane++)
+            {
+                int set = first + (lane < valid ? lane : valid - 1);
+                value[lane] = joints[(size_t)set * kin->joint_count + link->joint];
+            }
+            value *= link->scale;
+
+            if (link->motion == SCENE_MOTION_ROTATIONAL)
+            {
+                vec_t s, c;
+                vec_sincos(&value, &s, &c);
+                mul_affine(w, &link->pre);
+                rotate_axis(w, link->axis, &s, &c);
+                mul_affine(w, &link->post);
+            }
+            else
+            {
+                for (int row = 0; row < 3; row++)
+                    w[9 + row] += w[link->axis * 3 + row] * value;
+                mul_affine(w, &link->pre);
+            }
+        }
+
+        if (links)
+        {
+            for (int lane = 0; lane < valid; lane++)
+                store_pose(w, lane, links[(size_t)(first + lane) * kin->link_count + i]);
+        }
+    }
+
+    if (tips)
+    {
+        for (int row = 0; row < 3; row++)
+            w[9 + row] += w[0 + row] * kin->tool[0] + w[3 + row] * kin->tool[1] + w[6 + row] * kin->tool[2];
+        for (int lane = 0; lane < valid; lane++)
+            store_pose(w, lane, tips[first + lane]);
+    }
+}
+
+void kinematics_forward(const kinematics_t *kin, const float *joints, int count, float (*tips)[16],
+                        float (*links)[16])
+{
+    for (int first = 0; first < count; first += KINEMATICS_LANES)
+    {
+        int valid = count - first < KINEMATICS_LANES ? count - first : KINEMATICS_LANES;
+        forward_block(kin, joints, first, valid, tips, links);
+    }
+}
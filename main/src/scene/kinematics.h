@@ -0,0 +1,76 @@
+/**
+ * @file kinematics.h
+ * @brief Batched forward kinematics over the assembly chain of a scene.
+ *
+ * The joints of config.xml are the assemblies with a motion type, and the
+ * scene mirror only evaluates them while a frame is drawn. A kinematics_t
+ * takes the path from a root node to one tip node (e.g. the flange of
+ * machines/meca500) out of the scene once and then computes tip and per-link
+ * poses for any number of joint vectors, with no renderer, cncvis or scene
+ * access. kinematics_forward() is reentrant, so large batches can be split
+ * over a worker pool.
+ *
+ * Joint values mean what scene_cncvis_set_motion() takes: degrees for
+ * rotational joints, model units for linear ones, before motion inversion.
+ * Joints are ordered root to tip. Poses are column-major float[16] as in
+ * scene_math.h and equal the world matrices scene_update() would produce
+ * for the same joint values.
+ *
+ * Joint sets are evaluated KINEMATICS_LANES at a time, one set per SIMD
+ * lane (structure of arrays), including sine and cosine; a batch that isn't
+ * a multiple of the lane count is padded internally.
+ */
+
+#ifndef KINEMATICS_H
+#define KINEMATICS_H
+
+#include "scene.h"
+
+#define KINEMATICS_LANES 8     /* Joint sets per vector; one AVX register, two SSE/NEON ones */
+
+typedef struct kinematics kinematics_t;
+
+/*
+ * Chain from the root above `tip` down to `tip` (-1 = the scene's last
+ * node). `tool` offsets the reported tip point in the tip node's frame and
+ * may be NULL. Fixed nodes keep the pose they have in the scene now.
+ * Returns NULL if `tip` is out of range or memory runs out.
+ */
+kinematics_t *kinematics_create(const scene_t *scene, int tip, const float tool[3]);
+void kinematics_destroy(kinematics_t *kin);
+
+/* Degrees of freedom, i.e. values per joint set */
+int kinematics_joint_count(const kinematics_t *kin);
+
+/* Scene node of joint `joint`, usable with scene_cncvis_set_motion() */
+int kinematics_joint_node(const kinematics_t *kin, int joint);
+
+/* Nodes on the chain, root first, tip last; every one gets a pose in `links` */
+int kinematics_link_count(const kinematics_t *kin);
+int kinematics_link_node(const kinematics_t *kin, int link);
+
+/* Joint values of the scene's current pose, kinematics_joint_count() of them */
+void kinematics_scene_joints(const kinematics_t *kin, const scene_t *scene, float *joints);
+
+/* Whether joint `joint` rotates (values in degrees) rather than slides (model units) */
+bool kinematics_joint_rotational(const kinematics_t *kin, int joint);
+
+/*
+ * Scalar evaluation of one joint set for solvers: the world direction of
+ * every joint's motion (unit length, inversion applied, so a growing value
+ * turns right-handed about or slides along it), a point on each rotational
+ * joint's axis and the tool pose. Any output may be NULL.
+ */
+void kinematics_joint_frames(const kinematics_t *kin, const float *joints, float (*axes)[3], float (*points)[3],
+                             float tip[16]);
+
+/*
+ * Evaluates `count` joint sets; joints[set * joint_count + j]. Writes one
+ * tool pose per set to `tips` (tool offset applied, orientation of the tip
+ * node) and link_count poses per set, set-major, to `links`; either may be
+ * NULL.
+ */
+void kinematics_forward(const kinematics_t *kin, const float *joints, int count, float (*tips)[16],
+                        float (*links)[16]);
+
+#endif // KINEMATICS_H
@@ -0,0 +1,188 @@
+/**
+ * @file kinematics_bench.c
+ * @brief Forward and inverse kinematics benchmark.
+ *
+ * Usage: kinematics_bench [solves]
+ *
+ * Builds two 6R arms as scene nodes the way scene_cncvis mirrors a config:
+ * one with the Meca500's dimensions (spherical wrist, intersecting shoulder
+ * axes, so the closed form applies), and the same arm with a 25 mm shoulder
+ * offset, which leaves it to damped least squares. For each it prints the
+ * batched forward kinematics throughput against one-at-a-time evaluation,
+ * then times `solves` inverse solves (default 20000) for poses reached from
+ * random joint vectors. Two seeds are used: a tracking seed a few degrees
+ * off, like a jog or interpolated G-code step, and a cold seed at the zero
+ * pose. Reports the success rate and mean, median, 99th percentile and
+ * worst time per solve.
+ */
+
+#include "kinematics_ik.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define FK_BATCH 100000
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static float random_range(float range)
+{
+    return ((float)rand() / (float)RAND_MAX * 2.0f - 1.0f) * range;
+}
+
+/* Base plus link1..link6 pivoting at their zero-pose joint positions; returns link6 */
+static int build_arm(scene_t *scene, float shoulder_offset)
+{
+    static const struct
+    {
+        float origin[3];
+        int axis;
+    } joints[6] = {
+        { { 0.0f, 0.0f, 0.0f }, 2 },     { { 0.0f, 0.0f, 135.0f }, 1 },   { { 0.0f, 0.0f, 270.0f }, 1 },
+        { { 0.0f, 0.0f, 308.0f }, 0 },   { { 120.0f, 0.0f, 308.0f }, 1 }, { { 120.0f, 0.0f, 308.0f }, 0 },
+    };
+    static const float zero[3] = { 0.0f, 0.0f, 0.0f };
+    int parent = scene_add_node(scene, "base", -1, NULL);
+
+    for (int j = 0; j < 6; j++)
+    {
+        char name[16];
+        float origin[3] = { joints[j].origin[0] + (j > 0 ? shoulder_offset : 0.0f), joints[j].origin[1],
+                            joints[j].origin[2] };
+        snprintf(name, sizeof(name), "link%d", j + 1);
+        parent = scene_add_node(scene, name, parent, NULL);
+        scene_set_node_pose(scene, parent, origin, zero, zero);
+        scene->nodes[parent].motion = SCENE_MOTION_ROTATIONAL;
+        scene->nodes[parent].motion_axis = joints[j].axis;
+    }
+    return parent;
+}
+
+static void random_joints(float *joints)
+{
+    static const float range[6] = { 170.0f, 90.0f, 90.0f, 170.0f, 110.0f, 170.0f };
+    for (int j = 0; j < 6; j++)
+        joints[j] = random_range(range[j]);
+}
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void bench_forward(const kinematics_t *kin)
+{
+    float *joints = malloc((size_t)FK_BATCH * 6 * sizeof(float));
+    float (*tips)[16] = malloc((size_t)FK_BATCH * sizeof(*tips));
+
+    if (joints == NULL || tips == NULL)
+    {
+        free(joints);
+        free(tips);
+        return;
+    }
+    for (int i = 0; i < FK_BATCH; i++)
+        random_joints(&joints[i * 6]);
+
+    double t0 = now_seconds();
+    kinematics_forward(kin, joints, FK_BATCH, tips, NULL);
+    double batched = now_seconds() - t0;
+
+    t0 = now_seconds();
+    for (int i = 0; i < FK_BATCH; i++)
+        kinematics_joint_frames(kin, &joints[i * 6], NULL, NULL, tips[i]);
+    double single = now_seconds() - t0;
+
+    printf("  forward: %.1f ns/pose batched (%d lanes), %.1f ns/pose one at a time\n",
+           batched * 1e9 / FK_BATCH, KINEMATICS_LANES, single * 1e9 / FK_BATCH);
+    free(joints);
+    free(tips);
+}
+
+static void bench_inverse(const kinematics_t *kin, const kinematics_ik_t *ik, int solves, bool cold)
+{
+    double *times = malloc((size_t)solves * sizeof(double));
+    double total = 0.0;
+    int solved = 0, analytic = 0;
+    long iterations = 0;
+
+    if (times == NULL)
+        return;
+    for (int i = 0; i < solves; i++)
+    {
+        float goal[6], seed[6], joints[6], target[16];
+        kinematics_ik_report_t report;
+
+        random_joints(goal);
+        for (int j = 0; j < 6; j++)
+            seed[j] = cold ? 0.0f : goal[j] + random_range(3.0f);
+        kinematics_forward(kin, goal, 1, &target, NULL);
+
+        double t0 = now_seconds();
+        solved += kinematics_ik_solve(ik, target, seed, joints, &report);
+        times[i] = (now_seconds() - t0) * 1e6;
+        total += times[i];
+        analytic += report.analytic;
+        iterations += report.iterations;
+    }
+
+    qsort(times, (size_t)solves, sizeof(double), compare_double);
+    printf("  inverse, %s seed: %.1f%% solved (%.0f%% closed form, %.1f DLS steps avg), "
+           "%.2f us avg, %.2f median, %.2f p99, %.2f max\n",
+           cold ? "cold" : "tracking", 100.0 * solved / solves, 100.0 * analytic / solves,
+           (double)iterations / solves, total / solves, times[solves / 2], times[solves * 99 / 100],
+           times[solves - 1]);
+    free(times);
+}
+
+static void bench_arm(const char *label, float shoulder_offset, int solves)
+{
+    static const float flange[3] = { 190.0f, 0.0f, 308.0f };
+    scene_t *scene = scene_create();
+    kinematics_t *kin = NULL;
+    kinematics_ik_t *ik = NULL;
+
+    if (scene != NULL)
+        kin = kinematics_create(scene, build_arm(scene, shoulder_offset), flange);
+    if (kin != NULL)
+        ik = kinematics_ik_create(kin);
+    if (ik == NULL)
+    {
+        fprintf(stderr, "%s: setup failed\n", label);
+    }
+    else
+    {
+        printf("%s: %d joints, %s solver\n", label, kinematics_joint_count(kin),
+               kinematics_ik_analytic(ik) ? "closed-form" : "damped least-squares");
+        bench_forward(kin);
+        bench_inverse(kin, ik, solves, false);
+        bench_inverse(kin, ik, solves, true);
+    }
+
+    kinematics_ik_destroy(ik);
+    kinematics_destroy(kin);
+    scene_destroy(scene);
+}
+
+int main(int argc, char **argv)
+{
+    int solves = argc > 1 ? atoi(argv[1]) : 20000;
+
+    if (solves <= 0)
+    {
+        fprintf(stderr, "usage: %s [solves]\n", argv[0]);
+        return 1;
+    }
+    srand(1);
+    bench_arm("meca500", 0.0f, solves);
+    bench_arm("meca500, 25 mm shoulder offset", 25.0f, solves);
+    return 0;
+}
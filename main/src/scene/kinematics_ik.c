@@ -0,0 +1,670 @@
+/**
+ * @file kinematics_ik.c
+ * @brief Closed-form wrist-partitioned solver and the damped least-squares fallback.
+ */
+
+#include "kinematics_ik.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DLS_DAMPING 0.01      /* Times the chain length */
+#define DLS_MAX_TURN 0.3      /* Largest rotational step, radians */
+#define DLS_MAX_SLIDE 0.1     /* Largest linear step, times the chain length */
+#define AXIS_MEET 1e-4        /* Axes closer than this times the chain length intersect */
+
+/* Rigid transform in double precision; r is column-major 3x3, r[col * 3 + row] */
+typedef struct
+{
+    double r[9];
+    double t[3];
+} rigid_t;
+
+struct kinematics_ik
+{
+    const kinematics_t *kin;
+    int joint_count;
+    bool rotational[KINEMATICS_IK_MAX_JOINTS];
+    double length;          /* Size of the chain, weighs orientation against position */
+    bool analytic;
+    double axes[6][3];      /* Joint axes at the zero pose */
+    double points[6][3];
+    double shoulder[3];     /* Where axes 1 and 2 meet */
+    double wrist[3];        /* Where axes 4, 5 and 6 meet */
+    rigid_t home_inverse;   /* Inverse of the zero-pose tool pose */
+};
+
+/* ---- Small vector and transform helpers ---- */
+
+static double dot3(const double a[3], const double b[3])
+{
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+static void cross3(const double a[3], const double b[3], double out[3])
+{
+    double x = a[1] * b[2] - a[2] * b[1];
+    double y = a[2] * b[0] - a[0] * b[2];
+    double z = a[0] * b[1] - a[1] * b[0];
+    out[0] = x;
+    out[1] = y;
+    out[2] = z;
+}
+
+static void sub3(const double a[3], const double b[3], double out[3])
+{
+    for (int i = 0; i < 3; i++)
+        out[i] = a[i] - b[i];
+}
+
+/* Component of v perpendicular to the unit vector w */
+static void reject3(const double v[3], const double w[3], double out[3])
+{
+    double d = dot3(v, w);
+    for (int i = 0; i < 3; i++)
+        out[i] = v[i] - w[i] * d;
+}
+
+static void rigid_from_mat4(const float m[16], rigid_t *g)
+{
+    for (int c = 0; c < 3; c++)
+    {
+        for (int row = 0; row < 3; row++)
+            g->r[c * 3 + row] = m[c * 4 + row];
+    }
+    for (int row = 0; row < 3; row++)
+        g->t[row] = m[12 + row];
+}
+
+static void rigid_apply(const rigid_t *g, const double p[3], double out[3])
+{
+    double x = p[0], y = p[1], z = p[2];
+    for (int row = 0; row < 3; row++)
+        out[row] = g->r[row] * x + g->r[3 + row] * y + g->r[6 + row] * z + g->t[row];
+}
+
+/* out = a * b; out may alias either */
+static void rigid_mul(const rigid_t *a, const rigid_t *b, rigid_t *out)
+{
+    rigid_t r;
+    for (int c = 0; c < 3; c++)
+    {
+        for (int row = 0; row < 3; row++)
+        {
+            r.r[c * 3 + row] = a->r[row] * b->r[c * 3] + a->r[3 + row] * b->r[c * 3 + 1] +
+                               a->r[6 + row] * b->r[c * 3 + 2];
+        }
+    }
+    rigid_apply(a, b->t, r.t);
+    *out = r;
+}
+
+static void rigid_inverse(const rigid_t *g, rigid_t *out)
+{
+    rigid_t r;
+    for (int c = 0; c < 3; c++)
+    {
+        for (int row = 0; row < 3; row++)
+            r.r[c * 3 + row] = g->r[row * 3 + c];
+    }
+    for (int row = 0; row < 3; row++)
+        r.t[row] = -(r.r[row] * g->t[0] + r.r[3 + row] * g->t[1] + r.r[6 + row] * g->t[2]);
+    *out = r;
+}
+
+/* Rotation by `angle` radians about the line through `point` along the unit vector `axis` */
+static void rigid_screw(const double axis[3], const double point[3], double angle, rigid_t *g)
+{
+    double c = cos(angle), s = sin(angle), v = 1.0 - c;
+    double x = axis[0], y = axis[1], z = axis[2];
+    double rotated[3];
+
+    g->r[0] = c + x * x * v;     g->r[3] = x * y * v - z * s; g->r[6] = x * z * v + y * s;
+    g->r[1] = y * x * v + z * s; g->r[4] = c + y * y * v;     g->r[7] = y * z * v - x * s;
+    g->r[2] = z * x * v - y * s; g->r[5] = z * y * v + x * s; g->r[8] = c + z * z * v;
+
+    memset(g->t, 0, sizeof(g->t));
+    rigid_apply(g, point, rotated);
+    sub3(point, rotated, g->t);
+}
+
+/* Closest approach of two lines; false when they are parallel */
+static bool lines_meet(const double p1[3], const double d1[3], const double p2[3], const double d2[3],
+                       double *distance, double mid[3])
+{
+    double w[3], c1[3], c2[3];
+    double b = dot3(d1, d2);
+    double den = 1.0 - b * b;
+
+    if (den < 1e-9)
+        return false;
+    sub3(p1, p2, w);
+    double d = dot3(d1, w), e = dot3(d2, w);
+    double s = (b * e - d) / den, t = (e - b * d) / den;
+    for (int i = 0; i < 3; i++)
+    {
+        c1[i] = p1[i] + d1[i] * s;
+        c2[i] = p2[i] + d2[i] * t;
+        mid[i] = 0.5 * (c1[i] + c2[i]);
+    }
+    sub3(c1, c2, w);
+    *distance = sqrt(dot3(w, w));
+    return true;
+}
+
+/* ---- Paden-Kahan subproblems ---- */
+
+/* Angle about (axis, r) taking p to q; `fallback` when p lies on the axis and any angle works */
+static double subproblem1(const double axis[3], const double r[3], const double p[3], const double q[3],
+                          double fallback)
+{
+    double u[3], v[3], up[3], vp[3], n[3];
+
+    sub3(p, r, u);
+    sub3(q, r, v);
+    reject3(u, axis, up);
+    reject3(v, axis, vp);
+    if (dot3(up, up) < 1e-18 || dot3(vp, vp) < 1e-18)
+        return fallback;
+    cross3(up, vp, n);
+    return atan2(dot3(axis, n), dot3(up, vp));
+}
+
+/*
+ * Angles with R1(theta1) * R2(theta2) * p = q for two axes meeting at r.
+ * Returns the number of solutions (0-2); fallbacks as in subproblem1.
+ */
+static int subproblem2(const double a1[3], const double a2[3], const double r[3], const double p[3],
+                       const double q[3], const double fallback[2], double theta1[2], double theta2[2])
+{
+    double u[3], v[3], n[3];
+    double a = dot3(a1, a2), den = a * a - 1.0;
+
+    sub3(p, r, u);
+    sub3(q, r, v);
+    cross3(a1, a2, n);
+    double alpha = (a * dot3(a2, u) - dot3(a1, v)) / den;
+    double beta = (a * dot3(a1, v) - dot3(a2, u)) / den;
+    double gamma2 = (dot3(u, u) - alpha * alpha - beta * beta - 2.0 * alpha * beta * a) / dot3(n, n);
+    if (gamma2 < -1e-6 * (dot3(u, u) + 1.0))
+        return 0;
+
+    double gamma = gamma2 > 0.0 ? sqrt(gamma2) : 0.0;
+    int count = gamma > 0.0 ? 2 : 1;
+    for (int i = 0; i < count; i++)
+    {
+        double g = i == 0 ? gamma : -gamma;
+        double z[3];
+        for (int k = 0; k < 3; k++)
+            z[k] = r[k] + alpha * a1[k] + beta * a2[k] + g * n[k];
+        theta2[i] = subproblem1(a2, r, p, z, fallback[1]);
+        theta1[i] = subproblem1(a1, r, z, q, fallback[0]);
+    }
+    return count;
+}
+
+/* Angles about (axis, r) putting p at `distance` from q; returns the number of solutions (0-2) */
+static int subproblem3(const double axis[3], const double r[3], const double p[3], const double q[3],
+                       double distance, double theta[2])
+{
+    double u[3], v[3], up[3], vp[3], n[3], pq[3];
+
+    sub3(p, r, u);
+    sub3(q, r, v);
+    reject3(u, axis, up);
+    reject3(v, axis, vp);
+    sub3(p, q, pq);
+    double along = dot3(axis, pq);
+    double planar2 = distance * distance - along * along;
+    double lu = sqrt(dot3(up, up)), lv = sqrt(dot3(vp, vp));
+    if (planar2 < 0.0 || lu < 1e-12 || lv < 1e-12)
+        return 0;
+
+    double c = (lu * lu + lv * lv - planar2) / (2.0 * lu * lv);
+    if (c > 1.0 + 1e-9 || c < -1.0 - 1e-9)
+        return 0;
+    c = c > 1.0 ? 1.0 : c < -1.0 ? -1.0 : c;
+    cross3(up, vp, n);
+    double base = atan2(dot3(axis, n), dot3(up, vp));
+    double spread = acos(c);
+    theta[0] = base + spread;
+    theta[1] = base - spread;
+    return spread > 0.0 ? 2 : 1;
+}
+
+/* ---- Error measure ---- */
+
+/* Rotation vector (axis times angle, radians) of the column-major 3x3 `r` */
+static void rotation_vector(const double r[9], double out[3])
+{
+    double c = 0.5 * (r[0] + r[4] + r[8] - 1.0);
+    double v[3] = { r[5] - r[7], r[6] - r[2], r[1] - r[3] };
+    c = c > 1.0 ? 1.0 : c < -1.0 ? -1.0 : c;
+    double angle = acos(c), s = sin(angle);
+
+    if (s > 1e-6)
+    {
+        for (int i = 0; i < 3; i++)
+            out[i] = v[i] * angle / (2.0 * s);
+    }
+    else if (angle < 1.0)
+    {
+        for (int i = 0; i < 3; i++)
+            out[i] = 0.5 * v[i];
+    }
+    else
+    {
+        /* Half a turn: the axis comes from the diagonal, signs from the largest component's row */
+        int k = r[0] >= r[4] && r[0] >= r[8] ? 0 : r[4] >= r[8] ? 1 : 2;
+        double axis[3];
+        axis[k] = sqrt(fmax(0.0, 0.5 * (r[k * 4] + 1.0)));
+        for (int i = 0; i < 3; i++)
+        {
+            if (i != k)
+                axis[i] = 0.5 * (r[k * 3 + i] + r[i * 3 + k]) / (2.0 * axis[k]);
+        }
+        for (int i = 0; i < 3; i++)
+            out[i] = axis[i] * angle;
+    }
+}
+
+/* Position and rotation-vector error taking `current` to `target` */
+static void pose_error(const rigid_t *target, const float current[16], double error[6])
+{
+    rigid_t now, back, diff;
+
+    rigid_from_mat4(current, &now);
+    sub3(target->t, now.t, error);
+    rigid_inverse(&now, &back);
+    rigid_mul(target, &back, &diff);
+    rotation_vector(diff.r, error + 3);
+}
+
+static void measure(const kinematics_ik_t *ik, const rigid_t *target, const float *joints, float *position,
+                    float *angle)
+{
+    float tip[16];
+    double error[6];
+
+    kinematics_joint_frames(ik->kin, joints, NULL, NULL, tip);
+    pose_error(target, tip, error);
+    *position = (float)sqrt(dot3(error, error));
+    *angle = (float)(sqrt(dot3(error + 3, error + 3)) * 180.0 / M_PI);
+}
+
+static bool within_tolerance(float position, float angle)
+{
+    return position <= KINEMATICS_IK_POSITION_TOLERANCE && angle <= KINEMATICS_IK_ANGLE_TOLERANCE;
+}
+
+/* ---- Closed form ---- */
+
+/* Angle in degrees equivalent to `radians`, within half a turn of `near` */
+static float nearest_degrees(double radians, float near)
+{
+    double deg = radians * 180.0 / M_PI;
+    return (float)(deg - 360.0 * floor((deg - near) / 360.0 + 0.5));
+}
+
+/*
+ * Every closed-form solution; the closest to the seed that meets the
+ * tolerances goes to `joints`, or failing that the most accurate one.
+ * Returns the number found.
+ */
+static int solve_analytic(const kinematics_ik_t *ik, const rigid_t *target, const float *seed, float *joints,
+                          kinematics_ik_report_t *report)
+{
+    const double (*w)[3] = ik->axes;
+    double fallback[6], wrist_target[3], in_tool[3], reach[3], theta3[2];
+    float candidates[8][6];
+    double distances[8];
+    int found = 0;
+
+    for (int j = 0; j < 6; j++)
+        fallback[j] = seed[j] * M_PI / 180.0;
+
+    /* The wrist centre depends on joints 1-3 only, and its distance from the shoulder on joint 3 alone */
+    rigid_apply(&ik->home_inverse, ik->wrist, in_tool);
+    rigid_apply(target, in_tool, wrist_target);
+    sub3(wrist_target, ik->shoulder, reach);
+    int n3 = subproblem3(w[2], ik->points[2], ik->wrist, ik->shoulder, sqrt(dot3(reach, reach)), theta3);
+
+    for (int i3 = 0; i3 < n3; i3++)
+    {
+        rigid_t e3;
+        double elbow[3], theta1[2], theta2[2];
+        rigid_screw(w[2], ik->points[2], theta3[i3], &e3);
+        rigid_apply(&e3, ik->wrist, elbow);
+        int n12 = subproblem2(w[0], w[1], ik->shoulder, elbow, wrist_target, fallback, theta1, theta2);
+
+        for (int i12 = 0; i12 < n12; i12++)
+        {
+            /* What joints 4-6 still have to do: (E1 E2 E3)^-1 * target * home^-1 */
+            rigid_t e1, e2, arm, rest;
+            rigid_screw(w[0], ik->points[0], theta1[i12], &e1);
+            rigid_screw(w[1], ik->points[1], theta2[i12], &e2);
+            rigid_mul(&e1, &e2, &arm);
+            rigid_mul(&arm, &e3, &arm);
+            rigid_inverse(&arm, &arm);
+            rigid_mul(&arm, target, &rest);
+            rigid_mul(&rest, &ik->home_inverse, &rest);
+
+            /* A point on axis 6 is left alone by joint 6, so joints 4 and 5 alone take it to rest * point */
+            double on6[3], moved6[3], theta4[2], theta5[2];
+            for (int k = 0; k < 3; k++)
+                on6[k] = ik->wrist[k] + w[5][k] * ik->length;
+            rigid_apply(&rest, on6, moved6);
+            int n45 = subproblem2(w[3], w[4], ik->wrist, on6, moved6, fallback + 3, theta4, theta5);
+
+            for (int i45 = 0; i45 < n45; i45++)
+            {
+                rigid_t e4, e5, wrist;
+                double side[3], off6[3], want[3];
+                double basis[3] = { fabs(w[5][0]) < 0.9 ? 1.0 : 0.0, fabs(w[5][0]) < 0.9 ? 0.0 : 1.0, 0.0 };
+
+                rigid_screw(w[3], ik->wrist, theta4[i45], &e4);
+                rigid_screw(w[4], ik->wrist, theta5[i45], &e5);
+                rigid_mul(&e4, &e5, &wrist);
+                rigid_inverse(&wrist, &wrist);
+                cross3(w[5], basis, side);
+                for (int k = 0; k < 3; k++)
+                    off6[k] = ik->wrist[k] + side[k] * ik->length;
+                rigid_apply(&rest, off6, want);
+                rigid_apply(&wrist, want, want);
+
+                double angles[6] = { theta1[i12], theta2[i12], theta3[i3], theta4[i45], theta5[i45],
+                                     subproblem1(w[5], ik->wrist, off6, want, fallback[5]) };
+                distances[found] = 0.0;
+                for (int j = 0; j < 6; j++)
+                {
+                    candidates[found][j] = nearest_degrees(angles[j], seed[j]);
+                    distances[found] += (double)(candidates[found][j] - seed[j]) * (candidates[found][j] - seed[j]);
+                }
+                found++;
+            }
+        }
+    }
+
+    /* Check candidates nearest first; normally the first one is exact and the only one evaluated */
+    bool tried[8] = { false };
+    float best_error = INFINITY;
+    for (int n = 0; n < found; n++)
+    {
+        int pick = -1;
+        float position, angle;
+        for (int i = 0; i < found; i++)
+        {
+            if (!tried[i] && (pick < 0 || distances[i] < distances[pick]))
+                pick = i;
+        }
+        tried[pick] = true;
+        measure(ik, target, candidates[pick], &position, &angle);
+
+        float error = (float)(position / ik->length) + angle;
+        if (error < best_error)
+        {
+            best_error = error;
+            memcpy(joints, candidates[pick], sizeof(candidates[pick]));
+            report->position_error = position;
+            report->angle_error = angle;
+        }
+        if (within_tolerance(position, angle))
+            break;
+    }
+    return found;
+}
+
+/* ---- Damped least squares ---- */
+
+/* Solves a x = b in place for the symmetric positive definite 6x6 a (Cholesky) */
+static void solve6(double a[6][6], double b[6])
+{
+    for (int j = 0; j < 6; j++)
+    {
+        double d = a[j][j];
+        for (int k = 0; k < j; k++)
+            d -= a[j][k] * a[j][k];
+        a[j][j] = sqrt(d > 1e-30 ? d : 1e-30);
+        for (int i = j + 1; i < 6; i++)
+        {
+            double s = a[i][j];
+            for (int k = 0; k < j; k++)
+                s -= a[i][k] * a[j][k];
+            a[i][j] = s / a[j][j];
+        }
+    }
+    for (int i = 0; i < 6; i++)
+    {
+        for (int k = 0; k < i; k++)
+            b[i] -= a[i][k] * b[k];
+        b[i] /= a[i][i];
+    }
+    for (int i = 5; i >= 0; i--)
+    {
+        for (int k = i + 1; k < 6; k++)
+            b[i] -= a[k][i] * b[k];
+        b[i] /= a[i][i];
+    }
+}
+
+/*
+ * Steps `joints` towards the target with dq = J^T (J J^T + lambda^2 I)^-1 e,
+ * orientation rows scaled by the chain length so both halves weigh alike.
+ * Leaves the best pose seen in `joints`; returns the steps taken.
+ */
+static int solve_dls(const kinematics_ik_t *ik, const rigid_t *target, float *joints,
+                     kinematics_ik_report_t *report)
+{
+    int n = ik->joint_count;
+    float axes[KINEMATICS_IK_MAX_JOINTS][3], points[KINEMATICS_IK_MAX_JOINTS][3], tip[16];
+    float best[KINEMATICS_IK_MAX_JOINTS];
+    double jac[6][KINEMATICS_IK_MAX_JOINTS];
+    double lambda2 = (DLS_DAMPING * ik->length) * (DLS_DAMPING * ik->length);
+    double best_cost = INFINITY;
+    int steps = 0;
+
+    memcpy(best, joints, (size_t)n * sizeof(float));
+    for (;;)
+    {
+        double error[6];
+        kinematics_joint_frames(ik->kin, joints, axes, points, tip);
+        pose_error(target, tip, error);
+
+        float position = (float)sqrt(dot3(error, error));
+        float angle = (float)(sqrt(dot3(error + 3, error + 3)) * 180.0 / M_PI);
+        double cost = position / ik->length + angle * (M_PI / 180.0);
+        if (cost < best_cost)
+        {
+            best_cost = cost;
+            memcpy(best, joints, (size_t)n * sizeof(float));
+            report->position_error = position;
+            report->angle_error = angle;
+        }
+        if (within_tolerance(position, angle) || steps == KINEMATICS_IK_MAX_ITERATIONS)
+            break;
+        steps++;
+
+        /* Columns per radian or model unit; a joint moves the tool point by axis x (tip - point) */
+        for (int j = 0; j < n; j++)
+        {
+            double axis[3] = { axes[j][0], axes[j][1], axes[j][2] };
+            if (ik->rotational[j])
+            {
+                double lever[3] = { tip[12] - points[j][0], tip[13] - points[j][1], tip[14] - points[j][2] };
+                double v[3];
+                cross3(axis, lever, v);
+                for (int k = 0; k < 3; k++)
+                {
+                    jac[k][j] = v[k];
+                    jac[3 + k][j] = axis[k] * ik->length;
+                }
+            }
+            else
+            {
+                for (int k = 0; k < 3; k++)
+                {
+                    jac[k][j] = axis[k];
+                    jac[3 + k][j] = 0.0;
+                }
+            }
+        }
+        for (int k = 3; k < 6; k++)
+            error[k] *= ik->length;
+
+        double a[6][6];
+        for (int r = 0; r < 6; r++)
+        {
+            for (int c = 0; c <= r; c++)
+            {
+                double s = r == c ? lambda2 : 0.0;
+                for (int j = 0; j < n; j++)
+                    s += jac[r][j] * jac[c][j];
+                a[r][c] = a[c][r] = s;
+            }
+        }
+        solve6(a, error);
+
+        double step[KINEMATICS_IK_MAX_JOINTS], scale = 1.0;
+        for (int j = 0; j < n; j++)
+        {
+            step[j] = 0.0;
+            for (int k = 0; k < 6; k++)
+                step[j] += jac[k][j] * error[k];
+            double limit = ik->rotational[j] ? DLS_MAX_TURN : DLS_MAX_SLIDE * ik->length;
+            if (fabs(step[j]) * scale > limit)
+                scale = limit / fabs(step[j]);
+        }
+        for (int j = 0; j < n; j++)
+            joints[j] += (float)(step[j] * scale * (ik->rotational[j] ? 180.0 / M_PI : 1.0));
+    }
+
+    memcpy(joints, best, (size_t)n * sizeof(float));
+    return steps;
+}
+
+/* ---- Setup ---- */
+
+static void detect_wrist_partition(kinematics_ik_t *ik)
+{
+    double distance, mid45[3], mid56[3], gap[3];
+    double tolerance = AXIS_MEET * ik->length;
+    const double (*w)[3] = ik->axes;
+    const double (*p)[3] = ik->points;
+
+    if (ik->joint_count != 6)
+        return;
+    for (int j = 0; j < 6; j++)
+    {
+        if (!ik->rotational[j])
+            return;
+    }
+
+    if (!lines_meet(p[0], w[0], p[1], w[1], &distance, ik->shoulder) || distance > tolerance)
+        return;
+    if (!lines_meet(p[3], w[3], p[4], w[4], &distance, mid45) || distance > tolerance)
+        return;
+    if (!lines_meet(p[4], w[4], p[5], w[5], &distance, mid56) || distance > tolerance)
+        return;
+    sub3(mid45, mid56, gap);
+    if (sqrt(dot3(gap, gap)) > tolerance)
+        return;
+
+    for (int k = 0; k < 3; k++)
+        ik->wrist[k] = 0.5 * (mid45[k] + mid56[k]);
+    ik->analytic = true;
+}
+
+kinematics_ik_t *kinematics_ik_create(const kinematics_t *kin)
+{
+    int n = kinematics_joint_count(kin);
+    float zero[KINEMATICS_IK_MAX_JOINTS] = { 0 };
+    float axes[KINEMATICS_IK_MAX_JOINTS][3], points[KINEMATICS_IK_MAX_JOINTS][3], home[16];
+    kinematics_ik_t *ik;
+
+    if (n > KINEMATICS_IK_MAX_JOINTS)
+        return NULL;
+    ik = calloc(1, sizeof(*ik));
+    if (ik == NULL)
+        return NULL;
+    ik->kin = kin;
+    ik->joint_count = n;
+
+    kinematics_joint_frames(kin, zero, axes, points, home);
+    rigid_t tool;
+    rigid_from_mat4(home, &tool);
+    rigid_inverse(&tool, &ik->home_inverse);
+
+    /* Chain length: the joint-to-joint path out to the tool, at least one unit */
+    double last[3] = { 0.0, 0.0, 0.0 };
+    for (int j = 0; j <= n; j++)
+    {
+        double next[3], d[3];
+        for (int k = 0; k < 3; k++)
+            next[k] = j < n ? points[j][k] : home[12 + k];
+        sub3(next, last, d);
+        if (j > 0)
+            ik->length += sqrt(dot3(d, d));
+        memcpy(last, next, sizeof(last));
+    }
+    if (ik->length < 1.0)
+        ik->length = 1.0;
+
+    for (int j = 0; j < n; j++)
+    {
+        ik->rotational[j] = kinematics_joint_rotational(kin, j);
+        if (j < 6)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                ik->axes[j][k] = axes[j][k];
+                ik->points[j][k] = points[j][k];
+            }
+        }
+    }
+    detect_wrist_partition(ik);
+    return ik;
+}
+
+void kinematics_ik_destroy(kinematics_ik_t *ik)
+{
+    free(ik);
+}
+
+bool kinematics_ik_analytic(const kinematics_ik_t *ik)
+{
+    return ik->analytic;
+}
+
+bool kinematics_ik_solve(const kinematics_ik_t *ik, const float target[16], const float *seed, float *joints,
+                         kinematics_ik_report_t *report)
+{
+    kinematics_ik_report_t result = { 0 };
+    float start[KINEMATICS_IK_MAX_JOINTS];
+    rigid_t goal;
+    bool solved = false;
+
+    memcpy(start, seed, (size_t)ik->joint_count * sizeof(float));
+    rigid_from_mat4(target, &goal);
+
+    if (ik->analytic && solve_analytic(ik, &goal, start, joints, &result) > 0)
+    {
+        result.analytic = true;
+        solved = within_tolerance(result.position_error, result.angle_error);
+    }
+    else
+    {
+        memcpy(joints, start, (size_t)ik->joint_count * sizeof(float));
+    }
+
+    /* Polishes a closed-form answer that float rounding left just outside, or does all the work */
+    if (!solved)
+    {
+        result.iterations = solve_dls(ik, &goal, joints, &result);
+        solved = within_tolerance(result.position_error, result.angle_error);
+    }
+
+    if (report)
+        *report = result;
+    return solved;
+}
@@ -0,0 +1,56 @@
+/**
+ * @file kinematics_ik.h
+ * @brief Inverse kinematics on a kinematics_t chain.
+ *
+ * kinematics_ik_create() inspects the chain once. Six rotational joints
+ * whose first two axes intersect and whose last three meet in one point (a
+ * spherical wrist, as on the Meca500 and most industrial arms) are solved
+ * in closed form with Paden-Kahan subproblems: the wrist centre fixes
+ * joints 1-3, what is left of the orientation joints 4-6. Of the up to
+ * eight solutions the one nearest the seed wins, each angle taken within
+ * 180 degrees of the seed's. Any other chain, and a closed-form answer that
+ * misses the tolerances, goes through damped least squares from the seed.
+ *
+ * Targets are tool poses as kinematics_forward() reports them; joint values
+ * are degrees or model units as in kinematics.h. Solving allocates nothing
+ * and leaves the solver untouched, so one solver may serve several threads.
+ * kinematics_bench reports solve times.
+ */
+
+#ifndef KINEMATICS_IK_H
+#define KINEMATICS_IK_H
+
+#include "kinematics.h"
+
+#define KINEMATICS_IK_MAX_JOINTS 16
+#define KINEMATICS_IK_MAX_ITERATIONS 32         /* Damped least-squares steps per solve */
+#define KINEMATICS_IK_POSITION_TOLERANCE 0.01f  /* Model units (mm in the machine configs) */
+#define KINEMATICS_IK_ANGLE_TOLERANCE 0.01f     /* Degrees */
+
+typedef struct kinematics_ik kinematics_ik_t;
+
+typedef struct
+{
+    float position_error;  /* Tool point distance to the target, model units */
+    float angle_error;     /* Tool orientation difference, degrees */
+    int iterations;        /* Damped least-squares steps, 0 when the closed form was exact */
+    bool analytic;         /* The result started from a closed-form solution */
+} kinematics_ik_report_t;
+
+/* Solver for `kin`, which must outlive it; NULL for chains with more than KINEMATICS_IK_MAX_JOINTS joints */
+kinematics_ik_t *kinematics_ik_create(const kinematics_t *kin);
+void kinematics_ik_destroy(kinematics_ik_t *ik);
+
+/* Whether the chain qualified for the closed-form solver */
+bool kinematics_ik_analytic(const kinematics_ik_t *ik);
+
+/*
+ * Joint values reaching `target` (column-major tool pose) starting from
+ * `seed`, typically the current pose; `joints` may alias `seed`. Returns
+ * whether both tolerances were met. Otherwise `joints` holds the closest
+ * pose found, e.g. for a target out of reach. `report` may be NULL.
+ */
+bool kinematics_ik_solve(const kinematics_ik_t *ik, const float target[16], const float *seed, float *joints,
+                         kinematics_ik_report_t *report);
+
+#endif // KINEMATICS_IK_H
@@ -0,0 +1,376 @@
+/**
+ * @file mesh.c
+ * @brief Vertex welding and Forsyth vertex-cache triangle ordering.
+ */
+
+#include "mesh.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Forsyth's published tuning */
+#define CACHE_DECAY_POWER 1.5f
+#define LAST_TRI_SCORE 0.75f
+#define VALENCE_BOOST_SCALE 2.0f
+#define VALENCE_BOOST_POWER 0.5f
+#define VALENCE_TABLE 64
+
+bool mesh_alloc(mesh_t *mesh, int vertex_count, int triangle_count)
+{
+    memset(mesh, 0, sizeof(*mesh));
+    mesh->vertex_count = vertex_count;
+    mesh->triangle_count = triangle_count;
+    mesh->x = malloc((size_t)vertex_count * sizeof(float) + 1);
+    mesh->y = malloc((size_t)vertex_count * sizeof(float) + 1);
+    mesh->z = malloc((size_t)vertex_count * sizeof(float) + 1);
+    mesh->indices = malloc((size_t)triangle_count * 3 * sizeof(uint32_t) + 1);
+    if (mesh->x == NULL || mesh->y == NULL || mesh->z == NULL || mesh->indices == NULL)
+    {
+        mesh_free(mesh);
+        return false;
+    }
+    return true;
+}
+
+void mesh_free(mesh_t *mesh)
+{
+    if (mesh->borrowed)
+    {
+        memset(mesh, 0, sizeof(*mesh));
+        return;
+    }
+    free(mesh->x);
+    free(mesh->y);
+    free(mesh->z);
+    free(mesh->indices);
+    memset(mesh, 0, sizeof(*mesh));
+}
+
+size_t mesh_bytes(const mesh_t *mesh)
+{
+    return (size_t)mesh->vertex_count * 3 * sizeof(float) + (size_t)mesh->triangle_count * 3 * sizeof(uint32_t);
+}
+
+/* ---- Welding ---- */
+
+static uint32_t hash_position(const float *p)
+{
+    uint32_t x, y, z;
+    float v[3] = { p[0] + 0.0f, p[1] + 0.0f, p[2] + 0.0f }; /* -0 and +0 weld */
+
+    memcpy(&x, &v[0], 4);
+    memcpy(&y, &v[1], 4);
+    memcpy(&z, &v[2], 4);
+    return (x * 73856093u) ^ (y * 19349663u) ^ (z * 83492791u);
+}
+
+bool mesh_from_soup(const stl_mesh_t *soup, mesh_t *mesh)
+{
+    size_t corners = (size_t)soup->triangle_count * 3;
+    size_t size = 64;
+    int vertex_count = 0;
+    int triangle_count = 0;
+
+    memset(mesh, 0, sizeof(*mesh));
+    while (size < corners * 2)
+        size *= 2;
+
+    int *table = malloc(size * sizeof(int));
+    uint32_t *first = malloc(corners * sizeof(uint32_t) + 1); /* Soup corner each vertex came from */
+    uint32_t *indices = malloc(corners * sizeof(uint32_t) + 1);
+    if (table == NULL || first == NULL || indices == NULL)
+    {
+        free(table);
+        free(first);
+        free(indices);
+        return false;
+    }
+    memset(table, 0xFF, size * sizeof(int));
+
+    for (size_t c = 0; c < corners; c++)
+    {
+        const float *p = &soup->vertices[c * 3];
+        size_t slot = hash_position(p) & (size - 1);
+
+        while (table[slot] >= 0 && memcmp(&soup->vertices[first[table[slot]] * 3], p, 3 * sizeof(float)) != 0)
+            slot = (slot + 1) & (size - 1);
+        if (table[slot] < 0)
+        {
+            table[slot] = vertex_count;
+            first[vertex_count++] = (uint32_t)c;
+        }
+        indices[c] = (uint32_t)table[slot];
+    }
+    free(table);
+
+    /* Triangles with two corners on the same vertex cover no pixels */
+    for (int t = 0; t < soup->triangle_count; t++)
+    {
+        const uint32_t *i = &indices[t * 3];
+        if (i[0] != i[1] && i[1] != i[2] && i[2] != i[0])
+        {
+            if (t != triangle_count)
+                memcpy(&indices[triangle_count * 3], i, 3 * sizeof(uint32_t));
+            triangle_count++;
+        }
+    }
+
+    bool ok = mesh_alloc(mesh, vertex_count, triangle_count);
+    if (ok)
+    {
+        for (int v = 0; v < vertex_count; v++)
+        {
+            const float *p = &soup->vertices[first[v] * 3];
+            mesh->x[v] = p[0];
+            mesh->y[v] = p[1];
+            mesh->z[v] = p[2];
+        }
+        memcpy(mesh->indices, indices, (size_t)triangle_count * 3 * sizeof(uint32_t));
+        ok = mesh_optimize(mesh);
+        if (!ok)
+            mesh_free(mesh);
+    }
+
+    free(first);
+    free(indices);
+    return ok;
+}
+
+/* ---- Forsyth ordering ---- */
+
+typedef struct
+{
+    float cache_score[MESH_CACHE_SIZE];
+    float valence_score[VALENCE_TABLE];
+} score_table_t;
+
+static void init_scores(score_table_t *s)
+{
+    for (int i = 0; i < MESH_CACHE_SIZE; i++)
+    {
+        /* The last triangle's vertices score a fixed amount so it isn't simply repeated */
+        s->cache_score[i] = i < 3 ? LAST_TRI_SCORE
+                                  : powf(1.0f - (float)(i - 3) / (float)(MESH_CACHE_SIZE - 3), CACHE_DECAY_POWER);
+    }
+    for (int i = 1; i < VALENCE_TABLE; i++)
+        s->valence_score[i] = VALENCE_BOOST_SCALE * powf((float)i, -VALENCE_BOOST_POWER);
+    s->valence_score[0] = 0.0f;
+}
+
+static float vertex_score(const score_table_t *s, int cache_position, int remaining)
+{
+    float score;
+
+    if (remaining == 0)
+        return -1.0f; /* Nothing left to draw with it */
+    score = cache_position >= 0 ? s->cache_score[cache_position] : 0.0f;
+    score += remaining < VALENCE_TABLE ? s->valence_score[remaining]
+                                       : VALENCE_BOOST_SCALE * powf((float)remaining, -VALENCE_BOOST_POWER);
+    return score;
+}
+
+static bool reorder_triangles(mesh_t *mesh)
+{
+    int vcount = mesh->vertex_count;
+    int tcount = mesh->triangle_count;
+    const uint32_t *in = mesh->indices;
+    score_table_t scores;
+    int cache[MESH_CACHE_SIZE + 3];
+    int cache_count = 0;
+    int cursor = 0;
+    bool ok;
+
+    int *offsets = calloc((size_t)vcount + 1, sizeof(int));
+    int *remaining = calloc((size_t)vcount + 1, sizeof(int));
+    int *position = malloc((size_t)vcount * sizeof(int) + 1);
+    float *vscore = malloc((size_t)vcount * sizeof(float) + 1);
+    int *adjacency = malloc((size_t)tcount * 3 * sizeof(int) + 1);
+    float *tscore = malloc((size_t)tcount * sizeof(float) + 1);
+    uint8_t *emitted = calloc((size_t)tcount + 1, 1);
+    uint32_t *out = malloc((size_t)tcount * 3 * sizeof(uint32_t) + 1);
+
+    ok = offsets && remaining && position && vscore && adjacency && tscore && emitted && out;
+    if (ok)
+    {
+        init_scores(&scores);
+
+        /* Triangles around each vertex; the first remaining[v] entries are the undrawn ones */
+        for (int i = 0; i < tcount * 3; i++)
+            offsets[in[i] + 1]++;
+        for (int v = 0; v < vcount; v++)
+            offsets[v + 1] += offsets[v];
+        for (int i = 0; i < tcount * 3; i++)
+            adjacency[offsets[in[i]] + remaining[in[i]]++] = i / 3;
+
+        for (int v = 0; v < vcount; v++)
+        {
+            position[v] = -1;
+            vscore[v] = vertex_score(&scores, -1, remaining[v]);
+        }
+        for (int t = 0; t < tcount; t++)
+            tscore[t] = vscore[in[t * 3]] + vscore[in[t * 3 + 1]] + vscore[in[t * 3 + 2]];
+    }
+
+    int best = -1;
+    for (int t = 0; ok && t < tcount; t++)
+    {
+        if (best < 0 || tscore[t] > tscore[best])
+            best = t;
+    }
+
+    for (int drawn = 0; ok && drawn < tcount; drawn++)
+    {
+        if (best < 0)
+        {
+            /* Nothing in the cache has work left: continue with the next undrawn triangle */
+            while (emitted[cursor])
+                cursor++;
+            best = cursor;
+        }
+
+        const uint32_t *tri = &in[best * 3];
+        int next[MESH_CACHE_SIZE + 3];
+        int next_count = 0;
+
+        memcpy(&out[drawn * 3], tri, 3 * sizeof(uint32_t));
+        emitted[best] = 1;
+
+        for (int k = 0; k < 3; k++)
+        {
+            int v = (int)tri[k];
+            int *list = &adjacency[offsets[v]];
+            for (int i = 0; i < remaining[v]; i++)
+            {
+                if (list[i] == best)
+                {
+                    list[i] = list[--remaining[v]];
+                    break;
+                }
+            }
+            next[next_count++] = v;
+        }
+
+        /* LRU: the drawn triangle's vertices move to the front */
+        for (int i = 0; i < cache_count; i++)
+        {
+            int v = cache[i];
+            if (v != (int)tri[0] && v != (int)tri[1] && v != (int)tri[2] && next_count < MESH_CACHE_SIZE + 3)
+                next[next_count++] = v;
+        }
+
+        for (int i = 0; i < next_count; i++)
+        {
+            int v = next[i];
+            position[v] = i < MESH_CACHE_SIZE ? i : -1;
+            vscore[v] = vertex_score(&scores, position[v], remaining[v]);
+        }
+
+        best = -1;
+        for (int i = 0; i < next_count; i++)
+        {
+            int v = next[i];
+            const int *list = &adjacency[offsets[v]];
+            for (int j = 0; j < remaining[v]; j++)
+            {
+                int t = list[j];
+                tscore[t] = vscore[in[t * 3]] + vscore[in[t * 3 + 1]] + vscore[in[t * 3 + 2]];
+                if (best < 0 || tscore[t] > tscore[best])
+                    best = t;
+            }
+        }
+
+        cache_count = next_count < MESH_CACHE_SIZE ? next_count : MESH_CACHE_SIZE;
+        memcpy(cache, next, (size_t)cache_count * sizeof(int));
+    }
+
+    if (ok)
+    {
+        free(mesh->indices);
+        mesh->indices = out;
+        out = NULL;
+    }
+
+    free(offsets);
+    free(remaining);
+    free(position);
+    free(vscore);
+    free(adjacency);
+    free(tscore);
+    free(emitted);
+    free(out);
+    return ok;
+}
+
+/* Vertices in the order the triangles first use them */
+static bool renumber_vertices(mesh_t *mesh)
+{
+    int count = mesh->vertex_count;
+    int *remap = malloc((size_t)count * sizeof(int) + 1);
+    float *x = malloc((size_t)count * sizeof(float) + 1);
+    float *y = malloc((size_t)count * sizeof(float) + 1);
+    float *z = malloc((size_t)count * sizeof(float) + 1);
+    int next = 0;
+
+    if (remap == NULL || x == NULL || y == NULL || z == NULL)
+    {
+        free(remap);
+        free(x);
+        free(y);
+        free(z);
+        return false;
+    }
+
+    memset(remap, 0xFF, (size_t)count * sizeof(int));
+    for (int i = 0; i < mesh->triangle_count * 3; i++)
+    {
+        uint32_t v = mesh->indices[i];
+        if (remap[v] < 0)
+        {
+            remap[v] = next;
+            x[next] = mesh->x[v];
+            y[next] = mesh->y[v];
+            z[next] = mesh->z[v];
+            next++;
+        }
+        mesh->indices[i] = (uint32_t)remap[v];
+    }
+
+    free(remap);
+    free(mesh->x);
+    free(mesh->y);
+    free(mesh->z);
+    mesh->x = x;
+    mesh->y = y;
+    mesh->z = z;
+    mesh->vertex_count = next; /* Vertices no triangle uses are gone */
+    return true;
+}
+
+bool mesh_optimize(mesh_t *mesh)
+{
+    if (mesh->triangle_count == 0)
+        return true;
+    return reorder_triangles(mesh) && renumber_vertices(mesh);
+}
+
+float mesh_acmr(const mesh_t *mesh, int cache_size)
+{
+    uint32_t *stamp = calloc((size_t)mesh->vertex_count + 1, sizeof(uint32_t));
+    uint32_t misses = 0;
+
+    if (stamp == NULL || mesh->triangle_count == 0)
+    {
+        free(stamp);
+        return 3.0f;
+    }
+
+    /* A vertex is still in the FIFO if fewer than cache_size misses happened since it was loaded */
+    for (int i = 0; i < mesh->triangle_count * 3; i++)
+    {
+        uint32_t v = mesh->indices[i];
+        if (stamp[v] == 0 || misses - stamp[v] >= (uint32_t)cache_size)
+            stamp[v] = ++misses;
+    }
+    free(stamp);
+    return (float)misses / (float)mesh->triangle_count;
+}
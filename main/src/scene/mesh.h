@@ -0,0 +1,82 @@
+/**
+ * @file mesh.h
+ * @brief Indexed, vertex-cache ordered triangle mesh built from STL soups.
+ *
+ * An STL soup stores every shared corner again for each triangle (about six
+ * copies per vertex on a closed surface) plus a facet normal the loader
+ * derives from the winding anyway. mesh_from_soup() welds bit-identical
+ * corners into one vertex, keeps positions as three separate arrays and
+ * drops the normals: they are recomputed from the winding where needed.
+ *
+ * Triangles are then reordered for post-transform vertex cache reuse with
+ * Tom Forsyth's linear-speed algorithm and the vertices renumbered in order
+ * of first use, so consecutive triangles mostly touch vertices that were
+ * just transformed and sit next to each other in memory.
+ */
+
+#ifndef MESH_H
+#define MESH_H
+
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "stl.h"
+
+#define MESH_CACHE_SIZE 32   /* Post-transform cache the triangle order is tuned for */
+
+typedef struct
+{
+    int vertex_count;
+    int triangle_count;
+    float *x;                /* Vertex positions, struct-of-arrays */
+    float *y;
+    float *z;
+    uint32_t *indices;       /* 3 per triangle, wound as in the STL file */
+    bool borrowed;           /* Arrays live in a cache mapping (mesh_cache.h); read-only, not freed */
+} mesh_t;
+
+/* Welds and reorders `soup`; degenerate triangles are dropped. False on allocation failure. */
+bool mesh_from_soup(const stl_mesh_t *soup, mesh_t *mesh);
+
+/* Allocates room for the given counts; contents are uninitialised */
+bool mesh_alloc(mesh_t *mesh, int vertex_count, int triangle_count);
+
+/* Frees owned arrays and clears the mesh; borrowed arrays are left to their mapping */
+void mesh_free(mesh_t *mesh);
+
+/* Forsyth triangle order, then vertices renumbered by first use */
+bool mesh_optimize(mesh_t *mesh);
+
+/* Average vertices transformed per triangle with a FIFO cache of `cache_size` (1.0 - 3.0) */
+float mesh_acmr(const mesh_t *mesh, int cache_size);
+
+/* Heap bytes held by the mesh */
+size_t mesh_bytes(const mesh_t *mesh);
+
+static inline void mesh_vertex(const mesh_t *mesh, uint32_t index, float out[3])
+{
+    out[0] = mesh->x[index];
+    out[1] = mesh->y[index];
+    out[2] = mesh->z[index];
+}
+
+/* Unit facet normal of triangle t from its winding; zero for a sliver */
+static inline void mesh_face_normal(const mesh_t *mesh, int t, float n[3])
+{
+    const uint32_t *i = &mesh->indices[t * 3];
+    float ax = mesh->x[i[1]] - mesh->x[i[0]], ay = mesh->y[i[1]] - mesh->y[i[0]], az = mesh->z[i[1]] - mesh->z[i[0]];
+    float bx = mesh->x[i[2]] - mesh->x[i[0]], by = mesh->y[i[2]] - mesh->y[i[0]], bz = mesh->z[i[2]] - mesh->z[i[0]];
+    float nx = ay * bz - az * by;
+    float ny = az * bx - ax * bz;
+    float nz = ax * by - ay * bx;
+    float len = sqrtf(nx * nx + ny * ny + nz * nz);
+    float inv = len > 0.0f ? 1.0f / len : 0.0f;
+
+    n[0] = nx * inv;
+    n[1] = ny * inv;
+    n[2] = nz * inv;
+}
+
+#endif // MESH_H
@@ -0,0 +1,657 @@
+/**
+ * @file mesh_bvh.c
+ * @brief Median-split hierarchy build, paired traversals and the triangle-triangle tests.
+ */
+
+#include "mesh_bvh.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define COPLANAR_EPSILON 1e-10f  /* |na x nb|^2 below this fraction of |na|^2 |nb|^2 counts as parallel */
+
+typedef struct
+{
+    uint32_t node;
+    uint32_t first;
+    uint32_t count;
+    int depth;
+} build_item_t;
+
+typedef struct
+{
+    uint32_t a;
+    uint32_t b;
+} node_pair_t;
+
+/* Reorders items[0..count) so that the nth smallest key lands at nth (Hoare selection) */
+static void select_nth(uint32_t *items, int count, int nth, const float *centroids, int axis)
+{
+    int lo = 0, hi = count - 1;
+
+    while (hi > lo)
+    {
+        float pivot = centroids[items[(lo + hi) / 2] * 3 + axis];
+        int i = lo, j = hi;
+
+        while (i <= j)
+        {
+            while (centroids[items[i] * 3 + axis] < pivot)
+                i++;
+            while (centroids[items[j] * 3 + axis] > pivot)
+                j--;
+            if (i <= j)
+            {
+                uint32_t t = items[i];
+                items[i++] = items[j];
+                items[j--] = t;
+            }
+        }
+        if (nth <= j)
+            hi = j;
+        else if (nth >= i)
+            lo = i;
+        else
+            break;
+    }
+}
+
+static void triangle_corners(const mesh_t *mesh, uint32_t t, float p[3][3])
+{
+    const uint32_t *i = &mesh->indices[t * 3];
+    for (int k = 0; k < 3; k++)
+        mesh_vertex(mesh, i[k], p[k]);
+}
+
+bool mesh_bvh_build(const mesh_t *mesh, mesh_bvh_t *bvh)
+{
+    int n = mesh->triangle_count;
+    build_item_t stack[MESH_BVH_MAX_DEPTH + 2];
+    int top = 0;
+    float *centroids;
+
+    memset(bvh, 0, sizeof(*bvh));
+    if (n <= 0)
+        return true;
+
+    bvh->triangles = malloc((size_t)n * sizeof(*bvh->triangles));
+    bvh->nodes = malloc((size_t)(2 * n - 1) * sizeof(*bvh->nodes));
+    centroids = malloc((size_t)n * 3 * sizeof(float));
+    if (bvh->triangles == NULL || bvh->nodes == NULL || centroids == NULL)
+    {
+        free(centroids);
+        mesh_bvh_free(bvh);
+        return false;
+    }
+
+    /* Corner sums: a third of the centroid orders the same */
+    for (int t = 0; t < n; t++)
+    {
+        float p[3][3];
+        triangle_corners(mesh, (uint32_t)t, p);
+        for (int k = 0; k < 3; k++)
+            centroids[t * 3 + k] = p[0][k] + p[1][k] + p[2][k];
+        bvh->triangles[t] = (uint32_t)t;
+    }
+    bvh->triangle_count = n;
+    bvh->node_count = 1;
+    stack[top++] = (build_item_t){ 0, 0, (uint32_t)n, 0 };
+
+    while (top > 0)
+    {
+        build_item_t item = stack[--top];
+        mesh_bvh_node_t *node = &bvh->nodes[item.node];
+        uint32_t *items = &bvh->triangles[item.first];
+        aabb_t spread;
+
+        aabb_empty(&node->box);
+        aabb_empty(&spread);
+        for (uint32_t i = 0; i < item.count; i++)
+        {
+            float p[3][3];
+            triangle_corners(mesh, items[i], p);
+            for (int k = 0; k < 3; k++)
+                aabb_add_point(&node->box, p[k]);
+            aabb_add_point(&spread, &centroids[items[i] * 3]);
+        }
+
+        if (item.count <= MESH_BVH_LEAF_TRIANGLES || item.depth >= MESH_BVH_MAX_DEPTH)
+        {
+            node->first = item.first;
+            node->count = item.count;
+            continue;
+        }
+
+        /* Identical centroids still split by position in the list, which keeps leaves small */
+        int axis = 0;
+        for (int k = 1; k < 3; k++)
+        {
+            if (spread.max[k] - spread.min[k] > spread.max[axis] - spread.min[axis])
+                axis = k;
+        }
+        uint32_t half = item.count / 2;
+        select_nth(items, (int)item.count, (int)half, centroids, axis);
+
+        node->first = (uint32_t)bvh->node_count;
+        node->count = 0;
+        bvh->node_count += 2;
+        stack[top++] = (build_item_t){ node->first + 1, item.first + half, item.count - half, item.depth + 1 };
+        stack[top++] = (build_item_t){ node->first, item.first, half, item.depth + 1 };
+    }
+
+    free(centroids);
+    return true;
+}
+
+void mesh_bvh_free(mesh_bvh_t *bvh)
+{
+    free(bvh->nodes);
+    free(bvh->triangles);
+    memset(bvh, 0, sizeof(*bvh));
+}
+
+size_t mesh_bvh_bytes(const mesh_bvh_t *bvh)
+{
+    return (size_t)bvh->node_count * sizeof(*bvh->nodes) + (size_t)bvh->triangle_count * sizeof(*bvh->triangles);
+}
+
+static inline void sub3(const float a[3], const float b[3], float out[3])
+{
+    out[0] = a[0] - b[0];
+    out[1] = a[1] - b[1];
+    out[2] = a[2] - b[2];
+}
+
+static inline void cross3(const float a[3], const float b[3], float out[3])
+{
+    out[0] = a[1] * b[2] - a[2] * b[1];
+    out[1] = a[2] * b[0] - a[0] * b[2];
+    out[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+static inline float dot3(const float a[3], const float b[3])
+{
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+/* Whether the projections of the two triangles onto `axis` are disjoint */
+static inline bool separated(const float a[3][3], const float b[3][3], const float axis[3])
+{
+    float a0 = dot3(a[0], axis), a1 = dot3(a[1], axis), a2 = dot3(a[2], axis);
+    float b0 = dot3(b[0], axis), b1 = dot3(b[1], axis), b2 = dot3(b[2], axis);
+    float amin = fminf(a0, fminf(a1, a2)), amax = fmaxf(a0, fmaxf(a1, a2));
+    float bmin = fminf(b0, fminf(b1, b2)), bmax = fmaxf(b0, fmaxf(b1, b2));
+
+    return amax < bmin || bmax < amin;
+}
+
+/*
+ * Separating axis test: the two face normals and the nine edge-edge cross
+ * products decide every configuration except coplanar triangles, which
+ * also need the in-plane edge normals. Touching counts as intersecting.
+ */
+static bool triangles_intersect(const float a[3][3], const float b[3][3])
+{
+    float ea[3][3], eb[3][3], na[3], nb[3], axis[3];
+
+    for (int k = 0; k < 3; k++)
+    {
+        sub3(a[(k + 1) % 3], a[k], ea[k]);
+        sub3(b[(k + 1) % 3], b[k], eb[k]);
+    }
+    cross3(ea[0], ea[1], na);
+    if (separated(a, b, na))
+        return false;
+    cross3(eb[0], eb[1], nb);
+    if (separated(a, b, nb))
+        return false;
+
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            cross3(ea[i], eb[j], axis);
+            if (separated(a, b, axis))
+                return false;
+        }
+    }
+
+    cross3(na, nb, axis);
+    if (dot3(axis, axis) > COPLANAR_EPSILON * dot3(na, na) * dot3(nb, nb))
+        return true;
+    for (int k = 0; k < 3; k++)
+    {
+        cross3(na, ea[k], axis);
+        if (separated(a, b, axis))
+            return false;
+        cross3(nb, eb[k], axis);
+        if (separated(a, b, axis))
+            return false;
+    }
+    return true;
+}
+
+static inline bool boxes_overlap(const aabb_t *a, const aabb_t *b)
+{
+    return a->min[0] <= b->max[0] && b->min[0] <= a->max[0] && a->min[1] <= b->max[1] && b->min[1] <= a->max[1] &&
+           a->min[2] <= b->max[2] && b->min[2] <= a->max[2];
+}
+
+static bool leaves_intersect(const mesh_t *a, const mesh_bvh_t *bvh_a, const mesh_bvh_node_t *leaf_a,
+                             const mesh_t *b, const mesh_bvh_t *bvh_b, const mesh_bvh_node_t *leaf_b,
+                             const float b_to_a[16])
+{
+    for (uint32_t j = 0; j < leaf_b->count; j++)
+    {
+        float tb[3][3];
+        aabb_t box;
+
+        triangle_corners(b, bvh_b->triangles[leaf_b->first + j], tb);
+        aabb_empty(&box);
+        for (int k = 0; k < 3; k++)
+        {
+            mat4_transform_point(b_to_a, tb[k], tb[k]);
+            aabb_add_point(&box, tb[k]);
+        }
+        if (!boxes_overlap(&box, &leaf_a->box))
+            continue;
+
+        for (uint32_t i = 0; i < leaf_a->count; i++)
+        {
+            float ta[3][3];
+            aabb_t tri_box;
+
+            triangle_corners(a, bvh_a->triangles[leaf_a->first + i], ta);
+            aabb_empty(&tri_box);
+            for (int k = 0; k < 3; k++)
+                aabb_add_point(&tri_box, ta[k]);
+            if (boxes_overlap(&box, &tri_box) && triangles_intersect(ta, tb))
+                return true;
+        }
+    }
+    return false;
+}
+
+static inline bool point_in_box(const float p[3], const aabb_t *b)
+{
+    return p[0] >= b->min[0] && p[0] <= b->max[0] && p[1] >= b->min[1] && p[1] <= b->max[1] && p[2] >= b->min[2] &&
+           p[2] <= b->max[2];
+}
+
+/* Slab test: whether the ray from `origin` enters the box */
+static bool ray_hits_box(const float origin[3], const float inverse_direction[3], const aabb_t *box)
+{
+    float near = 0.0f, far = FLT_MAX;
+
+    for (int k = 0; k < 3; k++)
+    {
+        float t0 = (box->min[k] - origin[k]) * inverse_direction[k];
+        float t1 = (box->max[k] - origin[k]) * inverse_direction[k];
+        near = fmaxf(near, fminf(t0, t1));
+        far = fminf(far, fmaxf(t0, t1));
+    }
+    return near <= far;
+}
+
+/* Möller-Trumbore: whether the ray crosses the triangle ahead of its origin */
+static bool ray_hits_triangle(const float origin[3], const float direction[3], const float t[3][3])
+{
+    float e1[3], e2[3], p[3], q[3], s[3];
+
+    sub3(t[1], t[0], e1);
+    sub3(t[2], t[0], e2);
+    cross3(direction, e2, p);
+    float det = dot3(e1, p);
+    if (det == 0.0f)
+        return false;
+    float inv = 1.0f / det;
+    sub3(origin, t[0], s);
+    float u = dot3(s, p) * inv;
+    if (u < 0.0f || u > 1.0f)
+        return false;
+    cross3(s, e1, q);
+    float v = dot3(direction, q) * inv;
+    return v >= 0.0f && u + v <= 1.0f && dot3(e2, q) * inv > 0.0f;
+}
+
+/*
+ * Even-odd test of a point against a closed mesh. The ray direction is
+ * deliberately skewed so it doesn't run along the axis-aligned edges and
+ * faces CAD parts are full of.
+ */
+static bool point_inside(const mesh_t *mesh, const mesh_bvh_t *bvh, const float point[3])
+{
+    static const float direction[3] = { 0.8017837f, 0.5345225f, 0.2672612f };
+    const float inverse_direction[3] = { 1.0f / direction[0], 1.0f / direction[1], 1.0f / direction[2] };
+    uint32_t stack[MESH_BVH_MAX_DEPTH + 2];
+    int top = 0, crossings = 0;
+
+    stack[top++] = 0;
+    while (top > 0)
+    {
+        const mesh_bvh_node_t *node = &bvh->nodes[stack[--top]];
+
+        if (!ray_hits_box(point, inverse_direction, &node->box))
+            continue;
+        if (node->count == 0)
+        {
+            stack[top++] = node->first + 1;
+            stack[top++] = node->first;
+            continue;
+        }
+        for (uint32_t i = 0; i < node->count; i++)
+        {
+            float t[3][3];
+            triangle_corners(mesh, bvh->triangles[node->first + i], t);
+            crossings += ray_hits_triangle(point, direction, t);
+        }
+    }
+    return crossings & 1;
+}
+
+/*
+ * Whether a vertex of either mesh lies inside the other. Then the solids
+ * overlap whether or not any surfaces cross: this catches a part wholly
+ * inside another, and is a quick way out for deep penetrations.
+ */
+static bool vertex_inside(const mesh_t *a, const mesh_bvh_t *bvh_a, const mesh_t *b, const mesh_bvh_t *bvh_b,
+                      const float b_to_a[16])
+{
+    float a_to_b[16], p[3];
+
+    mesh_vertex(b, b->indices[0], p);
+    mat4_transform_point(b_to_a, p, p);
+    if (point_in_box(p, &bvh_a->nodes[0].box) && point_inside(a, bvh_a, p))
+        return true;
+    if (!mat4_affine_inverse(b_to_a, a_to_b))
+        return false;
+    mesh_vertex(a, a->indices[0], p);
+    mat4_transform_point(a_to_b, p, p);
+    return point_in_box(p, &bvh_b->nodes[0].box) && point_inside(b, bvh_b, p);
+}
+
+static inline float box_extent(const aabb_t *b)
+{
+    return (b->max[0] - b->min[0]) + (b->max[1] - b->min[1]) + (b->max[2] - b->min[2]);
+}
+
+bool mesh_bvh_intersect(const mesh_t *a, const mesh_bvh_t *bvh_a, const mesh_t *b, const mesh_bvh_t *bvh_b,
+                        const float b_to_a[16])
+{
+    /* Each step replaces one pair by at most two, one level deeper on one side */
+    node_pair_t stack[2 * MESH_BVH_MAX_DEPTH + 4];
+    int top = 0;
+
+    if (bvh_a->node_count == 0 || bvh_b->node_count == 0)
+        return false;
+    if (vertex_inside(a, bvh_a, b, bvh_b, b_to_a))
+        return true;
+
+    stack[top++] = (node_pair_t){ 0, 0 };
+    while (top > 0)
+    {
+        node_pair_t pair = stack[--top];
+        const mesh_bvh_node_t *na = &bvh_a->nodes[pair.a];
+        const mesh_bvh_node_t *nb = &bvh_b->nodes[pair.b];
+        aabb_t box;
+
+        aabb_transform(b_to_a, &nb->box, &box);
+        if (!boxes_overlap(&na->box, &box))
+            continue;
+
+        if (na->count > 0 && nb->count > 0)
+        {
+            if (leaves_intersect(a, bvh_a, na, b, bvh_b, nb, b_to_a))
+                return true;
+        }
+        else if (nb->count > 0 || (na->count == 0 && box_extent(&na->box) >= box_extent(&box)))
+        {
+            /* Descend the larger box, or the only side that still can */
+            stack[top++] = (node_pair_t){ na->first + 1, pair.b };
+            stack[top++] = (node_pair_t){ na->first, pair.b };
+        }
+        else
+        {
+            stack[top++] = (node_pair_t){ pair.a, nb->first + 1 };
+            stack[top++] = (node_pair_t){ pair.a, nb->first };
+        }
+    }
+    return false;
+}
+
+/* Squared gap between two boxes; 0 when they overlap */
+static inline float box_distance2(const aabb_t *a, const aabb_t *b)
+{
+    float d2 = 0.0f;
+
+    for (int k = 0; k < 3; k++)
+    {
+        float gap = fmaxf(a->min[k] - b->max[k], b->min[k] - a->max[k]);
+        if (gap > 0.0f)
+            d2 += gap * gap;
+    }
+    return d2;
+}
+
+static inline float clamp01(float x)
+{
+    return x < 0.0f ? 0.0f : (x > 1.0f ? 1.0f : x);
+}
+
+static inline float point_distance2(const float a[3], const float b[3])
+{
+    float d[3];
+    sub3(a, b, d);
+    return dot3(d, d);
+}
+
+/* Closest points of segments p1-q1 and p2-q2 (Ericson, Real-Time Collision Detection 5.1.9) */
+static float segment_distance2(const float p1[3], const float q1[3], const float p2[3], const float q2[3])
+{
+    float d1[3], d2[3], r[3], c1[3], c2[3];
+    float s = 0.0f, t = 0.0f;
+
+    sub3(q1, p1, d1);
+    sub3(q2, p2, d2);
+    sub3(p1, p2, r);
+    float a = dot3(d1, d1), e = dot3(d2, d2), f = dot3(d2, r);
+    if (a > 0.0f && e > 0.0f)
+    {
+        float b = dot3(d1, d2), c = dot3(d1, r), denom = a * e - b * b;
+
+        s = denom > 0.0f ? clamp01((b * f - c * e) / denom) : 0.0f;
+        t = (b * s + f) / e;
+        if (t < 0.0f)
+        {
+            t = 0.0f;
+            s = clamp01(-c / a);
+        }
+        else if (t > 1.0f)
+        {
+            t = 1.0f;
+            s = clamp01((b - c) / a);
+        }
+    }
+    else if (a > 0.0f)
+        s = clamp01(-dot3(d1, r) / a);
+    else if (e > 0.0f)
+        t = clamp01(f / e);
+
+    for (int k = 0; k < 3; k++)
+    {
+        c1[k] = p1[k] + d1[k] * s;
+        c2[k] = p2[k] + d2[k] * t;
+    }
+    return point_distance2(c1, c2);
+}
+
+/* Closest point of a triangle by Voronoi region (Ericson 5.1.5) */
+static float point_triangle_distance2(const float p[3], const float t[3][3])
+{
+    float ab[3], ac[3], ap[3], bp[3], cp[3], closest[3];
+
+    sub3(t[1], t[0], ab);
+    sub3(t[2], t[0], ac);
+    sub3(p, t[0], ap);
+    float d1 = dot3(ab, ap), d2 = dot3(ac, ap);
+    if (d1 <= 0.0f && d2 <= 0.0f)
+        return point_distance2(p, t[0]);
+    sub3(p, t[1], bp);
+    float d3 = dot3(ab, bp), d4 = dot3(ac, bp);
+    if (d3 >= 0.0f && d4 <= d3)
+        return point_distance2(p, t[1]);
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+    {
+        float v = d1 / (d1 - d3);
+        for (int k = 0; k < 3; k++)
+            closest[k] = t[0][k] + ab[k] * v;
+        return point_distance2(p, closest);
+    }
+    sub3(p, t[2], cp);
+    float d5 = dot3(ab, cp), d6 = dot3(ac, cp);
+    if (d6 >= 0.0f && d5 <= d6)
+        return point_distance2(p, t[2]);
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+    {
+        float w = d2 / (d2 - d6);
+        for (int k = 0; k < 3; k++)
+            closest[k] = t[0][k] + ac[k] * w;
+        return point_distance2(p, closest);
+    }
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f)
+    {
+        float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        for (int k = 0; k < 3; k++)
+            closest[k] = t[1][k] + (t[2][k] - t[1][k]) * w;
+        return point_distance2(p, closest);
+    }
+    float denom = 1.0f / (va + vb + vc);
+    float v = vb * denom, w = vc * denom;
+    for (int k = 0; k < 3; k++)
+        closest[k] = t[0][k] + ab[k] * v + ac[k] * w;
+    return point_distance2(p, closest);
+}
+
+/*
+ * Squared distance of two disjoint triangles: the closest points lie on an
+ * edge of each, or a vertex of one and the face of the other.
+ */
+static float triangles_distance2(const float a[3][3], const float b[3][3])
+{
+    float best = FLT_MAX;
+
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+            best = fminf(best, segment_distance2(a[i], a[(i + 1) % 3], b[j], b[(j + 1) % 3]));
+        best = fminf(best, point_triangle_distance2(a[i], b));
+        best = fminf(best, point_triangle_distance2(b[i], a));
+    }
+    return best;
+}
+
+/* Lowers *best (squared) to the closest triangle pair of two leaves */
+static void leaves_distance2(const mesh_t *a, const mesh_bvh_t *bvh_a, const mesh_bvh_node_t *leaf_a,
+                             const mesh_t *b, const mesh_bvh_t *bvh_b, const mesh_bvh_node_t *leaf_b,
+                             const float b_to_a[16], float *best)
+{
+    for (uint32_t j = 0; j < leaf_b->count && *best > 0.0f; j++)
+    {
+        float tb[3][3];
+        aabb_t box;
+
+        triangle_corners(b, bvh_b->triangles[leaf_b->first + j], tb);
+        aabb_empty(&box);
+        for (int k = 0; k < 3; k++)
+        {
+            mat4_transform_point(b_to_a, tb[k], tb[k]);
+            aabb_add_point(&box, tb[k]);
+        }
+        if (box_distance2(&box, &leaf_a->box) >= *best)
+            continue;
+
+        for (uint32_t i = 0; i < leaf_a->count && *best > 0.0f; i++)
+        {
+            float ta[3][3];
+            aabb_t tri_box;
+
+            triangle_corners(a, bvh_a->triangles[leaf_a->first + i], ta);
+            aabb_empty(&tri_box);
+            for (int k = 0; k < 3; k++)
+                aabb_add_point(&tri_box, ta[k]);
+            float gap = box_distance2(&box, &tri_box);
+            if (gap >= *best)
+                continue;
+            if (gap == 0.0f && triangles_intersect(ta, tb))
+                *best = 0.0f;
+            else
+                *best = fminf(*best, triangles_distance2(ta, tb));
+        }
+    }
+}
+
+float mesh_bvh_distance(const mesh_t *a, const mesh_bvh_t *bvh_a, const mesh_t *b, const mesh_bvh_t *bvh_b,
+                        const float b_to_a[16], float max_distance)
+{
+    node_pair_t stack[2 * MESH_BVH_MAX_DEPTH + 4];
+    float best = max_distance * max_distance;
+    int top = 0;
+
+    if (bvh_a->node_count == 0 || bvh_b->node_count == 0)
+        return max_distance;
+    if (vertex_inside(a, bvh_a, b, bvh_b, b_to_a))
+        return 0.0f;
+
+    stack[top++] = (node_pair_t){ 0, 0 };
+    while (top > 0 && best > 0.0f)
+    {
+        node_pair_t pair = stack[--top];
+        const mesh_bvh_node_t *na = &bvh_a->nodes[pair.a];
+        const mesh_bvh_node_t *nb = &bvh_b->nodes[pair.b];
+        aabb_t box;
+
+        aabb_transform(b_to_a, &nb->box, &box);
+        if (box_distance2(&na->box, &box) >= best)
+            continue;
+
+        if (na->count > 0 && nb->count > 0)
+        {
+            leaves_distance2(a, bvh_a, na, b, bvh_b, nb, b_to_a, &best);
+            continue;
+        }
+
+        node_pair_t near, far;
+        float near_gap, far_gap;
+        aabb_t left, right;
+
+        if (nb->count > 0 || (na->count == 0 && box_extent(&na->box) >= box_extent(&box)))
+        {
+            near = (node_pair_t){ na->first, pair.b };
+            far = (node_pair_t){ na->first + 1, pair.b };
+            near_gap = box_distance2(&bvh_a->nodes[near.a].box, &box);
+            far_gap = box_distance2(&bvh_a->nodes[far.a].box, &box);
+        }
+        else
+        {
+            near = (node_pair_t){ pair.a, nb->first };
+            far = (node_pair_t){ pair.a, nb->first + 1 };
+            aabb_transform(b_to_a, &bvh_b->nodes[near.b].box, &left);
+            aabb_transform(b_to_a, &bvh_b->nodes[far.b].box, &right);
+            near_gap = box_distance2(&na->box, &left);
+            far_gap = box_distance2(&na->box, &right);
+        }
+        if (far_gap < near_gap)
+        {
+            node_pair_t swap = near;
+            near = far;
+            far = swap;
+        }
+        /* The nearer child goes on top so `best` shrinks early and prunes more */
+        stack[top++] = far;
+        stack[top++] = near;
+    }
+    return best < max_distance * max_distance ? sqrtf(best) : max_distance;
+}
@@ -0,0 +1,73 @@
+/**
+ * @file mesh_bvh.h
+ * @brief Triangle bounding volume hierarchies and mesh-mesh intersection.
+ *
+ * A mesh_bvh_t is a binary tree of axis-aligned boxes over the triangles of
+ * one mesh (mesh.h), split at the median centroid along the longest axis
+ * down to MESH_BVH_LEAF_TRIANGLES per leaf. It is built once per actor when
+ * the geometry is loaded and only read afterwards, so any number of threads
+ * may test against it.
+ *
+ * mesh_bvh_intersect() first checks one vertex of each mesh against the
+ * other by ray parity, which catches a part lying wholly inside another and
+ * assumes closed meshes, as STL solids are. Then it descends both trees at
+ * once with the second mesh's boxes carried into the first mesh's frame,
+ * and tests the triangles of overlapping leaf pairs exactly with the
+ * separating axis theorem, stopping at the first intersecting pair.
+ * mesh_bvh_distance() walks the same pairs nearest first and prunes every
+ * pair whose boxes are further apart than the closest triangles found so
+ * far, for clearance checks.
+ */
+
+#ifndef MESH_BVH_H
+#define MESH_BVH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "mesh.h"
+#include "scene_math.h"
+
+#define MESH_BVH_LEAF_TRIANGLES 4
+#define MESH_BVH_MAX_DEPTH 48    /* Deeper nodes become leaves; keeps the traversal stack fixed */
+
+typedef struct
+{
+    aabb_t box;
+    uint32_t first;          /* Leaf: first entry of `triangles`; inner node: left child, right = first + 1 */
+    uint32_t count;          /* Leaf: triangles; 0 for inner nodes */
+} mesh_bvh_node_t;
+
+typedef struct
+{
+    mesh_bvh_node_t *nodes;  /* Root first; empty for a mesh without triangles */
+    int node_count;
+    uint32_t *triangles;     /* Triangle indices of `mesh`, grouped by leaf */
+    int triangle_count;
+} mesh_bvh_t;
+
+/* Hierarchy over the triangles of `mesh`; false on allocation failure */
+bool mesh_bvh_build(const mesh_t *mesh, mesh_bvh_t *bvh);
+void mesh_bvh_free(mesh_bvh_t *bvh);
+
+/* Heap bytes held by the hierarchy */
+size_t mesh_bvh_bytes(const mesh_bvh_t *bvh);
+
+/*
+ * Whether any triangle of `a` intersects or touches one of `b`, or one
+ * mesh encloses the other, once `b` is placed with `b_to_a`, an affine
+ * transform from b's mesh space into a's.
+ */
+bool mesh_bvh_intersect(const mesh_t *a, const mesh_bvh_t *bvh_a, const mesh_t *b, const mesh_bvh_t *bvh_b,
+                        const float b_to_a[16]);
+
+/*
+ * Smallest distance between the surfaces of `a` and `b`, placed as for
+ * mesh_bvh_intersect() and measured in a's space, or 0 where they
+ * intersect. Gives up at max_distance (> 0) and returns it for any pair at
+ * least that far apart, which is much cheaper than an exact answer.
+ */
+float mesh_bvh_distance(const mesh_t *a, const mesh_bvh_t *bvh_a, const mesh_t *b, const mesh_bvh_t *bvh_b,
+                        const float b_to_a[16], float max_distance);
+
+#endif // MESH_BVH_H
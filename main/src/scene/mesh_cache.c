@@ -0,0 +1,266 @@
+/**
+ * @file mesh_cache.c
+ * @brief Content hashing, entry layout and the mmap loader.
+ */
+
+#include "mesh_cache.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define ENTRY_MAGIC "CNCMESH\0"
+#define ENTRY_ALIGN 16
+
+typedef struct
+{
+    uint32_t vertex_count;
+    uint32_t triangle_count;
+    uint64_t offset;         /* x, then y, z and the indices, each ENTRY_ALIGN-aligned */
+} entry_level_t;
+
+typedef struct
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t level_count;
+    uint64_t hash;
+    float bounds[6];         /* Mesh-space min xyz, max xyz */
+    float errors[MESH_CACHE_MAX_LEVELS];
+    entry_level_t levels[MESH_CACHE_MAX_LEVELS];
+} entry_header_t;
+
+static size_t align_up(size_t v)
+{
+    return (v + ENTRY_ALIGN - 1) & ~(size_t)(ENTRY_ALIGN - 1);
+}
+
+static void entry_path(char *out, size_t size, const char *dir, uint64_t hash, const char *suffix)
+{
+    snprintf(out, size, "%s/%016llx%s", dir, (unsigned long long)hash, suffix);
+}
+
+/* ---- Hashing ---- */
+
+/* FNV-1a over 64-bit words, then a final avalanche; the length is mixed in so padding can't collide */
+static uint64_t hash_bytes(const uint8_t *data, size_t size)
+{
+    uint64_t h = 0xcbf29ce484222325ull;
+    size_t i = 0;
+
+    for (; i + 8 <= size; i += 8)
+    {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        h = (h ^ word) * 0x100000001b3ull;
+    }
+    for (; i < size; i++)
+        h = (h ^ data[i]) * 0x100000001b3ull;
+
+    h ^= (uint64_t)size;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+bool mesh_cache_hash_file(const char *path, uint64_t *hash)
+{
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+    bool ok = false;
+
+    if (fd < 0)
+        return false;
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+        void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED)
+        {
+            *hash = hash_bytes(data, (size_t)st.st_size);
+            munmap(data, (size_t)st.st_size);
+            ok = true;
+        }
+    }
+    close(fd);
+    return ok;
+}
+
+uint64_t mesh_cache_hash_data(const void *data, size_t size)
+{
+    return hash_bytes(data, size);
+}
+
+/* ---- Writing ---- */
+
+static bool write_padded(FILE *fp, const void *data, size_t size, size_t *offset)
+{
+    static const uint8_t zeros[ENTRY_ALIGN];
+    size_t pad = align_up(*offset + size) - (*offset + size);
+
+    if (fwrite(data, 1, size, fp) != size || fwrite(zeros, 1, pad, fp) != pad)
+        return false;
+    *offset += size + pad;
+    return true;
+}
+
+bool mesh_cache_store(const char *dir, uint64_t hash, const mesh_t *levels, const float *errors, int count,
+                      const aabb_t *bounds)
+{
+    entry_header_t header;
+    char tmp[512], path[512];
+    size_t offset = align_up(sizeof(header));
+    bool ok = true;
+
+    if (count <= 0 || count > MESH_CACHE_MAX_LEVELS)
+        return false;
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST)
+        return false;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, ENTRY_MAGIC, sizeof(header.magic));
+    header.version = MESH_CACHE_VERSION;
+    header.level_count = (uint32_t)count;
+    header.hash = hash;
+    memcpy(header.bounds, bounds->min, 3 * sizeof(float));
+    memcpy(header.bounds + 3, bounds->max, 3 * sizeof(float));
+    for (int l = 0; l < count; l++)
+    {
+        size_t axis = align_up((size_t)levels[l].vertex_count * sizeof(float));
+        header.errors[l] = errors[l];
+        header.levels[l].vertex_count = (uint32_t)levels[l].vertex_count;
+        header.levels[l].triangle_count = (uint32_t)levels[l].triangle_count;
+        header.levels[l].offset = offset;
+        offset += 3 * axis + align_up((size_t)levels[l].triangle_count * 3 * sizeof(uint32_t));
+    }
+
+    /* Parts sharing an STL can miss together; each writer gets its own temp file and the last rename wins */
+    static unsigned writers;
+    char suffix[48];
+    snprintf(suffix, sizeof(suffix), ".%ld.%u.tmp", (long)getpid(), __atomic_fetch_add(&writers, 1, __ATOMIC_RELAXED));
+    entry_path(tmp, sizeof(tmp), dir, hash, suffix);
+    entry_path(path, sizeof(path), dir, hash, ".mesh");
+    FILE *fp = fopen(tmp, "wb");
+    if (fp == NULL)
+        return false;
+
+    offset = 0;
+    ok = write_padded(fp, &header, sizeof(header), &offset);
+    for (int l = 0; ok && l < count; l++)
+    {
+        size_t axis = (size_t)levels[l].vertex_count * sizeof(float);
+        ok = write_padded(fp, levels[l].x, axis, &offset) && write_padded(fp, levels[l].y, axis, &offset) &&
+             write_padded(fp, levels[l].z, axis, &offset) &&
+             write_padded(fp, levels[l].indices, (size_t)levels[l].triangle_count * 3 * sizeof(uint32_t), &offset);
+    }
+
+    ok = fclose(fp) == 0 && ok;
+    if (ok)
+        ok = rename(tmp, path) == 0;
+    if (!ok)
+        remove(tmp);
+    return ok;
+}
+
+/* ---- Loading ---- */
+
+/* Points `mesh` into the mapping after checking the level stays inside it and its indices are in range */
+static bool borrow_level(const mesh_cache_map_t *map, const entry_level_t *level, mesh_t *mesh)
+{
+    size_t room, axis;
+
+    if (level->offset % ENTRY_ALIGN != 0 || level->offset > map->size || level->vertex_count > INT32_MAX ||
+        level->triangle_count > INT32_MAX / 3)
+        return false;
+
+    /* Each count against what is left of the file, so a damaged one can't overflow a size sum */
+    room = map->size - (size_t)level->offset;
+    if (level->vertex_count > room / 3 / sizeof(float))
+        return false;
+    axis = align_up((size_t)level->vertex_count * sizeof(float));
+    if (3 * axis > room || level->triangle_count > (room - 3 * axis) / (3 * sizeof(uint32_t)))
+        return false;
+
+    uint8_t *base = (uint8_t *)map->base + level->offset;
+
+    memset(mesh, 0, sizeof(*mesh));
+    mesh->vertex_count = (int)level->vertex_count;
+    mesh->triangle_count = (int)level->triangle_count;
+    mesh->x = (float *)base;
+    mesh->y = (float *)(base + axis);
+    mesh->z = (float *)(base + 2 * axis);
+    mesh->indices = (uint32_t *)(base + 3 * axis);
+    mesh->borrowed = true;
+
+    /* A damaged entry must not send the rasterizers outside the arrays */
+    uint32_t largest = 0;
+    for (size_t i = 0; i < (size_t)mesh->triangle_count * 3; i++)
+        largest = mesh->indices[i] > largest ? mesh->indices[i] : largest;
+    return mesh->triangle_count == 0 || largest < level->vertex_count;
+}
+
+bool mesh_cache_load(const char *dir, uint64_t hash, mesh_cache_map_t *map, mesh_t *levels, float *errors, int max,
+                     int *count, aabb_t *bounds)
+{
+    char path[512];
+    struct stat st;
+    const entry_header_t *header;
+    int fd;
+
+    memset(map, 0, sizeof(*map));
+    entry_path(path, sizeof(path), dir, hash, ".mesh");
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(entry_header_t))
+    {
+        close(fd);
+        return false;
+    }
+
+    map->size = (size_t)st.st_size;
+    map->base = mmap(NULL, map->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map->base == MAP_FAILED)
+    {
+        memset(map, 0, sizeof(*map));
+        return false;
+    }
+
+    header = (const entry_header_t *)map->base;
+    bool ok = memcmp(header->magic, ENTRY_MAGIC, sizeof(header->magic)) == 0 &&
+              header->version == MESH_CACHE_VERSION && header->hash == hash && header->level_count >= 1 &&
+              header->level_count <= MESH_CACHE_MAX_LEVELS && (int)header->level_count <= max;
+
+    for (int l = 0; ok && l < (int)header->level_count; l++)
+    {
+        ok = borrow_level(map, &header->levels[l], &levels[l]);
+        errors[l] = header->errors[l];
+    }
+
+    if (!ok)
+    {
+        for (int l = 0; l < max; l++)
+            memset(&levels[l], 0, sizeof(levels[l]));
+        mesh_cache_unmap(map);
+        return false;
+    }
+
+    *count = (int)header->level_count;
+    memcpy(bounds->min, header->bounds, 3 * sizeof(float));
+    memcpy(bounds->max, header->bounds + 3, 3 * sizeof(float));
+    return true;
+}
+
+void mesh_cache_unmap(mesh_cache_map_t *map)
+{
+    if (map->base != NULL)
+        munmap(map->base, map->size);
+    memset(map, 0, sizeof(*map));
+}
@@ -0,0 +1,66 @@
+/**
+ * @file mesh_cache.h
+ * @brief On-disk cache of preprocessed actor meshes, mapped back with mmap.
+ *
+ * Welding, vertex-cache ordering and above all the LOD decimation cost far
+ * more than reading an STL. The cache keeps their result per source mesh in
+ * `<dir>/<hash>.mesh`, keyed by a 64-bit hash of the STL's content (or of
+ * triangles already parsed from it), so an edited model misses and a copied
+ * or renamed one still hits.
+ *
+ * An entry is one header followed by every detail level's x, y, z and index
+ * arrays in exactly the in-memory layout of mesh_t, each 16-byte aligned. A
+ * hit maps the file read-only and points the meshes into it: the mirror
+ * welds, decimates and copies nothing. cncvis_init() still parses the STLs
+ * for itself, and the collision hierarchies (mesh_bvh.h) are not cached but
+ * rebuilt on every start. Entries are written to a temporary file
+ * and renamed into place, so a crash never leaves a half-written entry
+ * under a valid name. Files are native-endian and not meant to move between
+ * machines of different byte order.
+ */
+
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mesh.h"
+#include "scene_math.h"
+
+#define MESH_CACHE_VERSION 1
+#define MESH_CACHE_MAX_LEVELS 8
+
+typedef struct
+{
+    void *base;              /* NULL when nothing is mapped */
+    size_t size;
+} mesh_cache_map_t;
+
+/* Content hash of a file; false if it can't be read */
+bool mesh_cache_hash_file(const char *path, uint64_t *hash);
+
+/* Same hash over data already in memory */
+uint64_t mesh_cache_hash_data(const void *data, size_t size);
+
+/*
+ * Writes levels[0..count) with their errors and the mesh-space bounds as
+ * the entry for `hash`, creating `dir` if needed. False on any I/O error;
+ * the cache is then simply not used for this mesh.
+ */
+bool mesh_cache_store(const char *dir, uint64_t hash, const mesh_t *levels, const float *errors, int count,
+                      const aabb_t *bounds);
+
+/*
+ * Maps the entry for `hash` and fills up to `max` levels, borrowing their
+ * arrays from the mapping (mesh_t.borrowed). *count, errors and *bounds
+ * receive the stored values. False if there is no valid entry.
+ */
+bool mesh_cache_load(const char *dir, uint64_t hash, mesh_cache_map_t *map, mesh_t *levels, float *errors, int max,
+                     int *count, aabb_t *bounds);
+
+/* Unmaps an entry; the meshes loaded from it must not be used afterwards */
+void mesh_cache_unmap(mesh_cache_map_t *map);
+
+#endif // MESH_CACHE_H
@@ -0,0 +1,636 @@
+/**
+ * @file mesh_lod.c
+ * @brief Quadrics and the edge-collapse queue.
+ */
+
+#include "mesh_lod.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BORDER_WEIGHT 10.0   /* Constraint planes along open borders count this much more */
+#define FLIP_COS 0.2f        /* Reject collapses turning a face by more than ~78 degrees */
+#define MIN_REDUCTION 0.8f   /* A level must keep at most this fraction of the previous one */
+
+/* Symmetric 4x4: a2 ab ac ad b2 bc bd c2 cd d2 */
+typedef struct
+{
+    double q[10];
+} quadric_t;
+
+typedef struct
+{
+    int *items;
+    int count;
+    int capacity;
+} int_list_t;
+
+typedef struct
+{
+    float cost;
+    int u, v;                /* v collapses into u */
+    uint32_t version_u, version_v;
+    float p[3];              /* Position of the merged vertex */
+} collapse_t;
+
+typedef struct
+{
+    int vertex_count;
+    float *pos;
+    quadric_t *quadrics;
+    uint32_t *version;       /* Bumped on every change; stale queue entries are skipped */
+    uint8_t *alive;
+    int_list_t *faces;       /* Faces around each vertex, may list dead ones */
+    uint32_t *stamp;
+    uint32_t stamp_value;
+
+    int face_count;
+    int *tri;
+    uint8_t *face_alive;
+    int live_faces;
+
+    collapse_t *heap;
+    int heap_count;
+    int heap_capacity;
+
+    float min[3], max[3];
+    double max_cost;
+} decimator_t;
+
+/* ---- Small containers ---- */
+
+static bool list_push(int_list_t *list, int value)
+{
+    if (list->count == list->capacity)
+    {
+        int capacity = list->capacity ? list->capacity * 2 : 8;
+        int *items = realloc(list->items, (size_t)capacity * sizeof(int));
+        if (items == NULL)
+            return false;
+        list->items = items;
+        list->capacity = capacity;
+    }
+    list->items[list->count++] = value;
+    return true;
+}
+
+static bool heap_push(decimator_t *d, const collapse_t *c)
+{
+    if (d->heap_count == d->heap_capacity)
+    {
+        int capacity = d->heap_capacity ? d->heap_capacity * 2 : 1024;
+        collapse_t *heap = realloc(d->heap, (size_t)capacity * sizeof(*heap));
+        if (heap == NULL)
+            return false;
+        d->heap = heap;
+        d->heap_capacity = capacity;
+    }
+
+    int i = d->heap_count++;
+    while (i > 0)
+    {
+        int parent = (i - 1) / 2;
+        if (d->heap[parent].cost <= c->cost)
+            break;
+        d->heap[i] = d->heap[parent];
+        i = parent;
+    }
+    d->heap[i] = *c;
+    return true;
+}
+
+static collapse_t heap_pop(decimator_t *d)
+{
+    collapse_t top = d->heap[0];
+    collapse_t last = d->heap[--d->heap_count];
+    int i = 0;
+
+    for (;;)
+    {
+        int child = 2 * i + 1;
+        if (child >= d->heap_count)
+            break;
+        if (child + 1 < d->heap_count && d->heap[child + 1].cost < d->heap[child].cost)
+            child++;
+        if (last.cost <= d->heap[child].cost)
+            break;
+        d->heap[i] = d->heap[child];
+        i = child;
+    }
+    if (d->heap_count > 0)
+        d->heap[i] = last;
+    return top;
+}
+
+/* ---- Quadrics ---- */
+
+static void quadric_add_plane(quadric_t *q, double a, double b, double c, double dd, double w)
+{
+    q->q[0] += w * a * a;
+    q->q[1] += w * a * b;
+    q->q[2] += w * a * c;
+    q->q[3] += w * a * dd;
+    q->q[4] += w * b * b;
+    q->q[5] += w * b * c;
+    q->q[6] += w * b * dd;
+    q->q[7] += w * c * c;
+    q->q[8] += w * c * dd;
+    q->q[9] += w * dd * dd;
+}
+
+static void quadric_sum(quadric_t *out, const quadric_t *a, const quadric_t *b)
+{
+    for (int i = 0; i < 10; i++)
+        out->q[i] = a->q[i] + b->q[i];
+}
+
+static double quadric_eval(const quadric_t *q, const float p[3])
+{
+    double x = p[0], y = p[1], z = p[2];
+    const double *m = q->q;
+
+    return m[0] * x * x + 2.0 * m[1] * x * y + 2.0 * m[2] * x * z + 2.0 * m[3] * x +
+           m[4] * y * y + 2.0 * m[5] * y * z + 2.0 * m[6] * y +
+           m[7] * z * z + 2.0 * m[8] * z + m[9];
+}
+
+/* Position minimising the quadric; false if the system is (nearly) singular */
+static bool quadric_optimum(const quadric_t *q, float out[3])
+{
+    const double *m = q->q;
+    double a = m[0], b = m[1], c = m[2], e = m[4], f = m[5], i = m[7];
+    double det = a * (e * i - f * f) - b * (b * i - f * c) + c * (b * f - e * c);
+    double scale = fabs(a) + fabs(e) + fabs(i);
+
+    if (scale == 0.0 || fabs(det) < 1e-12 * scale * scale * scale)
+        return false;
+
+    double r0 = -m[3], r1 = -m[6], r2 = -m[8];
+    out[0] = (float)((r0 * (e * i - f * f) - b * (r1 * i - f * r2) + c * (r1 * f - e * r2)) / det);
+    out[1] = (float)((a * (r1 * i - f * r2) - r0 * (b * i - f * c) + c * (b * r2 - r1 * c)) / det);
+    out[2] = (float)((a * (e * r2 - r1 * f) - b * (b * r2 - r1 * c) + r0 * (b * f - e * c)) / det);
+    return true;
+}
+
+static void face_normal(const float *a, const float *b, const float *c, float n[3])
+{
+    float u[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+    float v[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+
+    n[0] = u[1] * v[2] - u[2] * v[1];
+    n[1] = u[2] * v[0] - u[0] * v[2];
+    n[2] = u[0] * v[1] - u[1] * v[0];
+}
+
+/* ---- Setup ---- */
+
+static size_t table_size(size_t entries)
+{
+    size_t size = 64;
+    while (size < entries * 2)
+        size *= 2;
+    return size;
+}
+
+static bool load(decimator_t *d, const mesh_t *src)
+{
+    d->vertex_count = src->vertex_count;
+    d->face_count = src->triangle_count;
+    d->live_faces = src->triangle_count;
+    d->pos = malloc((size_t)src->vertex_count * 3 * sizeof(float) + 1);
+    d->tri = malloc((size_t)src->triangle_count * 3 * sizeof(int) + 1);
+    if (d->pos == NULL || d->tri == NULL)
+        return false;
+
+    for (int v = 0; v < src->vertex_count; v++)
+        mesh_vertex(src, (uint32_t)v, &d->pos[v * 3]);
+    for (int i = 0; i < src->triangle_count * 3; i++)
+        d->tri[i] = (int)src->indices[i];
+    return true;
+}
+
+static bool init_vertices(decimator_t *d)
+{
+    int n = d->vertex_count;
+
+    d->quadrics = calloc((size_t)n, sizeof(quadric_t));
+    d->version = calloc((size_t)n, sizeof(uint32_t));
+    d->alive = malloc((size_t)n);
+    d->faces = calloc((size_t)n, sizeof(int_list_t));
+    d->stamp = calloc((size_t)n, sizeof(uint32_t));
+    d->face_alive = malloc((size_t)d->face_count);
+    if (!d->quadrics || !d->version || !d->alive || !d->faces || !d->stamp || (!d->face_alive && d->face_count))
+        return false;
+    memset(d->alive, 1, (size_t)n);
+    memset(d->face_alive, 1, (size_t)d->face_count);
+
+    for (int k = 0; k < 3; k++)
+    {
+        d->min[k] = n ? d->pos[k] : 0.0f;
+        d->max[k] = d->min[k];
+    }
+    for (int v = 0; v < n; v++)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            if (d->pos[v * 3 + k] < d->min[k]) d->min[k] = d->pos[v * 3 + k];
+            if (d->pos[v * 3 + k] > d->max[k]) d->max[k] = d->pos[v * 3 + k];
+        }
+    }
+
+    for (int f = 0; f < d->face_count; f++)
+    {
+        const int *t = &d->tri[f * 3];
+        float n3[3];
+
+        face_normal(&d->pos[t[0] * 3], &d->pos[t[1] * 3], &d->pos[t[2] * 3], n3);
+        double len = sqrt((double)n3[0] * n3[0] + (double)n3[1] * n3[1] + (double)n3[2] * n3[2]);
+        for (int k = 0; k < 3; k++)
+        {
+            if (!list_push(&d->faces[t[k]], f))
+                return false;
+        }
+        if (len == 0.0)
+            continue;
+
+        double a = n3[0] / len, b = n3[1] / len, c = n3[2] / len;
+        double dd = -(a * d->pos[t[0] * 3] + b * d->pos[t[0] * 3 + 1] + c * d->pos[t[0] * 3 + 2]);
+        for (int k = 0; k < 3; k++)
+            quadric_add_plane(&d->quadrics[t[k]], a, b, c, dd, 1.0);
+    }
+    return true;
+}
+
+/* ---- Collapses ---- */
+
+static bool inside_bounds(const decimator_t *d, const float p[3])
+{
+    for (int k = 0; k < 3; k++)
+    {
+        if (!(p[k] >= d->min[k] && p[k] <= d->max[k]))
+            return false;
+    }
+    return true;
+}
+
+static void plan_collapse(const decimator_t *d, int u, int v, collapse_t *c)
+{
+    quadric_t q;
+    float candidates[4][3];
+    int count = 0;
+
+    quadric_sum(&q, &d->quadrics[u], &d->quadrics[v]);
+    if (quadric_optimum(&q, candidates[count]) && inside_bounds(d, candidates[count]))
+        count++;
+    memcpy(candidates[count++], &d->pos[u * 3], sizeof(candidates[0]));
+    memcpy(candidates[count++], &d->pos[v * 3], sizeof(candidates[0]));
+    for (int k = 0; k < 3; k++)
+        candidates[count][k] = 0.5f * (d->pos[u * 3 + k] + d->pos[v * 3 + k]);
+    count++;
+
+    c->u = u;
+    c->v = v;
+    c->version_u = d->version[u];
+    c->version_v = d->version[v];
+    c->cost = INFINITY;
+    for (int i = 0; i < count; i++)
+    {
+        double cost = quadric_eval(&q, candidates[i]);
+        if (cost < 0.0)
+            cost = 0.0;
+        if ((float)cost < c->cost)
+        {
+            c->cost = (float)cost;
+            memcpy(c->p, candidates[i], sizeof(c->p));
+        }
+    }
+}
+
+static bool face_has(const int *t, int v)
+{
+    return t[0] == v || t[1] == v || t[2] == v;
+}
+
+static uint32_t next_stamp(decimator_t *d)
+{
+    d->stamp_value += 2;
+    if (d->stamp_value < 2)
+    {
+        memset(d->stamp, 0, (size_t)d->vertex_count * sizeof(uint32_t));
+        d->stamp_value = 2;
+    }
+    return d->stamp_value;
+}
+
+/* Link condition: the only vertices next to both ends are the ones of the faces they share */
+static bool keeps_manifold(decimator_t *d, int u, int v)
+{
+    uint32_t mark = next_stamp(d);
+    int shared = 0, common = 0;
+
+    for (int i = 0; i < d->faces[u].count; i++)
+    {
+        int f = d->faces[u].items[i];
+        if (!d->face_alive[f])
+            continue;
+        for (int k = 0; k < 3; k++)
+            d->stamp[d->tri[f * 3 + k]] = mark;
+    }
+    for (int i = 0; i < d->faces[v].count; i++)
+    {
+        int f = d->faces[v].items[i];
+        const int *t = &d->tri[f * 3];
+        if (!d->face_alive[f])
+            continue;
+        if (face_has(t, u))
+            shared++;
+        for (int k = 0; k < 3; k++)
+        {
+            if (t[k] != u && t[k] != v && d->stamp[t[k]] == mark)
+            {
+                d->stamp[t[k]] = mark + 1; /* Count each neighbour once */
+                common++;
+            }
+        }
+    }
+    return shared > 0 && common == shared;
+}
+
+/* No face around u or v may turn over when its corner moves to p */
+static bool keeps_orientation(const decimator_t *d, int u, int v, const float p[3])
+{
+    const int ends[2] = { u, v };
+
+    for (int e = 0; e < 2; e++)
+    {
+        const int_list_t *list = &d->faces[ends[e]];
+        for (int i = 0; i < list->count; i++)
+        {
+            int f = list->items[i];
+            const int *t = &d->tri[f * 3];
+            const float *corner[3];
+            float before[3], after[3];
+
+            if (!d->face_alive[f] || (face_has(t, u) && face_has(t, v)))
+                continue;
+
+            for (int k = 0; k < 3; k++)
+                corner[k] = &d->pos[t[k] * 3];
+            face_normal(corner[0], corner[1], corner[2], before);
+            for (int k = 0; k < 3; k++)
+            {
+                if (t[k] == ends[e])
+                    corner[k] = p;
+            }
+            face_normal(corner[0], corner[1], corner[2], after);
+
+            float dot = before[0] * after[0] + before[1] * after[1] + before[2] * after[2];
+            float len2 = (before[0] * before[0] + before[1] * before[1] + before[2] * before[2]) *
+                         (after[0] * after[0] + after[1] * after[1] + after[2] * after[2]);
+            if (len2 > 0.0f && dot <= FLIP_COS * sqrtf(len2))
+                return false;
+        }
+    }
+    return true;
+}
+
+static bool queue_edges_of(decimator_t *d, int u)
+{
+    uint32_t mark = next_stamp(d);
+
+    for (int i = 0; i < d->faces[u].count; i++)
+    {
+        int f = d->faces[u].items[i];
+        for (int k = 0; k < 3; k++)
+        {
+            int w = d->tri[f * 3 + k];
+            collapse_t c;
+            if (w == u || d->stamp[w] == mark)
+                continue;
+            d->stamp[w] = mark;
+            plan_collapse(d, u, w, &c);
+            if (!heap_push(d, &c))
+                return false;
+        }
+    }
+    return true;
+}
+
+static bool apply_collapse(decimator_t *d, const collapse_t *c)
+{
+    int u = c->u, v = c->v;
+    int_list_t *fu = &d->faces[u];
+    int_list_t *fv = &d->faces[v];
+
+    if (!keeps_manifold(d, u, v) || !keeps_orientation(d, u, v, c->p))
+        return true; /* Edge stays; it is queued again if a neighbour changes */
+
+    memcpy(&d->pos[u * 3], c->p, sizeof(c->p));
+    quadric_sum(&d->quadrics[u], &d->quadrics[u], &d->quadrics[v]);
+    d->alive[v] = 0;
+    d->version[u]++;
+    d->version[v]++;
+    if ((double)c->cost > d->max_cost)
+        d->max_cost = c->cost;
+
+    for (int i = 0; i < fv->count; i++)
+    {
+        int f = fv->items[i];
+        int *t = &d->tri[f * 3];
+        if (!d->face_alive[f])
+            continue;
+        if (face_has(t, u))
+        {
+            d->face_alive[f] = 0;
+            d->live_faces--;
+            continue;
+        }
+        for (int k = 0; k < 3; k++)
+        {
+            if (t[k] == v)
+                t[k] = u;
+        }
+        if (!list_push(fu, f))
+            return false;
+    }
+    free(fv->items);
+    memset(fv, 0, sizeof(*fv));
+
+    /* Drop faces that died along the way */
+    int kept = 0;
+    for (int i = 0; i < fu->count; i++)
+    {
+        if (d->face_alive[fu->items[i]])
+            fu->items[kept++] = fu->items[i];
+    }
+    fu->count = kept;
+
+    return queue_edges_of(d, u);
+}
+
+/* Live faces over all vertices; mesh_optimize drops the collapsed ones and orders the rest */
+static bool emit(const decimator_t *d, mesh_t *out)
+{
+    int written = 0;
+
+    if (!mesh_alloc(out, d->vertex_count, d->live_faces))
+        return false;
+
+    for (int v = 0; v < d->vertex_count; v++)
+    {
+        out->x[v] = d->pos[v * 3];
+        out->y[v] = d->pos[v * 3 + 1];
+        out->z[v] = d->pos[v * 3 + 2];
+    }
+    for (int f = 0; f < d->face_count; f++)
+    {
+        if (!d->face_alive[f])
+            continue;
+        for (int k = 0; k < 3; k++)
+            out->indices[written * 3 + k] = (uint32_t)d->tri[f * 3 + k];
+        written++;
+    }
+
+    if (!mesh_optimize(out))
+    {
+        mesh_free(out);
+        return false;
+    }
+    return true;
+}
+
+static void decimator_free(decimator_t *d)
+{
+    if (d->faces)
+    {
+        for (int i = 0; i < d->vertex_count; i++)
+            free(d->faces[i].items);
+    }
+    free(d->faces);
+    free(d->pos);
+    free(d->quadrics);
+    free(d->version);
+    free(d->alive);
+    free(d->stamp);
+    free(d->tri);
+    free(d->face_alive);
+    free(d->heap);
+}
+
+/* Unique edges; open borders get constraint planes so holes and rims keep their outline */
+static bool init_edges(decimator_t *d)
+{
+    size_t size = table_size((size_t)d->face_count * 3);
+    uint64_t *keys = malloc(size * sizeof(uint64_t));
+    int *face = malloc(size * sizeof(int));
+    int *uses = calloc(size, sizeof(int));
+    bool ok = keys && face && uses;
+
+    if (ok)
+        memset(keys, 0xFF, size * sizeof(uint64_t));
+
+    for (int f = 0; ok && f < d->face_count; f++)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            int a = d->tri[f * 3 + k], b = d->tri[f * 3 + (k + 1) % 3];
+            uint64_t key = a < b ? ((uint64_t)a << 32) | (uint32_t)b : ((uint64_t)b << 32) | (uint32_t)a;
+            size_t slot = (size_t)((key * 0x9E3779B97F4A7C15ull) >> 20) & (size - 1);
+
+            while (keys[slot] != UINT64_MAX && keys[slot] != key)
+                slot = (slot + 1) & (size - 1);
+            if (keys[slot] == UINT64_MAX)
+            {
+                keys[slot] = key;
+                face[slot] = f;
+            }
+            uses[slot]++;
+        }
+    }
+
+    for (size_t s = 0; ok && s < size; s++)
+    {
+        int a, b;
+
+        if (keys[s] == UINT64_MAX)
+            continue;
+        a = (int)(keys[s] >> 32);
+        b = (int)(keys[s] & 0xFFFFFFFFu);
+
+        if (uses[s] == 1)
+        {
+            const int *t = &d->tri[face[s] * 3];
+            const float *pa = &d->pos[a * 3], *pb = &d->pos[b * 3];
+            float n[3], e[3] = { pb[0] - pa[0], pb[1] - pa[1], pb[2] - pa[2] };
+
+            face_normal(&d->pos[t[0] * 3], &d->pos[t[1] * 3], &d->pos[t[2] * 3], n);
+            double bx = (double)e[1] * n[2] - (double)e[2] * n[1];
+            double by = (double)e[2] * n[0] - (double)e[0] * n[2];
+            double bz = (double)e[0] * n[1] - (double)e[1] * n[0];
+            double len = sqrt(bx * bx + by * by + bz * bz);
+            if (len > 0.0)
+            {
+                bx /= len;
+                by /= len;
+                bz /= len;
+                double dd = -(bx * pa[0] + by * pa[1] + bz * pa[2]);
+                quadric_add_plane(&d->quadrics[a], bx, by, bz, dd, BORDER_WEIGHT);
+                quadric_add_plane(&d->quadrics[b], bx, by, bz, dd, BORDER_WEIGHT);
+            }
+        }
+    }
+
+    /* Costs need the border planes, so queue in a second pass */
+    for (size_t s = 0; ok && s < size; s++)
+    {
+        collapse_t c;
+        if (keys[s] == UINT64_MAX)
+            continue;
+        plan_collapse(d, (int)(keys[s] >> 32), (int)(keys[s] & 0xFFFFFFFFu), &c);
+        ok = heap_push(d, &c);
+    }
+
+    free(keys);
+    free(face);
+    free(uses);
+    return ok;
+}
+
+int mesh_lod_build(const mesh_t *src, const int *targets, int count, mesh_t *out, float *errors)
+{
+    decimator_t d;
+    int levels = 0;
+    int previous = src->triangle_count;
+
+    memset(&d, 0, sizeof(d));
+    if (src->triangle_count <= 0 || !load(&d, src) || !init_vertices(&d) || !init_edges(&d))
+    {
+        decimator_free(&d);
+        return 0;
+    }
+
+    for (int level = 0; level < count; level++)
+    {
+        bool ok = true;
+
+        while (ok && d.live_faces > targets[level] && d.heap_count > 0)
+        {
+            collapse_t c = heap_pop(&d);
+            if (d.alive[c.u] && d.alive[c.v] && c.version_u == d.version[c.u] && c.version_v == d.version[c.v])
+                ok = apply_collapse(&d, &c);
+        }
+        if (!ok || d.live_faces > (int)((float)previous * MIN_REDUCTION))
+            break;
+        if (!emit(&d, &out[level]))
+            break;
+
+        errors[level] = (float)sqrt(d.max_cost);
+        previous = d.live_faces;
+        levels++;
+    }
+
+    decimator_free(&d);
+    return levels;
+}
@@ -0,0 +1,28 @@
+/**
+ * @file mesh_lod.h
+ * @brief Quadric-error edge-collapse decimation of indexed meshes.
+ *
+ * Each vertex of the welded mesh (mesh.h) gets the Garland-Heckbert quadric
+ * of its faces' planes plus constraint planes along open borders, and edges
+ * are collapsed cheapest first. Collapses that would fold a face over or
+ * pinch the surface into a non-manifold edge are skipped. Collapsed
+ * vertices are placed at the quadric optimum when that stays inside the mesh
+ * bounds, so the decimated levels never outgrow the original's bounding box.
+ */
+
+#ifndef MESH_LOD_H
+#define MESH_LOD_H
+
+#include "mesh.h"
+
+/*
+ * Decimates `src` once, taking a snapshot each time the live triangle count
+ * reaches the next of `targets` (decreasing). out[i] receives a compacted,
+ * cache-ordered copy (mesh_optimize), errors[i] the largest collapse error so
+ * far: roughly how far, in mesh units, any part of the surface moved.
+ * Returns the number of levels produced, which is smaller than `count` once
+ * the mesh can't be reduced by at least a fifth any more.
+ */
+int mesh_lod_build(const mesh_t *src, const int *targets, int count, mesh_t *out, float *errors);
+
+#endif // MESH_LOD_H
@@ -0,0 +1,744 @@
+/**
+ * @file scene.c
+ * @brief Application-side mirror of the cncvis assembly tree.
+ */
+
+#include "scene.h"
+#include "mesh_cache.h"
+#include "mesh_lod.h"
+#include "../sys/worker_pool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+scene_t *scene_create(void)
+{
+    return calloc(1, sizeof(scene_t));
+}
+
+void scene_destroy(scene_t *scene)
+{
+    if (scene == NULL)
+        return;
+
+    for (int i = 0; i < scene->actor_count && !scene->shared_geometry; i++)
+    {
+        mesh_free(&scene->actors[i].mesh);
+        for (int l = 0; l < SCENE_LOD_LEVELS - 1; l++)
+            mesh_free(&scene->actors[i].lod_meshes[l]);
+        mesh_cache_unmap(&scene->actors[i].cache_map);
+        mesh_bvh_free(&scene->actors[i].bvh);
+    }
+    free(scene->actors);
+    free(scene->nodes);
+    free(scene->name_slots);
+    free(scene);
+}
+
+static void *copy_array(const void *src, size_t bytes)
+{
+    void *dst = malloc(bytes > 0 ? bytes : 1);
+    if (dst != NULL && bytes > 0)
+        memcpy(dst, src, bytes);
+    return dst;
+}
+
+scene_t *scene_create_view(const scene_t *scene)
+{
+    scene_t *view = malloc(sizeof(*view));
+    if (view == NULL)
+        return NULL;
+
+    *view = *scene;
+    view->nodes = copy_array(scene->nodes, (size_t)scene->node_count * sizeof(*scene->nodes));
+    view->actors = copy_array(scene->actors, (size_t)scene->actor_count * sizeof(*scene->actors));
+    view->name_slots = copy_array(scene->name_slots, (size_t)scene->name_slot_count * sizeof(*scene->name_slots));
+    view->node_capacity = scene->node_count;
+    view->actor_capacity = scene->actor_count;
+    view->shared_geometry = true;
+    if (view->nodes == NULL || view->actors == NULL || view->name_slots == NULL)
+    {
+        scene_destroy(view);
+        return NULL;
+    }
+    return view;
+}
+
+static void copy_name(char *dst, size_t size, const char *src)
+{
+    snprintf(dst, size, "%s", src ? src : "");
+}
+
+void scene_set_cache_dir(scene_t *scene, const char *dir)
+{
+    copy_name(scene->cache_dir, sizeof(scene->cache_dir), dir);
+}
+
+static uint32_t name_hash(const char *name)
+{
+    uint32_t h = 2166136261u;
+
+    while (*name)
+        h = (h ^ (uint8_t)*name++) * 16777619u;
+    return h;
+}
+
+/* Adds node `index` to the name index; the first of several equal names keeps the slot */
+static void index_name(scene_t *scene, int index)
+{
+    uint32_t mask = (uint32_t)scene->name_slot_count - 1;
+    uint32_t slot = name_hash(scene->nodes[index].name) & mask;
+
+    while (scene->name_slots[slot] >= 0)
+    {
+        if (strcmp(scene->nodes[scene->name_slots[slot]].name, scene->nodes[index].name) == 0)
+            return;
+        slot = (slot + 1) & mask;
+    }
+    scene->name_slots[slot] = index;
+}
+
+/* Keeps the index at most half full, rebuilding it in node order when it grows */
+static bool reserve_name_slots(scene_t *scene, int nodes)
+{
+    if (nodes * 2 <= scene->name_slot_count)
+        return true;
+
+    int count = scene->name_slot_count ? scene->name_slot_count * 2 : 32;
+    while (nodes * 2 > count)
+        count *= 2;
+    int *slots = malloc((size_t)count * sizeof(*slots));
+    if (slots == NULL)
+        return false;
+
+    free(scene->name_slots);
+    scene->name_slots = slots;
+    scene->name_slot_count = count;
+    memset(slots, 0xff, (size_t)count * sizeof(*slots));
+    for (int i = 0; i < scene->node_count; i++)
+        index_name(scene, i);
+    return true;
+}
+
+int scene_add_node(scene_t *scene, const char *name, int parent, void *source)
+{
+    if (parent >= scene->node_count)
+        return -1;
+
+    if (scene->node_count == scene->node_capacity)
+    {
+        int capacity = scene->node_capacity ? scene->node_capacity * 2 : 16;
+        scene_node_t *nodes = realloc(scene->nodes, (size_t)capacity * sizeof(*nodes));
+        if (nodes == NULL)
+            return -1;
+        scene->nodes = nodes;
+        scene->node_capacity = capacity;
+    }
+    if (!reserve_name_slots(scene, scene->node_count + 1))
+        return -1;
+
+    scene_node_t *node = &scene->nodes[scene->node_count];
+    memset(node, 0, sizeof(*node));
+    copy_name(node->name, sizeof(node->name), name);
+    node->parent = parent;
+    node->source = source;
+    node->motion = SCENE_MOTION_NONE;
+    mat4_identity(node->local);
+    mat4_identity(node->world);
+    node->dirty = true;
+    aabb_empty(&node->bounds);
+    node->visibility = FRUSTUM_INTERSECTS;
+    index_name(scene, scene->node_count);
+    return scene->node_count++;
+}
+
+static scene_actor_t *append_actor(scene_t *scene, int node, const char *name,
+                                   const float local[16], const float color[3])
+{
+    if (node < 0 || node >= scene->node_count)
+        return NULL;
+
+    if (scene->actor_count == scene->actor_capacity)
+    {
+        int capacity = scene->actor_capacity ? scene->actor_capacity * 2 : 16;
+        scene_actor_t *actors = realloc(scene->actors, (size_t)capacity * sizeof(*actors));
+        if (actors == NULL)
+            return NULL;
+        scene->actors = actors;
+        scene->actor_capacity = capacity;
+    }
+
+    scene_actor_t *actor = &scene->actors[scene->actor_count];
+    memset(actor, 0, sizeof(*actor));
+    copy_name(actor->name, sizeof(actor->name), name);
+    actor->node = node;
+    if (local)
+        memcpy(actor->local, local, sizeof(actor->local));
+    else
+        mat4_identity(actor->local);
+    actor->color[0] = color ? color[0] : 0.8f;
+    actor->color[1] = color ? color[1] : 0.8f;
+    actor->color[2] = color ? color[2] : 0.8f;
+    actor->lod_count = 1;
+    aabb_empty(&actor->bounds);
+    aabb_empty(&actor->world_bounds);
+    aabb_empty(&actor->drawn_bounds);
+    return actor;
+}
+
+/*
+ * Bounds from the soup's corners, published at once: welding keeps every
+ * corner but those of dropped degenerate triangles, so they also hold for
+ * the mesh.
+ */
+static void soup_bounds(scene_actor_t *actor, const stl_mesh_t *soup)
+{
+    for (int i = 0; i < soup->triangle_count * 3; i++)
+        aabb_add_point(&actor->bounds, &soup->vertices[i * 3]);
+    __atomic_store_n(&actor->bounds_ready, true, __ATOMIC_RELEASE);
+}
+
+/* Welds the soup into the actor's mesh and frees it */
+static bool index_soup(scene_actor_t *actor, stl_mesh_t *soup)
+{
+    bool ok = mesh_from_soup(soup, &actor->mesh);
+
+    stl_free(soup);
+    if (!ok)
+        printf("scene: out of memory indexing actor '%s'\n", actor->name);
+    return ok;
+}
+
+typedef struct
+{
+    int actor;
+    off_t size;              /* Of the STL file (as binary STL for facets), to schedule the largest first */
+} pending_actor_t;
+
+typedef struct
+{
+    scene_t *scene;
+    pending_actor_t *pending;
+    const scene_load_callbacks_t *callbacks;
+    int failed;
+} load_job_t;
+
+static int larger_first(const void *a, const void *b)
+{
+    off_t sa = ((const pending_actor_t *)a)->size, sb = ((const pending_actor_t *)b)->size;
+    return (sa < sb) - (sa > sb);
+}
+
+static void notify_changed(const load_job_t *job, int actor)
+{
+    if (job->callbacks && job->callbacks->changed)
+        job->callbacks->changed(job->callbacks->arg, actor);
+}
+
+/* Points the actor's mesh and detail levels into its cache entry, if there is a valid one */
+static bool load_cached(scene_t *scene, scene_actor_t *actor)
+{
+    mesh_t levels[SCENE_LOD_LEVELS];
+    int count;
+
+    if (!mesh_cache_load(scene->cache_dir, actor->source_hash, &actor->cache_map, levels, actor->lod_error,
+                         SCENE_LOD_LEVELS, &count, &actor->bounds))
+        return false;
+
+    actor->mesh = levels[0];
+    for (int l = 1; l < count; l++)
+        actor->lod_meshes[l - 1] = levels[l];
+    actor->lod_count = count;
+    return true;
+}
+
+/* Soup of the corners of handed-over facets; welding never reads the normals */
+static bool facets_to_soup(const scene_actor_t *actor, stl_mesh_t *soup)
+{
+    memset(soup, 0, sizeof(*soup));
+    soup->vertices = malloc((size_t)actor->facet_count * 9 * sizeof(float));
+    if (soup->vertices == NULL)
+    {
+        printf("scene: out of memory copying the facets of actor '%s'\n", actor->name);
+        return false;
+    }
+    for (int t = 0; t < actor->facet_count; t++)
+        memcpy(&soup->vertices[t * 9], &actor->facets[t * 12 + 3], 9 * sizeof(float));
+    soup->triangle_count = actor->facet_count;
+    return true;
+}
+
+static bool hash_source(const scene_actor_t *actor, uint64_t *hash)
+{
+    if (actor->facets == NULL)
+        return mesh_cache_hash_file(actor->path, hash);
+    *hash = mesh_cache_hash_data(actor->facets, (size_t)actor->facet_count * 12 * sizeof(float));
+    return true;
+}
+
+/*
+ * Fills the actor's geometry from the mesh cache, its facets or its STL;
+ * safe to run for several actors at once. With a job, its hooks hear of the
+ * bounds as soon as they are known.
+ */
+static bool load_geometry(scene_t *scene, scene_actor_t *actor, const load_job_t *job)
+{
+    stl_mesh_t soup;
+
+    if (scene->cache_dir[0] != '\0' && hash_source(actor, &actor->source_hash))
+    {
+        if (load_cached(scene, actor))
+        {
+            __atomic_store_n(&actor->bounds_ready, true, __ATOMIC_RELEASE);
+            __atomic_fetch_add(&scene->cache_hits, 1, __ATOMIC_RELAXED);
+            return true;
+        }
+        __atomic_fetch_add(&scene->cache_misses, 1, __ATOMIC_RELAXED);
+        actor->cache_pending = true;
+    }
+    if (actor->facets)
+    {
+        if (!facets_to_soup(actor, &soup))
+            return false;
+    }
+    else if (!stl_load(actor->path, &soup))
+    {
+        printf("scene: failed to load STL '%s' for actor '%s'\n", actor->path, actor->name);
+        return false;
+    }
+    soup_bounds(actor, &soup);
+    if (job)
+        notify_changed(job, (int)(actor - scene->actors));
+    return index_soup(actor, &soup);
+}
+
+static void store_cached(scene_t *scene, scene_actor_t *actor)
+{
+    mesh_t levels[SCENE_LOD_LEVELS];
+
+    levels[0] = actor->mesh;
+    for (int l = 1; l < actor->lod_count; l++)
+        levels[l] = actor->lod_meshes[l - 1];
+    if (!mesh_cache_store(scene->cache_dir, actor->source_hash, levels, actor->lod_error, actor->lod_count,
+                          &actor->bounds))
+        printf("scene: failed to write the mesh cache entry for '%s' in '%s'\n", actor->path, scene->cache_dir);
+    actor->cache_pending = false;
+}
+
+/*
+ * Decimated levels of one actor, then its cache entry if it missed. The
+ * actor may already be drawn: the levels are complete before lod_count
+ * publishes them.
+ */
+static void build_lods(scene_t *scene, scene_actor_t *actor)
+{
+    int targets[SCENE_LOD_LEVELS - 1];
+    int count = 0;
+
+    if (actor->lod_count == 1 && actor->cache_map.base == NULL)
+    {
+        for (int n = actor->mesh.triangle_count / 4; n >= SCENE_LOD_MIN_TRIANGLES && count < SCENE_LOD_LEVELS - 1;
+             n /= 4)
+            targets[count++] = n;
+        if (count > 0)
+        {
+            int built = mesh_lod_build(&actor->mesh, targets, count, actor->lod_meshes, &actor->lod_error[1]);
+            __atomic_store_n(&actor->lod_count, 1 + built, __ATOMIC_RELEASE);
+        }
+    }
+    if (actor->cache_pending)
+        store_cached(scene, actor);
+}
+
+/* Hands an actor whose mesh and bounds are complete to scene_update() and the renderers */
+static void attach_actor(scene_actor_t *actor)
+{
+    __atomic_store_n(&actor->ready, true, __ATOMIC_RELEASE);
+}
+
+/* Collision hierarchy of the full mesh; an actor without one is left out of collision checks */
+static void build_bvh(scene_actor_t *actor)
+{
+    if (!mesh_bvh_build(&actor->mesh, &actor->bvh))
+    {
+        printf("scene: out of memory building the collision hierarchy of '%s'\n", actor->name);
+        return;
+    }
+    __atomic_store_n(&actor->bvh_ready, true, __ATOMIC_RELEASE);
+}
+
+int scene_add_actor(scene_t *scene, int node, const char *name, const char *path,
+                    const float local[16], const float color[3])
+{
+    scene_actor_t *actor = append_actor(scene, node, name, local, color);
+    if (actor == NULL)
+        return -1;
+
+    copy_name(actor->path, sizeof(actor->path), path);
+    if (!load_geometry(scene, actor, NULL))
+    {
+        mesh_cache_unmap(&actor->cache_map);
+        return -1;
+    }
+    actor->visible = true;
+    attach_actor(actor);
+    build_bvh(actor);
+    return scene->actor_count++;
+}
+
+int scene_add_actor_mesh(scene_t *scene, int node, const char *name, stl_mesh_t *mesh,
+                         const float local[16], const float color[3])
+{
+    scene_actor_t *actor = append_actor(scene, node, name, local, color);
+    if (actor == NULL)
+        return -1;
+    soup_bounds(actor, mesh);
+    if (!index_soup(actor, mesh))
+        return -1;
+
+    actor->visible = true;
+    attach_actor(actor);
+    build_bvh(actor);
+    return scene->actor_count++;
+}
+
+int scene_add_actor_deferred(scene_t *scene, int node, const char *name, const char *path,
+                             const float local[16], const float color[3])
+{
+    scene_actor_t *actor = append_actor(scene, node, name, local, color);
+    if (actor == NULL)
+        return -1;
+
+    copy_name(actor->path, sizeof(actor->path), path);
+    return scene->actor_count++;
+}
+
+int scene_add_actor_facets(scene_t *scene, int node, const char *name, const char *path, const float *facets,
+                           int count, const float local[16], const float color[3])
+{
+    int index = facets && count > 0 ? scene_add_actor_deferred(scene, node, name, path, local, color) : -1;
+
+    if (index >= 0)
+    {
+        scene->actors[index].facets = facets;
+        scene->actors[index].facet_count = count;
+    }
+    return index;
+}
+
+/* Attaches the full mesh as soon as it exists, so it is on screen while its detail levels are built */
+static void load_actor_job(void *arg, int index, int worker)
+{
+    load_job_t *job = (load_job_t *)arg;
+    int i = job->pending[index].actor;
+    scene_actor_t *actor = &job->scene->actors[i];
+
+    (void)worker;
+    if (load_geometry(job->scene, actor, job))
+    {
+        int levels = actor->lod_count;
+
+        attach_actor(actor);
+        notify_changed(job, i);
+        build_lods(job->scene, actor);
+        build_bvh(actor);
+        if (actor->lod_count != levels)
+            notify_changed(job, i);
+    }
+    else
+    {
+        /* No box for an actor that won't come */
+        if (__atomic_exchange_n(&actor->bounds_ready, false, __ATOMIC_ACQ_REL))
+            notify_changed(job, i);
+        __atomic_fetch_add(&job->failed, 1, __ATOMIC_RELAXED);
+    }
+    __atomic_fetch_add(&job->scene->load_finished, 1, __ATOMIC_RELEASE);
+}
+
+/* Totals over the attached actors, once they are all in */
+static void log_loaded(const scene_t *scene, int loaded, int failed, int threads)
+{
+    int triangles = 0, vertices = 0, coarsest = 0;
+    size_t bytes = 0;
+
+    for (int i = 0; i < scene->actor_count; i++)
+    {
+        const scene_actor_t *actor = &scene->actors[i];
+        if (!scene_actor_ready(actor))
+            continue;
+        triangles += actor->mesh.triangle_count;
+        vertices += actor->mesh.vertex_count;
+        bytes += mesh_bytes(&actor->mesh);
+        coarsest += actor->lod_count > 1 ? actor->lod_meshes[actor->lod_count - 2].triangle_count
+                                         : actor->mesh.triangle_count;
+    }
+    printf("scene: %d actors loaded on %d thread(s), %d failed\n", loaded, threads, failed);
+    /* An STL soup takes 12 floats per triangle: three corners and the facet normal */
+    printf("scene: %d triangles (%d at the coarsest levels), %d vertices, %.1f MB indexed (%.1f MB as soup)\n",
+           triangles, coarsest, vertices, (double)bytes / 1048576.0,
+           (double)triangles * 12.0 * sizeof(float) / 1048576.0);
+    if (scene->cache_dir[0] != '\0')
+        printf("scene: mesh cache '%s', %d hits, %d misses\n", scene->cache_dir, scene->cache_hits,
+               scene->cache_misses);
+}
+
+int scene_load_actors(scene_t *scene, int threads, const scene_load_callbacks_t *callbacks)
+{
+    load_job_t job = { scene, NULL, callbacks, 0 };
+    int count = 0;
+
+    job.pending = malloc((size_t)(scene->actor_count > 0 ? scene->actor_count : 1) * sizeof(*job.pending));
+    if (job.pending == NULL)
+    {
+        if (callbacks && callbacks->ready)
+            callbacks->ready(callbacks->arg, scene->actor_count);
+        return scene->actor_count;
+    }
+    for (int i = 0; i < scene->actor_count; i++)
+    {
+        struct stat st;
+
+        const scene_actor_t *actor = &scene->actors[i];
+
+        if (scene_actor_ready(actor) || (actor->path[0] == '\0' && actor->facets == NULL))
+            continue;
+        job.pending[count].actor = i;
+        if (actor->facets)
+            job.pending[count].size = 84 + (off_t)actor->facet_count * 50;
+        else
+            job.pending[count].size = stat(actor->path, &st) == 0 ? st.st_size : 0;
+        count++;
+    }
+
+    /*
+     * Jobs are claimed in order, so starting with the largest files keeps one
+     * big part from being picked up last and holding up the whole load.
+     */
+    qsort(job.pending, (size_t)count, sizeof(*job.pending), larger_first);
+    __atomic_store_n(&scene->load_finished, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&scene->load_total, count, __ATOMIC_RELEASE);
+    if (threads <= 0)
+        threads = worker_pool_cpu_count();
+    worker_pool_t *pool = count > 1 && threads > 1 ? worker_pool_create(threads < count ? threads : count) : NULL;
+    worker_pool_run(pool, load_actor_job, &job, count);
+    log_loaded(scene, count - job.failed, job.failed, worker_pool_threads(pool));
+    worker_pool_destroy(pool);
+    free(job.pending);
+
+    if (callbacks && callbacks->ready)
+        callbacks->ready(callbacks->arg, job.failed);
+    return job.failed;
+}
+
+void scene_generate_lods(scene_t *scene)
+{
+    int before = 0, after = 0;
+
+    for (int i = 0; i < scene->actor_count; i++)
+    {
+        scene_actor_t *actor = &scene->actors[i];
+
+        if (!scene_actor_ready(actor))
+            continue;
+        before += actor->mesh.triangle_count;
+        build_lods(scene, actor);
+        after += actor->lod_count > 1 ? actor->lod_meshes[actor->lod_count - 2].triangle_count
+                                      : actor->mesh.triangle_count;
+    }
+    printf("scene: detail levels built, %d triangles at full detail, %d at the coarsest\n", before, after);
+}
+
+int scene_find_node(const scene_t *scene, const char *name)
+{
+    if (scene->name_slot_count == 0)
+        return -1;
+
+    uint32_t mask = (uint32_t)scene->name_slot_count - 1;
+    for (uint32_t slot = name_hash(name) & mask; scene->name_slots[slot] >= 0; slot = (slot + 1) & mask)
+    {
+        if (strcmp(scene->nodes[scene->name_slots[slot]].name, name) == 0)
+            return scene->name_slots[slot];
+    }
+    return -1;
+}
+
+/*
+ * Meant to match ucncAssemblyRender: move to the pivot (origin) plus the
+ * assembly's position, rotate X, Y, Z about the pivot, then move back.
+ * headless -C compares the frames drawn this way with cncvis_render().
+ */
+void scene_node_local_matrix(const scene_node_t *node, float out[16])
+{
+    mat4_translation(out, node->origin[0] + node->position[0],
+                     node->origin[1] + node->position[1],
+                     node->origin[2] + node->position[2]);
+    mat4_rotate_axis(out, 0, node->rotation[0]);
+    mat4_rotate_axis(out, 1, node->rotation[1]);
+    mat4_rotate_axis(out, 2, node->rotation[2]);
+    mat4_translate(out, -node->origin[0], -node->origin[1], -node->origin[2]);
+}
+
+/* Position or rotation component a node's motion drives, NULL for a fixed node */
+static float *joint_field(scene_node_t *node)
+{
+    switch (node->motion)
+    {
+    case SCENE_MOTION_ROTATIONAL:
+        return &node->rotation[node->motion_axis];
+    case SCENE_MOTION_LINEAR:
+        return &node->position[node->motion_axis];
+    default:
+        return NULL;
+    }
+}
+
+bool scene_set_joint(scene_t *scene, int index, float value)
+{
+    scene_node_t *node = index >= 0 && index < scene->node_count ? &scene->nodes[index] : NULL;
+    float *field = node ? joint_field(node) : NULL;
+
+    if (field == NULL)
+        return false;
+    value = node->motion_inverted ? -value : value;
+    if (*field != value)
+    {
+        *field = value;
+        node->dirty = true;
+    }
+    return true;
+}
+
+bool scene_get_joint(const scene_t *scene, int index, float *value)
+{
+    scene_node_t *node = index >= 0 && index < scene->node_count ? &scene->nodes[index] : NULL;
+    float *field = node ? joint_field(node) : NULL;
+
+    if (field == NULL)
+        return false;
+    *value = node->motion_inverted ? -*field : *field;
+    return true;
+}
+
+bool scene_set_node_pose(scene_t *scene, int index, const float origin[3], const float position[3],
+                         const float rotation[3])
+{
+    scene_node_t *node = &scene->nodes[index];
+
+    if (memcmp(node->origin, origin, sizeof(node->origin)) == 0 &&
+        memcmp(node->position, position, sizeof(node->position)) == 0 &&
+        memcmp(node->rotation, rotation, sizeof(node->rotation)) == 0)
+        return false;
+
+    memcpy(node->origin, origin, sizeof(node->origin));
+    memcpy(node->position, position, sizeof(node->position));
+    memcpy(node->rotation, rotation, sizeof(node->rotation));
+    node->dirty = true;
+    return true;
+}
+
+int scene_update(scene_t *scene)
+{
+    int moved = 0;
+
+    /*
+     * Parents precede children, so one forward pass resolves the hierarchy.
+     * Only dirty nodes and the nodes below one that moved get new matrices;
+     * everything else keeps its cached world matrix.
+     */
+    scene->matrices_updated = 0;
+    for (int i = 0; i < scene->node_count; i++)
+    {
+        scene_node_t *node = &scene->nodes[i];
+        const scene_node_t *parent = node->parent >= 0 ? &scene->nodes[node->parent] : NULL;
+        float world[16];
+
+        node->moved = false;
+        if (!node->dirty && (parent == NULL || !parent->moved))
+            continue;
+
+        if (node->dirty)
+            scene_node_local_matrix(node, node->local);
+        if (parent)
+            mat4_mul(world, parent->world, node->local);
+        else
+            memcpy(world, node->local, sizeof(world));
+        node->dirty = false;
+        scene->matrices_updated++;
+
+        node->moved = memcmp(world, node->world, sizeof(world)) != 0;
+        if (node->moved)
+        {
+            memcpy(node->world, world, sizeof(world));
+            moved++;
+        }
+    }
+
+    bool refit = moved > 0;
+    for (int i = 0; i < scene->actor_count; i++)
+    {
+        scene_actor_t *actor = &scene->actors[i];
+        const scene_node_t *node = &scene->nodes[actor->node];
+        if (!scene_actor_bounds_ready(actor))
+            continue;
+        if (node->moved || aabb_is_empty(&actor->world_bounds))
+        {
+            float m[16];
+            mat4_mul(m, node->world, actor->local);
+            aabb_transform(m, &actor->bounds, &actor->world_bounds);
+            refit = true;
+        }
+    }
+
+    if (refit)
+    {
+        for (int i = 0; i < scene->node_count; i++)
+            aabb_empty(&scene->nodes[i].bounds);
+        for (int i = 0; i < scene->actor_count; i++)
+            aabb_union(&scene->nodes[scene->actors[i].node].bounds, &scene->actors[i].world_bounds);
+        /* Children follow their parents, so a backward pass folds each subtree in before its root */
+        for (int i = scene->node_count - 1; i >= 0; i--)
+        {
+            if (scene->nodes[i].parent >= 0)
+                aabb_union(&scene->nodes[scene->nodes[i].parent].bounds, &scene->nodes[i].bounds);
+        }
+    }
+
+    return moved;
+}
+
+int scene_cull(scene_t *scene, const frustum_t *frustum)
+{
+    int culled = 0;
+
+    for (int i = 0; i < scene->node_count; i++)
+    {
+        scene_node_t *node = &scene->nodes[i];
+        frustum_result_t parent = node->parent >= 0 ? scene->nodes[node->parent].visibility : FRUSTUM_INTERSECTS;
+
+        node->visibility = parent == FRUSTUM_INTERSECTS ? frustum_classify(frustum, &node->bounds) : parent;
+    }
+
+    for (int i = 0; i < scene->actor_count; i++)
+    {
+        scene_actor_t *actor = &scene->actors[i];
+        frustum_result_t node = scene->nodes[actor->node].visibility;
+
+        if (node == FRUSTUM_INTERSECTS)
+            node = frustum_classify(frustum, &actor->world_bounds);
+        actor->visible = node != FRUSTUM_OUTSIDE && scene_actor_ready(actor);
+        if (!actor->visible)
+            culled++;
+    }
+    return culled;
+}
+
+void scene_mark_drawn(scene_t *scene)
+{
+    for (int i = 0; i < scene->actor_count; i++)
+    {
+        scene->actors[i].drawn_bounds = scene->actors[i].world_bounds;
+        scene->actors[i].drawn_colliding = scene->actors[i].colliding;
+    }
+}
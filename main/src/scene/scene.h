@@ -0,0 +1,286 @@
+/**
+ * @file scene.h
+ * @brief Application-side mirror of the cncvis assembly tree.
+ *
+ * cncvis owns the configuration (assemblies, camera, lights), but its render
+ * path is a black box: it exposes neither bounds nor transforms. The scene
+ * mirror keeps one node per ucncAssembly with cached local/world matrices and
+ * subtree bounds, and one actor per ucncActor with its own welded copy of
+ * the STL geometry, its decimated detail levels and bounds, which is what the
+ * renderer, dirty-rectangle tracking, frustum culling and the collision
+ * code work from.
+ *
+ * This module has no TinyGL, LVGL or cncvis dependency; see scene_cncvis.h
+ * for building a scene from the cncvis tree.
+ */
+
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "mesh.h"
+#include "mesh_bvh.h"
+#include "mesh_cache.h"
+#include "scene_math.h"
+#include "stl.h"
+
+#define SCENE_NAME_MAX 64
+#define SCENE_PATH_MAX 256
+#define SCENE_LOD_LEVELS 4     /* Detail levels per actor, including the full mesh */
+#define SCENE_LOD_MIN_TRIANGLES 64
+
+typedef enum
+{
+    SCENE_MOTION_NONE,
+    SCENE_MOTION_ROTATIONAL,
+    SCENE_MOTION_LINEAR
+} scene_motion_t;
+
+typedef struct
+{
+    char name[SCENE_NAME_MAX];
+    char path[SCENE_PATH_MAX];
+    void *source;          /* The ucncActor this actor mirrors (opaque here), or NULL */
+    const float *facets;   /* Triangles parsed elsewhere, loaded instead of `path`; see scene_add_actor_facets() */
+    int facet_count;
+    int node;              /* Owning node index */
+    float local[16];       /* Placement inside the owning node */
+    float color[3];
+    mesh_t mesh;           /* Welded, cache-ordered geometry (mesh.h) */
+    mesh_t lod_meshes[SCENE_LOD_LEVELS - 1]; /* Decimated levels 1.. of `mesh` */
+    float lod_error[SCENE_LOD_LEVELS];           /* Geometric error of each level, mesh units */
+    int lod_count;         /* Levels available, 1 = only the full mesh */
+    int lod;               /* Level the renderer picked for this frame */
+    bool visible;          /* Inside the frustum of the last scene_cull() */
+    bool ready;            /* Geometry loaded; read with scene_actor_ready() */
+    bool bounds_ready;     /* `bounds` known, maybe before the geometry; read with scene_actor_bounds_ready() */
+    aabb_t bounds;         /* Mesh-space bounds */
+    aabb_t world_bounds;   /* Bounds at the current pose */
+    aabb_t drawn_bounds;   /* World bounds when the actor was last drawn */
+    mesh_bvh_t bvh;        /* Triangle hierarchy of `mesh` for collision checks; read with scene_actor_bvh() */
+    bool bvh_ready;
+    bool colliding;        /* In a pair found by the last scene_collision_update() */
+    bool drawn_colliding;  /* `colliding` when the actor was last drawn */
+    uint64_t source_hash;  /* Content hash of the STL or the facets, for the mesh cache */
+    bool cache_pending;    /* Missed the cache; stored once its levels are built */
+    mesh_cache_map_t cache_map; /* Entry the meshes are borrowed from on a hit */
+} scene_actor_t;
+
+typedef struct
+{
+    char name[SCENE_NAME_MAX];
+    int parent;            /* -1 for roots; parents always precede their children */
+    void *source;          /* The ucncAssembly this node mirrors (opaque here) */
+    float origin[3];
+    float position[3];
+    float rotation[3];     /* Degrees about X, Y, Z */
+    scene_motion_t motion;
+    int motion_axis;       /* 0 = X, 1 = Y, 2 = Z */
+    bool motion_inverted;
+    float local[16];
+    float world[16];       /* Cached; recomputed only when the node or an ancestor changed */
+    bool dirty;            /* Pose changed since the last scene_update() (scene_set_node_pose) */
+    bool moved;            /* World matrix changed in the last scene_update() */
+    aabb_t bounds;         /* World bounds of the node's actors and all its descendants */
+    frustum_result_t visibility; /* Of `bounds` in the last scene_cull() */
+} scene_node_t;
+
+typedef struct
+{
+    scene_node_t *nodes;
+    int node_count;
+    int node_capacity;
+    int *name_slots;       /* Open-addressed hash of node names to indices, -1 = free */
+    int name_slot_count;   /* Power of two, at least twice node_count */
+    scene_actor_t *actors;
+    int actor_count;
+    int actor_capacity;
+    char cache_dir[SCENE_PATH_MAX]; /* Mesh cache directory, empty = no cache */
+    int cache_hits;
+    int cache_misses;
+    int matrices_updated;  /* World matrices recomputed by the last scene_update() */
+    uint64_t joints_timestamp_us; /* Controller time of the last joint batch (scene_cncvis_apply_joints) */
+    int load_total;        /* Actors the running scene_load_actors() started with */
+    int load_finished;     /* Of those, loaded or failed so far; read with scene_load_progress() */
+    bool shared_geometry;  /* A view (scene_create_view): meshes and hierarchies belong to the source */
+} scene_t;
+
+/*
+ * Hooks for watching scene_load_actors(). `changed` runs on a loader thread
+ * when an actor's bounds are known, again when it is attached and again
+ * when its detail levels are added, e.g. to request a frame; `ready` runs once when every actor is
+ * done, with the number that failed. Either may be NULL.
+ */
+typedef struct
+{
+    void (*changed)(void *arg, int actor);
+    void (*ready)(void *arg, int failed);
+    void *arg;
+} scene_load_callbacks_t;
+
+scene_t *scene_create(void);
+void scene_destroy(scene_t *scene);
+
+/*
+ * Copy of the nodes and actors of a loaded scene that shares its meshes,
+ * detail levels and collision hierarchies: poses, matrices, bounds and
+ * flags are the view's own, so each thread of a batch job can pose one
+ * while the geometry is read by all. The source must stay loaded and
+ * unchanged for the view's lifetime; scene_destroy() frees only the copy.
+ */
+scene_t *scene_create_view(const scene_t *scene);
+
+/*
+ * Enables the mesh cache (mesh_cache.h) for actors added from now on: a hit
+ * maps the welded mesh and its detail levels instead of loading the STL, a
+ * miss stores them once its detail levels are built. NULL or "" disables
+ * it.
+ */
+void scene_set_cache_dir(scene_t *scene, const char *dir);
+
+/* Appends a node; parent must already exist (or be -1). Returns its index or -1. */
+int scene_add_node(scene_t *scene, const char *name, int parent, void *source);
+
+/* Appends an actor to `node` and loads its STL. Returns its index or -1. */
+int scene_add_actor(scene_t *scene, int node, const char *name, const char *path,
+                    const float local[16], const float color[3]);
+
+/* Same with a soup already in memory; it is converted (mesh_from_soup) and freed */
+int scene_add_actor_mesh(scene_t *scene, int node, const char *name, stl_mesh_t *mesh,
+                         const float local[16], const float color[3]);
+
+/*
+ * Appends an actor without loading it: it takes part in the hierarchy but
+ * is skipped by scene_update(), scene_cull() and the renderers until
+ * scene_load_actors() has attached its geometry. Returns its index or -1.
+ */
+int scene_add_actor_deferred(scene_t *scene, int node, const char *name, const char *path,
+                             const float local[16], const float color[3]);
+
+/*
+ * Same, for triangles something else already parsed (cncvis_init does):
+ * `count` facets of 12 floats each, the normal and then the three corners.
+ * scene_load_actors() welds them instead of reading an STL, so a model is
+ * parsed only once; `path` then only names the actor's STL in messages.
+ * The facets are not copied and must stay valid until the actor is loaded
+ * or has failed to.
+ */
+int scene_add_actor_facets(scene_t *scene, int node, const char *name, const char *path, const float *facets,
+                           int count, const float local[16], const float color[3]);
+
+/*
+ * Loads every deferred actor on a pool of `threads` threads (0 = one per
+ * CPU): mesh cache lookup, STL load or the facets handed over, welding,
+ * detail levels and the cache entry for a miss all run in the job. An
+ * actor is attached with its full mesh as soon as that exists and its
+ * detail levels follow when built, so the scene may be rendered from
+ * another thread meanwhile. Returns the
+ * number of actors that failed to load; they stay detached. `callbacks`
+ * may be NULL.
+ */
+int scene_load_actors(scene_t *scene, int threads, const scene_load_callbacks_t *callbacks);
+
+/* Actors finished (loaded or failed) and started by the current or last scene_load_actors() */
+static inline void scene_load_progress(const scene_t *scene, int *finished, int *total)
+{
+    *total = __atomic_load_n(&scene->load_total, __ATOMIC_ACQUIRE);
+    *finished = __atomic_load_n(&scene->load_finished, __ATOMIC_ACQUIRE);
+}
+
+/*
+ * Builds the decimated levels of every actor (mesh_lod.h), each about a
+ * quarter of the previous one, down to SCENE_LOD_MIN_TRIANGLES. Meant to run
+ * once after loading; actors already carrying levels (including cache hits)
+ * are skipped, and cache misses are written out afterwards.
+ */
+void scene_generate_lods(scene_t *scene);
+
+/* Whether the actor's geometry, bounds and levels may be read; pairs with the loader's release store */
+static inline bool scene_actor_ready(const scene_actor_t *actor)
+{
+    return __atomic_load_n(&actor->ready, __ATOMIC_ACQUIRE);
+}
+
+/*
+ * Whether the actor's mesh-space bounds may be read. They are known once its
+ * STL is parsed, before welding and attaching, so a renderer can stand a
+ * box in for the actor meanwhile; scene_update() keeps world_bounds for it.
+ */
+static inline bool scene_actor_bounds_ready(const scene_actor_t *actor)
+{
+    return __atomic_load_n(&actor->bounds_ready, __ATOMIC_ACQUIRE);
+}
+
+/* Detail levels published so far; the loader may still be adding some */
+static inline int scene_actor_lod_count(const scene_actor_t *actor)
+{
+    return __atomic_load_n(&actor->lod_count, __ATOMIC_ACQUIRE);
+}
+
+/* Collision hierarchy of the full mesh, or NULL while the loader is still building it */
+static inline const mesh_bvh_t *scene_actor_bvh(const scene_actor_t *actor)
+{
+    return __atomic_load_n(&actor->bvh_ready, __ATOMIC_ACQUIRE) ? &actor->bvh : NULL;
+}
+
+/* Colour to draw `actor` in: its own, or the collision highlight */
+static inline const float *scene_actor_color(const scene_actor_t *actor)
+{
+    static const float highlight[3] = { 1.0f, 0.15f, 0.1f };
+    return actor->colliding ? highlight : actor->color;
+}
+
+/* Geometry of the level the renderer picked for `actor` */
+static inline const mesh_t *scene_actor_mesh(const scene_actor_t *actor)
+{
+    return actor->lod > 0 ? &actor->lod_meshes[actor->lod - 1] : &actor->mesh;
+}
+
+/*
+ * Index of the first node called `name`, or -1; a hash lookup. Node indices
+ * never change, so they serve as stable joint handles (scene_cncvis.h).
+ */
+int scene_find_node(const scene_t *scene, const char *name);
+
+/* Local transform of a node from its origin/position/rotation */
+void scene_node_local_matrix(const scene_node_t *node, float out[16]);
+
+/*
+ * Sets a node's origin/position/rotation and marks it dirty if any of them
+ * changed; returns whether it did. Writing the fields directly must be
+ * followed by setting `dirty` by hand.
+ */
+bool scene_set_node_pose(scene_t *scene, int index, const float origin[3], const float position[3],
+                         const float rotation[3]);
+
+/*
+ * Joint value of a node with a motion type, as scene_cncvis_set_motion()
+ * takes it (degrees or units, inversion applied), read from or written to
+ * the node's pose instead of its ucncAssembly: for scenes and views posed
+ * without cncvis. Setting marks the node dirty if the value changed. Both
+ * return false for a node that can't move.
+ */
+bool scene_set_joint(scene_t *scene, int index, float value);
+bool scene_get_joint(const scene_t *scene, int index, float *value);
+
+/*
+ * Recomputes the matrices of dirty nodes and their subtrees, the world
+ * bounds of the actors that moved with them, and refits the node bounds
+ * when anything moved; returns the number of nodes that moved.
+ */
+int scene_update(scene_t *scene);
+
+/*
+ * Sets every actor's `visible` flag against `frustum`, top-down: a node
+ * whose bounds are outside hides its whole subtree and one fully inside
+ * shows it, both without testing further. Returns the number of actors
+ * culled.
+ */
+int scene_cull(scene_t *scene, const frustum_t *frustum);
+
+/* Records the current actor bounds as the ones on screen */
+void scene_mark_drawn(scene_t *scene);
+
+#endif // SCENE_H
@@ -0,0 +1,256 @@
+/**
+ * @file scene_cncvis.c
+ * @brief Builds and synchronises the scene mirror from the cncvis assembly tree.
+ */
+
+#include "scene_cncvis.h"
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Where an actor's STL lives; false if the result doesn't fit in `size` */
+static bool resolve_path(char *out, size_t size, const char *config_path, const char *file)
+{
+    FILE *fp = fopen(file, "rb");
+    const char *slash = config_path ? strrchr(config_path, '/') : NULL;
+    int length;
+
+    if (fp != NULL || file[0] == '/' || slash == NULL)
+    {
+        if (fp)
+            fclose(fp);
+        length = snprintf(out, size, "%s", file);
+    }
+    else
+    {
+        /* Relative to the directory holding config.xml */
+        length = snprintf(out, size, "%.*s/%s", (int)(slash - config_path), config_path, file);
+    }
+    return length >= 0 && (size_t)length < size;
+}
+
+/* Copies the assembly's pose into the node, marking it dirty only if it changed */
+static void read_pose(scene_t *scene, int index, const ucncAssembly *assembly)
+{
+    const float origin[3] = { assembly->originX, assembly->originY, assembly->originZ };
+    const float position[3] = { assembly->positionX, assembly->positionY, assembly->positionZ };
+    const float rotation[3] = { assembly->rotationX, assembly->rotationY, assembly->rotationZ };
+
+    scene_set_node_pose(scene, index, origin, position, rotation);
+}
+
+static void read_motion(scene_node_t *node, const ucncAssembly *assembly)
+{
+    if (strcmp(assembly->motionType, "rotational") == 0)
+        node->motion = SCENE_MOTION_ROTATIONAL;
+    else if (strcmp(assembly->motionType, "linear") == 0)
+        node->motion = SCENE_MOTION_LINEAR;
+    else
+        node->motion = SCENE_MOTION_NONE;
+
+    switch (assembly->motionAxis)
+    {
+    case 'X': case 'x': node->motion_axis = 0; break;
+    case 'Y': case 'y': node->motion_axis = 1; break;
+    default:            node->motion_axis = 2; break;
+    }
+    node->motion_inverted = assembly->invertMotion != 0;
+}
+
+static void actor_local_matrix(const ucncActor *actor, float out[16])
+{
+    mat4_translation(out, actor->positionX, actor->positionY, actor->positionZ);
+    mat4_rotate_axis(out, 0, actor->rotationX);
+    mat4_rotate_axis(out, 1, actor->rotationY);
+    mat4_rotate_axis(out, 2, actor->rotationZ);
+}
+
+/*
+ * The triangles cncvis_init() parsed for an actor: triangleCount facets of
+ * 12 floats at stlObject, the normal and then the three corners, the way
+ * cncvis draws them. NULL if it has none, e.g. its STL failed to load.
+ */
+static const float *parsed_facets(const ucncActor *actor, int *count)
+{
+    if (actor->stlObject == NULL || actor->triangleCount == 0 || actor->triangleCount > INT_MAX / 12)
+        return NULL;
+    *count = (int)actor->triangleCount;
+    return actor->stlObject;
+}
+
+static void build_node(scene_t *scene, ucncAssembly *assembly, int parent, const char *config_path)
+{
+    int index = scene_add_node(scene, assembly->name, parent, assembly);
+    if (index < 0)
+        return;
+
+    read_pose(scene, index, assembly);
+    read_motion(&scene->nodes[index], assembly);
+
+    for (int i = 0; i < assembly->actorCount; i++)
+    {
+        ucncActor *actor = assembly->actors[i];
+        char path[SCENE_PATH_MAX];
+        float local[16];
+        float color[3] = { actor->colorR, actor->colorG, actor->colorB };
+        int count = 0;
+        const float *facets = parsed_facets(actor, &count);
+        int added;
+
+        /* A cut path would fail later as a missing file; an empty one is never loaded */
+        if (!resolve_path(path, sizeof(path), config_path, actor->stlFile))
+        {
+            printf("scene: STL path too long for actor '%s' (limit %d): '%s'\n", actor->name, SCENE_PATH_MAX - 1,
+                   actor->stlFile);
+            path[0] = '\0';
+        }
+        actor_local_matrix(actor, local);
+        if (facets)
+            added = scene_add_actor_facets(scene, index, actor->name, path, facets, count, local, color);
+        else
+            added = scene_add_actor_deferred(scene, index, actor->name, path, local, color);
+        if (added >= 0)
+            scene->actors[added].source = actor;
+    }
+
+    for (int i = 0; i < assembly->assemblyCount; i++)
+        build_node(scene, assembly->assemblies[i], index, config_path);
+}
+
+scene_t *scene_cncvis_build(ucncAssembly *root, const char *config_path, const char *cache_dir)
+{
+    scene_t *scene = scene_create();
+    if (scene == NULL || root == NULL)
+        return scene;
+
+    scene_set_cache_dir(scene, cache_dir);
+    /* The whole tree first, so the loaders only ever touch their own actor */
+    build_node(scene, root, -1, config_path);
+    scene_update(scene);
+    printf("scene: %d nodes, %d actors\n", scene->node_count, scene->actor_count);
+    return scene;
+}
+
+int scene_cncvis_release_geometry(scene_t *scene)
+{
+    size_t bytes = 0;
+    int released = 0;
+
+    for (int i = 0; i < scene->actor_count; i++)
+    {
+        scene_actor_t *actor = &scene->actors[i];
+        ucncActor *source = (ucncActor *)actor->source;
+
+        if (source == NULL || actor->facets == NULL || !scene_actor_ready(actor))
+            continue;
+        bytes += (size_t)actor->facet_count * 12 * sizeof(float);
+        free(source->stlObject);
+        source->stlObject = NULL;
+        source->triangleCount = 0;
+        actor->facets = NULL;
+        actor->facet_count = 0;
+        released++;
+    }
+    if (released > 0)
+        printf("scene: released cncvis' copy of %d actor(s), %.1f MB\n", released, (double)bytes / 1048576.0);
+    return released;
+}
+
+/* Hides (or puts back) the handed-over triangles cncvis still holds */
+static void show_handed_over(scene_t *scene, bool show)
+{
+    for (int i = 0; i < scene->actor_count; i++)
+    {
+        const scene_actor_t *actor = &scene->actors[i];
+        ucncActor *source = (ucncActor *)actor->source;
+
+        if (source == NULL || actor->facets == NULL)
+            continue;
+        source->stlObject = show ? (float *)actor->facets : NULL;
+        source->triangleCount = show ? actor->facet_count : 0;
+    }
+}
+
+void scene_cncvis_render_backdrop(scene_t *scene)
+{
+    show_handed_over(scene, false);
+    cncvis_render();
+    show_handed_over(scene, true);
+}
+
+/* The assembly field a joint's motion drives, or NULL */
+static float *motion_field(scene_t *scene, int joint)
+{
+    if (joint < 0 || joint >= scene->node_count || scene->nodes[joint].source == NULL)
+        return NULL;
+
+    const scene_node_t *node = &scene->nodes[joint];
+    ucncAssembly *assembly = (ucncAssembly *)node->source;
+    float *rotation[3] = { &assembly->rotationX, &assembly->rotationY, &assembly->rotationZ };
+    float *position[3] = { &assembly->positionX, &assembly->positionY, &assembly->positionZ };
+
+    switch (node->motion)
+    {
+    case SCENE_MOTION_ROTATIONAL: return rotation[node->motion_axis];
+    case SCENE_MOTION_LINEAR:     return position[node->motion_axis];
+    default:                      return NULL;
+    }
+}
+
+bool scene_cncvis_update_motion(scene_t *scene, int joint, float delta)
+{
+    float *field = motion_field(scene, joint);
+    if (field == NULL)
+        return false;
+
+    *field += scene->nodes[joint].motion_inverted ? -delta : delta;
+    return true;
+}
+
+bool scene_cncvis_set_motion(scene_t *scene, int joint, float value)
+{
+    float *field = motion_field(scene, joint);
+    if (field == NULL)
+        return false;
+
+    *field = scene->nodes[joint].motion_inverted ? -value : value;
+    return true;
+}
+
+bool scene_cncvis_get_motion(scene_t *scene, int joint, float *value)
+{
+    float *field = motion_field(scene, joint);
+    if (field == NULL)
+        return false;
+
+    *value = scene->nodes[joint].motion_inverted ? -*field : *field;
+    return true;
+}
+
+int scene_cncvis_apply_joints(scene_t *scene, const int *joints, const float *values, int count,
+                              uint64_t timestamp_us)
+{
+    int applied = 0;
+
+    if (timestamp_us < scene->joints_timestamp_us)
+        return -1;
+
+    for (int i = 0; i < count; i++)
+    {
+        if (scene_cncvis_set_motion(scene, joints[i], values[i]))
+            applied++;
+    }
+    scene->joints_timestamp_us = timestamp_us;
+    return applied;
+}
+
+void scene_cncvis_sync(scene_t *scene)
+{
+    for (int i = 0; i < scene->node_count; i++)
+    {
+        if (scene->nodes[i].source)
+            read_pose(scene, i, (const ucncAssembly *)scene->nodes[i].source);
+    }
+}
@@ -0,0 +1,86 @@
+/**
+ * @file scene_cncvis.h
+ * @brief Builds and synchronises the scene mirror from the cncvis assembly tree.
+ *
+ * This is the only place that reads cncvis struct fields directly
+ * (ucncAssembly: name, origin/position/rotation, motionType, motionAxis,
+ * invertMotion, actors, assemblies; ucncActor: name, stlFile,
+ * position/rotation, color, stlObject, triangleCount) and the only one
+ * writing them (joint motion, releasing the actors' triangles).
+ * Everything else talks to scene_t.
+ */
+
+#ifndef SCENE_CNCVIS_H
+#define SCENE_CNCVIS_H
+
+#include "../../../cncvis/api.h"
+
+#include "scene.h"
+
+/*
+ * Mirrors `root` with every actor deferred: nothing is loaded yet, see
+ * scene_load_actors() and scene_loader.h. The triangles cncvis_init()
+ * already parsed are handed to the mirror (scene_add_actor_facets), so
+ * every STL is read once; an actor cncvis holds none for falls back to
+ * loading its file. config_path resolves relative STL paths; cache_dir is
+ * the mesh cache (scene_set_cache_dir), NULL = none.
+ */
+scene_t *scene_cncvis_build(ucncAssembly *root, const char *config_path, const char *cache_dir);
+
+/*
+ * Frees cncvis' triangles of every actor the mirror has loaded from them
+ * and clears them in the ucncActor, so the model is held once, welded, by
+ * the mirror. cncvis_render() draws nothing for those actors afterwards,
+ * so skip this where it still has to (the headless comparison, -C).
+ * Call after scene_load_actors(), with the scene locked as for any cncvis
+ * write.
+ * Returns the number released.
+ */
+int scene_cncvis_release_geometry(scene_t *scene);
+
+/*
+ * cncvis_render() without the actors the mirror draws: its background,
+ * axes and on-screen display, plus any actor whose triangles cncvis kept to
+ * itself. Triangles handed over but not yet released are hidden for the
+ * call and put back after it. Call with the scene locked: cncvis_render()
+ * reads the assemblies, the camera and the lights.
+ */
+void scene_cncvis_render_backdrop(scene_t *scene);
+
+/* Pulls origin/position/rotation from the cncvis assemblies into the nodes */
+void scene_cncvis_sync(scene_t *scene);
+
+/*
+ * Joint handles: resolve an assembly name once with scene_find_node() and
+ * move it through the node index from then on, without the name search of
+ * ucncUpdateMotionByName. These take the place of a handle API inside
+ * cncvis (ucncUpdateMotion/ucncSetMotion(handle, value)), which would have
+ * to live in the cncvis submodule; the handle index is the mirror's node
+ * name hash, built by scene_cncvis_build() right after cncvis_init().
+ * Both write the ucncAssembly the node mirrors, as ucncUpdateMotionByName
+ * does: degrees about the motion axis for a rotational joint, units along
+ * it for a linear one, sign flipped by invertMotion. The node
+ * follows at the next scene_cncvis_sync(). Call with the scene locked, as
+ * for any cncvis write; false if the handle is invalid or has no motion.
+ */
+bool scene_cncvis_update_motion(scene_t *scene, int joint, float delta);
+
+/* Same, but sets the joint to an absolute value instead of moving it by one */
+bool scene_cncvis_set_motion(scene_t *scene, int joint, float value);
+
+/* Current value of a joint as scene_cncvis_set_motion() takes it; false if it can't move */
+bool scene_cncvis_get_motion(scene_t *scene, int joint, float *value);
+
+/*
+ * One controller status frame: sets joints[i] to values[i] (absolute, as
+ * scene_cncvis_set_motion) for all `count` joints and records timestamp_us
+ * as the scene's joint time. A batch older than the last one applied is
+ * dropped whole, so a late packet can't move the machine back. Returns the
+ * number of joints set, or -1 for a dropped batch. Call with the scene
+ * locked (render_thread_apply_joints does), so a frame sees all of a batch
+ * or none of it.
+ */
+int scene_cncvis_apply_joints(scene_t *scene, const int *joints, const float *values, int count,
+                              uint64_t timestamp_us);
+
+#endif // SCENE_CNCVIS_H
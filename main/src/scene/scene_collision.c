@@ -0,0 +1,301 @@
+/**
+ * @file scene_collision.c
+ * @brief Incremental broad phase over the assembly tree and the pair list.
+ */
+
+#include "scene_collision.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct scene_collision
+{
+    int node_count;
+    int actor_count;
+    int first_root;            /* Node tree as child and sibling lists, -1 terminated */
+    int *first_child;
+    int *next_sibling;
+    int *first_actor;          /* Actors of each node */
+    int *next_actor;
+    int *stack;                /* Traversal scratch, one slot per node */
+    uint8_t *allowed;          /* node_count x node_count bit matrix of exempt node pairs */
+    float (*placement)[16];    /* Mesh-to-world matrix of each actor at its last check */
+    bool *checked;             /* The actor has been checked at `placement` */
+    bool *moved;               /* Re-tested by the running update */
+    float clearance;           /* Pairs closer than this are reported as near misses */
+    scene_collision_pair_t *pairs;
+    int pair_count;
+    int pair_capacity;
+    int colliding_count;       /* Pairs at distance 0 */
+    scene_collision_stats_t stats;
+};
+
+static size_t bit_index(const scene_collision_t *sc, int a, int b)
+{
+    return (size_t)a * (size_t)sc->node_count + (size_t)b;
+}
+
+static bool is_allowed(const scene_collision_t *sc, int a, int b)
+{
+    size_t bit = bit_index(sc, a, b);
+    return (sc->allowed[bit / 8] >> (bit % 8)) & 1;
+}
+
+scene_collision_t *scene_collision_create(const scene_t *scene, bool allow_adjacent)
+{
+    scene_collision_t *sc = calloc(1, sizeof(*sc));
+    int nodes = scene->node_count, actors = scene->actor_count;
+
+    if (sc == NULL)
+        return NULL;
+    sc->node_count = nodes;
+    sc->actor_count = actors;
+    sc->first_root = -1;
+    sc->first_child = malloc((size_t)(nodes > 0 ? nodes : 1) * sizeof(int));
+    sc->next_sibling = malloc((size_t)(nodes > 0 ? nodes : 1) * sizeof(int));
+    sc->first_actor = malloc((size_t)(nodes > 0 ? nodes : 1) * sizeof(int));
+    sc->stack = malloc((size_t)(nodes > 0 ? nodes : 1) * sizeof(int));
+    sc->next_actor = malloc((size_t)(actors > 0 ? actors : 1) * sizeof(int));
+    sc->allowed = calloc(((size_t)nodes * (size_t)nodes + 7) / 8 + 1, 1);
+    sc->placement = malloc((size_t)(actors > 0 ? actors : 1) * sizeof(*sc->placement));
+    sc->checked = calloc((size_t)(actors > 0 ? actors : 1), sizeof(bool));
+    sc->moved = calloc((size_t)(actors > 0 ? actors : 1), sizeof(bool));
+    if (sc->first_child == NULL || sc->next_sibling == NULL || sc->first_actor == NULL || sc->stack == NULL ||
+        sc->next_actor == NULL || sc->allowed == NULL || sc->placement == NULL || sc->checked == NULL ||
+        sc->moved == NULL)
+    {
+        scene_collision_destroy(sc);
+        return NULL;
+    }
+
+    /* Built back to front so the lists come out in index order */
+    for (int i = 0; i < nodes; i++)
+        sc->first_child[i] = sc->first_actor[i] = -1;
+    for (int i = nodes - 1; i >= 0; i--)
+    {
+        int parent = scene->nodes[i].parent;
+        int *head = parent >= 0 ? &sc->first_child[parent] : &sc->first_root;
+        sc->next_sibling[i] = *head;
+        *head = i;
+        if (allow_adjacent && parent >= 0)
+            scene_collision_allow(sc, i, parent);
+    }
+    for (int i = actors - 1; i >= 0; i--)
+    {
+        int node = scene->actors[i].node;
+        sc->next_actor[i] = sc->first_actor[node];
+        sc->first_actor[node] = i;
+    }
+    return sc;
+}
+
+void scene_collision_destroy(scene_collision_t *sc)
+{
+    if (sc == NULL)
+        return;
+    free(sc->first_child);
+    free(sc->next_sibling);
+    free(sc->first_actor);
+    free(sc->next_actor);
+    free(sc->stack);
+    free(sc->allowed);
+    free(sc->placement);
+    free(sc->checked);
+    free(sc->moved);
+    free(sc->pairs);
+    free(sc);
+}
+
+void scene_collision_allow(scene_collision_t *sc, int node_a, int node_b)
+{
+    size_t ab, ba;
+
+    if (node_a < 0 || node_a >= sc->node_count || node_b < 0 || node_b >= sc->node_count)
+        return;
+    ab = bit_index(sc, node_a, node_b);
+    ba = bit_index(sc, node_b, node_a);
+    sc->allowed[ab / 8] |= (uint8_t)(1u << (ab % 8));
+    sc->allowed[ba / 8] |= (uint8_t)(1u << (ba % 8));
+}
+
+int scene_collision_allow_list(scene_collision_t *sc, const scene_t *scene, const char *list)
+{
+    int added = 0;
+
+    while (list != NULL && *list != '\0')
+    {
+        char names[2][SCENE_NAME_MAX];
+        size_t length = strcspn(list, ",");
+        const char *colon = memchr(list, ':', length);
+        int nodes[2];
+
+        if (colon == NULL || colon == list || colon == list + length - 1 ||
+            (size_t)(colon - list) >= SCENE_NAME_MAX || length - (size_t)(colon - list) > SCENE_NAME_MAX)
+            return -1;
+        snprintf(names[0], sizeof(names[0]), "%.*s", (int)(colon - list), list);
+        snprintf(names[1], sizeof(names[1]), "%.*s", (int)(length - (size_t)(colon - list) - 1), colon + 1);
+        for (int k = 0; k < 2; k++)
+        {
+            nodes[k] = scene_find_node(scene, names[k]);
+            if (nodes[k] < 0)
+                return -1;
+        }
+        scene_collision_allow(sc, nodes[0], nodes[1]);
+        added++;
+        list += length;
+        if (*list == ',')
+            list++;
+    }
+    return added;
+}
+
+void scene_collision_set_clearance(scene_collision_t *sc, float clearance)
+{
+    sc->clearance = clearance > 0.0f ? clearance : 0.0f;
+    memset(sc->checked, 0, (size_t)sc->actor_count * sizeof(bool));
+    sc->pair_count = 0;
+}
+
+/* Whether the boxes come within `margin` of each other */
+static inline bool boxes_near(const aabb_t *a, const aabb_t *b, float margin)
+{
+    return a->min[0] <= b->max[0] + margin && b->min[0] <= a->max[0] + margin && a->min[1] <= b->max[1] + margin &&
+           b->min[1] <= a->max[1] + margin && a->min[2] <= b->max[2] + margin && b->min[2] <= a->max[2] + margin;
+}
+
+static void add_pair(scene_collision_t *sc, int a, int b, float distance)
+{
+    if (sc->pair_count == sc->pair_capacity)
+    {
+        int capacity = sc->pair_capacity ? sc->pair_capacity * 2 : 16;
+        scene_collision_pair_t *pairs = realloc(sc->pairs, (size_t)capacity * sizeof(*pairs));
+        if (pairs == NULL)
+            return;
+        sc->pairs = pairs;
+        sc->pair_capacity = capacity;
+    }
+    sc->pairs[sc->pair_count++] = (scene_collision_pair_t){ a < b ? a : b, a < b ? b : a, distance };
+}
+
+static void test_pair(scene_collision_t *sc, const scene_t *scene, int a, int b)
+{
+    const scene_actor_t *actor_a = &scene->actors[a];
+    const scene_actor_t *actor_b = &scene->actors[b];
+    float inverse[16], b_to_a[16];
+
+    /* A pair of two moved actors is tested once, from the lower index */
+    if (b == a || b >= sc->actor_count || !sc->checked[b] || (sc->moved[b] && b < a))
+        return;
+    if (actor_a->node == actor_b->node || is_allowed(sc, actor_a->node, actor_b->node))
+        return;
+    if (!boxes_near(&actor_a->world_bounds, &actor_b->world_bounds, sc->clearance))
+        return;
+    sc->stats.candidates++;
+    if (!mat4_affine_inverse(sc->placement[a], inverse))
+        return;
+
+    mat4_mul(b_to_a, inverse, sc->placement[b]);
+    sc->stats.narrow++;
+    if (sc->clearance > 0.0f)
+    {
+        float distance =
+            mesh_bvh_distance(&actor_a->mesh, &actor_a->bvh, &actor_b->mesh, &actor_b->bvh, b_to_a, sc->clearance);
+        if (distance < sc->clearance)
+            add_pair(sc, a, b, distance);
+    }
+    else if (mesh_bvh_intersect(&actor_a->mesh, &actor_a->bvh, &actor_b->mesh, &actor_b->bvh, b_to_a))
+        add_pair(sc, a, b, 0.0f);
+}
+
+/* Broad phase for one moved actor: subtrees whose bounds miss it are skipped whole */
+static void test_actor(scene_collision_t *sc, const scene_t *scene, int index)
+{
+    const aabb_t *box = &scene->actors[index].world_bounds;
+    int top = 0;
+
+    for (int root = sc->first_root; root >= 0; root = sc->next_sibling[root])
+        sc->stack[top++] = root;
+    while (top > 0)
+    {
+        int node = sc->stack[--top];
+
+        if (!boxes_near(&scene->nodes[node].bounds, box, sc->clearance))
+            continue;
+        for (int other = sc->first_actor[node]; other >= 0; other = sc->next_actor[other])
+            test_pair(sc, scene, index, other);
+        for (int child = sc->first_child[node]; child >= 0; child = sc->next_sibling[child])
+            sc->stack[top++] = child;
+    }
+}
+
+static int pair_order(const void *x, const void *y)
+{
+    const scene_collision_pair_t *a = x, *b = y;
+    return a->a != b->a ? (a->a > b->a) - (a->a < b->a) : (a->b > b->b) - (a->b < b->b);
+}
+
+int scene_collision_update(scene_collision_t *sc, scene_t *scene)
+{
+    int actors = scene->actor_count < sc->actor_count ? scene->actor_count : sc->actor_count;
+    int moved = 0, kept = 0, colliding = 0;
+
+    memset(&sc->stats, 0, sizeof(sc->stats));
+
+    /* Actors join once scene_update() has given them world bounds and the loader a hierarchy */
+    for (int i = 0; i < actors; i++)
+    {
+        const scene_actor_t *actor = &scene->actors[i];
+        float placement[16];
+
+        sc->moved[i] = false;
+        if (!scene_actor_ready(actor) || aabb_is_empty(&actor->world_bounds) || scene_actor_bvh(actor) == NULL)
+            continue;
+        mat4_mul(placement, scene->nodes[actor->node].world, actor->local);
+        if (sc->checked[i] && memcmp(placement, sc->placement[i], sizeof(placement)) == 0)
+            continue;
+        memcpy(sc->placement[i], placement, sizeof(placement));
+        sc->checked[i] = true;
+        sc->moved[i] = true;
+        moved++;
+    }
+    sc->stats.moved = moved;
+    if (moved == 0)
+        return sc->colliding_count;
+
+    for (int p = 0; p < sc->pair_count; p++)
+    {
+        if (!sc->moved[sc->pairs[p].a] && !sc->moved[sc->pairs[p].b])
+            sc->pairs[kept++] = sc->pairs[p];
+    }
+    sc->pair_count = kept;
+    for (int i = 0; i < actors; i++)
+    {
+        if (sc->moved[i])
+            test_actor(sc, scene, i);
+    }
+    qsort(sc->pairs, (size_t)sc->pair_count, sizeof(*sc->pairs), pair_order);
+
+    for (int i = 0; i < actors; i++)
+        scene->actors[i].colliding = false;
+    for (int p = 0; p < sc->pair_count; p++)
+    {
+        if (sc->pairs[p].distance > 0.0f)
+            continue;
+        scene->actors[sc->pairs[p].a].colliding = scene->actors[sc->pairs[p].b].colliding = true;
+        colliding++;
+    }
+    sc->colliding_count = colliding;
+    return colliding;
+}
+
+const scene_collision_pair_t *scene_collision_pairs(const scene_collision_t *sc, int *count)
+{
+    *count = sc->pair_count;
+    return sc->pairs;
+}
+
+void scene_collision_get_stats(const scene_collision_t *sc, scene_collision_stats_t *stats)
+{
+    *stats = sc->stats;
+}
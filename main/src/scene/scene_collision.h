@@ -0,0 +1,85 @@
+/**
+ * @file scene_collision.h
+ * @brief Collision checks between the actors of a scene after each motion update.
+ *
+ * cncvis has no notion of contact, so collisions are found on the scene
+ * mirror: every actor carries a triangle hierarchy of its full mesh
+ * (mesh_bvh.h, built by the loader) and its world bounds from
+ * scene_update(). scene_collision_update() re-tests only the actors whose
+ * placement changed since their last check. For each of them the broad
+ * phase walks the assembly tree and skips every subtree whose node bounds
+ * miss the actor's world bounds, then the actor bounds themselves; the
+ * narrow phase runs mesh_bvh_intersect() on what is left. Pairs between
+ * two unmoved actors keep their previous result.
+ *
+ * Actors of the same node never collide with each other: they are one
+ * rigid part. Further pairs of nodes can be exempted, e.g. adjacent links
+ * of an arm that touch at their joint by design. The result is a list of
+ * actor pairs plus each actor's `colliding` flag, which the renderers draw
+ * as a highlight colour (scene_actor_color).
+ *
+ * With a clearance set, the narrow phase measures distances instead
+ * (mesh_bvh_distance) and pairs closer than the clearance are listed too,
+ * as near misses; they leave the `colliding` flags alone.
+ */
+
+#ifndef SCENE_COLLISION_H
+#define SCENE_COLLISION_H
+
+#include "scene.h"
+
+typedef struct scene_collision scene_collision_t;
+
+typedef struct
+{
+    int a;                 /* Actor indices, a < b */
+    int b;
+    float distance;        /* 0 when colliding, else the gap of a near miss */
+} scene_collision_pair_t;
+
+typedef struct
+{
+    int moved;             /* Actors re-tested by the last update */
+    int candidates;        /* Actor pairs whose world bounds overlapped */
+    int narrow;            /* Of those, pairs that went through the triangle hierarchies */
+} scene_collision_stats_t;
+
+/*
+ * Checker for the nodes and actors `scene` has now. With allow_adjacent,
+ * actors of a node and of its parent are never reported together.
+ * Returns NULL if memory runs out.
+ */
+scene_collision_t *scene_collision_create(const scene_t *scene, bool allow_adjacent);
+void scene_collision_destroy(scene_collision_t *sc);
+
+/* Exempts actors of node_a from colliding with those of node_b */
+void scene_collision_allow(scene_collision_t *sc, int node_a, int node_b);
+
+/*
+ * Same for a comma-separated list of node name pairs, "base:link1,link5:tool".
+ * Returns the number of pairs added, or -1 if an entry is malformed or
+ * names an unknown node; the entries before it are kept.
+ */
+int scene_collision_allow_list(scene_collision_t *sc, const scene_t *scene, const char *list);
+
+/*
+ * Also reports pairs closer than `clearance` (scene units); 0, the default,
+ * looks for contact only. Every actor is re-tested by the next update.
+ */
+void scene_collision_set_clearance(scene_collision_t *sc, float clearance);
+
+/*
+ * Brings the pair list up to date with the scene's current pose; call
+ * after scene_update(), on the thread that owns the scene. Actors still
+ * loading join once their hierarchy is published. Sets every actor's
+ * `colliding` flag and returns the number of colliding pairs.
+ */
+int scene_collision_update(scene_collision_t *sc, scene_t *scene);
+
+/* Colliding pairs and near misses after the last update, ordered by a then b */
+const scene_collision_pair_t *scene_collision_pairs(const scene_collision_t *sc, int *count);
+
+/* Work done by the last update */
+void scene_collision_get_stats(const scene_collision_t *sc, scene_collision_stats_t *stats);
+
+#endif // SCENE_COLLISION_H
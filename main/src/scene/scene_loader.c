@@ -0,0 +1,62 @@
+/**
+ * @file scene_loader.c
+ * @brief Background thread that loads a scene's deferred actors.
+ */
+
+#include "scene_loader.h"
+
+#include <stdlib.h>
+
+#include "../sys/os_thread.h"
+
+#define SCENE_LOADER_STACK (128 * 1024)
+
+struct scene_loader
+{
+    os_thread_t thread;
+    scene_t *scene;
+    int threads;
+    scene_load_callbacks_t callbacks;
+    bool done;
+};
+
+static void loader_main(void *arg)
+{
+    scene_loader_t *loader = (scene_loader_t *)arg;
+
+    scene_load_actors(loader->scene, loader->threads, &loader->callbacks);
+    __atomic_store_n(&loader->done, true, __ATOMIC_RELEASE);
+}
+
+scene_loader_t *scene_loader_start(scene_t *scene, int threads, const scene_load_callbacks_t *callbacks)
+{
+    scene_loader_t *loader = calloc(1, sizeof(*loader));
+    if (loader == NULL)
+        return NULL;
+
+    loader->scene = scene;
+    loader->threads = threads;
+    if (callbacks)
+        loader->callbacks = *callbacks;
+
+    if (!os_thread_create(&loader->thread, "scene_loader", loader_main, loader, SCENE_LOADER_STACK, 0))
+    {
+        free(loader);
+        return NULL;
+    }
+    return loader;
+}
+
+bool scene_loader_done(const scene_loader_t *loader)
+{
+    return __atomic_load_n(&loader->done, __ATOMIC_ACQUIRE);
+}
+
+void scene_loader_join(scene_loader_t *loader)
+{
+    if (loader == NULL)
+        return;
+
+    os_thread_join(&loader->thread);
+    free(loader);
+}
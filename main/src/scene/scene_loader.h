@@ -0,0 +1,32 @@
+/**
+ * @file scene_loader.h
+ * @brief Background thread that loads a scene's deferred actors.
+ *
+ * scene_loader_start() runs scene_load_actors() on a thread of its own and
+ * returns at once, so the UI can come up and the render thread can draw the
+ * actors that are already attached while the rest stream in. Progress is
+ * read with scene_load_progress(); the callbacks report each attached actor
+ * and the end of the load.
+ *
+ * The scene must not gain or lose actors or nodes while a load is running.
+ */
+
+#ifndef SCENE_LOADER_H
+#define SCENE_LOADER_H
+
+#include <stdbool.h>
+
+#include "scene.h"
+
+typedef struct scene_loader scene_loader_t;
+
+/* NULL if the thread can't be started; the caller can then load synchronously */
+scene_loader_t *scene_loader_start(scene_t *scene, int threads, const scene_load_callbacks_t *callbacks);
+
+/* True once the `ready` callback has returned */
+bool scene_loader_done(const scene_loader_t *loader);
+
+/* Waits for the load to finish and frees the loader */
+void scene_loader_join(scene_loader_t *loader);
+
+#endif // SCENE_LOADER_H
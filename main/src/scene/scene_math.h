@@ -0,0 +1,237 @@
+/**
+ * @file scene_math.h
+ * @brief Small 4x4 matrix, bounding-box and frustum helpers for the scene mirror.
+ *
+ * Matrices are column-major float[16], the same layout TinyGL's glLoadMatrixf
+ * and glGetFloatv(GL_*_MATRIX) use, so they can be passed straight through.
+ */
+
+#ifndef SCENE_MATH_H
+#define SCENE_MATH_H
+
+#include <float.h>
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+typedef struct
+{
+    float min[3];
+    float max[3];
+} aabb_t;
+
+/* Six clip planes (a, b, c, d) with a*x + b*y + c*z + d >= 0 inside */
+typedef struct
+{
+    float planes[6][4];
+} frustum_t;
+
+typedef enum
+{
+    FRUSTUM_OUTSIDE,
+    FRUSTUM_INTERSECTS,
+    FRUSTUM_INSIDE
+} frustum_result_t;
+
+static inline void mat4_identity(float m[16])
+{
+    memset(m, 0, 16 * sizeof(float));
+    m[0] = m[5] = m[10] = m[15] = 1.0f;
+}
+
+/* out = a * b; out may alias a or b */
+static inline void mat4_mul(float out[16], const float a[16], const float b[16])
+{
+    float r[16];
+    for (int c = 0; c < 4; c++)
+    {
+        for (int row = 0; row < 4; row++)
+        {
+            r[c * 4 + row] = a[0 * 4 + row] * b[c * 4 + 0] + a[1 * 4 + row] * b[c * 4 + 1] +
+                             a[2 * 4 + row] * b[c * 4 + 2] + a[3 * 4 + row] * b[c * 4 + 3];
+        }
+    }
+    memcpy(out, r, sizeof(r));
+}
+
+static inline void mat4_translation(float m[16], float x, float y, float z)
+{
+    mat4_identity(m);
+    m[12] = x;
+    m[13] = y;
+    m[14] = z;
+}
+
+/* Rotation of `degrees` about principal axis 0 (X), 1 (Y) or 2 (Z), as glRotatef */
+static inline void mat4_rotation_axis(float m[16], int axis, float degrees)
+{
+    float rad = degrees * (float)(M_PI / 180.0);
+    float c = cosf(rad);
+    float s = sinf(rad);
+
+    mat4_identity(m);
+    switch (axis)
+    {
+    case 0:
+        m[5] = c; m[6] = s; m[9] = -s; m[10] = c;
+        break;
+    case 1:
+        m[0] = c; m[2] = -s; m[8] = s; m[10] = c;
+        break;
+    default:
+        m[0] = c; m[1] = s; m[4] = -s; m[5] = c;
+        break;
+    }
+}
+
+static inline void mat4_translate(float m[16], float x, float y, float z)
+{
+    float t[16];
+    mat4_translation(t, x, y, z);
+    mat4_mul(m, m, t);
+}
+
+static inline void mat4_rotate_axis(float m[16], int axis, float degrees)
+{
+    float r[16];
+    mat4_rotation_axis(r, axis, degrees);
+    mat4_mul(m, m, r);
+}
+
+static inline void mat4_transform_point(const float m[16], const float p[3], float out[3])
+{
+    float x = p[0], y = p[1], z = p[2];
+    out[0] = m[0] * x + m[4] * y + m[8] * z + m[12];
+    out[1] = m[1] * x + m[5] * y + m[9] * z + m[13];
+    out[2] = m[2] * x + m[6] * y + m[10] * z + m[14];
+}
+
+static inline void mat4_transform_vector(const float m[16], const float v[3], float out[3])
+{
+    float x = v[0], y = v[1], z = v[2];
+    out[0] = m[0] * x + m[4] * y + m[8] * z;
+    out[1] = m[1] * x + m[5] * y + m[9] * z;
+    out[2] = m[2] * x + m[6] * y + m[10] * z;
+}
+
+/* Inverse of an affine matrix (bottom row 0 0 0 1); false if it is singular */
+static inline bool mat4_affine_inverse(const float m[16], float out[16])
+{
+    float c[9] = {
+        m[5] * m[10] - m[6] * m[9], m[2] * m[9] - m[1] * m[10], m[1] * m[6] - m[2] * m[5],
+        m[6] * m[8] - m[4] * m[10], m[0] * m[10] - m[2] * m[8], m[2] * m[4] - m[0] * m[6],
+        m[4] * m[9] - m[5] * m[8], m[1] * m[8] - m[0] * m[9], m[0] * m[5] - m[1] * m[4],
+    };
+    float det = m[0] * c[0] + m[4] * c[1] + m[8] * c[2];
+
+    if (fabsf(det) < 1e-12f)
+        return false;
+    float inv = 1.0f / det;
+    for (int col = 0; col < 3; col++)
+    {
+        for (int row = 0; row < 3; row++)
+            out[col * 4 + row] = c[col * 3 + row] * inv;
+        out[col * 4 + 3] = 0.0f;
+    }
+    for (int row = 0; row < 3; row++)
+        out[12 + row] = -(out[row] * m[12] + out[4 + row] * m[13] + out[8 + row] * m[14]);
+    out[15] = 1.0f;
+    return true;
+}
+
+static inline void aabb_empty(aabb_t *b)
+{
+    b->min[0] = b->min[1] = b->min[2] = FLT_MAX;
+    b->max[0] = b->max[1] = b->max[2] = -FLT_MAX;
+}
+
+static inline bool aabb_is_empty(const aabb_t *b)
+{
+    return b->min[0] > b->max[0];
+}
+
+static inline void aabb_add_point(aabb_t *b, const float p[3])
+{
+    for (int i = 0; i < 3; i++)
+    {
+        if (p[i] < b->min[i]) b->min[i] = p[i];
+        if (p[i] > b->max[i]) b->max[i] = p[i];
+    }
+}
+
+static inline void aabb_union(aabb_t *b, const aabb_t *o)
+{
+    if (aabb_is_empty(o))
+        return;
+    aabb_add_point(b, o->min);
+    aabb_add_point(b, o->max);
+}
+
+/* Bounds of a box after an affine transform (Arvo's method) */
+static inline void aabb_transform(const float m[16], const aabb_t *in, aabb_t *out)
+{
+    if (aabb_is_empty(in))
+    {
+        aabb_empty(out);
+        return;
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        float lo = m[12 + i];
+        float hi = m[12 + i];
+        for (int j = 0; j < 3; j++)
+        {
+            float a = m[j * 4 + i] * in->min[j];
+            float b = m[j * 4 + i] * in->max[j];
+            lo += a < b ? a : b;
+            hi += a < b ? b : a;
+        }
+        out->min[i] = lo;
+        out->max[i] = hi;
+    }
+}
+
+/* World-space planes of a view-projection matrix (Gribb/Hartmann) */
+static inline void frustum_from_matrix(frustum_t *f, const float m[16])
+{
+    for (int i = 0; i < 3; i++)
+    {
+        for (int k = 0; k < 4; k++)
+        {
+            f->planes[i * 2][k] = m[k * 4 + 3] + m[k * 4 + i];
+            f->planes[i * 2 + 1][k] = m[k * 4 + 3] - m[k * 4 + i];
+        }
+    }
+}
+
+/* Nearest/farthest-corner test per plane; an empty box is outside */
+static inline frustum_result_t frustum_classify(const frustum_t *f, const aabb_t *b)
+{
+    frustum_result_t result = FRUSTUM_INSIDE;
+
+    if (aabb_is_empty(b))
+        return FRUSTUM_OUTSIDE;
+
+    for (int i = 0; i < 6; i++)
+    {
+        const float *p = f->planes[i];
+        float far_d = p[3], near_d = p[3];
+        for (int k = 0; k < 3; k++)
+        {
+            far_d += p[k] * (p[k] > 0.0f ? b->max[k] : b->min[k]);
+            near_d += p[k] * (p[k] > 0.0f ? b->min[k] : b->max[k]);
+        }
+        if (far_d < 0.0f)
+            return FRUSTUM_OUTSIDE;
+        if (near_d < 0.0f)
+            result = FRUSTUM_INTERSECTS;
+    }
+    return result;
+}
+
+#endif // SCENE_MATH_H
@@ -0,0 +1,158 @@
+/**
+ * @file stl.c
+ * @brief Minimal binary/ASCII STL reader.
+ */
+
+#include "stl.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static bool stl_alloc(stl_mesh_t *mesh, int triangles)
+{
+    mesh->triangle_count = triangles;
+    mesh->vertices = malloc((size_t)triangles * 9 * sizeof(float));
+    mesh->normals = malloc((size_t)triangles * 3 * sizeof(float));
+    if (mesh->vertices == NULL || mesh->normals == NULL)
+    {
+        stl_free(mesh);
+        return false;
+    }
+    return true;
+}
+
+/* Facet normals in STL files are often zero or stale; derive them from the winding */
+static void stl_fix_normal(const float *v, float *n)
+{
+    float ax = v[3] - v[0], ay = v[4] - v[1], az = v[5] - v[2];
+    float bx = v[6] - v[0], by = v[7] - v[1], bz = v[8] - v[2];
+    float nx = ay * bz - az * by;
+    float ny = az * bx - ax * bz;
+    float nz = ax * by - ay * bx;
+    float len = sqrtf(nx * nx + ny * ny + nz * nz);
+
+    if (len > 0.0f)
+    {
+        n[0] = nx / len;
+        n[1] = ny / len;
+        n[2] = nz / len;
+    }
+}
+
+static bool stl_read_binary(FILE *fp, long size, stl_mesh_t *mesh)
+{
+    uint8_t header[84];
+    if (fseek(fp, 0, SEEK_SET) != 0 || fread(header, 1, sizeof(header), fp) != sizeof(header))
+        return false;
+
+    uint32_t count = (uint32_t)header[80] | (uint32_t)header[81] << 8 |
+                     (uint32_t)header[82] << 16 | (uint32_t)header[83] << 24;
+    if (size != 84 + (long)count * 50 || count == 0 || count > 0x7FFFFFF)
+        return false;
+    if (!stl_alloc(mesh, (int)count))
+        return false;
+
+    uint8_t record[50];
+    for (uint32_t t = 0; t < count; t++)
+    {
+        float f[12];
+        if (fread(record, 1, sizeof(record), fp) != sizeof(record))
+        {
+            stl_free(mesh);
+            return false;
+        }
+        memcpy(f, record, sizeof(f)); /* little-endian IEEE floats, as on every supported host */
+        memcpy(&mesh->vertices[t * 9], &f[3], 9 * sizeof(float));
+        memcpy(&mesh->normals[t * 3], &f[0], 3 * sizeof(float));
+        stl_fix_normal(&mesh->vertices[t * 9], &mesh->normals[t * 3]);
+    }
+    return true;
+}
+
+static bool stl_read_ascii(FILE *fp, stl_mesh_t *mesh)
+{
+    int capacity = 1024;
+    int count = 0;
+    int corner = 0;
+    char line[256];
+
+    if (fseek(fp, 0, SEEK_SET) != 0 || !stl_alloc(mesh, capacity))
+        return false;
+
+    while (fgets(line, sizeof(line), fp))
+    {
+        float x, y, z;
+        const char *p = line;
+        while (*p == ' ' || *p == '\t')
+            p++;
+        if (strncmp(p, "vertex", 6) != 0 || sscanf(p + 6, "%f %f %f", &x, &y, &z) != 3)
+            continue;
+
+        if (count == capacity)
+        {
+            capacity *= 2;
+            float *v = realloc(mesh->vertices, (size_t)capacity * 9 * sizeof(float));
+            float *n = v ? realloc(mesh->normals, (size_t)capacity * 3 * sizeof(float)) : NULL;
+            if (v)
+                mesh->vertices = v;
+            if (n == NULL)
+            {
+                stl_free(mesh);
+                return false;
+            }
+            mesh->normals = n;
+        }
+
+        float *v = &mesh->vertices[count * 9 + corner * 3];
+        v[0] = x;
+        v[1] = y;
+        v[2] = z;
+        if (++corner == 3)
+        {
+            float *n = &mesh->normals[count * 3];
+            n[0] = n[1] = 0.0f;
+            n[2] = 1.0f;
+            stl_fix_normal(&mesh->vertices[count * 9], n);
+            corner = 0;
+            count++;
+        }
+    }
+
+    mesh->triangle_count = count;
+    if (count == 0)
+    {
+        stl_free(mesh);
+        return false;
+    }
+    return true;
+}
+
+bool stl_load(const char *path, stl_mesh_t *mesh)
+{
+    memset(mesh, 0, sizeof(*mesh));
+
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL)
+        return false;
+
+    bool ok = false;
+    if (fseek(fp, 0, SEEK_END) == 0)
+    {
+        long size = ftell(fp);
+        /* Binary files may also start with "solid", so trust the size check first */
+        ok = stl_read_binary(fp, size, mesh) || stl_read_ascii(fp, mesh);
+    }
+
+    fclose(fp);
+    return ok;
+}
+
+void stl_free(stl_mesh_t *mesh)
+{
+    free(mesh->vertices);
+    free(mesh->normals);
+    memset(mesh, 0, sizeof(*mesh));
+}
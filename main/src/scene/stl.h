@@ -0,0 +1,22 @@
+/**
+ * @file stl.h
+ * @brief Minimal binary/ASCII STL reader producing a flat triangle soup.
+ */
+
+#ifndef STL_H
+#define STL_H
+
+#include <stdbool.h>
+
+typedef struct
+{
+    int triangle_count;
+    float *vertices; /* 9 floats per triangle */
+    float *normals;  /* 3 floats per triangle (facet normal) */
+} stl_mesh_t;
+
+/* Loads `path`; returns false and leaves *mesh empty on failure */
+bool stl_load(const char *path, stl_mesh_t *mesh);
+void stl_free(stl_mesh_t *mesh);
+
+#endif // STL_H
@@ -0,0 +1,226 @@
+/**
+ * @file os_thread.c
+ * @brief pthread and FreeRTOS implementations of the os_thread wrappers.
+ */
+
+#include "os_thread.h"
+
+#include <stddef.h>
+
+#ifdef USE_FREERTOS
+
+static void thread_trampoline(void *arg)
+{
+    os_thread_t *thread = (os_thread_t *)arg;
+
+    thread->fn(thread->arg);
+    xSemaphoreGive(thread->done);
+    vTaskDelete(NULL);
+}
+
+bool os_thread_create(os_thread_t *thread, const char *name, os_thread_fn_t fn, void *arg,
+                      uint32_t stack_bytes, int priority)
+{
+    UBaseType_t base = tskIDLE_PRIORITY + 1;
+
+    thread->fn = fn;
+    thread->arg = arg;
+    thread->done = xSemaphoreCreateBinary();
+    if (thread->done == NULL)
+        return false;
+
+    if (priority > 0 && base + (UBaseType_t)priority < configMAX_PRIORITIES)
+        base += (UBaseType_t)priority;
+
+    if (xTaskCreate(thread_trampoline, name, stack_bytes / sizeof(StackType_t), thread, base,
+                    &thread->handle) != pdPASS)
+    {
+        vSemaphoreDelete(thread->done);
+        return false;
+    }
+    return true;
+}
+
+void os_thread_join(os_thread_t *thread)
+{
+    xSemaphoreTake(thread->done, portMAX_DELAY);
+    vSemaphoreDelete(thread->done);
+}
+
+bool os_mutex_init(os_mutex_t *mutex)
+{
+    mutex->handle = xSemaphoreCreateMutex();
+    return mutex->handle != NULL;
+}
+
+void os_mutex_destroy(os_mutex_t *mutex)
+{
+    vSemaphoreDelete(mutex->handle);
+}
+
+void os_mutex_lock(os_mutex_t *mutex)
+{
+    xSemaphoreTake(mutex->handle, portMAX_DELAY);
+}
+
+void os_mutex_unlock(os_mutex_t *mutex)
+{
+    xSemaphoreGive(mutex->handle);
+}
+
+bool os_event_init(os_event_t *event)
+{
+    event->handle = xSemaphoreCreateBinary();
+    return event->handle != NULL;
+}
+
+void os_event_destroy(os_event_t *event)
+{
+    vSemaphoreDelete(event->handle);
+}
+
+void os_event_post(os_event_t *event)
+{
+    xSemaphoreGive(event->handle);
+}
+
+bool os_event_wait(os_event_t *event, uint32_t timeout_ms)
+{
+    TickType_t ticks = timeout_ms == OS_WAIT_FOREVER ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+    return xSemaphoreTake(event->handle, ticks) == pdTRUE;
+}
+
+void os_sleep_ms(uint32_t ms)
+{
+    vTaskDelay(pdMS_TO_TICKS(ms));
+}
+
+#else /* pthreads */
+
+#include <errno.h>
+#include <time.h>
+
+static void *thread_trampoline(void *arg)
+{
+    os_thread_t *thread = (os_thread_t *)arg;
+
+    thread->fn(thread->arg);
+    return NULL;
+}
+
+bool os_thread_create(os_thread_t *thread, const char *name, os_thread_fn_t fn, void *arg,
+                      uint32_t stack_bytes, int priority)
+{
+    pthread_attr_t attr;
+    int rc;
+
+    (void)name;
+    (void)priority; /* Raising priority needs privileges on desktop systems */
+
+    thread->fn = fn;
+    thread->arg = arg;
+
+    pthread_attr_init(&attr);
+    if (stack_bytes > 0)
+        pthread_attr_setstacksize(&attr, stack_bytes);
+    rc = pthread_create(&thread->handle, &attr, thread_trampoline, thread);
+    pthread_attr_destroy(&attr);
+    return rc == 0;
+}
+
+void os_thread_join(os_thread_t *thread)
+{
+    pthread_join(thread->handle, NULL);
+}
+
+bool os_mutex_init(os_mutex_t *mutex)
+{
+    return pthread_mutex_init(&mutex->handle, NULL) == 0;
+}
+
+void os_mutex_destroy(os_mutex_t *mutex)
+{
+    pthread_mutex_destroy(&mutex->handle);
+}
+
+void os_mutex_lock(os_mutex_t *mutex)
+{
+    pthread_mutex_lock(&mutex->handle);
+}
+
+void os_mutex_unlock(os_mutex_t *mutex)
+{
+    pthread_mutex_unlock(&mutex->handle);
+}
+
+bool os_event_init(os_event_t *event)
+{
+    event->signaled = false;
+    if (pthread_mutex_init(&event->mutex, NULL) != 0)
+        return false;
+    if (pthread_cond_init(&event->cond, NULL) != 0)
+    {
+        pthread_mutex_destroy(&event->mutex);
+        return false;
+    }
+    return true;
+}
+
+void os_event_destroy(os_event_t *event)
+{
+    pthread_cond_destroy(&event->cond);
+    pthread_mutex_destroy(&event->mutex);
+}
+
+void os_event_post(os_event_t *event)
+{
+    pthread_mutex_lock(&event->mutex);
+    event->signaled = true;
+    pthread_cond_signal(&event->cond);
+    pthread_mutex_unlock(&event->mutex);
+}
+
+bool os_event_wait(os_event_t *event, uint32_t timeout_ms)
+{
+    struct timespec deadline;
+    bool signaled;
+
+    pthread_mutex_lock(&event->mutex);
+    if (timeout_ms == OS_WAIT_FOREVER)
+    {
+        while (!event->signaled)
+            pthread_cond_wait(&event->cond, &event->mutex);
+    }
+    else
+    {
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L)
+        {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        while (!event->signaled)
+        {
+            if (pthread_cond_timedwait(&event->cond, &event->mutex, &deadline) == ETIMEDOUT)
+                break;
+        }
+    }
+    signaled = event->signaled;
+    event->signaled = false;
+    pthread_mutex_unlock(&event->mutex);
+    return signaled;
+}
+
+void os_sleep_ms(uint32_t ms)
+{
+    struct timespec ts;
+
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = (long)(ms % 1000) * 1000000L;
+    while (nanosleep(&ts, &ts) == -1 && errno == EINTR)
+        ;
+}
+
+#endif
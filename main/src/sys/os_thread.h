@@ -0,0 +1,79 @@
+/**
+ * @file os_thread.h
+ * @brief Minimal thread, mutex and event wrappers for the pthread and FreeRTOS builds.
+ *
+ * The application threads only need to start a worker, guard shared state
+ * and wake a sleeping worker. The FreeRTOS build (USE_FREERTOS) maps these
+ * onto tasks and semaphores; every other build uses pthreads.
+ */
+
+#ifndef OS_THREAD_H
+#define OS_THREAD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef USE_FREERTOS
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "task.h"
+#else
+#include <pthread.h>
+#endif
+
+typedef void (*os_thread_fn_t)(void *arg);
+
+typedef struct
+{
+    os_thread_fn_t fn;
+    void *arg;
+#ifdef USE_FREERTOS
+    TaskHandle_t handle;
+    SemaphoreHandle_t done; /* Given when fn returns; tasks can't be joined */
+#else
+    pthread_t handle;
+#endif
+} os_thread_t;
+
+typedef struct
+{
+#ifdef USE_FREERTOS
+    SemaphoreHandle_t handle;
+#else
+    pthread_mutex_t handle;
+#endif
+} os_mutex_t;
+
+/* Auto-reset event: posts made while nobody waits are remembered (once) */
+typedef struct
+{
+#ifdef USE_FREERTOS
+    SemaphoreHandle_t handle;
+#else
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    bool signaled;
+#endif
+} os_event_t;
+
+#define OS_WAIT_FOREVER 0xFFFFFFFFu
+
+/* priority is relative to the caller's: 0 = same, >0 = higher (FreeRTOS only) */
+bool os_thread_create(os_thread_t *thread, const char *name, os_thread_fn_t fn, void *arg,
+                      uint32_t stack_bytes, int priority);
+void os_thread_join(os_thread_t *thread);
+
+bool os_mutex_init(os_mutex_t *mutex);
+void os_mutex_destroy(os_mutex_t *mutex);
+void os_mutex_lock(os_mutex_t *mutex);
+void os_mutex_unlock(os_mutex_t *mutex);
+
+bool os_event_init(os_event_t *event);
+void os_event_destroy(os_event_t *event);
+void os_event_post(os_event_t *event);
+/* Returns true if the event was posted, false on timeout */
+bool os_event_wait(os_event_t *event, uint32_t timeout_ms);
+
+void os_sleep_ms(uint32_t ms);
+
+#endif // OS_THREAD_H
@@ -0,0 +1,269 @@
+/**
+ * @file worker_pool.c
+ * @brief Worker threads that sleep on an event between jobs.
+ */
+
+#include "worker_pool.h"
+#include "os_thread.h"
+
+#include <stdlib.h>
+
+#ifndef USE_FREERTOS
+#include <unistd.h>
+#endif
+
+#define WORKER_POOL_STACK (128 * 1024)
+
+typedef struct
+{
+    worker_pool_t *pool;
+    int index;
+    os_thread_t thread;
+    os_event_t start;
+} worker_t;
+
+struct worker_pool
+{
+    int threads;
+    worker_t workers[WORKER_POOL_MAX_THREADS];
+    os_event_t done;
+    bool stop;
+
+    /* Current job */
+    worker_pool_fn_t fn;
+    worker_pool_range_fn_t range_fn; /* Set instead of fn for worker_pool_run_ranges() */
+    void *arg;
+    int count;
+    int next;     /* Next unclaimed index */
+    int active;   /* Workers still running the job */
+    int grain;
+    int steals;
+    uint64_t shares[WORKER_POOL_MAX_THREADS]; /* Unclaimed [begin, end) per thread, begin in the high half */
+};
+
+static inline uint64_t pack_share(uint32_t begin, uint32_t end)
+{
+    return (uint64_t)begin << 32 | end;
+}
+
+/* Moves the back half of the largest other share into `worker`'s; false once every share is empty */
+static bool steal(worker_pool_t *pool, int worker)
+{
+    for (;;)
+    {
+        int victim = -1;
+        uint64_t seen = 0;
+        uint32_t most = 0;
+
+        for (int i = 0; i < pool->threads; i++)
+        {
+            uint64_t share = __atomic_load_n(&pool->shares[i], __ATOMIC_ACQUIRE);
+            uint32_t begin = (uint32_t)(share >> 32), end = (uint32_t)share;
+            uint32_t left = end > begin ? end - begin : 0;
+            if (left > most)
+            {
+                most = left;
+                seen = share;
+                victim = i;
+            }
+        }
+        if (victim < 0)
+            return false;
+
+        uint32_t begin = (uint32_t)(seen >> 32), end = (uint32_t)seen;
+        uint32_t middle = begin + (end - begin) / 2;
+        if (__atomic_compare_exchange_n(&pool->shares[victim], &seen, pack_share(begin, middle), false,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        {
+            /* Only the owner refills an empty share, so a plain store will do */
+            __atomic_store_n(&pool->shares[worker], pack_share(middle, end), __ATOMIC_RELEASE);
+            __atomic_fetch_add(&pool->steals, 1, __ATOMIC_RELAXED);
+            return true;
+        }
+    }
+}
+
+static void run_ranges(worker_pool_t *pool, int worker)
+{
+    uint64_t share = __atomic_load_n(&pool->shares[worker], __ATOMIC_ACQUIRE);
+
+    for (;;)
+    {
+        uint32_t begin = (uint32_t)(share >> 32), end = (uint32_t)share;
+
+        if (begin >= end)
+        {
+            if (!steal(pool, worker))
+                return;
+            share = __atomic_load_n(&pool->shares[worker], __ATOMIC_ACQUIRE);
+            continue;
+        }
+        uint32_t take = end - begin < (uint32_t)pool->grain ? end - begin : (uint32_t)pool->grain;
+        if (__atomic_compare_exchange_n(&pool->shares[worker], &share, pack_share(begin + take, end), false,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        {
+            pool->range_fn(pool->arg, (int)begin, (int)(begin + take), worker);
+            share = __atomic_load_n(&pool->shares[worker], __ATOMIC_ACQUIRE);
+        }
+    }
+}
+
+static void run_job(worker_pool_t *pool, int worker)
+{
+    int index;
+
+    if (pool->range_fn)
+    {
+        run_ranges(pool, worker);
+        return;
+    }
+    while ((index = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED)) < pool->count)
+        pool->fn(pool->arg, index, worker);
+}
+
+static void worker_main(void *arg)
+{
+    worker_t *self = (worker_t *)arg;
+    worker_pool_t *pool = self->pool;
+
+    for (;;)
+    {
+        os_event_wait(&self->start, OS_WAIT_FOREVER);
+        if (__atomic_load_n(&pool->stop, __ATOMIC_ACQUIRE))
+            break;
+
+        run_job(pool, self->index);
+        if (__atomic_sub_fetch(&pool->active, 1, __ATOMIC_ACQ_REL) == 0)
+            os_event_post(&pool->done);
+    }
+}
+
+int worker_pool_cpu_count(void)
+{
+#ifdef USE_FREERTOS
+    return 1;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n < 1 ? 1 : (int)n;
+#endif
+}
+
+worker_pool_t *worker_pool_create(int threads)
+{
+    worker_pool_t *pool = calloc(1, sizeof(*pool));
+    if (pool == NULL)
+        return NULL;
+
+    if (threads <= 0)
+        threads = worker_pool_cpu_count();
+    if (threads > WORKER_POOL_MAX_THREADS)
+        threads = WORKER_POOL_MAX_THREADS;
+
+    if (!os_event_init(&pool->done))
+    {
+        free(pool);
+        return NULL;
+    }
+
+    /* Slot 0 is the calling thread */
+    pool->threads = 1;
+    for (int i = 1; i < threads; i++)
+    {
+        worker_t *w = &pool->workers[i];
+        w->pool = pool;
+        w->index = i;
+        if (!os_event_init(&w->start))
+            break;
+        if (!os_thread_create(&w->thread, "worker", worker_main, w, WORKER_POOL_STACK, 0))
+        {
+            os_event_destroy(&w->start);
+            break;
+        }
+        pool->threads++;
+    }
+    return pool;
+}
+
+void worker_pool_destroy(worker_pool_t *pool)
+{
+    if (pool == NULL)
+        return;
+
+    __atomic_store_n(&pool->stop, true, __ATOMIC_RELEASE);
+    for (int i = 1; i < pool->threads; i++)
+        os_event_post(&pool->workers[i].start);
+    for (int i = 1; i < pool->threads; i++)
+    {
+        os_thread_join(&pool->workers[i].thread);
+        os_event_destroy(&pool->workers[i].start);
+    }
+    os_event_destroy(&pool->done);
+    free(pool);
+}
+
+int worker_pool_threads(const worker_pool_t *pool)
+{
+    return pool ? pool->threads : 1;
+}
+
+/* Wakes the workers on the job set up in `pool`, joins in and waits for all of them */
+static void start_job(worker_pool_t *pool)
+{
+    /* The event post/wait pairs order the job stores before the workers read them */
+    __atomic_store_n(&pool->active, pool->threads - 1, __ATOMIC_RELEASE);
+    for (int i = 1; i < pool->threads; i++)
+        os_event_post(&pool->workers[i].start);
+
+    run_job(pool, 0);
+    os_event_wait(&pool->done, OS_WAIT_FOREVER);
+}
+
+void worker_pool_run(worker_pool_t *pool, worker_pool_fn_t fn, void *arg, int count)
+{
+    if (count <= 0)
+        return;
+
+    if (pool == NULL || pool->threads == 1 || count == 1)
+    {
+        for (int i = 0; i < count; i++)
+            fn(arg, i, 0);
+        return;
+    }
+
+    pool->fn = fn;
+    pool->range_fn = NULL;
+    pool->arg = arg;
+    pool->count = count;
+    __atomic_store_n(&pool->next, 0, __ATOMIC_RELAXED);
+    start_job(pool);
+}
+
+int worker_pool_run_ranges(worker_pool_t *pool, worker_pool_range_fn_t fn, void *arg, int count, int grain)
+{
+    if (count <= 0)
+        return 0;
+    if (grain < 1)
+        grain = 1;
+
+    if (pool == NULL || pool->threads == 1)
+    {
+        for (int begin = 0; begin < count; begin += grain)
+            fn(arg, begin, count - begin < grain ? count : begin + grain, 0);
+        return 0;
+    }
+
+    pool->fn = NULL;
+    pool->range_fn = fn;
+    pool->arg = arg;
+    pool->count = count;
+    pool->grain = grain;
+    __atomic_store_n(&pool->steals, 0, __ATOMIC_RELAXED);
+    for (int i = 0; i < pool->threads; i++)
+    {
+        uint32_t begin = (uint32_t)((int64_t)count * i / pool->threads);
+        uint32_t end = (uint32_t)((int64_t)count * (i + 1) / pool->threads);
+        __atomic_store_n(&pool->shares[i], pack_share(begin, end), __ATOMIC_RELAXED);
+    }
+    start_job(pool);
+    return __atomic_load_n(&pool->steals, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,50 @@
+/**
+ * @file worker_pool.h
+ * @brief Fixed pool of worker threads running indexed jobs in parallel.
+ *
+ * worker_pool_run() calls fn(arg, index, worker) for every index in
+ * [0, count), spread over the workers and the calling thread, and returns
+ * once all of them finished. Indices are handed out through an atomic
+ * counter, so uneven jobs balance themselves. `worker` identifies the thread
+ * (0 is the caller) for per-thread scratch space.
+ *
+ * worker_pool_run_ranges() is for jobs whose neighbouring indices share
+ * state, such as consecutive poses of a motion: every thread starts on its
+ * own contiguous share and takes chunks off its front, and a thread that
+ * runs dry steals the back half of the largest share left. Each share is
+ * one 64-bit word changed by compare-and-swap, so owner and thieves never
+ * block each other.
+ */
+
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define WORKER_POOL_MAX_THREADS 32
+
+typedef void (*worker_pool_fn_t)(void *arg, int index, int worker);
+typedef void (*worker_pool_range_fn_t)(void *arg, int begin, int end, int worker);
+
+typedef struct worker_pool worker_pool_t;
+
+/* threads counts the caller: 1 runs everything inline, 0 picks the CPU count */
+worker_pool_t *worker_pool_create(int threads);
+void worker_pool_destroy(worker_pool_t *pool);
+
+int worker_pool_threads(const worker_pool_t *pool);
+
+void worker_pool_run(worker_pool_t *pool, worker_pool_fn_t fn, void *arg, int count);
+
+/*
+ * Calls fn(arg, begin, end, worker) for chunks of at most `grain` indices
+ * that together cover [0, count) once, with work stealing as above, and
+ * returns the number of steals.
+ */
+int worker_pool_run_ranges(worker_pool_t *pool, worker_pool_range_fn_t fn, void *arg, int count, int grain);
+
+/* Online CPUs, at least 1 */
+int worker_pool_cpu_count(void);
+
+#endif // WORKER_POOL_H
@@ -1,7 +1,14 @@
 #include "cnc_communication.h"
+#include "cnc_state_machine.h"
 #include "../utils/logger.h"
+#include "../../render/render_thread.h"
+#include <stdio.h>
 #include <string.h>
 
+// Scene joint of each controller axis, in status-frame order; -1 = not in the model
+static int axis_joints[CNC_MAX_AXES];
+static int axis_count = 0;
+
 // Placeholder for CNC communication implementation
 // Implement actual communication protocols (e.g., serial, TCP/IP)
 
@@ -44,3 +51,42 @@ void cnc_set_tool_offset(int tool_number, double measured_value) {
     cnc_send_gcode(gcode);
     log_info("CNC Tool Offset Set");
 }
+
+int cnc_bind_axes(const char *const *assemblies, int count) {
+    char log_msg[100];
+    int found = 0;
+
+    if (count < 0 || count > CNC_MAX_AXES) {
+        snprintf(log_msg, sizeof(log_msg), "CNC: cannot bind %d axes, at most %d", count, CNC_MAX_AXES);
+        log_error(log_msg);
+        return -1;
+    }
+    for (int i = 0; i < count; i++) {
+        // Resolved once here, so a status frame needs no name lookups
+        axis_joints[i] = render_thread_find_joint(assemblies[i]);
+        if (axis_joints[i] >= 0) {
+            found++;
+        } else {
+            snprintf(log_msg, sizeof(log_msg), "CNC: axis %d (%s) is not in the 3D model", i, assemblies[i]);
+            log_warning(log_msg);
+        }
+    }
+    axis_count = count;
+    return found;
+}
+
+void cnc_receive_axes(const float *positions, int count, uint64_t timestamp_us) {
+    if (count != axis_count) {
+        // Once, not for every frame of a kHz stream
+        if (cnc_get_current_state() != CNC_STATE_ERROR) {
+            char log_msg[100];
+            snprintf(log_msg, sizeof(log_msg), "CNC: status frame has %d axes, %d are bound", count, axis_count);
+            log_error(log_msg);
+            cnc_set_state(CNC_STATE_ERROR);
+        }
+        return;
+    }
+    // The whole frame as one batch: the 3D view never shows half of one frame and half of the next,
+    // and a frame older than the last one applied is dropped
+    render_thread_apply_joints(axis_joints, positions, count, timestamp_us);
+}
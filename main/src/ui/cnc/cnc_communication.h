@@ -2,6 +2,9 @@
 #define CNC_COMMUNICATION_H
 
 #include "lvgl.h"
+#include <stdint.h>
+
+#define CNC_MAX_AXES 32
 
 // Initialize CNC communication interface
 void cnc_init(void);
@@ -17,4 +20,11 @@ void cnc_emergency_stop(void);
 // Tool Offset Management
 void cnc_set_tool_offset(int tool_number, double measured_value);
 
+// Controller feedback: the assembly each axis of a status frame drives, in frame order.
+// Returns the axes found in the 3D model, or -1 for more than CNC_MAX_AXES.
+int cnc_bind_axes(const char *const *assemblies, int count);
+
+// One status frame: every bound axis position (degrees or units) and the controller's time
+void cnc_receive_axes(const float *positions, int count, uint64_t timestamp_us);
+
 #endif // CNC_COMMUNICATION_H
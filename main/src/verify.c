@@ -0,0 +1,233 @@
+/**
+ * @file verify.c
+ * @brief Offline collision verification of a G-code program for build servers.
+ *
+ * Usage: verify [-a axis-map] [-r step] [-R degrees] [-m clearance]
+ *               [-k allow-list] [-t threads] [-c cache-dir] [-j jobs]
+ *               config.xml program
+ *
+ * No rendering: loads config.xml through cncvis, mirrors it into a scene
+ * and sweeps every move of the program ("-" = stdin) through collision
+ * checks on all cores (collision_sweep.h). The program's axes drive
+ * movable assemblies as joint values, the way a controller status frame
+ * would: -a maps them explicitly ("X=carriage,Z=spindle,C=table"), and an
+ * unmapped axis drives the assembly named by its letter in either case, if
+ * there is one. Program coordinates are taken as machine coordinates; work
+ * offsets and tool lengths aren't applied.
+ *
+ * -r and -R set the sweep resolution: the largest linear travel (default
+ * 0.5) and rotary step (default 1 degree) between two checked poses. -m is
+ * the clearance below which pairs are reported as near misses (default 1,
+ * 0 reports contact only, which is much faster). -k exempts node pairs as
+ * in headless; parent and child assemblies may always touch. -t sets the
+ * checking threads and -j the threads loading meshes (both 0 = one per
+ * CPU), -c the mesh cache directory (mesh_cache.h).
+ *
+ * Every collision and near miss goes to stdout, one per move and actor
+ * pair in program order:
+ *
+ *   collision line 1234: spindle / vise
+ *   near-miss line 1240: spindle / vise, 0.42
+ *
+ * and a summary with the first collision goes to stderr. Exits 0 when no
+ * move collides, 2 when one does and 1 on errors.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../../cncvis/api.h"
+
+#include "scene/collision_sweep.h"
+#include "scene/scene_cncvis.h"
+
+// Global Scene State
+ZBuffer *globalFramebuffer = NULL;
+ucncAssembly *globalScene = NULL;
+ucncCamera *globalCamera = NULL;
+ucncLight **globalLights = NULL;
+int globalLightCount = 0;
+
+static const char axisLetters[GCODE_AXES + 1] = "XYZABC";
+
+/* Applies "X=name,Z=name" to joints[]; false on a malformed entry or an assembly that can't move */
+static bool parse_axis_map(const scene_t *scene, const char *map, int joints[GCODE_AXES])
+{
+    while (map != NULL && *map != '\0')
+    {
+        char name[SCENE_NAME_MAX];
+        size_t length = strcspn(map, ",");
+        int axis = gcode_axis_index(map[0]);
+        float value;
+
+        if (axis < 0 || length < 3 || map[1] != '=' || length - 2 >= sizeof(name))
+            return false;
+        snprintf(name, sizeof(name), "%.*s", (int)(length - 2), map + 2);
+        joints[axis] = scene_find_node(scene, name);
+        if (!scene_get_joint(scene, joints[axis], &value))
+        {
+            fprintf(stderr, "verify: no movable assembly '%s' for axis %c\n", name, axisLetters[axis]);
+            return false;
+        }
+        map += length;
+        if (*map == ',')
+            map++;
+    }
+    return true;
+}
+
+/* Axes left unmapped drive the assembly named by their letter, if it can move */
+static void default_axis_map(const scene_t *scene, int joints[GCODE_AXES])
+{
+    for (int k = 0; k < GCODE_AXES; k++)
+    {
+        char names[2][2] = { { axisLetters[k], '\0' }, { (char)(axisLetters[k] - 'A' + 'a'), '\0' } };
+        float value;
+
+        for (int i = 0; i < 2 && joints[k] < 0; i++)
+        {
+            int node = scene_find_node(scene, names[i]);
+            if (scene_get_joint(scene, node, &value))
+                joints[k] = node;
+        }
+    }
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [-a axis-map] [-r step] [-R degrees] [-m clearance] [-k allow-list] [-t threads] "
+            "[-c cache-dir] [-j jobs] config.xml program\n",
+            argv0);
+}
+
+int main(int argc, char **argv)
+{
+    collision_sweep_config_t config = {
+        .linear_step = 0.5f,
+        .angular_step = 1.0f,
+        .clearance = 1.0f,
+        .allow_adjacent = true,
+    };
+    const char *axisMap = NULL;
+    const char *cacheDir = NULL;
+    int loadThreads = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "a:r:R:m:k:t:c:j:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'a': axisMap = optarg; break;
+        case 'r': config.linear_step = (float)atof(optarg); break;
+        case 'R': config.angular_step = (float)atof(optarg); break;
+        case 'm': config.clearance = (float)atof(optarg); break;
+        case 'k': config.allow_list = optarg; break;
+        case 't': config.threads = atoi(optarg); break;
+        case 'c': cacheDir = optarg; break;
+        case 'j': loadThreads = atoi(optarg); break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (optind != argc - 2 || config.linear_step <= 0.0f || config.angular_step <= 0.0f)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    const char *configFile = argv[optind];
+    const char *programFile = argv[optind + 1];
+    if (cncvis_init(configFile) != 0)
+    {
+        fprintf(stderr, "cncvis_init failed for '%s'\n", configFile);
+        return 1;
+    }
+
+    scene_t *scene = scene_cncvis_build(globalScene, configFile, cacheDir);
+    int failed = scene_load_actors(scene, loadThreads, NULL);
+    scene_cncvis_release_geometry(scene);
+    if (failed > 0)
+        fprintf(stderr, "verify: %d mesh(es) failed to load and are left out of the checks\n", failed);
+    scene_update(scene);
+
+    for (int k = 0; k < GCODE_AXES; k++)
+        config.joints[k] = -1;
+    if (!parse_axis_map(scene, axisMap, config.joints))
+    {
+        fprintf(stderr, "verify: bad axis map '%s'\n", axisMap);
+        return 1;
+    }
+    default_axis_map(scene, config.joints);
+
+    /* The machine starts where config.xml poses it */
+    float start[GCODE_AXES] = { 0 };
+    for (int k = 0; k < GCODE_AXES; k++)
+    {
+        if (config.joints[k] >= 0)
+            scene_get_joint(scene, config.joints[k], &start[k]);
+    }
+
+    gcode_program_t program;
+    bool loaded = gcode_load(programFile, start, &program);
+    if (!loaded)
+    {
+        if (program.error_line > 0)
+            fprintf(stderr, "%s:%d: %s\n", programFile, program.error_line, program.error);
+        else
+            fprintf(stderr, "verify: cannot read '%s': %s\n", programFile, program.error);
+        return 1;
+    }
+    for (int k = 0; k < GCODE_AXES; k++)
+    {
+        if ((program.axes_used & (1u << k)) && config.joints[k] < 0)
+            fprintf(stderr, "verify: axis %c moves no assembly (see -a)\n", axisLetters[k]);
+    }
+    fprintf(stderr, "verify: %d moves in %d lines, %d line(s) with unsupported motion skipped\n",
+            program.move_count, program.line_count, program.ignored);
+
+    config.scene = scene;
+    config.program = &program;
+    collision_sweep_result_t result;
+    if (!collision_sweep_run(&config, &result))
+    {
+        fprintf(stderr, "verify: sweep failed (out of memory or bad allow list '%s')\n",
+                config.allow_list ? config.allow_list : "");
+        return 1;
+    }
+
+    int nearMisses = result.event_count - result.collisions;
+    for (int i = 0; i < result.event_count; i++)
+    {
+        const collision_sweep_event_t *event = &result.events[i];
+        const char *a = scene->actors[event->a].name, *b = scene->actors[event->b].name;
+
+        if (event->distance > 0.0f)
+            printf("near-miss line %u: %s / %s, %.3f\n", event->line, a, b, event->distance);
+        else
+            printf("collision line %u: %s / %s\n", event->line, a, b);
+    }
+    fflush(stdout);
+
+    fprintf(stderr, "verify: %llu poses in %.3f s on %d thread(s), %.0f poses/s, %d steal(s)\n",
+            (unsigned long long)result.poses, result.seconds, result.threads,
+            result.seconds > 0.0 ? (double)result.poses / result.seconds : 0.0, result.steals);
+    fprintf(stderr, "verify: %d collision(s), %d near miss(es) under %.3f\n", result.collisions, nearMisses,
+            config.clearance);
+    if (result.first_collision >= 0)
+    {
+        const collision_sweep_event_t *first = &result.events[result.first_collision];
+        fprintf(stderr, "verify: first collision at line %u: %s / %s\n", first->line, scene->actors[first->a].name,
+                scene->actors[first->b].name);
+    }
+
+    int status = result.collisions > 0 ? 2 : 0;
+    collision_sweep_free(&result);
+    gcode_free(&program);
+    scene_destroy(scene);
+    cncvis_cleanup();
+    return status;
+}